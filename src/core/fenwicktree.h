@@ -0,0 +1,122 @@
+#ifndef FENWICKTREE_H
+#define FENWICKTREE_H
+/**
+ * Copyright (C) 2010-2017 Mladen Milinkovic <max@smoothware.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <QVector>
+
+namespace SubtitleComposer {
+/**
+ * @brief Binary indexed tree of non-negative counts.
+ *
+ * Updating a count, summing counts of a prefix and finding the index at which a prefix
+ * reaches a sum are O(log n), building the tree from counts is O(n).
+ */
+class FenwickTree
+{
+public:
+	FenwickTree() {}
+	explicit FenwickTree(const QVector<int> &values) { reset(values); }
+
+	inline int size() const { return m_values.size(); }
+	inline int value(int index) const { return m_values.at(index); }
+
+	void reset(const QVector<int> &values)
+	{
+		const int n = values.size();
+		m_values = values;
+		m_tree.fill(0, n + 1);
+		for(int i = 1; i <= n; i++) {
+			m_tree[i] += values.at(i - 1);
+			const int parent = i + (i & -i);
+			if(parent <= n)
+				m_tree[parent] += m_tree[i];
+		}
+	}
+
+	void clear()
+	{
+		m_values.clear();
+		m_tree.clear();
+	}
+
+	void add(int index, int delta)
+	{
+		m_values[index] += delta;
+		for(int i = index + 1, n = m_values.size(); i <= n; i += i & -i)
+			m_tree[i] += delta;
+	}
+
+	inline void set(int index, int value) { add(index, value - m_values.at(index)); }
+
+	/// inserts @p count copies of @p value before @p index, rebuilding the tree is O(n)
+	void insert(int index, int count, int value)
+	{
+		QVector<int> values = m_values;
+		values.insert(index, count, value);
+		reset(values);
+	}
+
+	/// removes @p count values starting at @p index, rebuilding the tree is O(n)
+	void remove(int index, int count)
+	{
+		QVector<int> values = m_values;
+		values.remove(index, count);
+		reset(values);
+	}
+
+	/// sum of the first @p count values
+	int prefixSum(int count) const
+	{
+		int sum = 0;
+		for(int i = qMin(count, m_values.size()); i > 0; i -= i & -i)
+			sum += m_tree.at(i);
+		return sum;
+	}
+
+	inline int total() const { return prefixSum(m_values.size()); }
+
+	/**
+	 * @brief lowerBound - finds the value at which the running sum reaches @p sum
+	 * @return smallest index for which prefixSum(index + 1) >= sum, or size() if total() < sum
+	 */
+	int lowerBound(int sum) const
+	{
+		const int n = m_values.size();
+		int step = 1;
+		while(step * 2 <= n)
+			step *= 2;
+
+		int index = 0;
+		for(; step; step /= 2) {
+			if(index + step <= n && m_tree.at(index + step) < sum) {
+				index += step;
+				sum -= m_tree.at(index);
+			}
+		}
+		return index;
+	}
+
+private:
+	QVector<int> m_values;
+	QVector<int> m_tree;        // 1-based, m_tree[i] holds sum of values (i - (i & -i), i]
+};
+}
+
+#endif // FENWICKTREE_H
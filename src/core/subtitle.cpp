@@ -26,6 +26,8 @@
 
 #include <KLocalizedString>
 
+#include <algorithm>
+
 using namespace SubtitleComposer;
 
 double Subtitle::s_defaultFramesPerSecond(23.976);
@@ -405,6 +407,48 @@ Subtitle::insertLines(const QList<SubtitleLine *> &lines, int index)
 	processAction(new InsertLinesAction(*this, lines, index));
 }
 
+void
+Subtitle::insertLinesSorted(const QList<SubtitleLine *> &lines)
+{
+	if(lines.isEmpty())
+		return;
+
+	const auto showTimeLess = [](const SubtitleLine *a, const SubtitleLine *b) { return a->showTime() < b->showTime(); };
+	QList<SubtitleLine *> sorted = lines;
+	std::stable_sort(sorted.begin(), sorted.end(), showTimeLess);
+
+	// lines following all existing ones are inserted with single action, lines of subtitle
+	// that isn't ordered by show times have no right place and are appended the same way
+	if(m_lines.isEmpty() || !(sorted.first()->showTime() < m_lines.last()->showTime()) || !std::is_sorted(m_lines.cbegin(), m_lines.cend(), showTimeLess)) {
+		insertLines(sorted);
+		return;
+	}
+
+	// otherwise every run of lines going between the same two existing lines gets its own action
+	beginCompositeAction(i18n("Insert Lines"));
+
+	int from = 0;
+	while(from < sorted.count()) {
+		const Time showTime = sorted.at(from)->showTime();
+		const int index = std::upper_bound(m_lines.cbegin(), m_lines.cend(), showTime,
+			[](const Time &time, const SubtitleLine *line) { return time < line->showTime(); }) - m_lines.cbegin();
+
+		int to = from + 1;
+		if(index < m_lines.count()) {
+			const Time nextShowTime = m_lines.at(index)->showTime();
+			while(to < sorted.count() && sorted.at(to)->showTime() < nextShowTime)
+				to++;
+		} else {
+			to = sorted.count();
+		}
+
+		insertLines(sorted.mid(from, to - from), index);
+		from = to;
+	}
+
+	endCompositeAction();
+}
+
 SubtitleLine *
 Subtitle::insertNewLine(int index, bool timeAfter, TextTarget target)
 {
@@ -123,6 +123,7 @@ public:
 
 	void insertLine(SubtitleLine *line, int index = -1);
 	void insertLines(const QList<SubtitleLine *> &lines, int index = -1);
+	void insertLinesSorted(const QList<SubtitleLine *> &lines);
 	SubtitleLine * insertNewLine(int index, bool timeAfter, TextTarget target);
 	void removeLines(const RangeList &ranges, TextTarget target);
 
@@ -374,6 +374,7 @@ SwapLinesTextsAction::internalRedo()
 		SString aux = line->m_primaryText;
 		line->m_secondaryText = line->m_primaryText;
 		line->m_primaryText = aux;
+		line->updateTextRevision();
 	}
 }
 
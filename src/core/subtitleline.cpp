@@ -22,6 +22,7 @@
 #include "subtitlelineactions.h"
 #include "subtitle.h"
 
+#include <QAtomicInteger>
 #include <QRegExp>
 
 #include <KLocalizedString>
@@ -143,48 +144,60 @@ SubtitleLine::SubtitleLine(const SString &pText, const SString &sText) :
 	m_subtitle(0),
 	m_primaryText(pText),
 	m_secondaryText(sText),
+	m_textRevision(0),
 	m_showTime(),
 	m_hideTime(),
 	m_errorFlags(0),
 	m_cachedIndex(-1),
 	m_formatData(0)
-{}
+{
+	updateTextRevision();
+}
 
 SubtitleLine::SubtitleLine(const SString &pText, const Time &showTime, const Time &hideTime) :
 	QObject(),
 	m_subtitle(0),
 	m_primaryText(pText),
 	m_secondaryText(QString()),
+	m_textRevision(0),
 	m_showTime(showTime),
 	m_hideTime(hideTime),
 	m_errorFlags(0),
 	m_cachedIndex(-1),
 	m_formatData(0)
-{}
+{
+	updateTextRevision();
+}
 
 SubtitleLine::SubtitleLine(const SString &pText, const SString &sText, const Time &showTime, const Time &hideTime) :
 	QObject(),
 	m_subtitle(0),
 	m_primaryText(pText),
 	m_secondaryText(sText),
+	m_textRevision(0),
 	m_showTime(showTime),
 	m_hideTime(hideTime),
 	m_errorFlags(0),
 	m_cachedIndex(-1),
 	m_formatData(0)
-{}
+{
+	updateTextRevision();
+}
 
 SubtitleLine::SubtitleLine(const SubtitleLine &line) :
 	QObject(),
 	m_subtitle(0),
 	m_primaryText(line.m_primaryText),
 	m_secondaryText(line.m_secondaryText),
+	m_textRevision(0),
 	m_showTime(line.m_showTime),
 	m_hideTime(line.m_hideTime),
 	m_errorFlags(line.m_errorFlags),
 	m_cachedIndex(-1),
 	m_formatData(0)
-{}
+{
+	updateTextRevision();
+}
 
 SubtitleLine &
 SubtitleLine::operator=(const SubtitleLine &line)
@@ -194,6 +207,7 @@ SubtitleLine::operator=(const SubtitleLine &line)
 
 	m_primaryText = line.m_primaryText;
 	m_secondaryText = line.m_secondaryText;
+	updateTextRevision();
 	m_showTime = line.m_showTime;
 	m_hideTime = line.m_hideTime;
 	m_errorFlags = line.m_errorFlags;
@@ -272,6 +286,13 @@ SubtitleLine::nextLine()
 	return m_subtitle ? m_subtitle->line(index() + 1) : NULL;
 }
 
+void
+SubtitleLine::updateTextRevision()
+{
+	static QAtomicInteger<quint32> lastTextRevision;
+	m_textRevision = lastTextRevision.fetchAndAddRelaxed(1) + 1;
+}
+
 const SString &
 SubtitleLine::primaryText() const
 {
@@ -156,6 +156,12 @@ public:
 
 	void setTexts(const SString &pText, const SString &sText);
 
+	/**
+	 * @brief textRevision - changes whenever primary or secondary text changes; never
+	 *  repeats, so it can be used together with line pointer as a key of cached text data
+	 */
+	inline quint32 textRevision() const { return m_textRevision; }
+
 	static SString fixPunctuation(const SString &text, bool spaces, bool quotes, bool englishI, bool ellipsis, bool *cont);
 	static SString breakText(const SString &text, int minLengthForBreak);
 	static QString simplifyTextWhiteSpace(QString text);
@@ -235,10 +241,13 @@ private:
 
 	void processAction(Action *action);
 
+	void updateTextRevision();
+
 private:
 	Subtitle *m_subtitle;
 	SString m_primaryText;
 	SString m_secondaryText;
+	quint32 m_textRevision;
 	Time m_showTime;
 	Time m_hideTime;
 	int m_errorFlags;
@@ -94,6 +94,7 @@ SetLinePrimaryTextAction::internalRedo()
 	SString aux = m_line.m_primaryText;
 	m_line.m_primaryText = m_primaryText;
 	m_primaryText = aux;
+	m_line.updateTextRevision();
 }
 
 void
@@ -135,6 +136,7 @@ SetLineSecondaryTextAction::internalRedo()
 	SString aux = m_line.m_secondaryText;
 	m_line.m_secondaryText = m_secondaryText;
 	m_secondaryText = aux;
+	m_line.updateTextRevision();
 }
 
 void
@@ -199,6 +201,8 @@ SetLineTextsAction::internalRedo()
 		m_line.m_secondaryText = m_secondaryText;
 		m_secondaryText = aux;
 	}
+
+	m_line.updateTextRevision();
 }
 
 void
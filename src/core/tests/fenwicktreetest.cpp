@@ -0,0 +1,130 @@
+/**
+ * Copyright (C) 2010-2017 Mladen Milinkovic <max@smoothware.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "fenwicktreetest.h"
+#include "../fenwicktree.h"
+
+#include <QTest>                               // krazy:exclude=c++/includes
+
+using namespace SubtitleComposer;
+
+static int
+naivePrefixSum(const QVector<int> &values, int count)
+{
+	int sum = 0;
+	for(int i = 0; i < count && i < values.size(); i++)
+		sum += values.at(i);
+	return sum;
+}
+
+static int
+naiveLowerBound(const QVector<int> &values, int sum)
+{
+	int prefix = 0;
+	for(int i = 0; i < values.size(); i++) {
+		prefix += values.at(i);
+		if(prefix >= sum)
+			return i;
+	}
+	return values.size();
+}
+
+void
+FenwickTreeTest::testEmpty()
+{
+	FenwickTree tree;
+	QCOMPARE(tree.size(), 0);
+	QCOMPARE(tree.total(), 0);
+	QCOMPARE(tree.prefixSum(-1), 0);
+	QCOMPARE(tree.prefixSum(5), 0);
+	QCOMPARE(tree.lowerBound(1), 0);
+}
+
+void
+FenwickTreeTest::testPrefixSum()
+{
+	const QVector<int> values = { 1, 0, 0, 1, 1, 0, 1, 0, 0, 0, 1, 1, 0 };
+	FenwickTree tree(values);
+
+	QCOMPARE(tree.size(), values.size());
+	QCOMPARE(tree.total(), 6);
+	QCOMPARE(tree.prefixSum(-3), 0);
+	for(int count = 0; count <= values.size() + 1; count++)
+		QCOMPARE(tree.prefixSum(count), naivePrefixSum(values, count));
+}
+
+void
+FenwickTreeTest::testLowerBound()
+{
+	const QVector<int> values = { 0, 0, 1, 0, 1, 1, 0, 0, 0, 1, 0, 2, 0, 1, 0, 0, 1 };
+	FenwickTree tree(values);
+
+	for(int sum = 1; sum <= tree.total() + 1; sum++)
+		QCOMPARE(tree.lowerBound(sum), naiveLowerBound(values, sum));
+
+	// first value is reached by zero sum
+	QCOMPARE(tree.lowerBound(0), 0);
+}
+
+void
+FenwickTreeTest::testUpdates()
+{
+	QVector<int> values(37, 0);
+	FenwickTree tree(values);
+
+	qsrand(4242);
+	for(int i = 0; i < 500; i++) {
+		const int index = qrand() % values.size();
+		const int value = qrand() % 2;
+		values[index] = value;
+		tree.set(index, value);
+
+		QCOMPARE(tree.value(index), value);
+		const int count = qrand() % (values.size() + 1);
+		QCOMPARE(tree.prefixSum(count), naivePrefixSum(values, count));
+		const int sum = 1 + qrand() % (tree.total() + 1);
+		QCOMPARE(tree.lowerBound(sum), naiveLowerBound(values, sum));
+	}
+
+	tree.reset(values);
+	QCOMPARE(tree.total(), naivePrefixSum(values, values.size()));
+}
+
+void
+FenwickTreeTest::testInsertRemove()
+{
+	QVector<int> values = { 1, 0, 1, 1, 0, 0, 1 };
+	FenwickTree tree(values);
+
+	values.insert(3, 4, 1);
+	tree.insert(3, 4, 1);
+	QCOMPARE(tree.size(), values.size());
+	for(int count = 0; count <= values.size(); count++)
+		QCOMPARE(tree.prefixSum(count), naivePrefixSum(values, count));
+
+	values.remove(1, 5);
+	tree.remove(1, 5);
+	QCOMPARE(tree.size(), values.size());
+	for(int count = 0; count <= values.size(); count++)
+		QCOMPARE(tree.prefixSum(count), naivePrefixSum(values, count));
+	for(int sum = 1; sum <= tree.total() + 1; sum++)
+		QCOMPARE(tree.lowerBound(sum), naiveLowerBound(values, sum));
+}
+
+QTEST_MAIN(FenwickTreeTest);
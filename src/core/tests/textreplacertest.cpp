@@ -0,0 +1,112 @@
+/**
+ * Copyright (C) 2010-2017 Mladen Milinkovic <max@smoothware.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "textreplacertest.h"
+#include "../textreplacer.h"
+
+#include <QTest>                               // krazy:exclude=c++/includes
+
+using namespace SubtitleComposer;
+
+void
+TextReplacerTest::testReplace_data()
+{
+	QTest::addColumn<QString>("text");
+	QTest::addColumn<QString>("pattern");
+	QTest::addColumn<QString>("replacement");
+	QTest::addColumn<bool>("regExp");
+	QTest::addColumn<bool>("caseSensitive");
+	QTest::addColumn<bool>("wholeWords");
+	QTest::addColumn<QString>("result");
+	QTest::addColumn<int>("replacements");
+
+	QTest::newRow("plain") << "one two one" << "one" << "1" << false << true << false << "1 two 1" << 2;
+	QTest::newRow("no match") << "one two" << "three" << "3" << false << true << false << "one two" << 0;
+	QTest::newRow("case") << "One one" << "one" << "1" << false << true << false << "One 1" << 1;
+	QTest::newRow("no case") << "One one" << "one" << "1" << false << false << false << "1 1" << 2;
+	QTest::newRow("whole words") << "cat concat cat." << "cat" << "dog" << false << true << true << "dog concat dog." << 2;
+	QTest::newRow("plain specials") << "a.b a*b" << "a.b" << "\\1" << false << true << false << "\\1 a*b" << 1;
+	QTest::newRow("remove") << "a-b-c" << "-" << "" << false << true << false << "abc" << 2;
+	QTest::newRow("captures") << "John Smith" << "(\\w+) (\\w+)" << "\\2, \\1" << true << true << false << "Smith, John" << 1;
+	QTest::newRow("whole match") << "abc" << "b" << "[\\0]" << true << true << false << "a[b]c" << 1;
+	QTest::newRow("escapes") << "a b" << " " << "\\n\\\\" << true << true << false << "a\n\\b" << 1;
+	QTest::newRow("empty matches") << "ab" << "^" << "- " << true << true << false << "- ab" << 1;
+}
+
+void
+TextReplacerTest::testReplace()
+{
+	QFETCH(QString, text);
+	QFETCH(QString, pattern);
+	QFETCH(QString, replacement);
+	QFETCH(bool, regExp);
+	QFETCH(bool, caseSensitive);
+	QFETCH(bool, wholeWords);
+	QFETCH(QString, result);
+	QFETCH(int, replacements);
+
+	TextReplacer replacer(pattern, replacement, regExp, caseSensitive, wholeWords);
+	QVERIFY(replacer.isValid());
+
+	SString sText(text);
+	QCOMPARE(replacer.replaceAll(sText), replacements);
+	QCOMPARE(sText.string(), result);
+}
+
+void
+TextReplacerTest::testStyles()
+{
+	// "<b>bold</b> <i>italic</i>"
+	SString text(QStringLiteral("bold italic"));
+	text.setStyleFlags(0, 4, SString::Bold);
+	text.setStyleFlags(5, 6, SString::Italic);
+
+	// literal replacement takes style of replaced text, kept text is unchanged
+	SString literal(text);
+	QCOMPARE(TextReplacer(QStringLiteral("italic"), QStringLiteral("slanted text"), false, true).replaceAll(literal), 1);
+	QCOMPARE(literal.string(), QStringLiteral("bold slanted text"));
+	for(int i = 0; i < 4; i++)
+		QCOMPARE(literal.styleFlagsAt(i), int(SString::Bold));
+	QCOMPARE(literal.styleFlagsAt(4), 0);
+	for(int i = 5; i < literal.length(); i++)
+		QCOMPARE(literal.styleFlagsAt(i), int(SString::Italic));
+
+	// captures keep their own styles when moved
+	SString swapped(text);
+	QCOMPARE(TextReplacer(QStringLiteral("(\\w+) (\\w+)"), QStringLiteral("\\2 \\1"), true, true).replaceAll(swapped), 1);
+	QCOMPARE(swapped.string(), QStringLiteral("italic bold"));
+	for(int i = 0; i < 6; i++)
+		QCOMPARE(swapped.styleFlagsAt(i), int(SString::Italic));
+	for(int i = 7; i < 11; i++)
+		QCOMPARE(swapped.styleFlagsAt(i), int(SString::Bold));
+}
+
+void
+TextReplacerTest::testInvalid()
+{
+	QVERIFY(!TextReplacer(QString(), QStringLiteral("x"), false, true).isValid());
+	QVERIFY(!TextReplacer(QStringLiteral("(a"), QStringLiteral("x"), true, true).isValid());
+	QVERIFY(!TextReplacer(QStringLiteral("(a)"), QStringLiteral("\\2"), true, true).isValid());
+
+	SString text(QStringLiteral("(a"));
+	QCOMPARE(TextReplacer(QStringLiteral("(a"), QStringLiteral("x"), true, true).replaceAll(text), 0);
+	QCOMPARE(text.string(), QStringLiteral("(a"));
+}
+
+QTEST_MAIN(TextReplacerTest);
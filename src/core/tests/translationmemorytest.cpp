@@ -0,0 +1,139 @@
+/**
+ * Copyright (C) 2010-2017 Mladen Milinkovic <max@smoothware.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "translationmemorytest.h"
+#include "../translationmemory.h"
+
+#include <QTemporaryDir>
+#include <QTest>                               // krazy:exclude=c++/includes
+
+using namespace SubtitleComposer;
+
+void
+TranslationMemoryTest::testTranslation()
+{
+	TranslationMemory memory;
+	QVERIFY(!memory.isModified());
+
+	memory.insert("en", "es", "Good morning!", "¡Buenos días!");
+	memory.insert("en", "fr", "Good morning!", "Bonjour !");
+	QCOMPARE(memory.size(), 2);
+	QVERIFY(memory.isModified());
+
+	// spacing and line breaks are ignored, language pairs are not
+	QCOMPARE(memory.translation("en", "es", "Good\nmorning! "), QString::fromUtf8("¡Buenos días!"));
+	QCOMPARE(memory.translation("en", "fr", "Good morning!"), QStringLiteral("Bonjour !"));
+	QVERIFY(memory.translation("es", "en", "Good morning!").isNull());
+	QVERIFY(memory.translation("en", "es", "Good evening!").isNull());
+
+	// same text is translated again
+	memory.insert("en", "es", "Good  morning!", "Buenos días");
+	QCOMPARE(memory.size(), 2);
+	QCOMPARE(memory.translation("en", "es", "Good morning!"), QString::fromUtf8("Buenos días"));
+
+	// empty texts aren't remembered
+	memory.insert("en", "es", " ", "nada");
+	QCOMPARE(memory.size(), 2);
+
+	memory.clear();
+	QCOMPARE(memory.size(), 0);
+	QVERIFY(memory.translation("en", "fr", "Good morning!").isNull());
+}
+
+void
+TranslationMemoryTest::testSuggestions()
+{
+	TranslationMemory memory;
+	memory.insert("en", "es", "Where are you going?", "¿Adónde vas?");
+	memory.insert("en", "es", "Where were you going?", "¿Adónde ibas?");
+	memory.insert("en", "es", "I don't know.", "No lo sé.");
+	memory.insert("en", "de", "Where are you going?", "Wohin gehst du?");
+
+	QList<TranslationMemory::Suggestion> suggestions = memory.suggestions("en", "es", "Where are you going now?", 0.5, 10);
+	QCOMPARE(suggestions.size(), 2);
+	QCOMPARE(suggestions.at(0).target, QString::fromUtf8("¿Adónde vas?"));
+	QCOMPARE(suggestions.at(1).target, QString::fromUtf8("¿Adónde ibas?"));
+	QVERIFY(suggestions.at(0).similarity > suggestions.at(1).similarity);
+	QVERIFY(suggestions.at(0).similarity < 1.0);
+
+	// any language pair
+	suggestions = memory.suggestions(QString(), QString(), "Where are you going?", 0.9, 10);
+	QCOMPARE(suggestions.size(), 2);
+	QCOMPARE(suggestions.at(0).similarity, 1.0);
+	QCOMPARE(suggestions.at(1).similarity, 1.0);
+
+	QCOMPARE(memory.suggestions(QString(), QString(), "Where are you going?", 0.5, 1).size(), 1);
+	QVERIFY(memory.suggestions("en", "fr", "Where are you going?", 0.5, 10).isEmpty());
+
+	// source of translated again text is indexed with its new spacing
+	memory.insert("en", "es", "Where are\nyou  going?", "¿A dónde vas?");
+	suggestions = memory.suggestions("en", "es", "Where are\nyou  going?", 0.5, 1);
+	QCOMPARE(suggestions.size(), 1);
+	QCOMPARE(suggestions.at(0).source, QStringLiteral("Where are\nyou  going?"));
+	QCOMPARE(suggestions.at(0).similarity, 1.0);
+}
+
+void
+TranslationMemoryTest::testSaveLoad()
+{
+	QTemporaryDir dir;
+	QVERIFY(dir.isValid());
+	const QString file = dir.path() + QStringLiteral("/memory/translationmemory.dat");
+
+	TranslationMemory memory;
+	QVERIFY(!memory.load(file));
+	memory.insert("en", "es", "Yes.", "Sí.");
+	memory.insert("en", "es", "No.", "No.");
+	QVERIFY(memory.save(file));
+	QVERIFY(!memory.isModified());
+
+	TranslationMemory loaded;
+	QVERIFY(loaded.load(file));
+	QVERIFY(!loaded.isModified());
+	QCOMPARE(loaded.size(), 2);
+	QCOMPARE(loaded.translation("en", "es", "Yes."), QString::fromUtf8("Sí."));
+	QCOMPARE(loaded.suggestions("en", "es", "No.", 1.0, 10).size(), 1);
+}
+
+void
+TranslationMemoryTest::testMaxEntries()
+{
+	TranslationMemory memory;
+	memory.setMaxEntries(8);
+	for(int i = 1; i <= 8; i++)
+		memory.insert("en", "es", QStringLiteral("Line %1").arg(i), QStringLiteral("Línea %1").arg(i));
+	QCOMPARE(memory.size(), 8);
+
+	// oldest quarter is forgotten once the limit is passed
+	memory.insert("en", "es", "Line 9", "Línea 9");
+	QCOMPARE(memory.size(), 6);
+	QVERIFY(memory.translation("en", "es", "Line 3").isNull());
+	QCOMPARE(memory.translation("en", "es", "Line 4"), QString::fromUtf8("Línea 4"));
+	QCOMPARE(memory.translation("en", "es", "Line 9"), QString::fromUtf8("Línea 9"));
+	QCOMPARE(memory.suggestions("en", "es", "Line 4", 1.0, 10).size(), 1);
+	QVERIFY(memory.suggestions("en", "es", "Line 2", 1.0, 10).isEmpty());
+
+	// lowering the limit drops the oldest right away
+	memory.setMaxEntries(2);
+	QCOMPARE(memory.size(), 2);
+	QVERIFY(memory.translation("en", "es", "Line 7").isNull());
+	QCOMPARE(memory.translation("en", "es", "Line 8"), QString::fromUtf8("Línea 8"));
+}
+
+QTEST_MAIN(TranslationMemoryTest);
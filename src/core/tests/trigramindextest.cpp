@@ -0,0 +1,160 @@
+/**
+ * Copyright (C) 2010-2017 Mladen Milinkovic <max@smoothware.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "trigramindextest.h"
+#include "../trigramindex.h"
+
+#include <QRegularExpression>
+#include <QTest>                               // krazy:exclude=c++/includes
+
+using namespace SubtitleComposer;
+
+static const char *documents[] = {
+	"The quick brown fox",
+	"jumps over the lazy dog",
+	"THE END",
+	"Lazy\nafternoon",
+	"no",
+	""
+};
+static const int documentCount = sizeof(documents) / sizeof(*documents);
+
+void
+TrigramIndexTest::testTrigrams()
+{
+	QCOMPARE(TrigramIndex::trigrams(QString()).size(), 0);
+	QCOMPARE(TrigramIndex::trigrams(QStringLiteral("ab")).size(), 0);
+	QCOMPARE(TrigramIndex::trigrams(QStringLiteral("abc")).size(), 1);
+	// duplicates are removed, case is folded
+	QCOMPARE(TrigramIndex::trigrams(QStringLiteral("aaaa")).size(), 1);
+	QCOMPARE(TrigramIndex::trigrams(QStringLiteral("ABCD")), TrigramIndex::trigrams(QStringLiteral("abcd")));
+}
+
+void
+TrigramIndexTest::testCandidates()
+{
+	TrigramIndex index;
+	for(int i = 0; i < documentCount; i++)
+		index.insert(i, QString::fromUtf8(documents[i]));
+	QCOMPARE(index.size(), documentCount);
+
+	const QStringList queries = { "the", "LAZY", "he ", "quick brown", "fox jumps", "y\na", "zzz" };
+	foreach(const QString &query, queries) {
+		bool restricted = false;
+		const QSet<int> candidates = index.candidates(QStringList() << query, &restricted);
+		QVERIFY(restricted);
+		for(int i = 0; i < documentCount; i++) {
+			const bool contains = QString::fromUtf8(documents[i]).contains(query, Qt::CaseInsensitive);
+			// index is exact for single literals, documents have all trigrams only if they contain it
+			if(contains)
+				QVERIFY(candidates.contains(i));
+			QCOMPARE(index.mayContain(i, QStringList() << query), candidates.contains(i));
+		}
+	}
+
+	bool restricted = true;
+	QVERIFY(index.candidates(QStringList() << "he", &restricted).isEmpty());
+	QVERIFY(!restricted);
+	QVERIFY(index.mayContain(0, QStringList() << "xy"));
+	QVERIFY(index.mayContain(documentCount, QStringList() << "anything"));
+}
+
+void
+TrigramIndexTest::testUpdates()
+{
+	TrigramIndex index;
+	index.insert(1, QStringLiteral("first text"));
+	index.insert(2, QStringLiteral("second text"));
+
+	bool restricted;
+	QCOMPARE(index.candidates(QStringList() << "text", &restricted), QSet<int>() << 1 << 2);
+
+	index.insert(1, QStringLiteral("changed"));
+	QCOMPARE(index.candidates(QStringList() << "text", &restricted), QSet<int>() << 2);
+	QCOMPARE(index.candidates(QStringList() << "change", &restricted), QSet<int>() << 1);
+
+	index.remove(2);
+	QVERIFY(!index.contains(2));
+	QVERIFY(index.candidates(QStringList() << "text", &restricted).isEmpty());
+
+	index.clear();
+	QCOMPARE(index.size(), 0);
+	QVERIFY(index.candidates(QStringList() << "change", &restricted).isEmpty());
+}
+
+void
+TrigramIndexTest::testSimilar()
+{
+	TrigramIndex index;
+	index.insert(1, QStringLiteral("Where are you going?"));
+	index.insert(2, QStringLiteral("Where were you going?"));
+	index.insert(3, QStringLiteral("Something else entirely"));
+
+	QList<QPair<int, double> > similar = index.similar(QStringLiteral("where are you going?"), 0.5, 10);
+	QCOMPARE(similar.size(), 2);
+	QCOMPARE(similar.at(0).first, 1);
+	QCOMPARE(similar.at(0).second, 1.0);
+	QCOMPARE(similar.at(1).first, 2);
+	QVERIFY(similar.at(1).second < 1.0);
+
+	QCOMPARE(index.similar(QStringLiteral("where are you going?"), 0.5, 1).size(), 1);
+	QVERIFY(index.similar(QStringLiteral("nothing alike"), 0.5, 10).isEmpty());
+	QVERIFY(index.similar(QStringLiteral("ab"), 0.0, 10).isEmpty());
+}
+
+void
+TrigramIndexTest::testRequiredLiterals_data()
+{
+	QTest::addColumn<QString>("regExp");
+	QTest::addColumn<QStringList>("literals");
+
+	QTest::newRow("plain") << "hello" << (QStringList() << "hello");
+	QTest::newRow("short") << "hi" << QStringList();
+	QTest::newRow("wildcard") << "abc.def" << (QStringList() << "abc" << "def");
+	QTest::newRow("optional") << "abcd?ef" << (QStringList() << "abc");
+	QTest::newRow("repeat") << "abcd+efg" << (QStringList() << "abcd" << "efg");
+	QTest::newRow("counted") << "abcd{2,3}efg" << (QStringList() << "abc" << "efg");
+	QTest::newRow("escaped") << "a\\.b\\.c" << (QStringList() << "a.b.c");
+	QTest::newRow("class escape") << "abc\\sdef" << (QStringList() << "abc" << "def");
+	QTest::newRow("hex escape") << "\\x41bcd" << (QStringList() << "bcd");
+	QTest::newRow("hex code escape") << "\\x{41}bcd" << (QStringList() << "bcd");
+	QTest::newRow("octal escape") << "\\o{101}bcd" << (QStringList() << "bcd");
+	QTest::newRow("control escape") << "\\cAbcd" << (QStringList() << "bcd");
+	QTest::newRow("property escape") << "\\pLabcd\\p{Lu}efg" << (QStringList() << "abcd" << "efg");
+	QTest::newRow("named reference") << "(?<n>x)\\k<n>abc\\k'n'def\\k{n}ghi" << (QStringList() << "abc" << "def" << "ghi");
+	QTest::newRow("group reference") << "(x)\\g1abc\\g{-1}def\\g<1>ghi" << (QStringList() << "abc" << "def" << "ghi");
+	QTest::newRow("quoted") << "ab\\Qc.d*\\Eef" << (QStringList() << "abc.d*ef");
+	QTest::newRow("class") << "abc[x-z]+def" << (QStringList() << "abc" << "def");
+	QTest::newRow("group") << "abc(xyz|uvw)def" << (QStringList() << "abc" << "def");
+	QTest::newRow("alternation") << "abc|def" << QStringList();
+	QTest::newRow("anchors") << "^start$" << (QStringList() << "start");
+	QTest::newRow("extended") << "(?x) a b c d" << QStringList();
+}
+
+void
+TrigramIndexTest::testRequiredLiterals()
+{
+	QFETCH(QString, regExp);
+	QFETCH(QStringList, literals);
+
+	QVERIFY(QRegularExpression(regExp).isValid());
+	QCOMPARE(TrigramIndex::requiredLiterals(regExp), literals);
+}
+
+QTEST_MAIN(TrigramIndexTest);
@@ -0,0 +1,193 @@
+/**
+ * Copyright (C) 2010-2017 Mladen Milinkovic <max@smoothware.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "textindex.h"
+#include "subtitle.h"
+
+#include <QPair>
+#include <QRegularExpression>
+#include <QVector>
+
+#include <algorithm>
+
+using namespace SubtitleComposer;
+
+TextIndex::TextIndex(QObject *parent)
+	: QObject(parent),
+	  m_subtitle(0),
+	  m_nextId(0)
+{}
+
+TextIndex::~TextIndex()
+{}
+
+void
+TextIndex::setSubtitle(Subtitle *subtitle)
+{
+	if(m_subtitle)
+		disconnect(m_subtitle, 0, this, 0);
+
+	m_subtitle = subtitle;
+
+	m_index.clear();
+	m_lineIds.clear();
+	m_idLines.clear();
+	m_nextId = 0;
+
+	if(m_subtitle) {
+		connect(m_subtitle, &Subtitle::linesInserted, this, &TextIndex::onLinesInserted);
+		connect(m_subtitle, &Subtitle::linesAboutToBeRemoved, this, &TextIndex::onLinesAboutToBeRemoved);
+		connect(m_subtitle, &Subtitle::linePrimaryTextChanged, this, &TextIndex::onLineTextChanged);
+		connect(m_subtitle, &Subtitle::lineSecondaryTextChanged, this, &TextIndex::onLineTextChanged);
+
+		for(int i = 0, n = m_subtitle->linesCount(); i < n; i++)
+			indexLine(m_subtitle->line(i));
+	}
+
+	emit indexChanged();
+}
+
+void
+TextIndex::indexLine(const SubtitleLine *line)
+{
+	QHash<const SubtitleLine *, int>::ConstIterator it = m_lineIds.constFind(line);
+	int id;
+	if(it == m_lineIds.constEnd()) {
+		id = m_nextId++;
+		m_lineIds.insert(line, id);
+		m_idLines.insert(id, const_cast<SubtitleLine *>(line));
+	} else {
+		id = it.value();
+	}
+
+	// separator keeps trigrams from spanning both texts
+	m_index.insert(id, line->primaryText().string() + QChar(0) + line->secondaryText().string());
+}
+
+void
+TextIndex::onLinesInserted(int firstIndex, int lastIndex)
+{
+	for(int i = firstIndex; i <= lastIndex; i++)
+		indexLine(m_subtitle->line(i));
+
+	emit indexChanged();
+}
+
+void
+TextIndex::onLinesAboutToBeRemoved(int firstIndex, int lastIndex)
+{
+	for(int i = firstIndex; i <= lastIndex; i++) {
+		const int id = m_lineIds.take(m_subtitle->line(i));
+		m_idLines.remove(id);
+		m_index.remove(id);
+	}
+
+	emit indexChanged();
+}
+
+void
+TextIndex::onLineTextChanged(SubtitleLine *line)
+{
+	indexLine(line);
+
+	emit indexChanged();
+}
+
+/*static*/ QStringList
+TextIndex::queryLiterals(const QString &pattern, bool regExp)
+{
+	return regExp ? TrigramIndex::requiredLiterals(pattern) : QStringList(pattern);
+}
+
+bool
+TextIndex::mayContain(const SubtitleLine *line, const QStringList &literals) const
+{
+	QHash<const SubtitleLine *, int>::ConstIterator it = m_lineIds.constFind(line);
+	return it == m_lineIds.constEnd() || m_index.mayContain(it.value(), literals);
+}
+
+QList<TextIndex::Match>
+TextIndex::findAll(const QString &pattern, bool regExp, bool caseSensitive, SubtitleLine::TextTarget target, const RangeList &ranges, int maxMatches) const
+{
+	QList<Match> matches;
+	if(!m_subtitle || pattern.isEmpty())
+		return matches;
+
+	QRegularExpression regularExpression;
+	if(regExp) {
+		regularExpression.setPattern(pattern);
+		if(!caseSensitive)
+			regularExpression.setPatternOptions(QRegularExpression::CaseInsensitiveOption);
+		if(!regularExpression.isValid())
+			return matches;
+	}
+
+	// only lines having all trigrams of the pattern literals are matched
+	bool restricted;
+	const QSet<int> candidateIds = m_index.candidates(queryLiterals(pattern, regExp), &restricted);
+
+	QVector<QPair<int, SubtitleLine *> > lines;
+	if(restricted) {
+		lines.reserve(candidateIds.size());
+		foreach(int id, candidateIds) {
+			SubtitleLine *line = m_idLines.value(id);
+			const int index = line->index();
+			if(ranges.contains(index))
+				lines.append(qMakePair(index, line));
+		}
+		std::sort(lines.begin(), lines.end());
+	} else {
+		for(int i = 0, n = m_subtitle->linesCount(); i < n; i++) {
+			if(ranges.contains(i))
+				lines.append(qMakePair(i, m_subtitle->line(i)));
+		}
+	}
+
+	const Qt::CaseSensitivity cs = caseSensitive ? Qt::CaseSensitive : Qt::CaseInsensitive;
+	for(int i = 0, n = lines.size(); i < n; i++) {
+		SubtitleLine *line = lines.at(i).second;
+		for(int t = SubtitleLine::Primary; t <= SubtitleLine::Secondary; t++) {
+			if(target != SubtitleLine::Both && target != t)
+				continue;
+
+			const bool primary = t == SubtitleLine::Primary;
+			const QString text = primary ? line->primaryText().string() : line->secondaryText().string();
+
+			if(regExp) {
+				QRegularExpressionMatchIterator it = regularExpression.globalMatch(text);
+				while(it.hasNext()) {
+					const QRegularExpressionMatch match = it.next();
+					if(!match.capturedLength())
+						continue;
+					matches.append({ line, primary, match.capturedStart(), match.capturedLength() });
+					if(matches.size() == maxMatches)
+						return matches;
+				}
+			} else {
+				for(int start = text.indexOf(pattern, 0, cs); start != -1; start = text.indexOf(pattern, start + pattern.length(), cs)) {
+					matches.append({ line, primary, start, pattern.length() });
+					if(matches.size() == maxMatches)
+						return matches;
+				}
+			}
+		}
+	}
+
+	return matches;
+}
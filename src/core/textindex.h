@@ -0,0 +1,95 @@
+#ifndef TEXTINDEX_H
+#define TEXTINDEX_H
+/**
+ * Copyright (C) 2010-2017 Mladen Milinkovic <max@smoothware.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "rangelist.h"
+#include "subtitleline.h"
+#include "trigramindex.h"
+
+#include <QHash>
+#include <QList>
+#include <QObject>
+
+namespace SubtitleComposer {
+class Subtitle;
+
+/**
+ * @brief Trigram index of primary and secondary texts of subtitle lines.
+ *
+ * Index is updated from subtitle line change notifications, finding all
+ * occurrences only looks at lines that have all trigrams of the searched text
+ * or of the literals every match of the regular expression contains.
+ */
+class TextIndex : public QObject
+{
+	Q_OBJECT
+
+public:
+	struct Match {
+		SubtitleLine *line;
+		bool primary;
+		int start;
+		int length;
+	};
+
+	explicit TextIndex(QObject *parent = 0);
+	virtual ~TextIndex();
+
+	inline Subtitle * subtitle() const { return m_subtitle; }
+
+	/// literals of @p pattern every match contains, for mayContain()
+	static QStringList queryLiterals(const QString &pattern, bool regExp);
+	/// false if texts of @p line can't contain all @p literals
+	bool mayContain(const SubtitleLine *line, const QStringList &literals) const;
+
+	/**
+	 * @brief findAll - finds all occurrences of @p pattern
+	 * @param maxMatches search stops after this many matches, negative for unlimited
+	 * @return matches ordered by line index, primary text first
+	 */
+	QList<Match> findAll(const QString &pattern, bool regExp, bool caseSensitive,
+						 SubtitleLine::TextTarget target = SubtitleLine::Both,
+						 const RangeList &ranges = Range::full(), int maxMatches = -1) const;
+
+public slots:
+	void setSubtitle(Subtitle *subtitle = 0);
+
+signals:
+	/// texts of some lines were changed, inserted or removed
+	void indexChanged();
+
+private slots:
+	void onLinesInserted(int firstIndex, int lastIndex);
+	void onLinesAboutToBeRemoved(int firstIndex, int lastIndex);
+	void onLineTextChanged(SubtitleLine *line);
+
+private:
+	void indexLine(const SubtitleLine *line);
+
+private:
+	Subtitle *m_subtitle;
+	TrigramIndex m_index;
+	QHash<const SubtitleLine *, int> m_lineIds;
+	QHash<int, SubtitleLine *> m_idLines;
+	int m_nextId;
+};
+}
+
+#endif // TEXTINDEX_H
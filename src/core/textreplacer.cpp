@@ -0,0 +1,126 @@
+/**
+ * Copyright (C) 2010-2017 Mladen Milinkovic <max@smoothware.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "textreplacer.h"
+
+#include <KLocalizedString>
+
+using namespace SubtitleComposer;
+
+TextReplacer::TextReplacer(const QString &pattern, const QString &replacement, bool regExp, bool caseSensitive, bool wholeWords)
+	: m_valid(false)
+{
+	if(pattern.isEmpty())
+		return;
+
+	// plain text is searched as an escaped pattern, captures are never referenced
+	QString regExpPattern = regExp ? pattern : QRegularExpression::escape(pattern);
+	if(wholeWords)
+		regExpPattern = QStringLiteral("\\b(?:") + regExpPattern + QStringLiteral(")\\b");
+
+	m_regExp.setPattern(regExpPattern);
+	if(!caseSensitive)
+		m_regExp.setPatternOptions(QRegularExpression::CaseInsensitiveOption);
+	if(!m_regExp.isValid()) {
+		m_errorString = m_regExp.errorString();
+		return;
+	}
+	m_regExp.optimize();
+
+	if(regExp) {
+		parseReplacement(replacement);
+		foreach(const Piece &piece, m_pieces) {
+			if(piece.capture > m_regExp.captureCount()) {
+				m_errorString = i18n("Replacement references missing capture \\%1", piece.capture);
+				return;
+			}
+		}
+	} else if(!replacement.isEmpty()) {
+		m_pieces.append({ -1, replacement });
+	}
+
+	m_valid = true;
+}
+
+void
+TextReplacer::parseReplacement(const QString &replacement)
+{
+	QString literal;
+	for(int i = 0, n = replacement.length(); i < n; i++) {
+		const QChar ch = replacement.at(i);
+		if(ch != QLatin1Char('\\') || i + 1 == n) {
+			literal.append(ch);
+			continue;
+		}
+
+		const QChar next = replacement.at(++i);
+		if(next.isDigit()) {
+			if(!literal.isEmpty())
+				m_pieces.append({ -1, literal });
+			literal.clear();
+			m_pieces.append({ next.digitValue(), QString() });
+		} else if(next == QLatin1Char('n')) {
+			literal.append(QLatin1Char('\n'));
+		} else {
+			literal.append(next);
+		}
+	}
+	if(!literal.isEmpty())
+		m_pieces.append({ -1, literal });
+}
+
+int
+TextReplacer::replaceAll(SString &text) const
+{
+	if(!m_valid)
+		return 0;
+
+	QRegularExpressionMatchIterator it = m_regExp.globalMatch(text.string());
+	if(!it.hasNext())
+		return 0;
+
+	SString result;
+	int replacements = 0;
+	int end = 0;
+	while(it.hasNext()) {
+		const QRegularExpressionMatch match = it.next();
+		const int start = match.capturedStart();
+
+		result.append(text.mid(end, start - end));
+
+		// literals are styled like the start of replaced text, or like the last character at the end
+		const int styleIndex = qMin(start, text.length() - 1);
+		const int styleFlags = text.styleFlagsAt(styleIndex);
+		const QRgb styleColor = text.styleColorAt(styleIndex);
+
+		foreach(const Piece &piece, m_pieces) {
+			if(piece.capture < 0)
+				result.append(SString(piece.text, styleFlags, styleColor));
+			else if(match.capturedLength(piece.capture) > 0)
+				result.append(text.mid(match.capturedStart(piece.capture), match.capturedLength(piece.capture)));
+		}
+
+		end = match.capturedEnd();
+		replacements++;
+	}
+	result.append(text.mid(end));
+
+	text = result;
+	return replacements;
+}
@@ -0,0 +1,67 @@
+#ifndef TEXTREPLACER_H
+#define TEXTREPLACER_H
+/**
+ * Copyright (C) 2010-2017 Mladen Milinkovic <max@smoothware.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "sstring.h"
+
+#include <QRegularExpression>
+#include <QString>
+#include <QVector>
+
+namespace SubtitleComposer {
+/**
+ * @brief Replaces all matches of a pattern in styled text.
+ *
+ * Text that is kept or copied from a regular expression capture keeps its styles, literal
+ * replacement text gets the style the replaced text started with. Replacing is reentrant,
+ * one TextReplacer can be used from many threads at once.
+ */
+class TextReplacer
+{
+public:
+	/**
+	 * @param replacement replacement text, with regular expressions \\0 to \\9 insert captures,
+	 *                    \\n inserts a line break and \\\\ a backslash
+	 */
+	TextReplacer(const QString &pattern, const QString &replacement, bool regExp, bool caseSensitive, bool wholeWords = false);
+
+	inline bool isValid() const { return m_valid; }
+	inline QString errorString() const { return m_errorString; }
+
+	/// replaces all matches in @p text, returns number of replacements made
+	int replaceAll(SString &text) const;
+
+private:
+	struct Piece {
+		int capture;            // -1 for literal text
+		QString text;
+	};
+
+	void parseReplacement(const QString &replacement);
+
+private:
+	QRegularExpression m_regExp;
+	QVector<Piece> m_pieces;
+	bool m_valid;
+	QString m_errorString;
+};
+}
+
+#endif // TEXTREPLACER_H
@@ -0,0 +1,212 @@
+/**
+ * Copyright (C) 2010-2017 Mladen Milinkovic <max@smoothware.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "translationmemory.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <algorithm>
+
+// header of memory files, files of other versions are ignored
+#define MEMORY_MAGIC 0x5343544d
+#define MEMORY_VERSION 1
+
+// memory doesn't grow past this many translations by default
+#define MEMORY_MAX_ENTRIES 100000
+
+using namespace SubtitleComposer;
+
+TranslationMemory::TranslationMemory()
+	: m_maxEntries(MEMORY_MAX_ENTRIES),
+	  m_modified(false)
+{}
+
+void
+TranslationMemory::setMaxEntries(int maxEntries)
+{
+	m_maxEntries = qMax(1, maxEntries);
+	if(m_entries.size() > m_maxEntries)
+		dropOldest(m_entries.size() - m_maxEntries);
+}
+
+void
+TranslationMemory::dropOldest(int count)
+{
+	// entry ids are indexes, so everything is indexed again
+	const QVector<Entry> entries = m_entries.mid(count);
+	m_entries.clear();
+	m_exactIds.clear();
+	m_indexes.clear();
+	foreach(const Entry &entry, entries)
+		insert(entry.sourceLanguage, entry.targetLanguage, entry.source, entry.target);
+	m_modified = true;
+}
+
+void
+TranslationMemory::clear()
+{
+	m_modified = m_modified || !m_entries.isEmpty();
+
+	m_entries.clear();
+	m_exactIds.clear();
+	m_indexes.clear();
+}
+
+/*static*/ QString
+TranslationMemory::languagePair(const QString &sourceLanguage, const QString &targetLanguage)
+{
+	return sourceLanguage + QLatin1Char('>') + targetLanguage;
+}
+
+/*static*/ QString
+TranslationMemory::normalized(const QString &text)
+{
+	// line breaks and spacing don't change the meaning of subtitle text
+	return text.simplified();
+}
+
+void
+TranslationMemory::insert(const QString &sourceLanguage, const QString &targetLanguage, const QString &source, const QString &target)
+{
+	const QString pair = languagePair(sourceLanguage, targetLanguage);
+	const QString key = pair + QChar(0) + normalized(source);
+	if(key.length() == pair.length() + 1)
+		return;
+
+	QHash<QString, int>::ConstIterator it = m_exactIds.constFind(key);
+	if(it != m_exactIds.constEnd()) {
+		Entry &entry = m_entries[it.value()];
+		if(entry.target != target) {
+			// spacing of the source could differ, its trigrams are indexed again
+			if(entry.source != source) {
+				entry.source = source;
+				m_indexes[pair].insert(it.value(), source);
+			}
+			entry.target = target;
+			m_modified = true;
+		}
+		return;
+	}
+
+	const int id = m_entries.size();
+	m_entries.append({ sourceLanguage, targetLanguage, source, target });
+	m_exactIds.insert(key, id);
+	m_indexes[pair].insert(id, source);
+	m_modified = true;
+
+	// a quarter is dropped at once so indexing again doesn't happen on every insert
+	if(m_entries.size() > m_maxEntries)
+		dropOldest(m_entries.size() - (m_maxEntries - m_maxEntries / 4));
+}
+
+QString
+TranslationMemory::translation(const QString &sourceLanguage, const QString &targetLanguage, const QString &source) const
+{
+	QHash<QString, int>::ConstIterator it = m_exactIds.constFind(languagePair(sourceLanguage, targetLanguage) + QChar(0) + normalized(source));
+	return it == m_exactIds.constEnd() ? QString() : m_entries.at(it.value()).target;
+}
+
+QList<TranslationMemory::Suggestion>
+TranslationMemory::suggestions(const QString &sourceLanguage, const QString &targetLanguage, const QString &source, double minSimilarity, int maxResults) const
+{
+	QList<QPair<int, double> > similar;
+	if(!sourceLanguage.isEmpty() && !targetLanguage.isEmpty()) {
+		QHash<QString, TrigramIndex>::ConstIterator it = m_indexes.constFind(languagePair(sourceLanguage, targetLanguage));
+		if(it != m_indexes.constEnd())
+			similar = it->similar(source, minSimilarity, maxResults);
+	} else {
+		// best results of each language pair are merged
+		foreach(const TrigramIndex &index, m_indexes)
+			similar += index.similar(source, minSimilarity, maxResults);
+		std::sort(similar.begin(), similar.end(), [](const QPair<int, double> &a, const QPair<int, double> &b){
+			return a.second > b.second || (a.second == b.second && a.first < b.first);
+		});
+	}
+
+	QList<Suggestion> result;
+	for(int i = 0, n = qMin(similar.size(), maxResults); i < n; i++) {
+		const Entry &entry = m_entries.at(similar.at(i).first);
+		result.append({ entry.sourceLanguage, entry.targetLanguage, entry.source, entry.target, similar.at(i).second });
+	}
+	return result;
+}
+
+bool
+TranslationMemory::load(const QString &file)
+{
+	clear();
+	m_modified = false;
+
+	QFile memoryFile(file);
+	if(!memoryFile.open(QIODevice::ReadOnly))
+		return false;
+
+	QDataStream stream(&memoryFile);
+	quint32 magic, version, count;
+	stream >> magic >> version >> count;
+	if(stream.status() != QDataStream::Ok || magic != MEMORY_MAGIC || version != MEMORY_VERSION)
+		return false;
+
+	for(quint32 i = 0; i < count; i++) {
+		Entry entry;
+		stream >> entry.sourceLanguage >> entry.targetLanguage >> entry.source >> entry.target;
+		if(stream.status() != QDataStream::Ok) {
+			clear();
+			m_modified = false;
+			return false;
+		}
+		insert(entry.sourceLanguage, entry.targetLanguage, entry.source, entry.target);
+	}
+
+	m_modified = false;
+	return true;
+}
+
+bool
+TranslationMemory::save(const QString &file)
+{
+	QDir().mkpath(QFileInfo(file).absolutePath());
+
+	// memory of previous sessions is kept if writing fails half way
+	QSaveFile memoryFile(file);
+	if(!memoryFile.open(QIODevice::WriteOnly))
+		return false;
+
+	QDataStream stream(&memoryFile);
+	stream << quint32(MEMORY_MAGIC) << quint32(MEMORY_VERSION) << quint32(m_entries.size());
+	foreach(const Entry &entry, m_entries)
+		stream << entry.sourceLanguage << entry.targetLanguage << entry.source << entry.target;
+
+	if(stream.status() != QDataStream::Ok || !memoryFile.commit())
+		return false;
+
+	m_modified = false;
+	return true;
+}
+
+/*static*/ QString
+TranslationMemory::defaultFile()
+{
+	return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + QStringLiteral("/translationmemory.dat");
+}
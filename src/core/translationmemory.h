@@ -0,0 +1,99 @@
+#ifndef TRANSLATIONMEMORY_H
+#define TRANSLATIONMEMORY_H
+/**
+ * Copyright (C) 2010-2017 Mladen Milinkovic <max@smoothware.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "trigramindex.h"
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QVector>
+
+namespace SubtitleComposer {
+/**
+ * @brief Remembers translations of texts between language pairs.
+ *
+ * Texts are looked up exactly, ignoring differences in whitespace, or by similarity of their
+ * trigrams. Languages are identified by any codes the caller uses consistently.
+ */
+class TranslationMemory
+{
+public:
+	struct Suggestion {
+		QString sourceLanguage;
+		QString targetLanguage;
+		QString source;
+		QString target;
+		double similarity;      // 1.0 for equal texts
+	};
+
+	TranslationMemory();
+
+	inline int size() const { return m_entries.size(); }
+	inline bool isModified() const { return m_modified; }
+
+	inline int maxEntries() const { return m_maxEntries; }
+	/// oldest translations are forgotten once there are more than @p maxEntries of them
+	void setMaxEntries(int maxEntries);
+
+	void clear();
+
+	/// remembers @p target as translation of @p source, replacing previous translation of the same text
+	void insert(const QString &sourceLanguage, const QString &targetLanguage, const QString &source, const QString &target);
+
+	/// translation of @p source, null string if it wasn't translated before
+	QString translation(const QString &sourceLanguage, const QString &targetLanguage, const QString &source) const;
+
+	/**
+	 * @brief suggestions - finds translations of texts similar to @p source
+	 *
+	 * Empty language codes match translations between any languages.
+	 */
+	QList<Suggestion> suggestions(const QString &sourceLanguage, const QString &targetLanguage, const QString &source, double minSimilarity, int maxResults) const;
+
+	bool load(const QString &file);
+	bool save(const QString &file);
+
+	/// file the memory is kept in between sessions
+	static QString defaultFile();
+
+private:
+	struct Entry {
+		QString sourceLanguage;
+		QString targetLanguage;
+		QString source;
+		QString target;
+	};
+
+	void dropOldest(int count);
+
+	static QString languagePair(const QString &sourceLanguage, const QString &targetLanguage);
+	static QString normalized(const QString &text);
+
+private:
+	QVector<Entry> m_entries;               // entry ids are their indexes
+	QHash<QString, int> m_exactIds;         // language pair and normalized source => entry id
+	QHash<QString, TrigramIndex> m_indexes; // language pair => index of sources
+	int m_maxEntries;
+	bool m_modified;
+};
+}
+
+#endif // TRANSLATIONMEMORY_H
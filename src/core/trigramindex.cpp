@@ -0,0 +1,320 @@
+/**
+ * Copyright (C) 2010-2017 Mladen Milinkovic <max@smoothware.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "trigramindex.h"
+
+#include <algorithm>
+#include <cctype>
+
+using namespace SubtitleComposer;
+
+void
+TrigramIndex::clear()
+{
+	m_postings.clear();
+	m_documents.clear();
+}
+
+void
+TrigramIndex::insert(int id, const QString &text)
+{
+	remove(id);
+
+	const QVector<Trigram> documentTrigrams = trigrams(text);
+	foreach(Trigram trigram, documentTrigrams)
+		m_postings[trigram].insert(id);
+	m_documents.insert(id, documentTrigrams);
+}
+
+void
+TrigramIndex::remove(int id)
+{
+	const QVector<Trigram> documentTrigrams = m_documents.take(id);
+	foreach(Trigram trigram, documentTrigrams) {
+		QHash<Trigram, QSet<int> >::Iterator it = m_postings.find(trigram);
+		if(it == m_postings.end())
+			continue;
+		it->remove(id);
+		if(it->isEmpty())
+			m_postings.erase(it);
+	}
+}
+
+QSet<int>
+TrigramIndex::candidates(const QStringList &literals, bool *restricted) const
+{
+	const QVector<Trigram> query = queryTrigrams(literals);
+	*restricted = !query.isEmpty();
+	if(query.isEmpty())
+		return QSet<int>();
+
+	QVector<const QSet<int> *> postings;
+	postings.reserve(query.size());
+	foreach(Trigram trigram, query) {
+		QHash<Trigram, QSet<int> >::ConstIterator it = m_postings.constFind(trigram);
+		if(it == m_postings.constEnd())
+			return QSet<int>();
+		postings.append(&it.value());
+	}
+
+	// intersecting starts with the rarest trigram, result only gets smaller
+	std::sort(postings.begin(), postings.end(), [](const QSet<int> *a, const QSet<int> *b){ return a->size() < b->size(); });
+
+	QSet<int> result = *postings.first();
+	for(int i = 1, n = postings.size(); i < n && !result.isEmpty(); i++)
+		result.intersect(*postings.at(i));
+	return result;
+}
+
+bool
+TrigramIndex::mayContain(int id, const QStringList &literals) const
+{
+	QHash<int, QVector<Trigram> >::ConstIterator doc = m_documents.constFind(id);
+	if(doc == m_documents.constEnd())
+		return true;
+
+	foreach(Trigram trigram, queryTrigrams(literals)) {
+		if(!std::binary_search(doc->constBegin(), doc->constEnd(), trigram))
+			return false;
+	}
+	return true;
+}
+
+QList<QPair<int, double> >
+TrigramIndex::similar(const QString &text, double minSimilarity, int maxResults) const
+{
+	QList<QPair<int, double> > result;
+
+	const QVector<Trigram> query = trigrams(text);
+	if(query.isEmpty())
+		return result;
+
+	QHash<int, int> sharedCounts;
+	foreach(Trigram trigram, query) {
+		QHash<Trigram, QSet<int> >::ConstIterator it = m_postings.constFind(trigram);
+		if(it == m_postings.constEnd())
+			continue;
+		foreach(int id, it.value())
+			sharedCounts[id]++;
+	}
+
+	for(QHash<int, int>::ConstIterator it = sharedCounts.constBegin(), end = sharedCounts.constEnd(); it != end; ++it) {
+		const double similarity = 2.0 * it.value() / (query.size() + m_documents.value(it.key()).size());
+		if(similarity >= minSimilarity)
+			result.append(qMakePair(it.key(), similarity));
+	}
+
+	// equally similar documents are ordered by id, so results don't depend on hashing
+	std::sort(result.begin(), result.end(), [](const QPair<int, double> &a, const QPair<int, double> &b){
+		return a.second > b.second || (a.second == b.second && a.first < b.first);
+	});
+	if(result.size() > maxResults)
+		result.erase(result.begin() + maxResults, result.end());
+	return result;
+}
+
+QVector<TrigramIndex::Trigram>
+TrigramIndex::queryTrigrams(const QStringList &literals) const
+{
+	QVector<Trigram> query;
+	foreach(const QString &literal, literals)
+		query += trigrams(literal);
+	std::sort(query.begin(), query.end());
+	query.erase(std::unique(query.begin(), query.end()), query.end());
+	return query;
+}
+
+/*static*/ QVector<TrigramIndex::Trigram>
+TrigramIndex::trigrams(const QString &text)
+{
+	QVector<Trigram> result;
+
+	const QString folded = text.toCaseFolded();
+	const ushort *chars = folded.utf16();
+	const int n = folded.length() - 2;
+	if(n <= 0)
+		return result;
+
+	result.reserve(n);
+	for(int i = 0; i < n; i++)
+		result.append((Trigram(chars[i]) << 32) | (Trigram(chars[i + 1]) << 16) | Trigram(chars[i + 2]));
+
+	std::sort(result.begin(), result.end());
+	result.erase(std::unique(result.begin(), result.end()), result.end());
+	return result;
+}
+
+/**
+ * @brief escapeEnd - finds the last character of escape sequence
+ * @param i position of the letter or digit following backslash
+ */
+static int
+escapeEnd(const QString &regExp, int i)
+{
+	const int n = regExp.length();
+	const QChar esc = regExp.at(i);
+
+	if(esc.isDigit()) {
+		// octal character or back reference
+		while(i + 1 < n && regExp.at(i + 1).isDigit())
+			i++;
+		return i;
+	}
+
+	switch(esc.toLatin1()) {
+	case 'c':
+		// control character
+		return qMin(i + 1, n - 1);
+	case 'x':
+		if(i + 1 < n && regExp.at(i + 1) == QLatin1Char('{'))
+			break;
+		for(int digits = 0; digits < 2 && i + 1 < n && isxdigit(regExp.at(i + 1).toLatin1()); digits++)
+			i++;
+		return i;
+	case 'g': case 'k': case 'N': case 'o': case 'p': case 'P':
+		break;
+	default:
+		return i;
+	}
+
+	// {code}, {property}, <name>, 'name' or {name}
+	if(i + 1 < n) {
+		const QChar open = regExp.at(i + 1);
+		const QChar close = open == QLatin1Char('{') ? QLatin1Char('}') : (open == QLatin1Char('<') ? QLatin1Char('>') : (open == QLatin1Char('\'') ? open : QChar()));
+		if(!close.isNull()) {
+			const int end = regExp.indexOf(close, i + 2);
+			return end < 0 ? n - 1 : end;
+		}
+	}
+
+	if(esc == QLatin1Char('p') || esc == QLatin1Char('P'))
+		return qMin(i + 1, n - 1);
+
+	if(esc == QLatin1Char('g')) {
+		// relative or absolute group number
+		if(i + 1 < n && (regExp.at(i + 1) == QLatin1Char('-') || regExp.at(i + 1) == QLatin1Char('+')))
+			i++;
+		while(i + 1 < n && regExp.at(i + 1).isDigit())
+			i++;
+	}
+	return i;
+}
+
+/*static*/ QStringList
+TrigramIndex::requiredLiterals(const QString &regExp)
+{
+	QStringList literals;
+	QString run;                    // literal characters that follow each other in every match
+	int depth = 0;
+
+	// shorter literals have no trigrams
+	auto endRun = [&](){
+		if(run.length() >= 3)
+			literals << run;
+		run.clear();
+	};
+
+	const int n = regExp.length();
+	for(int i = 0; i < n; i++) {
+		const QChar ch = regExp.at(i);
+
+		if(ch == QLatin1Char('\\')) {
+			if(++i >= n)
+				break;
+			// escaped punctuation is literal, escaped letters and digits are classes, anchors, references or codes
+			if(regExp.at(i) == QLatin1Char('Q')) {
+				// quoted text is literal up to \E
+				int end = regExp.indexOf(QLatin1String("\\E"), i + 1);
+				if(end < 0)
+					end = n;
+				if(!depth)
+					run.append(regExp.midRef(i + 1, end - i - 1));
+				i = end + 1;
+			} else if(!regExp.at(i).isLetterOrNumber()) {
+				if(!depth)
+					run.append(regExp.at(i));
+			} else {
+				if(!depth)
+					endRun();
+				i = escapeEnd(regExp, i);
+			}
+			continue;
+		}
+
+		if(ch == QLatin1Char('[')) {
+			// skip character class, leading ']' is a literal inside of it
+			i++;
+			if(i < n && regExp.at(i) == QLatin1Char('^'))
+				i++;
+			if(i < n && regExp.at(i) == QLatin1Char(']'))
+				i++;
+			for(; i < n && regExp.at(i) != QLatin1Char(']'); i++) {
+				if(regExp.at(i) == QLatin1Char('\\'))
+					i++;
+			}
+			if(!depth)
+				endRun();
+			continue;
+		}
+
+		if(ch == QLatin1Char('(')) {
+			// extended syntax ignores whitespace, literals can't be taken from the pattern
+			if(i + 1 < n && regExp.at(i + 1) == QLatin1Char('?')) {
+				for(int j = i + 2; j < n && regExp.at(j).isLetter(); j++) {
+					if(regExp.at(j) == QLatin1Char('x'))
+						return QStringList();
+				}
+			}
+			if(!depth++)
+				endRun();
+			continue;
+		}
+
+		if(ch == QLatin1Char(')')) {
+			if(depth)
+				depth--;
+			continue;
+		}
+
+		// groups are optional or alternatives as far as we know
+		if(depth)
+			continue;
+
+		if(ch == QLatin1Char('|'))
+			return QStringList();
+
+		if(ch == QLatin1Char('*') || ch == QLatin1Char('?') || ch == QLatin1Char('{')) {
+			// previous character may be missing
+			run.chop(1);
+			if(ch == QLatin1Char('{')) {
+				while(i < n && regExp.at(i) != QLatin1Char('}'))
+					i++;
+			}
+		} else if(ch != QLatin1Char('+') && ch != QLatin1Char('.') && ch != QLatin1Char('^') && ch != QLatin1Char('$')) {
+			run.append(ch);
+			continue;
+		}
+
+		// previous character may repeat, or any character can follow
+		endRun();
+	}
+	endRun();
+
+	return literals;
+}
@@ -0,0 +1,92 @@
+#ifndef TRIGRAMINDEX_H
+#define TRIGRAMINDEX_H
+/**
+ * Copyright (C) 2010-2017 Mladen Milinkovic <max@smoothware.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+namespace SubtitleComposer {
+/**
+ * @brief Inverted index of case folded character trigrams of documents identified by integer ids.
+ *
+ * A document that contains a string has all trigrams of the string, so ids of documents having
+ * all trigrams of query literals are a superset of documents that contain them. Candidates still
+ * have to be verified by real matching. Literals shorter than three characters don't restrict
+ * the candidates.
+ */
+class TrigramIndex
+{
+public:
+	typedef quint64 Trigram;
+
+	TrigramIndex() {}
+
+	inline int size() const { return m_documents.size(); }
+	inline bool contains(int id) const { return m_documents.contains(id); }
+
+	void clear();
+
+	/// indexes @p text of document @p id, replacing its previous text
+	void insert(int id, const QString &text);
+	void remove(int id);
+
+	/**
+	 * @brief candidates - finds documents which may contain all @p literals
+	 * @param restricted set to false if literals have no trigrams and every document is a candidate
+	 * @return ids of documents having all trigrams of @p literals
+	 */
+	QSet<int> candidates(const QStringList &literals, bool *restricted) const;
+
+	/// false if document @p id can't contain all @p literals, unknown documents may contain anything
+	bool mayContain(int id, const QStringList &literals) const;
+
+	/**
+	 * @brief similar - finds documents sharing most trigrams with @p text
+	 * @return ids and Dice coefficients of their trigrams with trigrams of @p text, which are
+	 *         at least @p minSimilarity, most similar first and at most @p maxResults of them
+	 */
+	QList<QPair<int, double> > similar(const QString &text, double minSimilarity, int maxResults) const;
+
+	/// sorted unique trigrams of case folded @p text
+	static QVector<Trigram> trigrams(const QString &text);
+
+	/**
+	 * @brief requiredLiterals - finds literal strings that every match of a regular expression contains
+	 *
+	 * Only parts of the pattern outside of groups and character classes are used. Result may be
+	 * empty even when the pattern has literals, but never has a literal that a match can lack.
+	 */
+	static QStringList requiredLiterals(const QString &regExp);
+
+private:
+	QVector<Trigram> queryTrigrams(const QStringList &literals) const;
+
+private:
+	QHash<Trigram, QSet<int> > m_postings;
+	QHash<int, QVector<Trigram> > m_documents;
+};
+}
+
+#endif // TRIGRAMINDEX_H
@@ -20,6 +20,7 @@
 #include "textdemux.h"
 
 #include "core/subtitle.h"
+#include "core/subtitleline.h"
 #include "streamprocessor/streamprocessor.h"
 
 #include <KLocalizedString>
@@ -27,6 +28,11 @@
 #include <QLabel>
 #include <QBoxLayout>
 #include <QProgressBar>
+#include <QTimer>
+
+// demuxed lines are inserted in batches of this many lines or after this many milliseconds
+#define INSERT_BATCH_SIZE 500
+#define INSERT_BATCH_INTERVAL 100
 
 using namespace SubtitleComposer;
 
@@ -34,8 +40,13 @@ TextDemux::TextDemux(QWidget *parent)
 	: QObject(parent),
 	  m_subtitle(NULL),
 	  m_streamProcessor(new StreamProcessor(this)),
+	  m_insertTimer(new QTimer(this)),
 	  m_progressWidget(new QWidget(parent))
 {
+	m_insertTimer->setInterval(INSERT_BATCH_INTERVAL);
+	m_insertTimer->setSingleShot(true);
+	connect(m_insertTimer, &QTimer::timeout, this, &TextDemux::insertPendingLines);
+
 	// progress Bar
 	m_progressWidget->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Expanding);
 	m_progressWidget->hide();
@@ -66,6 +77,7 @@ TextDemux::demuxFile(Subtitle *subtitle, const QString filename, int textStreamI
 		return;
 
 	m_streamProcessor->close();
+	insertPendingLines();
 
 	m_subtitle = subtitle;
 
@@ -73,10 +85,40 @@ TextDemux::demuxFile(Subtitle *subtitle, const QString filename, int textStreamI
 		m_streamProcessor->start();
 }
 
+void
+TextDemux::setSubtitle(Subtitle *subtitle)
+{
+	// import into previous subtitle is abandoned, lines waiting for next batch included
+	m_streamProcessor->close();
+	m_insertTimer->stop();
+	qDeleteAll(m_pendingLines);
+	m_pendingLines.clear();
+	m_progressWidget->hide();
+
+	m_subtitle = subtitle;
+}
+
 void
 TextDemux::onStreamData(const QString &text, quint64 msecStart, quint64 msecDuration)
 {
-	m_subtitle->insertLine(new SubtitleLine(SString(text), Time(double(msecStart)), Time(double(msecStart) + double(msecDuration))));
+	m_pendingLines.append(new SubtitleLine(SString(text), Time(double(msecStart)), Time(double(msecStart) + double(msecDuration))));
+
+	if(m_pendingLines.size() >= INSERT_BATCH_SIZE)
+		insertPendingLines();
+	else if(!m_insertTimer->isActive())
+		m_insertTimer->start();
+}
+
+void
+TextDemux::insertPendingLines()
+{
+	m_insertTimer->stop();
+
+	if(m_pendingLines.isEmpty())
+		return;
+
+	m_subtitle->insertLinesSorted(m_pendingLines);
+	m_pendingLines.clear();
 }
 
 void
@@ -95,6 +137,7 @@ TextDemux::onStreamError(int code, const QString &message, const QString &debug)
 				 .arg(message)
 				 .arg(debug));
 	m_streamProcessor->close();
+	insertPendingLines();
 	m_progressWidget->hide();
 }
 
@@ -102,6 +145,7 @@ void
 TextDemux::onStreamFinished()
 {
 	m_streamProcessor->close();
+	insertPendingLines();
 	m_progressWidget->hide();
 }
 
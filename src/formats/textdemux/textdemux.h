@@ -21,12 +21,15 @@
  */
 
 #include <QObject>
+#include <QList>
 
 QT_FORWARD_DECLARE_CLASS(QWidget)
 QT_FORWARD_DECLARE_CLASS(QProgressBar)
+QT_FORWARD_DECLARE_CLASS(QTimer)
 
 namespace SubtitleComposer {
 class Subtitle;
+class SubtitleLine;
 class StreamProcessor;
 
 class TextDemux : public QObject
@@ -40,6 +43,9 @@ public:
 
 	QWidget * progressWidget();
 
+public slots:
+	void setSubtitle(Subtitle *subtitle = NULL);
+
 signals:
 	void onError(const QString &message);
 
@@ -48,11 +54,15 @@ private slots:
 	void onStreamProgress(quint64 msecPos, quint64 msecLength);
 	void onStreamError(int code, const QString &message, const QString &debug);
 	void onStreamFinished();
+	void insertPendingLines();
 
 private:
 	Subtitle *m_subtitle;
 	StreamProcessor *m_streamProcessor;
 
+	QList<SubtitleLine *> m_pendingLines;
+	QTimer *m_insertTimer;
+
 	QWidget *m_progressWidget;
 	QProgressBar *m_progressBar;
 };
@@ -45,10 +45,13 @@
 #define ACT_JOIN_SELECTED_LINES "join_selected_lines"
 #define ACT_SELECT_ALL_LINES "select_all_lines"
 #define ACT_GOTO_LINE "goto_line"
+#define ACT_TOGGLE_LINES_FILTER "toggle_lines_filter"
 #define ACT_FIND "find"
 #define ACT_FIND_NEXT "find_next"
 #define ACT_FIND_PREVIOUS "find_previous"
 #define ACT_REPLACE "replace"
+#define ACT_REPLACE_ALL "replace_all"
+#define ACT_FIND_ALL "find_all"
 #define ACT_RETROCEDE_CURRENT_LINE "retrocede_current_line"
 #define ACT_ADVANCE_CURRENT_LINE "advance_current_line"
 #define ACT_CHECK_ERRORS "check_errors"
@@ -58,6 +61,7 @@
 #define ACT_FIND_NEXT_ERROR "find_next_error"
 #define ACT_FIND_PREVIOUS_ERROR "find_previous_error"
 #define ACT_SPELL_CHECK "spell_check"
+#define ACT_TOGGLE_BACKGROUND_SPELL_CHECK "toggle_background_spell_check"
 #define ACT_TOGGLE_SELECTED_LINES_MARK "toggle_selected_lines_mark"
 #define ACT_TOGGLE_SELECTED_LINES_BOLD "toggle_selected_lines_bold"
 #define ACT_TOGGLE_SELECTED_LINES_ITALIC "toggle_selected_lines_italic"
@@ -75,6 +79,9 @@
 #define ACT_MAXIMIZE_DURATIONS "maximize_durations"
 #define ACT_FIX_OVERLAPPING_LINES "fix_overlapping_lines"
 #define ACT_SYNC_WITH_SUBTITLE "sync_with_subtitle"
+#define ACT_SNAP_TO_SPEECH "snap_to_speech"
+#define ACT_SNAP_TO_FRAMES "snap_to_frames"
+#define ACT_SNAP_TO_SCENE_CUTS "snap_to_scene_cuts"
 #define ACT_ADJUST_TEXTS "adjust_texts"
 #define ACT_UNBREAK_TEXTS "unbreak_texts"
 #define ACT_SIMPLIFY_SPACES "simplify_spaces"
@@ -90,9 +97,12 @@
 #define ACT_PLAY_PAUSE "play_pause"
 #define ACT_SEEK_BACKWARDS "seek_backwards"
 #define ACT_SEEK_FORWARDS "seek_forwards"
+#define ACT_STEP_FRAME_BACKWARDS "step_frame_backwards"
+#define ACT_STEP_FRAME_FORWARDS "step_frame_forwards"
 #define ACT_SEEK_TO_NEXT_LINE "seek_to_next_line"
 #define ACT_SEEK_TO_PREVIOUS_LINE "seek_to_previous_line"
 #define ACT_PLAY_CURRENT_LINE_AND_PAUSE "play_current_line_and_pause"
+#define ACT_LOOP_SELECTED_LINES "loop_selected_lines"
 #define ACT_SET_CURRENT_LINE_SHOW_TIME "set_current_line_show_time"
 #define ACT_SET_CURRENT_LINE_HIDE_TIME "set_current_line_hide_time"
 #define ACT_CURRENT_LINE_FOLLOWS_VIDEO "current_line_follows_video"
@@ -52,10 +52,13 @@
 #include "dialogs/removelinesdialog.h"
 #include "dialogs/intinputdialog.h"
 #include "dialogs/subtitlecolordialog.h"
+#include "dialogs/replacealldialog.h"
+#include "findresultswidget.h"
 #include "utils/finder.h"
 #include "utils/replacer.h"
 #include "utils/errorfinder.h"
 #include "utils/speller.h"
+#include "utils/backgroundspeller.h"
 #include "utils/errortracker.h"
 #include "utils/translator.h"
 #include "scripting/scriptsmanager.h"
@@ -63,9 +66,11 @@
 #include "common/fileloadhelper.h"
 #include "common/filesavehelper.h"
 #include "core/subtitleiterator.h"
+#include "core/translationmemory.h"
 #include "videoplayer/videoplayer.h"
 #include "videoplayer/playerbackend.h"
 #include "widgets/waveformwidget.h"
+#include "streamprocessor/voiceactivitydetector.h"
 #include "profiler.h"
 #include "formats/formatmanager.h"
 #include "formats/textdemux/textdemux.h"
@@ -152,6 +157,20 @@ Application::init()
 	m_errorFinder = new ErrorFinder(m_linesWidget);
 	m_speller = new Speller(m_linesWidget);
 
+	m_backgroundSpeller = new BackgroundSpeller(this);
+	m_backgroundSpeller->setEnabled(SCConfig::backgroundSpellCheck());
+	connect(SCConfig::self(), SIGNAL(configChanged()), m_backgroundSpeller, SLOT(resetSpeller()));
+	m_linesWidget->setBackgroundSpeller(m_backgroundSpeller);
+	m_curLineWidget->setBackgroundSpeller(m_backgroundSpeller);
+
+	m_translationMemory = new TranslationMemory();
+	m_translationMemory->load(TranslationMemory::defaultFile());
+	m_curLineWidget->setTranslationMemory(m_translationMemory);
+
+	m_textIndex = new TextIndex(this);
+	m_finder->setTextIndex(m_textIndex);
+	m_mainWindow->m_findResultsWidget->setTextIndex(m_textIndex);
+
 	m_errorTracker = new ErrorTracker(this);
 
 	m_scriptsManager = new ScriptsManager(this);
@@ -168,10 +187,11 @@ Application::init()
 	connect(m_player, SIGNAL(textStreamsChanged(const QStringList &)), this, SLOT(onPlayerTextStreamsChanged(const QStringList &)));
 	connect(m_player, SIGNAL(activeAudioStreamChanged(int)), this, SLOT(onPlayerActiveAudioStreamChanged(int)));
 	connect(m_player, SIGNAL(muteChanged(bool)), this, SLOT(onPlayerMuteChanged(bool)));
+	connect(m_player, SIGNAL(loopChanged(bool)), this, SLOT(onPlayerLoopChanged(bool)));
 
 	QList<QObject *> listeners;
 	listeners << actionManager << m_mainWindow << m_playerWidget << m_linesWidget
-			  << m_curLineWidget << m_finder << m_replacer << m_errorFinder << m_speller
+			  << m_curLineWidget << m_finder << m_replacer << m_errorFinder << m_speller << m_backgroundSpeller << m_textIndex
 			  << m_errorTracker << m_scriptsManager << m_mainWindow->m_waveformWidget;
 	for(QList<QObject *>::ConstIterator it = listeners.begin(), end = listeners.end(); it != end; ++it) {
 		connect(this, SIGNAL(subtitleOpened(Subtitle *)), *it, SLOT(setSubtitle(Subtitle *)));
@@ -179,7 +199,8 @@ Application::init()
 	}
 
 	listeners.clear();
-	listeners << actionManager << m_playerWidget << m_linesWidget << m_curLineWidget << m_finder << m_replacer << m_errorFinder << m_speller;
+	listeners << actionManager << m_playerWidget << m_linesWidget << m_curLineWidget << m_finder << m_replacer << m_errorFinder << m_speller
+			  << m_mainWindow->m_findResultsWidget;
 	for(QList<QObject *>::ConstIterator it = listeners.begin(), end = listeners.end(); it != end; ++it)
 		connect(this, SIGNAL(translationModeChanged(bool)), *it, SLOT(setTranslationMode(bool)));
 
@@ -196,6 +217,7 @@ Application::init()
 	connect(m_playerWidget, SIGNAL(playingLineChanged(SubtitleLine *)), this, SLOT(onPlayingLineChanged(SubtitleLine *)));
 
 	connect(m_finder, SIGNAL(found(SubtitleLine *, bool, int, int)), this, SLOT(onHighlightLine(SubtitleLine *, bool, int, int)));
+	connect(m_mainWindow->m_findResultsWidget, SIGNAL(found(SubtitleLine *, bool, int, int)), this, SLOT(onHighlightLine(SubtitleLine *, bool, int, int)));
 	connect(m_replacer, SIGNAL(found(SubtitleLine *, bool, int, int)), this, SLOT(onHighlightLine(SubtitleLine *, bool, int, int)));
 	connect(m_errorFinder, SIGNAL(found(SubtitleLine *)), this, SLOT(onHighlightLine(SubtitleLine *)));
 	connect(m_speller, SIGNAL(misspelled(SubtitleLine *, bool, int, int)), this, SLOT(onHighlightLine(SubtitleLine *, bool, int, int)));
@@ -208,6 +230,8 @@ Application::init()
 
 	m_textDemux = new TextDemux(m_mainWindow);
 	connect(m_textDemux, &TextDemux::onError, [&](const QString &message){ KMessageBox::sorry(m_mainWindow, message); });
+	connect(this, SIGNAL(subtitleOpened(Subtitle *)), m_textDemux, SLOT(setSubtitle(Subtitle *)));
+	connect(this, SIGNAL(subtitleClosed()), m_textDemux, SLOT(setSubtitle()));
 	m_mainWindow->statusBar()->addPermanentWidget(m_textDemux->progressWidget());
 
 	m_speechProcessor = new SpeechProcessor(m_mainWindow);
@@ -236,6 +260,7 @@ Application::~Application()
 	// delete m_mainWindow; the window is destroyed when it's closed
 
 	delete m_subtitle;
+	delete m_translationMemory;
 }
 
 Application *
@@ -636,6 +661,14 @@ Application::setupActions()
 	actionCollection->addAction(ACT_GOTO_LINE, gotoLineAction);
 	actionManager->addAction(gotoLineAction, UserAction::SubHasLines);
 
+	KToggleAction *toggleLinesFilterAction = new KToggleAction(actionCollection);
+	toggleLinesFilterAction->setIcon(QIcon::fromTheme("view-filter"));
+	toggleLinesFilterAction->setText(i18n("Filter Lines"));
+	toggleLinesFilterAction->setStatusTip(i18n("Show only lines matching text, errors, marks, times or durations"));
+	connect(toggleLinesFilterAction, SIGNAL(toggled(bool)), m_mainWindow->m_linesFilterBar, SLOT(setActive(bool)));
+	connect(m_mainWindow->m_linesFilterBar, SIGNAL(closeRequested()), toggleLinesFilterAction, SLOT(toggle()));
+	actionCollection->addAction(ACT_TOGGLE_LINES_FILTER, toggleLinesFilterAction);
+
 	QAction *findAction = new QAction(actionCollection);
 	findAction->setIcon(QIcon::fromTheme("edit-find"));
 	findAction->setText(i18n("Find..."));
@@ -671,6 +704,22 @@ Application::setupActions()
 	actionCollection->addAction(ACT_REPLACE, replaceAction);
 	actionManager->addAction(replaceAction, UserAction::SubHasLine | UserAction::FullScreenOff);
 
+	QAction *replaceAllAction = new QAction(actionCollection);
+	replaceAllAction->setText(i18n("Replace All..."));
+	replaceAllAction->setStatusTip(i18n("Replace all occurrences of strings or regular expressions at once"));
+	connect(replaceAllAction, SIGNAL(triggered()), this, SLOT(replaceAll()));
+	actionCollection->addAction(ACT_REPLACE_ALL, replaceAllAction);
+	actionManager->addAction(replaceAllAction, UserAction::SubHasLine | UserAction::FullScreenOff);
+
+	QAction *findAllAction = new QAction(actionCollection);
+	findAllAction->setIcon(QIcon::fromTheme("edit-find"));
+	findAllAction->setText(i18n("Find All..."));
+	findAllAction->setStatusTip(i18n("List all occurrences of strings or regular expressions"));
+	actionCollection->setDefaultShortcut(findAllAction, QKeySequence("Ctrl+Alt+F"));
+	connect(findAllAction, SIGNAL(triggered()), this, SLOT(findAll()));
+	actionCollection->addAction(ACT_FIND_ALL, findAllAction);
+	actionManager->addAction(findAllAction, UserAction::SubHasLine | UserAction::FullScreenOff);
+
 	QAction *retrocedeCurrentLineAction = new QAction(actionCollection);
 	retrocedeCurrentLineAction->setIcon(QIcon::fromTheme("go-down"));
 	retrocedeCurrentLineAction->setText(i18n("Retrocede current line"));
@@ -747,6 +796,13 @@ Application::setupActions()
 	actionCollection->addAction(ACT_SPELL_CHECK, spellCheckAction);
 	actionManager->addAction(spellCheckAction, UserAction::SubHasLine | UserAction::FullScreenOff);
 
+	KToggleAction *backgroundSpellCheckAction = new KToggleAction(actionCollection);
+	backgroundSpellCheckAction->setText(i18n("Highlight Misspelled Words"));
+	backgroundSpellCheckAction->setStatusTip(i18n("Check spelling of all lines in background and underline misspelled words"));
+	backgroundSpellCheckAction->setChecked(SCConfig::backgroundSpellCheck());
+	connect(backgroundSpellCheckAction, SIGNAL(toggled(bool)), this, SLOT(setBackgroundSpellCheck(bool)));
+	actionCollection->addAction(ACT_TOGGLE_BACKGROUND_SPELL_CHECK, backgroundSpellCheckAction);
+
 	QAction *toggleSelectedLinesMarkAction = new QAction(actionCollection);
 	toggleSelectedLinesMarkAction->setText(i18n("Toggle Mark"));
 	toggleSelectedLinesMarkAction->setStatusTip(i18n("Toggle selected lines mark"));
@@ -878,6 +934,27 @@ Application::setupActions()
 	actionCollection->addAction(ACT_SYNC_WITH_SUBTITLE, syncWithSubtitleAction);
 	actionManager->addAction(syncWithSubtitleAction, UserAction::SubHasLine | UserAction::FullScreenOff | UserAction::AnchorsNone);
 
+	QAction *snapToSpeechAction = new QAction(actionCollection);
+	snapToSpeechAction->setText(i18n("Snap to Speech"));
+	snapToSpeechAction->setStatusTip(i18n("Move show and hide times of selected lines to nearest detected speech boundaries"));
+	connect(snapToSpeechAction, &QAction::triggered, this, &Application::snapLinesToSpeech);
+	actionCollection->addAction(ACT_SNAP_TO_SPEECH, snapToSpeechAction);
+	actionManager->addAction(snapToSpeechAction, UserAction::HasSelection | UserAction::FullScreenOff | UserAction::AnchorsNone);
+
+	QAction *snapToFramesAction = new QAction(actionCollection);
+	snapToFramesAction->setText(i18n("Snap to Video Frames"));
+	snapToFramesAction->setStatusTip(i18n("Move show and hide times of selected lines to nearest video frame boundaries"));
+	connect(snapToFramesAction, &QAction::triggered, this, &Application::snapLinesToFrames);
+	actionCollection->addAction(ACT_SNAP_TO_FRAMES, snapToFramesAction);
+	actionManager->addAction(snapToFramesAction, UserAction::HasSelection | UserAction::VideoOpened | UserAction::FullScreenOff | UserAction::AnchorsNone);
+
+	QAction *snapToSceneCutsAction = new QAction(actionCollection);
+	snapToSceneCutsAction->setText(i18n("Snap to Shot Changes"));
+	snapToSceneCutsAction->setStatusTip(i18n("Move show and hide times of selected lines to nearby shot changes"));
+	connect(snapToSceneCutsAction, &QAction::triggered, this, &Application::snapLinesToSceneCuts);
+	actionCollection->addAction(ACT_SNAP_TO_SCENE_CUTS, snapToSceneCutsAction);
+	actionManager->addAction(snapToSceneCutsAction, UserAction::HasSelection | UserAction::VideoOpened | UserAction::FullScreenOff | UserAction::AnchorsNone);
+
 	QAction *breakLinesAction = new QAction(actionCollection);
 	breakLinesAction->setText(i18n("Break Lines..."));
 	breakLinesAction->setStatusTip(i18n("Automatically set line breaks"));
@@ -1009,6 +1086,24 @@ Application::setupActions()
 	actionCollection->addAction(ACT_SEEK_FORWARDS, seekForwardsAction);
 	actionManager->addAction(seekForwardsAction, UserAction::VideoPlaying);
 
+	QAction *stepFrameBackwardsAction = new QAction(actionCollection);
+	stepFrameBackwardsAction->setIcon(QIcon::fromTheme("media-seek-backward"));
+	stepFrameBackwardsAction->setText(i18n("Previous Frame"));
+	stepFrameBackwardsAction->setStatusTip(i18n("Pause and step one video frame backwards"));
+	actionCollection->setDefaultShortcut(stepFrameBackwardsAction, QKeySequence("Alt+Left"));
+	connect(stepFrameBackwardsAction, &QAction::triggered, this, &Application::stepFrameBackwards);
+	actionCollection->addAction(ACT_STEP_FRAME_BACKWARDS, stepFrameBackwardsAction);
+	actionManager->addAction(stepFrameBackwardsAction, UserAction::VideoPlaying);
+
+	QAction *stepFrameForwardsAction = new QAction(actionCollection);
+	stepFrameForwardsAction->setIcon(QIcon::fromTheme("media-seek-forward"));
+	stepFrameForwardsAction->setText(i18n("Next Frame"));
+	stepFrameForwardsAction->setStatusTip(i18n("Pause and step one video frame forwards"));
+	actionCollection->setDefaultShortcut(stepFrameForwardsAction, QKeySequence("Alt+Right"));
+	connect(stepFrameForwardsAction, &QAction::triggered, this, &Application::stepFrameForwards);
+	actionCollection->addAction(ACT_STEP_FRAME_FORWARDS, stepFrameForwardsAction);
+	actionManager->addAction(stepFrameForwardsAction, UserAction::VideoPlaying);
+
 	QAction *seekToPrevLineAction = new QAction(actionCollection);
 	seekToPrevLineAction->setIcon(QIcon::fromTheme("media-skip-backward"));
 	seekToPrevLineAction->setText(i18n("Jump to Previous Line"));
@@ -1042,6 +1137,15 @@ Application::setupActions()
 	actionCollection->addAction(ACT_PLAY_CURRENT_LINE_AND_PAUSE, playCurrentLineAndPauseAction);
 	actionManager->addAction(playCurrentLineAndPauseAction, UserAction::SubHasLine | UserAction::VideoPlaying);
 
+	KToggleAction *loopSelectedLinesAction = new KToggleAction(actionCollection);
+	loopSelectedLinesAction->setIcon(QIcon::fromTheme(QStringLiteral("media-playlist-repeat")));
+	loopSelectedLinesAction->setText(i18n("Loop Selected Lines"));
+	loopSelectedLinesAction->setStatusTip(i18n("Repeat playback from show time of first selected line to hide time of last selected line"));
+	actionCollection->setDefaultShortcut(loopSelectedLinesAction, QKeySequence("Ctrl+Shift+L"));
+	connect(loopSelectedLinesAction, SIGNAL(toggled(bool)), this, SLOT(loopSelectedLines(bool)));
+	actionCollection->addAction(ACT_LOOP_SELECTED_LINES, loopSelectedLinesAction);
+	actionManager->addAction(loopSelectedLinesAction, UserAction::HasSelection | UserAction::VideoPlaying);
+
 	QAction *seekToNextLineAction = new QAction(actionCollection);
 	seekToNextLineAction->setIcon(QIcon::fromTheme("media-skip-forward"));
 	seekToNextLineAction->setText(i18n("Jump to Next Line"));
@@ -2085,12 +2189,55 @@ Application::replace()
 						);
 }
 
+void
+Application::replaceAll()
+{
+	static ReplaceAllDialog *dlg = new ReplaceAllDialog(m_mainWindow);
+
+	const QString text = m_curLineWidget->focusedText();
+	if(!text.isEmpty())
+		dlg->setPattern(text);
+
+	if(dlg->exec() != QDialog::Accepted)
+		return;
+
+	const TextReplacer replacer = dlg->textReplacer();
+	if(!replacer.isValid()) {
+		KMessageBox::sorry(m_mainWindow, replacer.errorString(), i18n("Replace All"));
+		return;
+	}
+
+	const QList<BatchReplacer::Edit> edits = dlg->edits();
+	if(edits.isEmpty()) {
+		KMessageBox::sorry(m_mainWindow, i18n("No instances of '%1' found!", dlg->pattern()), i18n("Replace All"));
+		return;
+	}
+
+	BatchReplacer::apply(*m_subtitle, edits);
+	m_mainWindow->statusBar()->showMessage(i18np("1 replacement done.", "%1 replacements done.", BatchReplacer::replacementsCount(edits)), 5000);
+}
+
+void
+Application::findAll()
+{
+	m_mainWindow->m_findResultsDock->show();
+	m_mainWindow->m_findResultsDock->raise();
+	m_mainWindow->m_findResultsWidget->startSearch(m_curLineWidget->focusedText());
+}
+
 void
 Application::spellCheck()
 {
 	m_speller->spellCheck(m_linesWidget->currentLineIndex());
 }
 
+void
+Application::setBackgroundSpellCheck(bool enabled)
+{
+	SCConfig::setBackgroundSpellCheck(enabled);
+	m_backgroundSpeller->setEnabled(enabled);
+}
+
 void
 Application::findError()
 {
@@ -2391,6 +2538,72 @@ Application::fixOverlappingLines()
 		m_subtitle->fixOverlappingLines(m_linesWidget->targetRanges(dlg->selectedLinesTarget()), dlg->minimumInterval());
 }
 
+void
+Application::snapLinesToSpeech()
+{
+	const VoiceActivityDetector *vad = m_mainWindow->m_waveformWidget->voiceActivityDetector();
+	if(!vad->isReady()) {
+		KMessageBox::sorry(m_mainWindow, i18n("Speech boundaries are not known yet.\nAudio stream has to be loaded in waveform and completely decoded first."));
+		return;
+	}
+
+	const qint32 maxDistance = SCConfig::wfSpeechSnapDistance();
+
+	SubtitleCompositeActionExecutor executor(*m_subtitle, i18n("Snap Lines to Speech"));
+	for(SubtitleIterator it(*m_subtitle, m_linesWidget->selectionRanges()); it.current(); ++it) {
+		SubtitleLine *line = it.current();
+
+		const qint32 show = vad->nearestSpeechStart(line->showTime().toMillis(), maxDistance);
+		const qint32 hide = vad->nearestSpeechEnd(line->hideTime().toMillis(), maxDistance);
+		const Time showTime = show < 0 ? line->showTime() : Time(show);
+		const Time hideTime = hide < 0 ? line->hideTime() : Time(hide);
+
+		if(showTime < hideTime && (showTime != line->showTime() || hideTime != line->hideTime()))
+			line->setTimes(showTime, hideTime);
+	}
+}
+
+void
+Application::snapLinesToFrames()
+{
+	SubtitleCompositeActionExecutor executor(*m_subtitle, i18n("Snap Lines to Video Frames"));
+	for(SubtitleIterator it(*m_subtitle, m_linesWidget->selectionRanges()); it.current(); ++it) {
+		SubtitleLine *line = it.current();
+
+		const Time showTime(m_player->snapToFrame(line->showTime().toSeconds()) * 1000.);
+		const Time hideTime(m_player->snapToFrame(line->hideTime().toSeconds()) * 1000.);
+
+		if(showTime < hideTime && (showTime != line->showTime() || hideTime != line->hideTime()))
+			line->setTimes(showTime, hideTime);
+	}
+}
+
+void
+Application::snapLinesToSceneCuts()
+{
+	if(m_player->sceneCuts().isEmpty()) {
+		KMessageBox::sorry(m_mainWindow, i18n("Shot changes are not known yet.\nVideo is analyzed in background after it is opened."));
+		return;
+	}
+
+	const double frameDuration = m_player->framesPerSecond() > 0. ? 1. / m_player->framesPerSecond() : .04;
+	// half a frame of tolerance for times that are not exactly on frame boundaries
+	const double maxDistance = (SCConfig::wfSceneCutSnapFrames() + .5) * frameDuration;
+
+	SubtitleCompositeActionExecutor executor(*m_subtitle, i18n("Snap Lines to Shot Changes"));
+	for(SubtitleIterator it(*m_subtitle, m_linesWidget->selectionRanges()); it.current(); ++it) {
+		SubtitleLine *line = it.current();
+
+		const double show = m_player->nearestSceneCut(line->showTime().toSeconds(), maxDistance);
+		const double hide = m_player->nearestSceneCut(line->hideTime().toSeconds(), maxDistance);
+		const Time showTime = show < 0. ? line->showTime() : Time(show * 1000.);
+		const Time hideTime = hide < 0. ? line->hideTime() : Time(hide * 1000.);
+
+		if(showTime < hideTime && (showTime != line->showTime() || hideTime != line->hideTime()))
+			line->setTimes(showTime, hideTime);
+	}
+}
+
 void
 Application::syncWithSubtitle()
 {
@@ -2487,61 +2700,106 @@ Application::fixPunctuation()
 bool
 Application::applyTranslation(RangeList ranges, bool primary, int inputLanguage, int outputLanguage, int textTargets)
 {
-	Translator translator;
+	const QString inputLanguageCode = Language::code((Language::Value)inputLanguage);
+	const QString outputLanguageCode = Language::code((Language::Value)outputLanguage);
 
-	QString inputLanguageName = Language::name((Language::Value)inputLanguage);
-	QString outputLanguageName = Language::name((Language::Value)outputLanguage);
+	// translation memory suggestions are taken from the same language pair
+	SCConfig::setTranslationInputLanguage(inputLanguageCode);
+	SCConfig::setTranslationOutputLanguage(outputLanguageCode);
+	SCConfig::self()->save();
 
-	ProgressDialog progressDialog(i18n("Translate"), i18n("Translating text (%1 to %2)...", inputLanguageName, outputLanguageName), true, m_mainWindow);
-
-	if(textTargets == SubtitleLine::Both) {
-		progressDialog.setDescription(primary
-									  ? i18n("Translating primary text (%1 to %2)...", inputLanguageName, outputLanguageName)
-									  : i18n("Translating secondary text (%1 to %2)...", inputLanguageName, outputLanguageName));
-	}
+	// texts translated before are taken from translation memory, only the rest is sent to translator
+	QList<SubtitleLine *> lines;
+	QStringList sourceTexts;
+	QStringList translatedTexts;
+	int untranslatedCount = 0;
 
 	QString inputText;
 	QRegExp dialogCueRegExp2("-([^-])");
 	for(SubtitleIterator it(*m_subtitle, ranges); it.current(); ++it) {
-		QString lineText = it.current()->primaryText().richString();
+		const QString sourceText = (primary ? it.current()->primaryText() : it.current()->secondaryText()).richString();
+		lines.append(it.current());
+		sourceTexts.append(sourceText);
+		translatedTexts.append(m_translationMemory->translation(inputLanguageCode, outputLanguageCode, sourceText));
+		if(!translatedTexts.last().isNull())
+			continue;
+
+		QString lineText = sourceText;
 		lineText.replace('\n', ' ').replace("--", "---").replace(dialogCueRegExp2, "- \\1");
 		inputText += lineText + "\n()() ";
+		untranslatedCount++;
 	}
 
-	translator.syncTranslate(inputText, (Language::Value)inputLanguage, (Language::Value)outputLanguage, &progressDialog);
+	QString errorMessage;
+
+	if(untranslatedCount) {
+		Translator translator;
+		translator.setEndpoint(QUrl(SCConfig::translationEndpoint()));
+		translator.setMaxChunksInFlight(SCConfig::translationParallelChunks());
 
-	if(translator.isAborted())
-		return false; // ended with error
+		QString inputLanguageName = Language::name((Language::Value)inputLanguage);
+		QString outputLanguageName = Language::name((Language::Value)outputLanguage);
 
-	QStringList outputLines;
-	QString errorMessage;
+		ProgressDialog progressDialog(i18n("Translate"), i18n("Translating text (%1 to %2)...", inputLanguageName, outputLanguageName), true, m_mainWindow);
 
-	if(translator.isFinishedWithError()) {
-		errorMessage = translator.errorMessage();
-	} else {
-		outputLines = translator.outputText().split(QRegExp("\\s*\n\\(\\) ?\\(\\)\\s*"));
+		if(textTargets == SubtitleLine::Both) {
+			progressDialog.setDescription(primary
+										  ? i18n("Translating primary text (%1 to %2)...", inputLanguageName, outputLanguageName)
+										  : i18n("Translating secondary text (%1 to %2)...", inputLanguageName, outputLanguageName));
+		}
+
+		translator.syncTranslate(inputText, (Language::Value)inputLanguage, (Language::Value)outputLanguage, &progressDialog);
+
+		if(translator.isAborted())
+			return false; // ended with error
+
+		QStringList outputLines;
 
-//		qDebug() << translator.inputText();
-//		qDebug() << translator.outputText();
+		if(translator.isFinishedWithError()) {
+			errorMessage = translator.errorMessage();
+		} else {
+			outputLines = translator.outputText().split(QRegExp("\\s*\n\\(\\) ?\\(\\)\\s*"));
+
+//			qDebug() << translator.inputText();
+//			qDebug() << translator.outputText();
+
+			if(outputLines.count() != untranslatedCount + 1)
+				errorMessage = i18n("Unable to perform texts synchronization (sent and received lines count do not match).");
+		}
+
+		if(errorMessage.isEmpty()) {
+			int index = -1;
+			QRegExp ellipsisRegExp("\\s+\\.\\.\\.");
+			QRegExp dialogCueRegExp("(^| )- ");
+			for(int i = 0, n = translatedTexts.size(); i < n; i++) {
+				if(!translatedTexts.at(i).isNull())
+					continue;
+
+				QString line = outputLines.at(++index);
+				line.replace(" ---", "--");
+				line.replace(ellipsisRegExp, "...");
+				line.replace(dialogCueRegExp, "\n-");
+				SString text;
+				text.setRichString(line);
+				translatedTexts[i] = text.trimmed().richString();
+				m_translationMemory->insert(inputLanguageCode, outputLanguageCode, sourceTexts.at(i), translatedTexts.at(i));
+			}
 
-		if(outputLines.count() != ranges.indexesCount() + 1)
-			errorMessage = i18n("Unable to perform texts synchronization (sent and received lines count do not match).");
+			if(m_translationMemory->isModified())
+				m_translationMemory->save(TranslationMemory::defaultFile());
+		}
 	}
 
 	if(errorMessage.isEmpty()) {
 		SubtitleCompositeActionExecutor executor(*m_subtitle, primary ? i18n("Translate Primary Text") : i18n("Translate Secondary Text"));
 
-		int index = -1;
-		QRegExp ellipsisRegExp("\\s+\\.\\.\\.");
-		QRegExp dialogCueRegExp("(^| )- ");
-		for(SubtitleIterator it(*m_subtitle, ranges); it.current(); ++it) {
-			QString line = outputLines.at(++index);
-			line.replace(" ---", "--");
-			line.replace(ellipsisRegExp, "...");
-			line.replace(dialogCueRegExp, "\n-");
+		for(int i = 0, n = lines.size(); i < n; i++) {
 			SString text;
-			text.setRichString(line);
-			it.current()->setPrimaryText(text.trimmed());
+			text.setRichString(translatedTexts.at(i));
+			if(primary)
+				lines.at(i)->setPrimaryText(text);
+			else
+				lines.at(i)->setSecondaryText(text);
 		}
 	} else {
 		KMessageBox::sorry(m_mainWindow, i18n("There was an error performing the translation:\n\n%1", errorMessage));
@@ -2628,6 +2886,20 @@ Application::seekForwards()
 	m_player->seek(position <= m_player->length() ? position : m_player->length(), false);
 }
 
+void
+Application::stepFrameBackwards()
+{
+	m_playerWidget->pauseAfterPlayingLine(nullptr);
+	m_player->step(-1);
+}
+
+void
+Application::stepFrameForwards()
+{
+	m_playerWidget->pauseAfterPlayingLine(nullptr);
+	m_player->step(1);
+}
+
 void
 Application::seekToPrevLine()
 {
@@ -2661,6 +2933,23 @@ Application::playOnlyCurrentLine()
 	}
 }
 
+void
+Application::loopSelectedLines(bool loop)
+{
+	if(!loop) {
+		m_player->clearLoop();
+		return;
+	}
+
+	const int firstIndex = m_linesWidget->firstSelectedIndex();
+	const int lastIndex = m_linesWidget->lastSelectedIndex();
+	const SubtitleLine *firstLine = firstIndex < 0 ? Q_NULLPTR : m_subtitle->line(firstIndex);
+	const SubtitleLine *lastLine = lastIndex < 0 ? Q_NULLPTR : m_subtitle->line(lastIndex);
+	m_playerWidget->pauseAfterPlayingLine(nullptr);
+	if(!firstLine || !lastLine || !m_player->setLoop(firstLine->showTime().toSeconds(), lastLine->hideTime().toSeconds()))
+		((KToggleAction *)action(ACT_LOOP_SELECTED_LINES))->setChecked(false);
+}
+
 void
 Application::seekToNextLine()
 {
@@ -3042,6 +3331,14 @@ Application::onPlayerMuteChanged(bool muted)
 	toggleMutedAction->setChecked(muted);
 }
 
+void
+Application::onPlayerLoopChanged(bool looping)
+{
+	// loop is also cleared by seeking outside of it or stopping the player
+	KToggleAction *loopSelectedLinesAction = (KToggleAction *)action(ACT_LOOP_SELECTED_LINES);
+	loopSelectedLinesAction->setChecked(looping);
+}
+
 void
 Application::updateActionTexts()
 {
@@ -59,6 +59,9 @@ class Finder;
 class Replacer;
 class ErrorFinder;
 class Speller;
+class BackgroundSpeller;
+class TextIndex;
+class TranslationMemory;
 class ErrorTracker;
 
 class ScriptsManager;
@@ -144,8 +147,11 @@ public slots:
 	void findNext();
 	void findPrevious();
 	void replace();
+	void replaceAll();
+	void findAll();
 
 	void spellCheck();
+	void setBackgroundSpellCheck(bool enabled);
 
 	void findError();
 	void findNextError();
@@ -182,6 +188,9 @@ public slots:
 	void setAutoDurations();
 	void maximizeDurations();
 	void fixOverlappingLines();
+	void snapLinesToSpeech();
+	void snapLinesToFrames();
+	void snapLinesToSceneCuts();
 	void syncWithSubtitle();
 
 	void breakLines();
@@ -199,7 +208,10 @@ public slots:
 
 	void seekBackwards();
 	void seekForwards();
+	void stepFrameBackwards();
+	void stepFrameForwards();
 	void playOnlyCurrentLine();
+	void loopSelectedLines(bool loop);
 	void seekToPrevLine();
 	void seekToNextLine();
 
@@ -264,6 +276,7 @@ private slots:
 	void onPlayerAudioStreamsChanged(const QStringList &audioStreams);
 	void onPlayerActiveAudioStreamChanged(int audioStream);
 	void onPlayerMuteChanged(bool muted);
+	void onPlayerLoopChanged(bool looping);
 
 	void onConfigChanged();
 
@@ -309,6 +322,9 @@ private:
 	Replacer *m_replacer;
 	ErrorFinder *m_errorFinder;
 	Speller *m_speller;
+	BackgroundSpeller *m_backgroundSpeller;
+	TextIndex *m_textIndex;
+	TranslationMemory *m_translationMemory;
 
 	ErrorTracker *m_errorTracker;
 
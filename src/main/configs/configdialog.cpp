@@ -74,8 +74,12 @@ ConfigDialog::ConfigDialog(QWidget *parent, const QString &name, KCoreConfigSkel
 	item->setIcon(QIcon::fromTheme(QStringLiteral("mediaplayer")));
 
 	// Backend pages
+	// loads plugins of backends that weren't used yet
 	for(const QString backendName : VideoPlayer::instance()->backendNames()) {
-		if(QWidget *configWidget = VideoPlayer::instance()->backend(backendName)->newConfigWidget(nullptr)) {
+		PlayerBackend *backend = VideoPlayer::instance()->backend(backendName);
+		if(!backend)
+			continue;
+		if(QWidget *configWidget = backend->newConfigWidget(nullptr)) {
 			item = addPage(configWidget, backendName);
 			item->setHeader(i18nc("@title Video player backend settings", "%1 backend settings", backendName));
 			item->setIcon(QIcon::fromTheme(backendName.toLower()));
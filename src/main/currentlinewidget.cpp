@@ -23,10 +23,15 @@
 #include "actions/useractionnames.h"
 #include "../widgets/timeedit.h"
 #include "../widgets/simplerichtextedit.h"
+#include "../core/translationmemory.h"
 
+#include <QApplication>
 #include <QTimer>
 #include <QLabel>
 #include <QToolButton>
+#include <QMenu>
+#include <QTextCursor>
+#include <QTextDocument>
 #include <QGroupBox>
 #include <QGridLayout>
 #include <QKeyEvent>
@@ -36,6 +41,14 @@
 #include <KConfigGroup>
 #include <KLocalizedString>
 
+// milliseconds of typing inactivity after which edited text is written to current line
+#define COMMIT_DELAY 500
+// milliseconds primary text has to stay unchanged before translations of similar texts are looked up
+#define SUGGESTIONS_DELAY 250
+// least similarity of remembered text to current one for its translation to be offered
+#define MIN_SUGGESTION_SIMILARITY 0.5
+#define MAX_SUGGESTIONS 8
+
 using namespace SubtitleComposer;
 
 QToolButton *
@@ -60,6 +73,9 @@ CurrentLineWidget::CurrentLineWidget(QWidget *parent) :
 	m_translationMode(false),
 	m_updateCurrentLine(true),
 	m_updateControls(true),
+	m_commitTimer(new QTimer(this)),
+	m_translationMemory(NULL),
+	m_suggestionsTimer(new QTimer(this)),
 	m_updateShorcutsTimer(new QTimer(this))
 {
 	QGroupBox *timesControlsGroupBox = new QGroupBox(this);
@@ -89,7 +105,6 @@ CurrentLineWidget::CurrentLineWidget(QWidget *parent) :
 
 		m_textEdits[index] = new SimpleRichTextEdit(this);
 		m_textEdits[index]->setTabChangesFocus(true);
-		m_textEdits[index]->installEventFilter(this);
 
 		m_boldButtons[index] = createToolButton(i18n("Toggle Bold"), "format-text-bold", m_textEdits[index], SLOT(toggleFontBold()));
 		m_italicButtons[index] = createToolButton(i18n("Toggle Italic"), "format-text-italic", m_textEdits[index], SLOT(toggleFontItalic()));
@@ -106,6 +121,27 @@ CurrentLineWidget::CurrentLineWidget(QWidget *parent) :
 		buttonsLayouts[index]->addWidget(m_textColorButtons[index], 0, 4, Qt::AlignBottom);
 	}
 
+	m_suggestionsButton = createToolButton(i18n("Translation Memory Suggestions"), "tools-wizard", this, SLOT(updateSuggestions()), false);
+	m_suggestionsButton->setPopupMode(QToolButton::InstantPopup);
+	m_suggestionsButton->setMenu(new QMenu(m_suggestionsButton));
+	m_suggestionsButton->setEnabled(false);
+	buttonsLayouts[1]->addWidget(m_suggestionsButton, 0, 5, Qt::AlignBottom);
+	connect(m_suggestionsButton->menu(), &QMenu::triggered, this, &CurrentLineWidget::onSuggestionTriggered);
+
+	m_textEdited[0] = m_textEdited[1] = false;
+
+	// subtitle is changed once per word or pause in typing, not on every key press
+	m_commitTimer->setInterval(COMMIT_DELAY);
+	m_commitTimer->setSingleShot(true);
+	connect(m_commitTimer, SIGNAL(timeout()), this, SLOT(commitEditedText()));
+
+	// events of text edits and everything that can trigger an action go through eventFilter()
+	qApp->installEventFilter(this);
+
+	m_suggestionsTimer->setInterval(SUGGESTIONS_DELAY);
+	m_suggestionsTimer->setSingleShot(true);
+	connect(m_suggestionsTimer, SIGNAL(timeout()), this, SLOT(updateSuggestions()));
+
 	QFont font = m_textLabels[0]->font();
 	font.setPointSize(font.pointSize() - 1);
 	m_textLabels[0]->setFont(font);
@@ -211,6 +247,8 @@ CurrentLineWidget::setSubtitle(Subtitle *subtitle)
 void
 CurrentLineWidget::setCurrentLine(SubtitleLine *line)
 {
+	commitEditedText();
+
 	if(m_currentLine) {
 		disconnect(m_currentLine, SIGNAL(primaryTextChanged(const SString &)), this, SLOT(onLinePrimaryTextChanged(const SString &)));
 		disconnect(m_currentLine, SIGNAL(secondaryTextChanged(const SString &)), this, SLOT(onLineSecondaryTextChanged(const SString &)));
@@ -219,6 +257,7 @@ CurrentLineWidget::setCurrentLine(SubtitleLine *line)
 	}
 
 	m_currentLine = line;
+	m_suggestionsTimer->start();
 
 	if(m_currentLine) {
 		connect(m_currentLine, SIGNAL(primaryTextChanged(const SString &)), this, SLOT(onLinePrimaryTextChanged(const SString &)));
@@ -268,6 +307,7 @@ CurrentLineWidget::setTranslationMode(bool enabled)
 		m_underlineButtons[1]->show();
 		m_strikeThroughButtons[1]->show();
 		m_textColorButtons[1]->show();
+		m_suggestionsButton->show();
 
 		m_mainLayout->setColumnMinimumWidth(4, 5);
 		m_mainLayout->setColumnStretch(5, 1);
@@ -280,6 +320,7 @@ CurrentLineWidget::setTranslationMode(bool enabled)
 		m_underlineButtons[1]->hide();
 		m_strikeThroughButtons[1]->hide();
 		m_textColorButtons[1]->hide();
+		m_suggestionsButton->hide();
 
 		m_mainLayout->setColumnMinimumWidth(4, 0);
 		m_mainLayout->setColumnStretch(5, 0);
@@ -309,29 +350,51 @@ CurrentLineWidget::onSecondaryTextEditSelectionChanged()
 void
 CurrentLineWidget::onPrimaryTextEditChanged()
 {
-	if(m_updateCurrentLine) {
-		m_updateControls = false;
+	if(m_updateCurrentLine)
+		onTextEdited(0);
+}
 
-		SString text(m_textEdits[0]->richText());
-		m_currentLine->setPrimaryText(text);
-		m_textLabels[0]->setText(buildTextDescription(text.string()));
+void
+CurrentLineWidget::onSecondaryTextEditChanged()
+{
+	if(m_updateCurrentLine)
+		onTextEdited(1);
+}
 
-		m_updateControls = true;
-	}
+void
+CurrentLineWidget::onTextEdited(int index)
+{
+	m_textEdited[index] = true;
+	m_textLabels[index]->setText(buildTextDescription(m_textEdits[index]->toPlainText()));
+
+	// finished words are committed right away, the rest once typing pauses
+	const QTextCursor cursor = m_textEdits[index]->textCursor();
+	if(cursor.position() > 0 && !m_textEdits[index]->document()->characterAt(cursor.position() - 1).isLetterOrNumber())
+		commitEditedText();
+	else
+		m_commitTimer->start();
 }
 
 void
-CurrentLineWidget::onSecondaryTextEditChanged()
+CurrentLineWidget::commitEditedText()
 {
-	if(m_updateCurrentLine) {
+	m_commitTimer->stop();
+
+	if(m_currentLine && (m_textEdited[0] || m_textEdited[1])) {
 		m_updateControls = false;
 
-		SString text(m_textEdits[1]->richText());
-		m_currentLine->setSecondaryText(text);
-		m_textLabels[1]->setText(buildTextDescription(text.string()));
+		// consecutive commits are merged into one undoable action by the action manager
+		if(m_textEdited[0] && m_textEdited[1])
+			m_currentLine->setTexts(m_textEdits[0]->richText(), m_textEdits[1]->richText());
+		else if(m_textEdited[0])
+			m_currentLine->setPrimaryText(m_textEdits[0]->richText());
+		else
+			m_currentLine->setSecondaryText(m_textEdits[1]->richText());
 
 		m_updateControls = true;
 	}
+
+	m_textEdited[0] = m_textEdited[1] = false;
 }
 
 void
@@ -406,7 +469,11 @@ CurrentLineWidget::onLineAnchorChanged(const SubtitleLine *line, bool anchored)
 void
 CurrentLineWidget::onLinePrimaryTextChanged(const SString &primaryText)
 {
+	m_suggestionsTimer->start();
+
 	if(m_updateControls) {
+		// text changed elsewhere replaces whatever was typed since last commit
+		m_textEdited[0] = false;
 		m_updateCurrentLine = false;
 
 		m_textLabels[0]->setText(buildTextDescription(primaryText.string()));
@@ -422,6 +489,7 @@ void
 CurrentLineWidget::onLineSecondaryTextChanged(const SString &secondaryText)
 {
 	if(m_updateControls && m_translationMode) {
+		m_textEdited[1] = false;
 		m_updateCurrentLine = false;
 
 		m_textLabels[1]->setText(buildTextDescription(secondaryText.string()));
@@ -471,6 +539,55 @@ CurrentLineWidget::highlightSecondary(int startIndex, int endIndex)
 	m_textEdits[1]->setFocus();
 }
 
+void
+CurrentLineWidget::setBackgroundSpeller(BackgroundSpeller *speller)
+{
+	m_textEdits[0]->setBackgroundSpeller(speller);
+	m_textEdits[1]->setBackgroundSpeller(speller);
+}
+
+void
+CurrentLineWidget::setTranslationMemory(TranslationMemory *memory)
+{
+	m_translationMemory = memory;
+	m_suggestionsTimer->start();
+}
+
+void
+CurrentLineWidget::updateSuggestions()
+{
+	m_suggestionsTimer->stop();
+
+	QMenu *menu = m_suggestionsButton->menu();
+	menu->clear();
+
+	if(m_translationMode && m_currentLine && m_translationMemory) {
+		// until something is translated, suggestions of any language pair are shown
+		const QList<TranslationMemory::Suggestion> suggestions = m_translationMemory->suggestions(
+			SCConfig::translationInputLanguage(), SCConfig::translationOutputLanguage(),
+			m_currentLine->primaryText().richString(), MIN_SUGGESTION_SIMILARITY, MAX_SUGGESTIONS);
+		foreach(const TranslationMemory::Suggestion &suggestion, suggestions) {
+			SString target;
+			target.setRichString(suggestion.target);
+			QAction *action = menu->addAction(i18n("%1% - %2", qRound(suggestion.similarity * 100), target.string().replace('\n', '|')));
+			action->setData(suggestion.target);
+		}
+	}
+
+	m_suggestionsButton->setEnabled(!menu->isEmpty());
+}
+
+void
+CurrentLineWidget::onSuggestionTriggered(QAction *action)
+{
+	if(!m_currentLine)
+		return;
+
+	SString text;
+	text.setRichString(action->data().toString());
+	m_currentLine->setSecondaryText(text);
+}
+
 void
 CurrentLineWidget::setupActions()
 {
@@ -536,7 +653,30 @@ CurrentLineWidget::updateShortcuts()
 bool
 CurrentLineWidget::eventFilter(QObject *object, QEvent *event)
 {
+	// pending text is committed before actions, dialogs or closing get to the subtitle
+	if(m_textEdited[0] || m_textEdited[1]) {
+		switch(event->type()) {
+		case QEvent::MouseButtonPress:
+		case QEvent::MouseButtonDblClick:
+			if(object->isWidgetType() && !m_textEdits[0]->isAncestorOf(static_cast<QWidget *>(object)) && !m_textEdits[1]->isAncestorOf(static_cast<QWidget *>(object)))
+				commitEditedText();
+			break;
+
+		case QEvent::Shortcut:
+		case QEvent::Close:
+		case QEvent::Drop:
+			commitEditedText();
+			break;
+
+		default:
+			break;
+		}
+	}
+
 	if(object == m_textEdits[0] || object == m_textEdits[1]) {
+		if(event->type() == QEvent::FocusOut)
+			commitEditedText();
+
 		if(event->type() == QEvent::KeyPress) {
 			// NOTE: for some reason, application actions are not triggered when the text edits
 			// have the focus so we have to intercept the event and handle issue ourselves.
@@ -574,6 +714,8 @@ CurrentLineWidget::eventFilter(QObject *object, QEvent *event)
 					return QWidget::eventFilter(object, event);
 			}
 
+			// application actions work with the subtitle, it has to have all typed text
+			commitEditedText();
 			return app()->triggerAction(keySequence);
 		}
 	}
@@ -30,10 +30,14 @@ QT_FORWARD_DECLARE_CLASS(QTimer)
 QT_FORWARD_DECLARE_CLASS(QGridLayout)
 QT_FORWARD_DECLARE_CLASS(QLabel)
 QT_FORWARD_DECLARE_CLASS(QToolButton)
+QT_FORWARD_DECLARE_CLASS(QAction)
 class TimeEdit;
 class SimpleRichTextEdit;
 
 namespace SubtitleComposer {
+class BackgroundSpeller;
+class TranslationMemory;
+
 class CurrentLineWidget : public QWidget
 {
 	Q_OBJECT
@@ -49,6 +53,10 @@ public:
 
 	void setupActions();
 
+	void setBackgroundSpeller(BackgroundSpeller *speller);
+	/// translations of similar texts are offered for current line in translation mode
+	void setTranslationMemory(TranslationMemory *memory);
+
 	virtual bool eventFilter(QObject *object, QEvent *event);
 
 public slots:
@@ -60,6 +68,9 @@ public slots:
 	void highlightPrimary(int startIndex, int endIndex);
 	void highlightSecondary(int startIndex, int endIndex);
 
+	/// writes text typed since last commit to current line
+	void commitEditedText();
+
 protected slots:
 	void onPrimaryTextEditSelectionChanged();
 	void onSecondaryTextEditSelectionChanged();
@@ -82,9 +93,14 @@ protected slots:
 	void markUpdateShortcuts();
 	void updateShortcuts();
 
+	void updateSuggestions();
+	void onSuggestionTriggered(QAction *action);
+
 private:
 	QToolButton * createToolButton(const QString &text, const char *icon, QObject *receiver, const char *slot, bool checkable = true);
 
+	void onTextEdited(int index);
+
 	QString buildTextDescription(const QString &text);
 
 protected:
@@ -95,6 +111,9 @@ protected:
 	bool m_updateCurrentLine;
 	bool m_updateControls;
 
+	bool m_textEdited[2];           // text edit has changes not committed to current line yet
+	QTimer *m_commitTimer;
+
 	TimeEdit *m_showTimeEdit;
 	TimeEdit *m_hideTimeEdit;
 	TimeEdit *m_durationTimeEdit;
@@ -106,6 +125,10 @@ protected:
 	QToolButton *m_underlineButtons[2];
 	QToolButton *m_strikeThroughButtons[2];
 	QToolButton *m_textColorButtons[2];
+	QToolButton *m_suggestionsButton;
+
+	TranslationMemory *m_translationMemory;
+	QTimer *m_suggestionsTimer;
 
 	QGridLayout *m_mainLayout;
 
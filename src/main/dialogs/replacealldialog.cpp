@@ -0,0 +1,180 @@
+/**
+ * Copyright (C) 2010-2017 Mladen Milinkovic <max@smoothware.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "replacealldialog.h"
+#include "../application.h"
+#include "../lineswidget.h"
+
+#include <QButtonGroup>
+#include <QCheckBox>
+#include <QGridLayout>
+#include <QGroupBox>
+#include <QHeaderView>
+#include <QLabel>
+#include <QLineEdit>
+#include <QPushButton>
+#include <QTreeWidget>
+
+// preview lists only this many changed texts, replacement counts include all of them
+#define MAX_PREVIEW_EDITS 1000
+
+using namespace SubtitleComposer;
+
+ReplaceAllDialog::ReplaceAllDialog(QWidget *parent) :
+	ActionWithTargetDialog(i18n("Replace All"), parent),
+	m_editsValid(false)
+{
+	QGroupBox *replaceGroupBox = createGroupBox(i18nc("@title:group", "Replace"));
+
+	m_patternEdit = new QLineEdit(replaceGroupBox);
+	m_replacementEdit = new QLineEdit(replaceGroupBox);
+	m_replacementEdit->setToolTip(i18n("With regular expressions \\0 to \\9 insert captured text and \\n a line break"));
+
+	m_regExpCheckBox = new QCheckBox(i18n("Regular expression"), replaceGroupBox);
+	m_caseSensitiveCheckBox = new QCheckBox(i18n("Case sensitive"), replaceGroupBox);
+	m_wholeWordsCheckBox = new QCheckBox(i18n("Whole words only"), replaceGroupBox);
+
+	QGridLayout *replaceLayout = createLayout(replaceGroupBox);
+	replaceLayout->addWidget(new QLabel(i18n("Text to find:"), replaceGroupBox), 0, 0, Qt::AlignRight | Qt::AlignVCenter);
+	replaceLayout->addWidget(m_patternEdit, 0, 1, 1, 3);
+	replaceLayout->addWidget(new QLabel(i18n("Replacement text:"), replaceGroupBox), 1, 0, Qt::AlignRight | Qt::AlignVCenter);
+	replaceLayout->addWidget(m_replacementEdit, 1, 1, 1, 3);
+	replaceLayout->addWidget(m_regExpCheckBox, 2, 1);
+	replaceLayout->addWidget(m_caseSensitiveCheckBox, 2, 2);
+	replaceLayout->addWidget(m_wholeWordsCheckBox, 2, 3);
+
+	createLineTargetsButtonGroup();
+	createTextTargetsButtonGroup();
+
+	QGroupBox *previewGroupBox = createGroupBox(i18nc("@title:group", "Preview"));
+
+	QPushButton *previewButton = new QPushButton(i18n("Preview"), previewGroupBox);
+	m_previewLabel = new QLabel(previewGroupBox);
+
+	m_previewTree = new QTreeWidget(previewGroupBox);
+	m_previewTree->setRootIsDecorated(false);
+	m_previewTree->setUniformRowHeights(true);
+	m_previewTree->setHeaderLabels(QStringList() << i18n("Line") << i18n("Text") << i18n("Replaced Text"));
+	m_previewTree->header()->setSectionResizeMode(0, QHeaderView::ResizeToContents);
+	m_previewTree->setMinimumHeight(150);
+
+	QGridLayout *previewLayout = createLayout(previewGroupBox);
+	previewLayout->addWidget(previewButton, 0, 0);
+	previewLayout->addWidget(m_previewLabel, 0, 1);
+	previewLayout->addWidget(m_previewTree, 1, 0, 1, 2);
+	previewLayout->setColumnStretch(1, 1);
+
+	connect(previewButton, &QPushButton::clicked, this, &ReplaceAllDialog::preview);
+
+	connect(m_patternEdit, &QLineEdit::textChanged, this, &ReplaceAllDialog::invalidatePreview);
+	connect(m_replacementEdit, &QLineEdit::textChanged, this, &ReplaceAllDialog::invalidatePreview);
+	connect(m_regExpCheckBox, &QCheckBox::toggled, this, &ReplaceAllDialog::invalidatePreview);
+	connect(m_caseSensitiveCheckBox, &QCheckBox::toggled, this, &ReplaceAllDialog::invalidatePreview);
+	connect(m_wholeWordsCheckBox, &QCheckBox::toggled, this, &ReplaceAllDialog::invalidatePreview);
+	connect(m_lineTargetsButtonGroup, SIGNAL(buttonClicked(int)), this, SLOT(invalidatePreview()));
+	connect(m_textTargetsButtonGroup, SIGNAL(buttonClicked(int)), this, SLOT(invalidatePreview()));
+}
+
+QString
+ReplaceAllDialog::pattern() const
+{
+	return m_patternEdit->text();
+}
+
+void
+ReplaceAllDialog::setPattern(const QString &pattern)
+{
+	m_patternEdit->setText(pattern);
+}
+
+TextReplacer
+ReplaceAllDialog::textReplacer() const
+{
+	return TextReplacer(m_patternEdit->text(), m_replacementEdit->text(), m_regExpCheckBox->isChecked(), m_caseSensitiveCheckBox->isChecked(), m_wholeWordsCheckBox->isChecked());
+}
+
+int
+ReplaceAllDialog::exec()
+{
+	// lines of a previous preview could have been changed or removed
+	invalidatePreview();
+	m_patternEdit->setFocus();
+	m_patternEdit->selectAll();
+
+	return ActionWithTargetDialog::exec();
+}
+
+void
+ReplaceAllDialog::invalidatePreview()
+{
+	m_editsValid = false;
+	m_edits.clear();
+	m_previewTree->clear();
+	m_previewLabel->clear();
+}
+
+void
+ReplaceAllDialog::evaluate()
+{
+	if(m_editsValid)
+		return;
+
+	m_edits.clear();
+	m_editsValid = true;
+
+	Subtitle *subtitle = app()->subtitle();
+	if(subtitle)
+		m_edits = BatchReplacer::evaluate(textReplacer(), *subtitle, app()->linesWidget()->targetRanges(selectedLinesTarget()), selectedTextsTarget());
+}
+
+QList<BatchReplacer::Edit>
+ReplaceAllDialog::edits()
+{
+	evaluate();
+	return m_edits;
+}
+
+void
+ReplaceAllDialog::preview()
+{
+	const TextReplacer replacer = textReplacer();
+	if(!replacer.isValid()) {
+		invalidatePreview();
+		m_previewLabel->setText(replacer.errorString());
+		return;
+	}
+
+	evaluate();
+
+	m_previewTree->clear();
+	QList<QTreeWidgetItem *> items;
+	for(int i = 0, n = qMin(m_edits.size(), MAX_PREVIEW_EDITS); i < n; i++) {
+		const BatchReplacer::Edit &edit = m_edits.at(i);
+		QTreeWidgetItem *item = new QTreeWidgetItem();
+		item->setText(0, QString::number(edit.line->number()));
+		item->setTextAlignment(0, Qt::AlignRight | Qt::AlignVCenter);
+		item->setText(1, edit.oldText.string().replace(QLatin1Char('\n'), QLatin1Char('|')));
+		item->setText(2, edit.newText.string().replace(QLatin1Char('\n'), QLatin1Char('|')));
+		items.append(item);
+	}
+	m_previewTree->addTopLevelItems(items);
+
+	m_previewLabel->setText(i18np("1 replacement", "%1 replacements", BatchReplacer::replacementsCount(m_edits))
+							+ QStringLiteral(", ") + i18np("1 text changed", "%1 texts changed", m_edits.size()));
+}
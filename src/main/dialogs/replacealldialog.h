@@ -0,0 +1,73 @@
+#ifndef REPLACEALLDIALOG_H
+#define REPLACEALLDIALOG_H
+/**
+ * Copyright (C) 2010-2017 Mladen Milinkovic <max@smoothware.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "sstring.h"
+
+#include "actionwithtargetdialog.h"
+#include "../utils/batchreplacer.h"
+
+QT_FORWARD_DECLARE_CLASS(QCheckBox)
+QT_FORWARD_DECLARE_CLASS(QLabel)
+QT_FORWARD_DECLARE_CLASS(QLineEdit)
+QT_FORWARD_DECLARE_CLASS(QTreeWidget)
+
+namespace SubtitleComposer {
+class ReplaceAllDialog : public ActionWithTargetDialog
+{
+	Q_OBJECT
+
+public:
+	explicit ReplaceAllDialog(QWidget *parent = 0);
+
+	QString pattern() const;
+	void setPattern(const QString &pattern);
+
+	TextReplacer textReplacer() const;
+
+	/// edits of the last preview, evaluated again if options were changed since
+	QList<BatchReplacer::Edit> edits();
+
+public slots:
+	virtual int exec();
+
+private slots:
+	void invalidatePreview();
+	void preview();
+
+private:
+	void evaluate();
+
+private:
+	QLineEdit *m_patternEdit;
+	QLineEdit *m_replacementEdit;
+	QCheckBox *m_regExpCheckBox;
+	QCheckBox *m_caseSensitiveCheckBox;
+	QCheckBox *m_wholeWordsCheckBox;
+
+	QLabel *m_previewLabel;
+	QTreeWidget *m_previewTree;
+
+	QList<BatchReplacer::Edit> m_edits;
+	bool m_editsValid;
+};
+}
+
+#endif // REPLACEALLDIALOG_H
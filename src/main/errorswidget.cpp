@@ -87,7 +87,7 @@ ErrorsModelNode::update()
 		if(!m_errorCount) {             // line was not visible before
 			m_model->beginInsertRows(QModelIndex(), modelL1Row, modelL1Row);
 
-			m_model->incrementVisibleLinesCount(1);
+			m_model->incrementVisibleLinesCount(this, 1);
 
 			m_model->endInsertRows();
 		}
@@ -105,7 +105,7 @@ ErrorsModelNode::update()
 		if(!newErrorsCount) {           // line is no longer visible
 			m_model->beginRemoveRows(QModelIndex(), modelL1Row, modelL1Row);
 
-			m_model->incrementVisibleLinesCount(-1);
+			m_model->incrementVisibleLinesCount(this, -1);
 			m_errorCount = 0;
 
 			m_model->endRemoveRows();
@@ -164,30 +164,30 @@ ErrorsModel::mapModelIndexToLineIndex(const QModelIndex &modelIndex) const
 int
 ErrorsModel::mapLineIndexToModelL1Row(int targetLineIndex) const
 {
-	int modelL1Row = -1;
-
-	if(targetLineIndex >= m_nodes.count())
-		targetLineIndex = m_nodes.count() - 1;
-
-	for(int lineIndex = 0; lineIndex <= targetLineIndex; ++lineIndex)
-		if(m_nodes.at(lineIndex)->isVisible())
-			modelL1Row++;
+	if(targetLineIndex < 0)
+		return -1;
 
-	return modelL1Row;
+	// number of visible lines up to and including the target line
+	return m_visibleLines.prefixSum(targetLineIndex + 1) - 1;
 }
 
 int
 ErrorsModel::mapModelL1RowToLineIndex(int targetModelL1Row) const
 {
-	int modelL1Row = -1;
-	for(int lineIndex = 0, linesCount = m_nodes.count(); lineIndex < linesCount; ++lineIndex) {
-		if(m_nodes.at(lineIndex)->isVisible()) {
-			modelL1Row++;
-			if(modelL1Row == targetModelL1Row)
-				return lineIndex;
-		}
-	}
-	return -1;
+	if(targetModelL1Row < 0)
+		return -1;
+
+	const int lineIndex = m_visibleLines.lowerBound(targetModelL1Row + 1);
+	return lineIndex < m_visibleLines.size() ? lineIndex : -1;
+}
+
+void
+ErrorsModel::updateVisibleLinesIndex()
+{
+	QVector<int> visible(m_nodes.count());
+	for(int lineIndex = 0, linesCount = m_nodes.count(); lineIndex < linesCount; ++lineIndex)
+		visible[lineIndex] = m_nodes.at(lineIndex)->isVisible() ? 1 : 0;
+	m_visibleLines.reset(visible);
 }
 
 int
@@ -233,6 +233,9 @@ ErrorsModel::onLinesInserted(int firstLineIndex, int lastLineIndex)
 		}
 	}
 
+	// indexes of all following lines have shifted
+	updateVisibleLinesIndex();
+
 	if(firstVisibleLineIndex != INT_MAX && lastVisibleLineIndex != INT_MIN) { // at least one visible line was inserted
 		beginInsertRows(QModelIndex(), mapLineIndexToModelL1Row(firstVisibleLineIndex), mapLineIndexToModelL1Row(lastVisibleLineIndex)
 						);
@@ -268,6 +271,8 @@ ErrorsModel::onLinesRemoved(int firstLineIndex, int lastLineIndex)
 	for(int lineIndex = firstLineIndex; lineIndex <= lastLineIndex; ++lineIndex)
 		delete m_nodes.takeAt(firstLineIndex);
 
+	updateVisibleLinesIndex();
+
 	emit dataChanged();
 }
 
@@ -325,11 +330,16 @@ ErrorsModel::emitDataChanged()
 }
 
 void
-ErrorsModel::incrementVisibleLinesCount(int delta)
+ErrorsModel::incrementVisibleLinesCount(const ErrorsModelNode *node, int delta)
 {
 	if(!m_statsChangedTimer->isActive())
 		m_statsChangedTimer->start();
 	m_lineWithErrorsCount += delta;
+
+	// nodes that are being created are not in m_nodes yet, index is rebuilt once they are added
+	const int lineIndex = node->line()->index();
+	if(lineIndex >= 0 && lineIndex < m_nodes.count() && m_nodes.at(lineIndex) == node)
+		m_visibleLines.add(lineIndex, delta);
 }
 
 void
@@ -20,6 +20,7 @@
  *   Boston, MA 02110-1301, USA.                                           *
  ***************************************************************************/
 
+#include "../core/fenwicktree.h"
 #include "../core/rangelist.h"
 #include "../core/subtitle.h"
 #include "../widgets/treeview.h"
@@ -120,7 +121,8 @@ private:
 	void markLineChanged(int lineIndex);
 	void updateLineErrors(SubtitleLine *line, int errorFlags);
 
-	void incrementVisibleLinesCount(int delta);
+	void incrementVisibleLinesCount(const ErrorsModelNode *node, int delta);
+	void updateVisibleLinesIndex();
 	void incrementErrorsCount(int delta);
 	void incrementMarksCount(int delta);
 
@@ -130,6 +132,7 @@ private:
 	const SubtitleLine LEVEL1_LINE;
 
 	QList<ErrorsModelNode *> m_nodes;
+	FenwickTree m_visibleLines;     // 1 for each line shown in the model, maps lines to rows both ways
 
 	QTimer *m_statsChangedTimer;
 	int m_lineWithErrorsCount;
@@ -0,0 +1,236 @@
+/**
+ * Copyright (C) 2010-2017 Mladen Milinkovic <max@smoothware.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "findresultswidget.h"
+
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QIcon>
+#include <QLabel>
+#include <QLineEdit>
+#include <QRegularExpression>
+#include <QShowEvent>
+#include <QTimer>
+#include <QToolButton>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+
+#include <KLocalizedString>
+
+// milliseconds the search text has to stay unchanged before searching
+#define SEARCH_DELAY 200
+// characters of text shown on each side of a match
+#define CONTEXT_CHARS 30
+// results list stops growing at this many matches
+#define MAX_MATCHES 10000
+
+using namespace SubtitleComposer;
+
+enum { LineColumn = 0, TextColumn, ContextColumn };
+
+FindResultsWidget::FindResultsWidget(QWidget *parent)
+	: QWidget(parent),
+	  m_textIndex(Q_NULLPTR),
+	  m_translationMode(false),
+	  m_resultsStale(false),
+	  m_searchTimer(new QTimer(this))
+{
+	m_textEdit = new QLineEdit(this);
+	m_textEdit->setClearButtonEnabled(true);
+	m_textEdit->setPlaceholderText(i18n("Find all..."));
+
+	m_regExpButton = createToolButton(i18n("Regular Expression"), "code-context");
+	m_regExpButton->setCheckable(true);
+	m_caseSensitiveButton = createToolButton(i18n("Case Sensitive"), "format-text-superscript");
+	m_caseSensitiveButton->setCheckable(true);
+
+	m_statusLabel = new QLabel(this);
+
+	m_resultsTree = new QTreeWidget(this);
+	m_resultsTree->setRootIsDecorated(false);
+	m_resultsTree->setAllColumnsShowFocus(true);
+	m_resultsTree->setUniformRowHeights(true);
+	m_resultsTree->setHeaderLabels(QStringList() << i18n("Line") << i18n("Text") << i18n("Context"));
+	m_resultsTree->header()->setSectionResizeMode(LineColumn, QHeaderView::ResizeToContents);
+	m_resultsTree->header()->setSectionResizeMode(TextColumn, QHeaderView::ResizeToContents);
+	m_resultsTree->header()->setStretchLastSection(true);
+	m_resultsTree->setColumnHidden(TextColumn, true);
+
+	QHBoxLayout *searchLayout = new QHBoxLayout();
+	searchLayout->setContentsMargins(0, 0, 0, 0);
+	searchLayout->addWidget(m_textEdit, 1);
+	searchLayout->addWidget(m_regExpButton);
+	searchLayout->addWidget(m_caseSensitiveButton);
+	searchLayout->addSpacing(5);
+	searchLayout->addWidget(m_statusLabel);
+
+	QVBoxLayout *layout = new QVBoxLayout(this);
+	layout->setContentsMargins(0, 0, 0, 0);
+	layout->addLayout(searchLayout);
+	layout->addWidget(m_resultsTree);
+
+	m_searchTimer->setInterval(SEARCH_DELAY);
+	m_searchTimer->setSingleShot(true);
+	connect(m_searchTimer, &QTimer::timeout, this, &FindResultsWidget::search);
+
+	connect(m_textEdit, &QLineEdit::textChanged, this, &FindResultsWidget::onSearchEdited);
+	connect(m_textEdit, &QLineEdit::returnPressed, this, &FindResultsWidget::search);
+	connect(m_regExpButton, &QToolButton::toggled, this, &FindResultsWidget::onSearchEdited);
+	connect(m_caseSensitiveButton, &QToolButton::toggled, this, &FindResultsWidget::onSearchEdited);
+	connect(m_resultsTree, &QTreeWidget::itemActivated, this, &FindResultsWidget::onItemActivated);
+}
+
+FindResultsWidget::~FindResultsWidget()
+{}
+
+QToolButton *
+FindResultsWidget::createToolButton(const QString &text, const char *icon)
+{
+	QToolButton *toolButton = new QToolButton(this);
+	toolButton->setToolTip(text);
+	toolButton->setIcon(QIcon::fromTheme(icon));
+	toolButton->setAutoRaise(true);
+	toolButton->setFocusPolicy(Qt::NoFocus);
+	return toolButton;
+}
+
+void
+FindResultsWidget::setTextIndex(TextIndex *textIndex)
+{
+	if(m_textIndex)
+		disconnect(m_textIndex, Q_NULLPTR, this, Q_NULLPTR);
+
+	m_textIndex = textIndex;
+
+	if(m_textIndex)
+		connect(m_textIndex, &TextIndex::indexChanged, this, &FindResultsWidget::onIndexChanged);
+
+	search();
+}
+
+void
+FindResultsWidget::setTranslationMode(bool enabled)
+{
+	m_translationMode = enabled;
+	m_resultsTree->setColumnHidden(TextColumn, !enabled);
+	onSearchEdited();
+}
+
+void
+FindResultsWidget::startSearch(const QString &text)
+{
+	if(!text.isEmpty())
+		m_textEdit->setText(text);
+	m_textEdit->setFocus();
+	m_textEdit->selectAll();
+	search();
+}
+
+void
+FindResultsWidget::onSearchEdited()
+{
+	m_searchTimer->start();
+}
+
+void
+FindResultsWidget::onIndexChanged()
+{
+	// results are refreshed after texts stop changing, same as after editing the search,
+	// but nobody looks at them while the panel is hidden
+	if(isVisible())
+		m_searchTimer->start();
+	else
+		m_resultsStale = true;
+}
+
+void
+FindResultsWidget::showEvent(QShowEvent *event)
+{
+	QWidget::showEvent(event);
+
+	if(m_resultsStale)
+		search();
+}
+
+void
+FindResultsWidget::search()
+{
+	m_searchTimer->stop();
+	m_resultsStale = false;
+
+	m_resultsTree->clear();
+	m_matches.clear();
+
+	const QString pattern = m_textEdit->text();
+	if(!m_textIndex || !m_textIndex->subtitle() || pattern.isEmpty()) {
+		m_statusLabel->clear();
+		return;
+	}
+
+	const bool regExp = m_regExpButton->isChecked();
+	if(regExp && !QRegularExpression(pattern).isValid()) {
+		m_statusLabel->setText(i18n("Invalid regular expression"));
+		return;
+	}
+
+	m_matches = m_textIndex->findAll(pattern, regExp, m_caseSensitiveButton->isChecked(),
+									 m_translationMode ? SubtitleLine::Both : SubtitleLine::Primary,
+									 Range::full(), MAX_MATCHES);
+
+	QList<QTreeWidgetItem *> items;
+	items.reserve(m_matches.size());
+	for(int i = 0, n = m_matches.size(); i < n; i++) {
+		const TextIndex::Match &match = m_matches.at(i);
+		const QString text = (match.primary ? match.line->primaryText() : match.line->secondaryText()).string();
+
+		const int contextStart = qMax(0, match.start - CONTEXT_CHARS);
+		const int contextEnd = qMin(text.length(), match.start + match.length + CONTEXT_CHARS);
+		QString context = text.mid(contextStart, contextEnd - contextStart);
+		context.replace(QLatin1Char('\n'), QLatin1Char('|'));
+		if(contextStart > 0)
+			context.prepend(QStringLiteral("..."));
+		if(contextEnd < text.length())
+			context.append(QStringLiteral("..."));
+
+		QTreeWidgetItem *item = new QTreeWidgetItem();
+		item->setText(LineColumn, QString::number(match.line->number()));
+		item->setTextAlignment(LineColumn, Qt::AlignRight | Qt::AlignVCenter);
+		item->setText(TextColumn, match.primary ? i18n("Primary") : i18n("Translation"));
+		item->setText(ContextColumn, context);
+		item->setData(LineColumn, Qt::UserRole, i);
+		items.append(item);
+	}
+	m_resultsTree->addTopLevelItems(items);
+
+	if(m_matches.size() >= MAX_MATCHES)
+		m_statusLabel->setText(i18n("First %1 matches", m_matches.size()));
+	else
+		m_statusLabel->setText(i18np("1 match", "%1 matches", m_matches.size()));
+}
+
+void
+FindResultsWidget::onItemActivated(QTreeWidgetItem *item)
+{
+	// lines of pending results may be gone already
+	if(m_searchTimer->isActive())
+		return;
+
+	const TextIndex::Match &match = m_matches.at(item->data(LineColumn, Qt::UserRole).toInt());
+	emit found(match.line, match.primary, match.start, match.start + match.length - 1);
+}
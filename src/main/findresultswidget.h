@@ -0,0 +1,87 @@
+#ifndef FINDRESULTSWIDGET_H
+#define FINDRESULTSWIDGET_H
+/**
+ * Copyright (C) 2010-2017 Mladen Milinkovic <max@smoothware.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "../core/textindex.h"
+
+#include <QWidget>
+
+QT_FORWARD_DECLARE_CLASS(QLabel)
+QT_FORWARD_DECLARE_CLASS(QLineEdit)
+QT_FORWARD_DECLARE_CLASS(QShowEvent)
+QT_FORWARD_DECLARE_CLASS(QTimer)
+QT_FORWARD_DECLARE_CLASS(QToolButton)
+QT_FORWARD_DECLARE_CLASS(QTreeWidget)
+QT_FORWARD_DECLARE_CLASS(QTreeWidgetItem)
+
+namespace SubtitleComposer {
+/**
+ * @brief Lists all occurrences of searched text using TextIndex.
+ *
+ * Results are updated while typing and whenever subtitle texts change, changes made
+ * while the widget is hidden are searched once it is shown again.
+ */
+class FindResultsWidget : public QWidget
+{
+	Q_OBJECT
+
+public:
+	explicit FindResultsWidget(QWidget *parent);
+	virtual ~FindResultsWidget();
+
+	void setTextIndex(TextIndex *textIndex);
+
+public slots:
+	void setTranslationMode(bool enabled);
+	/// focuses search field, replacing its text with @p text if not empty
+	void startSearch(const QString &text = QString());
+
+signals:
+	void found(SubtitleLine *line, bool primary, int startIndex, int endIndex);
+
+protected:
+	void showEvent(QShowEvent *event) Q_DECL_OVERRIDE;
+
+private slots:
+	void onSearchEdited();
+	void onIndexChanged();
+	void search();
+	void onItemActivated(QTreeWidgetItem *item);
+
+private:
+	QToolButton * createToolButton(const QString &text, const char *icon);
+
+private:
+	TextIndex *m_textIndex;
+	bool m_translationMode;
+	QList<TextIndex::Match> m_matches;
+	bool m_resultsStale;                // texts changed while hidden
+
+	QLineEdit *m_textEdit;
+	QToolButton *m_regExpButton;
+	QToolButton *m_caseSensitiveButton;
+	QLabel *m_statusLabel;
+	QTreeWidget *m_resultsTree;
+
+	QTimer *m_searchTimer;
+};
+}
+
+#endif // FINDRESULTSWIDGET_H
@@ -0,0 +1,246 @@
+/**
+ * Copyright (C) 2010-2017 Mladen Milinkovic <max@smoothware.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "linesfilterbar.h"
+#include "lineswidget.h"
+#include "../widgets/timeedit.h"
+
+#include <QCheckBox>
+#include <QDoubleSpinBox>
+#include <QHBoxLayout>
+#include <QIcon>
+#include <QLabel>
+#include <QLineEdit>
+#include <QRegularExpression>
+#include <QSpinBox>
+#include <QTime>
+#include <QTimer>
+#include <QToolButton>
+
+#include <KLocalizedString>
+
+// milliseconds the controls have to stay unchanged before the filter is applied
+#define FILTER_APPLY_DELAY 300
+
+using namespace SubtitleComposer;
+
+QToolButton *
+LinesFilterBar::createToolButton(const QString &text, const char *icon)
+{
+	QToolButton *toolButton = new QToolButton(this);
+	toolButton->setToolTip(text);
+	toolButton->setIcon(QIcon::fromTheme(icon));
+	toolButton->setAutoRaise(true);
+	toolButton->setFocusPolicy(Qt::NoFocus);
+	return toolButton;
+}
+
+LinesFilterBar::LinesFilterBar(QWidget *parent)
+	: QWidget(parent),
+	  m_model(Q_NULLPTR),
+	  m_applyTimer(new QTimer(this))
+{
+	m_textEdit = new QLineEdit(this);
+	m_textEdit->setClearButtonEnabled(true);
+	m_textEdit->setPlaceholderText(i18n("Filter lines..."));
+
+	m_regExpButton = createToolButton(i18n("Regular Expression"), "code-context");
+	m_regExpButton->setCheckable(true);
+	m_caseSensitiveButton = createToolButton(i18n("Case Sensitive"), "format-text-superscript");
+	m_caseSensitiveButton->setCheckable(true);
+
+	m_errorsCheckBox = new QCheckBox(i18n("Errors"), this);
+	m_markedCheckBox = new QCheckBox(i18n("Marked"), this);
+
+	m_timeCheckBox = new QCheckBox(i18n("Time"), this);
+	m_timeFromEdit = new TimeEdit(this);
+	m_timeFromEdit->setEnabled(false);
+	m_timeToEdit = new TimeEdit(this);
+	m_timeToEdit->setEnabled(false);
+	m_timeToEdit->setValue(QTime(0, 0, 0, 0).msecsTo(m_timeToEdit->maximumTime()));
+
+	m_minDurationSpinBox = new QSpinBox(this);
+	m_maxDurationSpinBox = new QSpinBox(this);
+	m_minCpsSpinBox = new QDoubleSpinBox(this);
+	m_maxCpsSpinBox = new QDoubleSpinBox(this);
+	foreach(QSpinBox *spinBox, QList<QSpinBox *>() << m_minDurationSpinBox << m_maxDurationSpinBox) {
+		spinBox->setRange(0, 99999);
+		spinBox->setSingleStep(100);
+		spinBox->setSuffix(i18nc("milliseconds", " ms"));
+		spinBox->setSpecialValueText(i18nc("no limit", "Any"));
+	}
+	foreach(QDoubleSpinBox *spinBox, QList<QDoubleSpinBox *>() << m_minCpsSpinBox << m_maxCpsSpinBox) {
+		spinBox->setRange(0., 999.);
+		spinBox->setDecimals(1);
+		spinBox->setSpecialValueText(i18nc("no limit", "Any"));
+	}
+
+	m_statusLabel = new QLabel(this);
+
+	QToolButton *closeButton = createToolButton(i18n("Close Filter"), "dialog-close");
+	connect(closeButton, &QToolButton::clicked, this, &LinesFilterBar::closeRequested);
+
+	QHBoxLayout *layout = new QHBoxLayout(this);
+	layout->setContentsMargins(0, 0, 0, 0);
+	layout->addWidget(m_textEdit, 1);
+	layout->addWidget(m_regExpButton);
+	layout->addWidget(m_caseSensitiveButton);
+	layout->addSpacing(5);
+	layout->addWidget(m_errorsCheckBox);
+	layout->addWidget(m_markedCheckBox);
+	layout->addSpacing(5);
+	layout->addWidget(m_timeCheckBox);
+	layout->addWidget(m_timeFromEdit);
+	layout->addWidget(new QLabel(QStringLiteral("–"), this));
+	layout->addWidget(m_timeToEdit);
+	layout->addSpacing(5);
+	layout->addWidget(new QLabel(i18n("Duration"), this));
+	layout->addWidget(m_minDurationSpinBox);
+	layout->addWidget(new QLabel(QStringLiteral("–"), this));
+	layout->addWidget(m_maxDurationSpinBox);
+	layout->addSpacing(5);
+	layout->addWidget(new QLabel(i18nc("characters per second", "CPS"), this));
+	layout->addWidget(m_minCpsSpinBox);
+	layout->addWidget(new QLabel(QStringLiteral("–"), this));
+	layout->addWidget(m_maxCpsSpinBox);
+	layout->addSpacing(5);
+	layout->addWidget(m_statusLabel);
+	layout->addWidget(closeButton);
+
+	m_applyTimer->setInterval(FILTER_APPLY_DELAY);
+	m_applyTimer->setSingleShot(true);
+	connect(m_applyTimer, &QTimer::timeout, this, &LinesFilterBar::applyFilter);
+
+	connect(m_textEdit, &QLineEdit::textChanged, this, &LinesFilterBar::onFilterEdited);
+	connect(m_regExpButton, &QToolButton::toggled, this, &LinesFilterBar::onFilterEdited);
+	connect(m_caseSensitiveButton, &QToolButton::toggled, this, &LinesFilterBar::onFilterEdited);
+	connect(m_errorsCheckBox, &QCheckBox::toggled, this, &LinesFilterBar::onFilterEdited);
+	connect(m_markedCheckBox, &QCheckBox::toggled, this, &LinesFilterBar::onFilterEdited);
+	connect(m_timeCheckBox, &QCheckBox::toggled, m_timeFromEdit, &TimeEdit::setEnabled);
+	connect(m_timeCheckBox, &QCheckBox::toggled, m_timeToEdit, &TimeEdit::setEnabled);
+	connect(m_timeCheckBox, &QCheckBox::toggled, this, &LinesFilterBar::onFilterEdited);
+	connect(m_timeFromEdit, &TimeEdit::valueChanged, this, &LinesFilterBar::onFilterEdited);
+	connect(m_timeToEdit, &TimeEdit::valueChanged, this, &LinesFilterBar::onFilterEdited);
+	connect(m_minDurationSpinBox, SIGNAL(valueChanged(int)), this, SLOT(onFilterEdited()));
+	connect(m_maxDurationSpinBox, SIGNAL(valueChanged(int)), this, SLOT(onFilterEdited()));
+	connect(m_minCpsSpinBox, SIGNAL(valueChanged(double)), this, SLOT(onFilterEdited()));
+	connect(m_maxCpsSpinBox, SIGNAL(valueChanged(double)), this, SLOT(onFilterEdited()));
+
+	// filter is applied right away when editing is finished
+	connect(m_textEdit, &QLineEdit::returnPressed, this, &LinesFilterBar::applyFilter);
+}
+
+LinesFilterBar::~LinesFilterBar()
+{}
+
+void
+LinesFilterBar::setFilterModel(LinesFilterModel *model)
+{
+	if(m_model)
+		disconnect(m_model, Q_NULLPTR, this, Q_NULLPTR);
+
+	m_model = model;
+
+	if(m_model) {
+		connect(m_model, &LinesFilterModel::filterUpdated, this, &LinesFilterBar::updateStatus);
+		connect(m_model, &LinesFilterModel::rowsInserted, this, &LinesFilterBar::updateStatus);
+		connect(m_model, &LinesFilterModel::rowsRemoved, this, &LinesFilterBar::updateStatus);
+		connect(m_model, &LinesFilterModel::modelReset, this, &LinesFilterBar::updateStatus);
+	}
+
+	updateStatus();
+}
+
+LinesFilter
+LinesFilterBar::filter() const
+{
+	LinesFilter filter;
+
+	filter.text = m_textEdit->text();
+	filter.regExp = m_regExpButton->isChecked();
+	filter.caseSensitive = m_caseSensitiveButton->isChecked();
+	filter.errorsOnly = m_errorsCheckBox->isChecked();
+	filter.markedOnly = m_markedCheckBox->isChecked();
+	if(m_timeCheckBox->isChecked()) {
+		filter.timeFrom = m_timeFromEdit->value();
+		filter.timeTo = m_timeToEdit->value();
+	}
+	filter.minDuration = m_minDurationSpinBox->value();
+	filter.maxDuration = m_maxDurationSpinBox->value();
+	filter.minCps = m_minCpsSpinBox->value();
+	filter.maxCps = m_maxCpsSpinBox->value();
+
+	return filter;
+}
+
+void
+LinesFilterBar::setActive(bool active)
+{
+	setVisible(active);
+
+	if(active) {
+		applyFilter();
+		m_textEdit->setFocus();
+		m_textEdit->selectAll();
+	} else {
+		m_applyTimer->stop();
+		if(m_model)
+			m_model->setFilter(LinesFilter());
+	}
+}
+
+void
+LinesFilterBar::onFilterEdited()
+{
+	m_applyTimer->start();
+}
+
+void
+LinesFilterBar::applyFilter()
+{
+	m_applyTimer->stop();
+
+	if(m_model && isVisible())
+		m_model->setFilter(filter());
+
+	updateStatus();
+}
+
+void
+LinesFilterBar::updateStatus()
+{
+	if(!m_model || !m_model->linesModel()) {
+		m_statusLabel->clear();
+		return;
+	}
+
+	const LinesFilter &filter = m_model->filter();
+	if(filter.regExp && !filter.text.isEmpty() && !QRegularExpression(filter.text).isValid()) {
+		m_statusLabel->setText(i18n("Invalid regular expression"));
+		return;
+	}
+
+	const int linesCount = m_model->linesModel()->rowCount();
+	if(!m_model->isFilterActive())
+		m_statusLabel->setText(i18np("1 line", "%1 lines", linesCount));
+	else if(m_model->isFiltering())
+		m_statusLabel->setText(i18n("Filtering..."));
+	else
+		m_statusLabel->setText(i18n("%1 of %2 lines", m_model->shownLinesCount(), linesCount));
+}
@@ -0,0 +1,89 @@
+#ifndef LINESFILTERBAR_H
+#define LINESFILTERBAR_H
+/**
+ * Copyright (C) 2010-2017 Mladen Milinkovic <max@smoothware.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "linesfiltermodel.h"
+
+#include <QWidget>
+
+QT_FORWARD_DECLARE_CLASS(QCheckBox)
+QT_FORWARD_DECLARE_CLASS(QDoubleSpinBox)
+QT_FORWARD_DECLARE_CLASS(QLabel)
+QT_FORWARD_DECLARE_CLASS(QLineEdit)
+QT_FORWARD_DECLARE_CLASS(QSpinBox)
+QT_FORWARD_DECLARE_CLASS(QTimer)
+QT_FORWARD_DECLARE_CLASS(QToolButton)
+
+class TimeEdit;
+
+namespace SubtitleComposer {
+/**
+ * @brief Controls of LinesFilterModel shown above lines list.
+ *
+ * Filter is applied shortly after the controls stop changing, hiding the bar removes the filter.
+ */
+class LinesFilterBar : public QWidget
+{
+	Q_OBJECT
+
+public:
+	explicit LinesFilterBar(QWidget *parent);
+	virtual ~LinesFilterBar();
+
+	void setFilterModel(LinesFilterModel *model);
+
+	LinesFilter filter() const;
+
+public slots:
+	void setActive(bool active);
+
+signals:
+	void closeRequested();
+
+private slots:
+	void onFilterEdited();
+	void applyFilter();
+	void updateStatus();
+
+private:
+	QToolButton * createToolButton(const QString &text, const char *icon);
+
+private:
+	LinesFilterModel *m_model;
+
+	QLineEdit *m_textEdit;
+	QToolButton *m_regExpButton;
+	QToolButton *m_caseSensitiveButton;
+	QCheckBox *m_errorsCheckBox;
+	QCheckBox *m_markedCheckBox;
+	QCheckBox *m_timeCheckBox;
+	TimeEdit *m_timeFromEdit;
+	TimeEdit *m_timeToEdit;
+	QSpinBox *m_minDurationSpinBox;
+	QSpinBox *m_maxDurationSpinBox;
+	QDoubleSpinBox *m_minCpsSpinBox;
+	QDoubleSpinBox *m_maxCpsSpinBox;
+	QLabel *m_statusLabel;
+
+	QTimer *m_applyTimer;
+};
+}
+
+#endif // LINESFILTERBAR_H
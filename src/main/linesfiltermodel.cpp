@@ -0,0 +1,534 @@
+/**
+ * Copyright (C) 2010-2017 Mladen Milinkovic <max@smoothware.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "linesfiltermodel.h"
+#include "lineswidget.h"
+#include "../core/subtitle.h"
+#include "../core/subtitleline.h"
+
+#include <QRunnable>
+#include <QThread>
+
+using namespace SubtitleComposer;
+
+/// LINES FILTER
+/// ============
+
+LinesFilter::LinesFilter()
+	: regExp(false),
+	  caseSensitive(false),
+	  errorsOnly(false),
+	  markedOnly(false),
+	  timeFrom(-1),
+	  timeTo(-1),
+	  minDuration(0),
+	  maxDuration(0),
+	  minCps(0.),
+	  maxCps(0.)
+{
+}
+
+bool
+LinesFilter::isEmpty() const
+{
+	return text.isEmpty() && !errorsOnly && !markedOnly && timeFrom < 0 && timeTo < 0
+		&& minDuration <= 0 && maxDuration <= 0 && minCps <= 0. && maxCps <= 0.;
+}
+
+bool
+LinesFilter::operator==(const LinesFilter &other) const
+{
+	return text == other.text && regExp == other.regExp && caseSensitive == other.caseSensitive
+		&& errorsOnly == other.errorsOnly && markedOnly == other.markedOnly
+		&& timeFrom == other.timeFrom && timeTo == other.timeTo
+		&& minDuration == other.minDuration && maxDuration == other.maxDuration
+		&& minCps == other.minCps && maxCps == other.maxCps;
+}
+
+/// FILTER JOB
+/// ==========
+
+class LinesFilterModel::FilterJob : public QRunnable
+{
+public:
+	// lines are copied here, on GUI thread
+	FilterJob(LinesFilterModel *model, int jobId, const Subtitle *subtitle, int firstLine, int lastLine)
+		: m_model(model),
+		  m_generation(model->m_generation),
+		  m_jobId(jobId),
+		  m_firstLine(firstLine),
+		  m_filter(model->m_filter),
+		  m_regExp(model->m_regExp)
+	{
+		m_lines.reserve(lastLine - firstLine + 1);
+		for(int i = firstLine; i <= lastLine; i++) {
+			const SubtitleLine *line = subtitle->line(i);
+			LineData data;
+			data.primaryText = line->primaryText().string();
+			data.secondaryText = line->secondaryText().string();
+			data.showTime = line->showTime().toMillis();
+			data.hideTime = line->hideTime().toMillis();
+			data.errorFlags = line->errorFlags();
+			m_lines.append(data);
+		}
+	}
+
+	void run() Q_DECL_OVERRIDE
+	{
+		QVector<int> shown;
+		shown.reserve(m_lines.size());
+		foreach(const LineData &line, m_lines)
+			shown.append(accepts(line) ? 1 : 0);
+
+		QMetaObject::invokeMethod(m_model, "onChunkFinished", Qt::QueuedConnection,
+			Q_ARG(int, m_generation), Q_ARG(int, m_jobId), Q_ARG(int, m_firstLine), Q_ARG(QVector<int>, shown));
+	}
+
+private:
+	struct LineData {
+		QString primaryText;
+		QString secondaryText;
+		int showTime;
+		int hideTime;
+		int errorFlags;
+	};
+
+	bool matches(const QString &text) const
+	{
+		if(m_filter.regExp)
+			return m_regExp.match(text).hasMatch();
+		return text.contains(m_filter.text, m_filter.caseSensitive ? Qt::CaseSensitive : Qt::CaseInsensitive);
+	}
+
+	bool accepts(const LineData &line) const
+	{
+		if(m_filter.errorsOnly && !(line.errorFlags & (SubtitleLine::AllErrors & ~SubtitleLine::UserMark)))
+			return false;
+		if(m_filter.markedOnly && !(line.errorFlags & SubtitleLine::UserMark))
+			return false;
+
+		if(m_filter.timeFrom >= 0 && line.hideTime < m_filter.timeFrom)
+			return false;
+		if(m_filter.timeTo >= 0 && line.showTime > m_filter.timeTo)
+			return false;
+
+		const int duration = line.hideTime - line.showTime;
+		if(m_filter.minDuration > 0 && duration < m_filter.minDuration)
+			return false;
+		if(m_filter.maxDuration > 0 && duration > m_filter.maxDuration)
+			return false;
+
+		if(m_filter.minCps > 0. || m_filter.maxCps > 0.) {
+			// same character count as SubtitleLine::primaryCharacters()
+			const double cps = line.primaryText.simplified().length() * 1000. / qMax(duration, 1);
+			if(m_filter.minCps > 0. && cps < m_filter.minCps)
+				return false;
+			if(m_filter.maxCps > 0. && cps > m_filter.maxCps)
+				return false;
+		}
+
+		// text is matched last, it's the most expensive check
+		if(!m_filter.text.isEmpty() && !matches(line.primaryText) && !matches(line.secondaryText))
+			return false;
+
+		return true;
+	}
+
+private:
+	LinesFilterModel *m_model;
+	int m_generation;
+	int m_jobId;
+	int m_firstLine;
+	LinesFilter m_filter;
+	QRegularExpression m_regExp;
+	QVector<LineData> m_lines;
+};
+
+/// LINES FILTER MODEL
+/// ==================
+
+LinesFilterModel::LinesFilterModel(QObject *parent)
+	: QAbstractProxyModel(parent),
+	  m_updatingRows(false),
+	  m_removingRows(false),
+	  m_generation(0),
+	  m_lastJobId(0),
+	  m_pendingJobs(0)
+{
+	qRegisterMetaType<QVector<int> >("QVector<int>");
+
+	// leave one core for GUI
+	m_threadPool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 1));
+}
+
+LinesFilterModel::~LinesFilterModel()
+{
+	m_threadPool.clear();
+	m_threadPool.waitForDone();
+}
+
+LinesModel *
+LinesFilterModel::linesModel() const
+{
+	return static_cast<LinesModel *>(sourceModel());
+}
+
+void
+LinesFilterModel::setSourceModel(QAbstractItemModel *sourceModel)
+{
+	beginResetModel();
+
+	if(this->sourceModel()) {
+		disconnect(this->sourceModel(), &QAbstractItemModel::rowsAboutToBeInserted, this, &LinesFilterModel::onSourceRowsAboutToBeInserted);
+		disconnect(this->sourceModel(), &QAbstractItemModel::rowsInserted, this, &LinesFilterModel::onSourceRowsInserted);
+		disconnect(this->sourceModel(), &QAbstractItemModel::rowsAboutToBeRemoved, this, &LinesFilterModel::onSourceRowsAboutToBeRemoved);
+		disconnect(this->sourceModel(), &QAbstractItemModel::rowsRemoved, this, &LinesFilterModel::onSourceRowsRemoved);
+		disconnect(this->sourceModel(), &QAbstractItemModel::dataChanged, this, &LinesFilterModel::onSourceDataChanged);
+		disconnect(this->sourceModel(), &QAbstractItemModel::modelAboutToBeReset, this, &LinesFilterModel::onSourceModelAboutToBeReset);
+		disconnect(this->sourceModel(), &QAbstractItemModel::modelReset, this, &LinesFilterModel::onSourceModelReset);
+	}
+
+	QAbstractProxyModel::setSourceModel(sourceModel);
+
+	if(sourceModel) {
+		connect(sourceModel, &QAbstractItemModel::rowsAboutToBeInserted, this, &LinesFilterModel::onSourceRowsAboutToBeInserted);
+		connect(sourceModel, &QAbstractItemModel::rowsInserted, this, &LinesFilterModel::onSourceRowsInserted);
+		connect(sourceModel, &QAbstractItemModel::rowsAboutToBeRemoved, this, &LinesFilterModel::onSourceRowsAboutToBeRemoved);
+		connect(sourceModel, &QAbstractItemModel::rowsRemoved, this, &LinesFilterModel::onSourceRowsRemoved);
+		connect(sourceModel, &QAbstractItemModel::dataChanged, this, &LinesFilterModel::onSourceDataChanged);
+		connect(sourceModel, &QAbstractItemModel::modelAboutToBeReset, this, &LinesFilterModel::onSourceModelAboutToBeReset);
+		connect(sourceModel, &QAbstractItemModel::modelReset, this, &LinesFilterModel::onSourceModelReset);
+	}
+
+	m_generation++;
+	m_pendingJobs = 0;
+	m_threadPool.clear();
+
+	const int lineCount = sourceModel ? sourceModel->rowCount() : 0;
+	m_shownLines.reset(QVector<int>(lineCount, isFilterActive() ? 0 : 1));
+	m_lineJobs.fill(0, lineCount);
+
+	endResetModel();
+
+	filterLines(0, lineCount - 1);
+}
+
+void
+LinesFilterModel::setFilter(const LinesFilter &filter)
+{
+	if(m_filter == filter)
+		return;
+
+	m_filter = filter;
+	m_regExp = QRegularExpression(filter.regExp ? filter.text : QString(),
+		filter.caseSensitive ? QRegularExpression::NoPatternOption : QRegularExpression::CaseInsensitiveOption);
+
+	restartFilter();
+
+	emit filterUpdated();
+}
+
+RangeList
+LinesFilterModel::shownRanges() const
+{
+	if(!isFilterActive())
+		return Range::full();
+
+	RangeList ranges;
+	int rangeFirstLine = -1, line = 0;
+	for(const int lineCount = m_shownLines.size(); line < lineCount; line++) {
+		if(m_shownLines.value(line)) {
+			if(rangeFirstLine == -1)
+				rangeFirstLine = line;
+		} else if(rangeFirstLine != -1) {
+			ranges << Range(rangeFirstLine, line - 1);
+			rangeFirstLine = -1;
+		}
+	}
+	if(rangeFirstLine != -1)
+		ranges << Range(rangeFirstLine, line - 1);
+
+	return ranges;
+}
+
+QModelIndex
+LinesFilterModel::mapToSource(const QModelIndex &proxyIndex) const
+{
+	if(!proxyIndex.isValid() || !sourceModel())
+		return QModelIndex();
+	return sourceModel()->index(m_shownLines.lowerBound(proxyIndex.row() + 1), proxyIndex.column());
+}
+
+QModelIndex
+LinesFilterModel::mapFromSource(const QModelIndex &sourceIndex) const
+{
+	if(!sourceIndex.isValid() || sourceIndex.row() >= m_shownLines.size() || !m_shownLines.value(sourceIndex.row()))
+		return QModelIndex();
+	return index(m_shownLines.prefixSum(sourceIndex.row()), sourceIndex.column());
+}
+
+QModelIndex
+LinesFilterModel::index(int row, int column, const QModelIndex &parent) const
+{
+	if(parent.isValid() || row < 0 || column < 0 || row >= rowCount() || column >= columnCount())
+		return QModelIndex();
+	return createIndex(row, column);
+}
+
+QModelIndex
+LinesFilterModel::parent(const QModelIndex & /*child*/) const
+{
+	return QModelIndex();
+}
+
+int
+LinesFilterModel::rowCount(const QModelIndex &parent) const
+{
+	return parent.isValid() ? 0 : m_shownLines.total();
+}
+
+int
+LinesFilterModel::columnCount(const QModelIndex &parent) const
+{
+	return parent.isValid() || !sourceModel() ? 0 : sourceModel()->columnCount();
+}
+
+QVariant
+LinesFilterModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+	// QAbstractProxyModel maps section through first row, headers would be lost when no line is shown
+	return sourceModel() ? sourceModel()->headerData(section, orientation, role) : QVariant();
+}
+
+void
+LinesFilterModel::onSourceRowsAboutToBeInserted(const QModelIndex & /*parent*/, int first, int last)
+{
+	// inserted lines are shown until they are evaluated
+	const int row = m_shownLines.prefixSum(first);
+	beginInsertRows(QModelIndex(), row, row + last - first);
+}
+
+void
+LinesFilterModel::onSourceRowsInserted(const QModelIndex & /*parent*/, int first, int last)
+{
+	m_shownLines.insert(first, last - first + 1, 1);
+	m_lineJobs.insert(first, last - first + 1, 0);
+
+	endInsertRows();
+
+	// line indexes of running jobs are not valid anymore
+	if(m_pendingJobs)
+		restartFilter();
+	else
+		filterLines(first, last);
+}
+
+void
+LinesFilterModel::onSourceRowsAboutToBeRemoved(const QModelIndex & /*parent*/, int first, int last)
+{
+	// shown lines of a line range are always consecutive rows
+	const int firstRow = m_shownLines.prefixSum(first);
+	const int lastRow = m_shownLines.prefixSum(last + 1) - 1;
+	m_removingRows = firstRow <= lastRow;
+	if(m_removingRows)
+		beginRemoveRows(QModelIndex(), firstRow, lastRow);
+}
+
+void
+LinesFilterModel::onSourceRowsRemoved(const QModelIndex & /*parent*/, int first, int last)
+{
+	m_shownLines.remove(first, last - first + 1);
+	m_lineJobs.remove(first, last - first + 1);
+
+	if(m_removingRows) {
+		m_removingRows = false;
+		endRemoveRows();
+	}
+
+	if(m_pendingJobs)
+		restartFilter();
+}
+
+void
+LinesFilterModel::onSourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &roles)
+{
+	if(!topLeft.isValid())
+		return;
+
+	const int firstLine = topLeft.row();
+	const int lastLine = bottomRight.isValid() ? bottomRight.row() : firstLine;
+	const int firstRow = m_shownLines.prefixSum(firstLine);
+	const int lastRow = m_shownLines.prefixSum(lastLine + 1) - 1;
+	if(firstRow <= lastRow)
+		emit dataChanged(index(firstRow, 0), index(lastRow, columnCount() - 1), roles);
+
+	// playing line and misspellings don't affect the filter
+	if(roles.size() == 1 && (roles.first() == LinesModel::PlayingLineRole || roles.first() == LinesModel::MisspellingsRole))
+		return;
+
+	filterLines(firstLine, lastLine);
+}
+
+void
+LinesFilterModel::onSourceModelAboutToBeReset()
+{
+	beginResetModel();
+}
+
+void
+LinesFilterModel::onSourceModelReset()
+{
+	m_generation++;
+	m_pendingJobs = 0;
+	m_threadPool.clear();
+
+	const int lineCount = sourceModel()->rowCount();
+	m_shownLines.reset(QVector<int>(lineCount, isFilterActive() ? 0 : 1));
+	m_lineJobs.fill(0, lineCount);
+
+	endResetModel();
+
+	filterLines(0, lineCount - 1);
+}
+
+void
+LinesFilterModel::restartFilter()
+{
+	// results of jobs that are still running will be ignored
+	m_generation++;
+	m_pendingJobs = 0;
+	m_threadPool.clear();
+
+	const int lineCount = m_shownLines.size();
+	m_lineJobs.fill(0, lineCount);
+
+	if(isFilterActive()) {
+		// lines stay as they are until their new results arrive
+		filterLines(0, lineCount - 1);
+	} else if(m_shownLines.total() != lineCount) {
+		// lines without a job are changed by job 0
+		applyLayout(0, 0, QVector<int>(lineCount, 1));
+	}
+}
+
+void
+LinesFilterModel::filterLines(int firstLine, int lastLine)
+{
+	if(!isFilterActive() || firstLine > lastLine)
+		return;
+
+	const Subtitle *subtitle = linesModel()->subtitle();
+	if(!subtitle)
+		return;
+
+	for(int chunkFirst = firstLine; chunkFirst <= lastLine; chunkFirst += CHUNK_SIZE) {
+		const int chunkLast = qMin(chunkFirst + CHUNK_SIZE - 1, lastLine);
+		const int jobId = ++m_lastJobId;
+		for(int line = chunkFirst; line <= chunkLast; line++)
+			m_lineJobs[line] = jobId;
+
+		m_pendingJobs++;
+		m_threadPool.start(new FilterJob(this, jobId, subtitle, chunkFirst, chunkLast));
+	}
+}
+
+void
+LinesFilterModel::onChunkFinished(int generation, int jobId, int firstLine, const QVector<int> &shown)
+{
+	if(generation != m_generation)
+		return;
+
+	m_pendingJobs--;
+
+	int runs = 0;
+	bool inRun = false;
+	for(int i = 0, n = shown.size(); i < n; i++) {
+		const bool changed = isChangedBy(jobId, firstLine + i, shown.at(i));
+		if(changed && (!inRun || shown.at(i) != shown.at(i - 1)))
+			runs++;
+		inRun = changed;
+	}
+
+	// inserting or removing rows is costly for the view, many of them are done at once
+	if(runs > MAX_CHUNK_RUNS)
+		applyLayout(jobId, firstLine, shown);
+	else if(runs)
+		applyRuns(jobId, firstLine, shown);
+
+	emit filterUpdated();
+}
+
+void
+LinesFilterModel::applyRuns(int jobId, int firstLine, const QVector<int> &shown)
+{
+	m_updatingRows = true;
+
+	for(int i = 0, n = shown.size(); i < n;) {
+		const int value = shown.at(i);
+		if(!isChangedBy(jobId, firstLine + i, value)) {
+			i++;
+			continue;
+		}
+
+		int end = i + 1;
+		while(end < n && shown.at(end) == value && isChangedBy(jobId, firstLine + end, value))
+			end++;
+
+		const int row = m_shownLines.prefixSum(firstLine + i);
+		if(value) {
+			beginInsertRows(QModelIndex(), row, row + end - i - 1);
+			for(; i < end; i++)
+				m_shownLines.set(firstLine + i, 1);
+			endInsertRows();
+		} else {
+			beginRemoveRows(QModelIndex(), row, row + end - i - 1);
+			for(; i < end; i++)
+				m_shownLines.set(firstLine + i, 0);
+			endRemoveRows();
+		}
+	}
+
+	m_updatingRows = false;
+}
+
+void
+LinesFilterModel::applyLayout(int jobId, int firstLine, const QVector<int> &shown)
+{
+	emit layoutAboutToBeChanged();
+
+	const QModelIndexList oldIndexes = persistentIndexList();
+	QModelIndexList sourceIndexes;
+	sourceIndexes.reserve(oldIndexes.size());
+	foreach(const QModelIndex &index, oldIndexes)
+		sourceIndexes.append(mapToSource(index));
+
+	for(int i = 0, n = shown.size(); i < n; i++) {
+		if(isChangedBy(jobId, firstLine + i, shown.at(i)))
+			m_shownLines.set(firstLine + i, shown.at(i));
+	}
+
+	// indexes of hidden lines become invalid
+	QModelIndexList newIndexes;
+	newIndexes.reserve(sourceIndexes.size());
+	foreach(const QModelIndex &index, sourceIndexes)
+		newIndexes.append(mapFromSource(index));
+	changePersistentIndexList(oldIndexes, newIndexes);
+
+	emit layoutChanged();
+}
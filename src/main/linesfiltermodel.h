@@ -0,0 +1,145 @@
+#ifndef LINESFILTERMODEL_H
+#define LINESFILTERMODEL_H
+/**
+ * Copyright (C) 2010-2017 Mladen Milinkovic <max@smoothware.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "../core/fenwicktree.h"
+#include "../core/rangelist.h"
+
+#include <QAbstractProxyModel>
+#include <QRegularExpression>
+#include <QThreadPool>
+#include <QVector>
+
+namespace SubtitleComposer {
+class LinesModel;
+
+/**
+ * @brief Conditions a line has to meet to be shown, all enabled conditions have to be met
+ */
+struct LinesFilter {
+	LinesFilter();
+
+	bool isEmpty() const;
+	bool operator==(const LinesFilter &other) const;
+	inline bool operator!=(const LinesFilter &other) const { return !operator==(other); }
+
+	QString text;                   // matched against primary and secondary plain text, empty disables
+	bool regExp;
+	bool caseSensitive;
+	bool errorsOnly;                // lines with errors other than the user mark
+	bool markedOnly;                // lines with the user mark
+	int timeFrom;                   // milliseconds, lines ending before are hidden, negative disables
+	int timeTo;                     // milliseconds, lines starting after are hidden, negative disables
+	int minDuration;                // milliseconds, zero disables
+	int maxDuration;                // milliseconds, zero disables
+	double minCps;                  // primary text characters per second, zero disables
+	double maxCps;                  // primary text characters per second, zero disables
+};
+
+/**
+ * @brief Proxy model showing only LinesModel rows that pass a LinesFilter.
+ *
+ * Lines are evaluated on a thread pool in chunks of CHUNK_SIZE lines, each job gets a
+ * copy of line texts, times and error flags taken on GUI thread, so lines can be
+ * edited while the filter is running. Changed rows are evaluated again, results of
+ * jobs started before lines were inserted or removed are discarded and all lines are
+ * evaluated again. Shown rows are kept in a FenwickTree so mapping between
+ * model rows and line indexes is O(log n).
+ */
+class LinesFilterModel : public QAbstractProxyModel
+{
+	Q_OBJECT
+
+public:
+	enum {
+		CHUNK_SIZE = 512,
+		MAX_CHUNK_RUNS = 16             ///< more shown/hidden row runs in a chunk result are applied as layout change
+	};
+
+	explicit LinesFilterModel(QObject *parent = Q_NULLPTR);
+	virtual ~LinesFilterModel();
+
+	void setSourceModel(QAbstractItemModel *sourceModel) Q_DECL_OVERRIDE;
+	LinesModel * linesModel() const;
+
+	inline const LinesFilter & filter() const { return m_filter; }
+	void setFilter(const LinesFilter &filter);
+
+	inline bool isFilterActive() const { return !m_filter.isEmpty(); }
+	/// true while rows are shown or hidden because of filter results, not because lines were inserted or removed
+	inline bool isUpdatingRows() const { return m_updatingRows; }
+	/// true while some lines are still being evaluated
+	inline bool isFiltering() const { return m_pendingJobs > 0; }
+
+	inline bool isLineShown(int lineIndex) const { return m_shownLines.value(lineIndex) != 0; }
+	inline int shownLinesCount() const { return m_shownLines.total(); }
+	/// indexes of shown lines, Range::full() if no filter is set
+	RangeList shownRanges() const;
+
+	QModelIndex mapToSource(const QModelIndex &proxyIndex) const Q_DECL_OVERRIDE;
+	QModelIndex mapFromSource(const QModelIndex &sourceIndex) const Q_DECL_OVERRIDE;
+
+	QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const Q_DECL_OVERRIDE;
+	QModelIndex parent(const QModelIndex &child) const Q_DECL_OVERRIDE;
+	int rowCount(const QModelIndex &parent = QModelIndex()) const Q_DECL_OVERRIDE;
+	int columnCount(const QModelIndex &parent = QModelIndex()) const Q_DECL_OVERRIDE;
+	QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const Q_DECL_OVERRIDE;
+
+signals:
+	void filterUpdated();
+
+private slots:
+	void onSourceRowsAboutToBeInserted(const QModelIndex &parent, int first, int last);
+	void onSourceRowsInserted(const QModelIndex &parent, int first, int last);
+	void onSourceRowsAboutToBeRemoved(const QModelIndex &parent, int first, int last);
+	void onSourceRowsRemoved(const QModelIndex &parent, int first, int last);
+	void onSourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &roles);
+	void onSourceModelAboutToBeReset();
+	void onSourceModelReset();
+
+	void onChunkFinished(int generation, int jobId, int firstLine, const QVector<int> &shown);
+
+private:
+	void restartFilter();
+	void filterLines(int firstLine, int lastLine);
+	/// true if result of job @p jobId is current for @p line and it changes its visibility
+	inline bool isChangedBy(int jobId, int line, int shown) const { return m_lineJobs.at(line) == jobId && m_shownLines.value(line) != shown; }
+	void applyRuns(int jobId, int firstLine, const QVector<int> &shown);
+	void applyLayout(int jobId, int firstLine, const QVector<int> &shown);
+
+private:
+	class FilterJob;
+
+	LinesFilter m_filter;
+	QRegularExpression m_regExp;
+
+	FenwickTree m_shownLines;
+	QVector<int> m_lineJobs;            // id of the last job started for each line, older results are ignored
+	bool m_updatingRows;
+	bool m_removingRows;
+
+	QThreadPool m_threadPool;
+	int m_generation;
+	int m_lastJobId;
+	int m_pendingJobs;
+};
+}
+
+#endif // LINESFILTERMODEL_H
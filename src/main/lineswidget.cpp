@@ -30,14 +30,13 @@
 
 #include <QVariant>
 #include <QTimer>
+#include <QSet>
 #include <QEvent>
 #include <QScrollBar>
 #include <QDropEvent>
 #include <QMimeData>
 #include <QPainter>
 #include <QFontMetrics>
-#include <QTextDocument>
-#include <QAbstractTextDocumentLayout>
 #include <QHeaderView>
 
 #include <QIcon>
@@ -47,11 +46,10 @@
 #include <QMenu>
 #include <QUrl>
 
-#if QT_VERSION >= 0x40500
-#define TEXT_DOCUMENT_CORRECTION 4
-#else
-#define TEXT_DOCUMENT_CORRECTION 2
-#endif
+// number of laid out rich text cells kept by each LinesItemDelegate, a few screens worth of rows
+#define TEXT_LAYOUT_CACHE_SIZE 1024
+// style of misspelled words in text columns
+#define MISSPELLED_STYLE "text-decoration:underline;color:#e02020"
 
 using namespace SubtitleComposer;
 
@@ -61,11 +59,13 @@ using namespace SubtitleComposer;
 LinesModel::LinesModel(QObject *parent) :
 	QAbstractListModel(parent),
 	m_subtitle(NULL),
+	m_speller(NULL),
 	m_playingLine(NULL),
 	m_dataChangedTimer(new QTimer(this)),
 	m_minChangedLineIndex(-1),
 	m_maxChangedLineIndex(-1),
-	m_graftPoints(QList<Subtitle *>())
+	m_graftPoints(QList<Subtitle *>()),
+	m_sizeHintDigits(0)
 {
 	m_dataChangedTimer->setInterval(0);
 	m_dataChangedTimer->setSingleShot(true);
@@ -121,6 +121,22 @@ LinesModel::setSubtitle(Subtitle *subtitle)
 	}
 }
 
+void
+LinesModel::setBackgroundSpeller(BackgroundSpeller *speller)
+{
+	if(m_speller)
+		disconnect(m_speller, 0, this, 0);
+
+	m_speller = speller;
+
+	if(m_speller) {
+		connect(m_speller, &BackgroundSpeller::misspellingsChanged, this, &LinesModel::onMisspellingsChanged);
+		connect(m_speller, &BackgroundSpeller::misspellingsReset, this, &LinesModel::onMisspellingsReset);
+	}
+
+	onMisspellingsReset();
+}
+
 const QList<Subtitle *> &
 LinesModel::graftPoints() const
 {
@@ -140,14 +156,14 @@ LinesModel::setPlayingLine(SubtitleLine *line)
 		if(m_playingLine) {
 			int row = m_playingLine->index();
 			m_playingLine = 0;
-			emit dataChanged(index(row, 0), index(row, ColumnCount));
+			emit dataChanged(index(row, 0), index(row, ColumnCount - 1), QVector<int>() << PlayingLineRole);
 		}
 
 		m_playingLine = line;
 
 		if(line) {
 			int row = m_playingLine->index();
-			emit dataChanged(index(row, 0), index(row, ColumnCount));
+			emit dataChanged(index(row, 0), index(row, ColumnCount - 1), QVector<int>() << PlayingLineRole);
 		}
 	}
 }
@@ -224,10 +240,72 @@ LinesModel::headerData(int section, Qt::Orientation orientation, int role) const
 	}
 }
 
+const LinesModel::RowCache &
+LinesModel::rowCache(int row) const
+{
+	RowCache &cache = m_rowCache[row];
+	if(!cache.valid) {
+		const SubtitleLine *line = m_subtitle->line(row);
+		cache.valid = true;
+		cache.anchored = m_subtitle->anchoredLines().contains(line);
+		cache.showTime = line->showTime().toString();
+		cache.hideTime = line->hideTime().toString();
+		cache.primaryText = richText(line->primaryText(), &cache.primaryMisspellings);
+		cache.secondaryText = richText(line->secondaryText(), &cache.secondaryMisspellings);
+	}
+	return cache;
+}
+
+QString
+LinesModel::richText(const SString &text, quint32 *misspellingsRevision) const
+{
+	*misspellingsRevision = 0;
+	const BackgroundSpeller::Misspellings misspellings = m_speller ? m_speller->misspellings(text.string(), 0, misspellingsRevision) : BackgroundSpeller::Misspellings();
+	if(misspellings.isEmpty())
+		return text.richString();
+
+	QString richText;
+	int end = 0;
+	foreach(const BackgroundSpeller::Misspelling &misspelling, misspellings) {
+		richText += text.mid(end, misspelling.start - end).richString();
+		richText += QStringLiteral("<span style=\"" MISSPELLED_STYLE "\">");
+		richText += text.mid(misspelling.start, misspelling.length).richString();
+		richText += QStringLiteral("</span>");
+		end = misspelling.start + misspelling.length;
+	}
+	richText += text.mid(end).richString();
+	return richText;
+}
+
+void
+LinesModel::invalidateRowCache(int firstRow, int lastRow)
+{
+	if(firstRow < 0)
+		return;
+
+	lastRow = qMin(lastRow, m_rowCache.size() - 1);
+	for(int row = firstRow; row <= lastRow; row++)
+		m_rowCache[row].valid = false;
+}
+
+void
+LinesModel::updateSizeHints() const
+{
+	// all rows get the hint of the widest line number, so it only changes with number of digits
+	const int digits = QString::number(rowCount()).length();
+	if(m_sizeHintDigits == digits)
+		return;
+
+	const QFontMetrics fontMetrics((QFont()));
+	m_sizeHintDigits = digits;
+	m_numberSizeHint = QSize(fontMetrics.width(QString(digits, QChar('0'))) + 28, 0);
+	m_timeSizeHint = QSize(fontMetrics.width(Time().toString()) + 16, 0);
+}
+
 QVariant
 LinesModel::data(const QModelIndex &index, int role) const
 {
-	if(!m_subtitle)
+	if(!m_subtitle || index.row() >= m_rowCache.size())
 		return QVariant();
 
 	SubtitleLine *line = m_subtitle->line(index.row());
@@ -235,36 +313,55 @@ LinesModel::data(const QModelIndex &index, int role) const
 	if(role == PlayingLineRole)
 		return line == m_playingLine;
 
-	if(role == AnchoredRole) {
-		const QList<const SubtitleLine *> &anchors = m_subtitle->anchoredLines();
-		return anchors.empty() ? 0 : (anchors.indexOf(line) != -1 ? 1 : -1);
+	if(role == AnchoredRole)
+		return m_subtitle->anchoredLines().empty() ? 0 : (rowCache(index.row()).anchored ? 1 : -1);
+
+	if(role == TextRevisionRole)
+		return line->textRevision();
+
+	if(role == MisspellingsRole) {
+		if(index.column() == Text)
+			return rowCache(index.row()).primaryMisspellings;
+		if(index.column() == Translation)
+			return rowCache(index.row()).secondaryMisspellings;
+		return 0;
 	}
 
 	switch(index.column()) {
 	case Number:
 		if(role == Qt::DisplayRole)
 			return index.row() + 1;
-		if(role == Qt::SizeHintRole)
-			return QSize(QFontMetrics(QFont()).width(QString::number(index.row() + 1)) + 28, 0);
+		if(role == Qt::SizeHintRole) {
+			updateSizeHints();
+			return m_numberSizeHint;
+		}
 		break;
 
 	case ShowTime:
 		if(role == Qt::DisplayRole)
-			return line->showTime().toString();
+			return rowCache(index.row()).showTime;
 		if(role == Qt::TextAlignmentRole)
 			return Qt::AlignCenter;
+		if(role == Qt::SizeHintRole) {
+			updateSizeHints();
+			return m_timeSizeHint;
+		}
 		break;
 
 	case HideTime:
 		if(role == Qt::DisplayRole)
-			return line->hideTime().toString();
+			return rowCache(index.row()).hideTime;
 		if(role == Qt::TextAlignmentRole)
 			return Qt::AlignCenter;
+		if(role == Qt::SizeHintRole) {
+			updateSizeHints();
+			return m_timeSizeHint;
+		}
 		break;
 
 	case Text:
 		if(role == Qt::DisplayRole)
-			return line->primaryText().richString();
+			return rowCache(index.row()).primaryText;
 		if(role == MarkedRole)
 			return line->errorFlags() & SubtitleLine::UserMark;
 		if(role == ErrorRole)
@@ -277,7 +374,7 @@ LinesModel::data(const QModelIndex &index, int role) const
 
 	case Translation:
 		if(role == Qt::DisplayRole)
-			return m_subtitle->line(index.row())->secondaryText().richString();
+			return rowCache(index.row()).secondaryText;
 		if(role == MarkedRole)
 			return line->errorFlags() & SubtitleLine::UserMark;
 		if(role == ErrorRole)
@@ -332,6 +429,7 @@ LinesModel::onLinesInserted(int firstIndex, int lastIndex)
 	static const QModelIndex rootIndex;
 
 	beginInsertRows(rootIndex, firstIndex, lastIndex);
+	m_rowCache.insert(firstIndex, lastIndex - firstIndex + 1, RowCache());
 	endInsertRows();                        // ridiculously costly operation
 }
 
@@ -341,6 +439,7 @@ LinesModel::onLinesRemoved(int firstIndex, int lastIndex)
 	static const QModelIndex rootIndex;
 
 	beginRemoveRows(rootIndex, firstIndex, lastIndex);
+	m_rowCache.remove(firstIndex, lastIndex - firstIndex + 1);
 	endRemoveRows();
 }
 
@@ -349,6 +448,9 @@ LinesModel::onLineChanged(const SubtitleLine *line)
 {
 	int lineIndex = line->index();
 
+	// row is formatted again on next paint, other changes are collected until emitDataChanged()
+	invalidateRowCache(lineIndex, lineIndex);
+
 	if(m_minChangedLineIndex < 0) {
 		m_minChangedLineIndex = lineIndex;
 		m_maxChangedLineIndex = lineIndex;
@@ -359,6 +461,46 @@ LinesModel::onLineChanged(const SubtitleLine *line)
 		m_maxChangedLineIndex = lineIndex;
 }
 
+void
+LinesModel::onMisspellingsChanged(const QStringList &texts)
+{
+	if(!m_subtitle || m_rowCache.isEmpty())
+		return;
+
+	// misspellings are only known for texts, only rows showing them are formatted again
+	const QSet<QString> changedTexts = texts.toSet();
+	int firstRow = -1;
+	for(int row = 0, lastRow = m_rowCache.size() - 1; row <= lastRow; row++) {
+		const SubtitleLine *line = m_subtitle->line(row);
+		if(changedTexts.contains(line->primaryText().string()) || changedTexts.contains(line->secondaryText().string())) {
+			if(firstRow < 0)
+				firstRow = row;
+			continue;
+		}
+		if(firstRow >= 0) {
+			emitMisspellingsChanged(firstRow, row - 1);
+			firstRow = -1;
+		}
+	}
+	if(firstRow >= 0)
+		emitMisspellingsChanged(firstRow, m_rowCache.size() - 1);
+}
+
+void
+LinesModel::onMisspellingsReset()
+{
+	if(!m_rowCache.isEmpty())
+		emitMisspellingsChanged(0, m_rowCache.size() - 1);
+}
+
+void
+LinesModel::emitMisspellingsChanged(int firstRow, int lastRow)
+{
+	// views only repaint, filtered lines don't depend on misspellings
+	invalidateRowCache(firstRow, lastRow);
+	emit dataChanged(index(firstRow, Text), index(lastRow, Translation), QVector<int>() << MisspellingsRole);
+}
+
 void
 LinesModel::emitDataChanged()
 {
@@ -380,14 +522,22 @@ LinesItemDelegate::LinesItemDelegate(bool useStyle, bool singleLineMode, bool ri
 	QStyledItemDelegate(parent),
 	m_useStyle(useStyle),
 	m_singleLineMode(singleLineMode),
-	m_textDocument(0)
+	m_richTextMode(richTextMode),
+	m_textLayouts(TEXT_LAYOUT_CACHE_SIZE)
 {
-	setRichTextMode(richTextMode);
 }
 
 LinesItemDelegate::~LinesItemDelegate()
 {
-	delete m_textDocument;
+}
+
+namespace SubtitleComposer {
+uint
+qHash(const LinesItemDelegate::TextLayoutKey &key, uint seed)
+{
+	return ::qHash(key.textRevision, seed) ^ ::qHash(key.misspellings << 4, seed) ^ ::qHash(key.column, seed) ^ ::qHash(key.width << 8, seed)
+		^ ::qHash(key.color, seed) ^ ::qHash(key.alignment << 16, seed);
+}
 }
 
 bool
@@ -411,31 +561,25 @@ LinesItemDelegate::singleLineMode() const
 void
 LinesItemDelegate::setSingleLineMode(bool singleLineMode)
 {
-	m_singleLineMode = singleLineMode;
+	if(m_singleLineMode != singleLineMode) {
+		m_singleLineMode = singleLineMode;
+		// cached layouts were built from text with differently replaced newlines
+		m_textLayouts.clear();
+	}
 }
 
 bool
 LinesItemDelegate::richTextMode() const
 {
-	return m_textDocument != 0;
+	return m_richTextMode;
 }
 
 void
 LinesItemDelegate::setRichTextMode(bool richTextMode)
 {
-	if(richTextMode != (m_textDocument != 0)) {
-		if(richTextMode) {
-			QTextOption defaultTextOption;
-			defaultTextOption.setWrapMode(QTextOption::NoWrap);
-
-			m_textDocument = new QTextDocument();
-			m_textDocument->setDefaultTextOption(defaultTextOption);
-			m_textDocument->setUndoRedoEnabled(false);
-			m_textDocument->setDefaultStyleSheet("p { display: inline; white-space: pre; vertical-align: baseline; margin-bottom: 0px; margin-top: 0px }");
-		} else {
-			delete m_textDocument;
-			m_textDocument = 0;
-		}
+	if(m_richTextMode != richTextMode) {
+		m_richTextMode = richTextMode;
+		m_textLayouts.clear();
 	}
 }
 
@@ -513,30 +657,40 @@ LinesItemDelegate::drawTextPrimitive(QPainter *painter, const QStyle *style, con
 
 	QRect textRect = rect.adjusted(textMargin, 0, -textMargin, 0);  // remove width padding
 
-	QString text = QString(option.text);
-
 	QFontMetrics fm = painter->fontMetrics();
-	text = fm.elidedText(option.text, option.textElideMode, textRect.width());
-
-	if(m_textDocument) {
-		QTextOption textOption;
-		textOption.setTextDirection(option.direction);
-		textOption.setAlignment((Qt::Alignment)alignment);
 
-		m_textDocument->setDefaultTextOption(textOption);
-		m_textDocument->setTextWidth(textRect.width() - textMargin);
-		m_textDocument->setHtml("<p>" + text + "</p>");
+	if(m_richTextMode) {
+		const QColor textColor = option.palette.color(cg, option.state & QStyle::State_Selected ? QPalette::HighlightedText : QPalette::Text);
+		const int textWidth = textRect.width() - textMargin;
 
-		QPalette palette(option.palette);
-		palette.setColor(QPalette::Text, palette.color(cg, option.state & QStyle::State_Selected ? QPalette::HighlightedText : QPalette::Text));
+		if(m_textLayoutFont != option.font) {
+			m_textLayoutFont = option.font;
+			m_textLayouts.clear();
+		}
 
-		QAbstractTextDocumentLayout::PaintContext context;
-		context.palette = palette;
+		// text color is baked into the layout, so selected rows have their own entries
+		const TextLayoutKey key = { index.data(LinesModel::TextRevisionRole).toUInt(), index.data(LinesModel::MisspellingsRole).toUInt(), index.column(), textWidth, textColor.rgba(), alignment | (option.direction << 16) };
+		QStaticText *staticText = m_textLayouts.object(key);
+		if(!staticText) {
+			QTextOption textOption;
+			textOption.setTextDirection(option.direction);
+			textOption.setAlignment((Qt::Alignment)alignment);
+
+			const QString text = fm.elidedText(option.text, option.textElideMode, textRect.width());
+			staticText = new QStaticText(QStringLiteral("<span style=\"white-space:pre\">") + text + QStringLiteral("</span>"));
+			staticText->setTextFormat(Qt::RichText);
+			staticText->setTextOption(textOption);
+			staticText->setTextWidth(textWidth);
+			painter->setPen(textColor);
+			staticText->prepare(painter->transform(), option.font);
+			m_textLayouts.insert(key, staticText);
+		}
 
-		painter->translate(textRect.x() - TEXT_DOCUMENT_CORRECTION, textRect.y() - TEXT_DOCUMENT_CORRECTION);
-		m_textDocument->documentLayout()->draw(painter, context);
-		painter->translate(-textRect.x() + TEXT_DOCUMENT_CORRECTION, -textRect.y() + TEXT_DOCUMENT_CORRECTION);
+		painter->setPen(textColor);
+		painter->drawStaticText(textRect.topLeft(), *staticText);
 	} else {
+		const QString text = fm.elidedText(option.text, option.textElideMode, textRect.width());
+
 		QColor textColor;
 		if(option.state & QStyle::State_Selected)
 			textColor = option.palette.color(cg, QPalette::HighlightedText);
@@ -714,7 +868,9 @@ LinesWidget::LinesWidget(QWidget *parent) :
 	m_translationMode(false),
 	m_showingContextMenu(false)
 {
-	setModel(new LinesModel(this));
+	LinesFilterModel *filterModel = new LinesFilterModel(this);
+	filterModel->setSourceModel(new LinesModel(this));
+	setModel(filterModel);
 
 	LinesItemDelegate *plainTextDelegate = new LinesItemDelegate(true, true, false, this);
 	LinesItemDelegate *richTextDelegate = new LinesItemDelegate(true, true, true, this);
@@ -785,7 +941,7 @@ LinesWidget::closeEditor(QWidget *editor, QAbstractItemDelegate::EndEditHint hin
 			editCurrentLineInPlace(editorIndex.column() == LinesModel::Text);
 		break;
 	case LinesItemDelegate::EditLowerItem:
-		if(editorIndex.row() < model()->rowCount() - 1)
+		if(editorIndex.row() < filterModel()->rowCount() - 1)
 			editCurrentLineInPlace(editorIndex.column() == LinesModel::Text);
 		break;
 
@@ -795,7 +951,7 @@ LinesWidget::closeEditor(QWidget *editor, QAbstractItemDelegate::EndEditHint hin
 		break;
 
 	case LinesItemDelegate::EditNextItem:
-		if(editorIndex.row() < model()->rowCount() - 1 || (m_translationMode && editorIndex.column() == LinesModel::Text))
+		if(editorIndex.row() < filterModel()->rowCount() - 1 || (m_translationMode && editorIndex.column() == LinesModel::Text))
 			editCurrentLineInPlace(editorIndex.column() != LinesModel::Text);
 		break;
 	}
@@ -806,10 +962,14 @@ LinesWidget::rowsAboutToBeRemoved(const QModelIndex &parent, int start, int end)
 {
 	TreeView::rowsAboutToBeRemoved(parent, start, end);
 
-	selectionModel()->select(model()->index(end + 1, 0, parent), QItemSelectionModel::Rows | QItemSelectionModel::ClearAndSelect | QItemSelectionModel::Current);
+	// rows hidden by the filter don't move the selection
+	if(filterModel()->isUpdatingRows())
+		return;
+
+	selectionModel()->select(filterModel()->index(end + 1, 0, parent), QItemSelectionModel::Rows | QItemSelectionModel::ClearAndSelect | QItemSelectionModel::Current);
 
 	if(m_scrollFollowsModel) {
-		scrollTo(model()->index(end + 1, 0, parent), QAbstractItemView::EnsureVisible);
+		scrollTo(filterModel()->index(end + 1, 0, parent), QAbstractItemView::EnsureVisible);
 	}
 }
 
@@ -818,16 +978,20 @@ LinesWidget::rowsInserted(const QModelIndex &parent, int start, int end)
 {
 	TreeView::rowsInserted(parent, start, end);
 
-	if(model()->rowCount() != (end - start + 1)) {  // there were other rows previously
-		selectionModel()->select(QItemSelection(model()->index(start, 0, parent), model()->index(end, 0, parent)), QItemSelectionModel::Rows | QItemSelectionModel::ClearAndSelect);
+	// rows shown by the filter don't move the selection
+	if(filterModel()->isUpdatingRows())
+		return;
+
+	if(filterModel()->rowCount() != (end - start + 1)) {  // there were other rows previously
+		selectionModel()->select(QItemSelection(filterModel()->index(start, 0, parent), filterModel()->index(end, 0, parent)), QItemSelectionModel::Rows | QItemSelectionModel::ClearAndSelect);
 
 		if(m_scrollFollowsModel) {
-			scrollTo(model()->index(start, 0, parent), QAbstractItemView::EnsureVisible);
+			scrollTo(filterModel()->index(start, 0, parent), QAbstractItemView::EnsureVisible);
 		}
 	}
 
 	if(m_scrollFollowsModel) {
-		selectionModel()->setCurrentIndex(model()->index(start, 0, parent), QItemSelectionModel::Rows | QItemSelectionModel::SelectCurrent);
+		selectionModel()->setCurrentIndex(filterModel()->index(start, 0, parent), QItemSelectionModel::Rows | QItemSelectionModel::SelectCurrent);
 	}
 }
 
@@ -836,7 +1000,7 @@ LinesWidget::editCurrentLineInPlace(bool primaryText)
 {
 	QModelIndex currentIndex = this->currentIndex();
 	if(currentIndex.isValid()) {
-		currentIndex = model()->index(currentIndex.row(), primaryText || !m_translationMode ? LinesModel::Text : LinesModel::Translation);
+		currentIndex = filterModel()->index(currentIndex.row(), primaryText || !m_translationMode ? LinesModel::Text : LinesModel::Translation);
 
 		setCurrentIndex(currentIndex);
 
@@ -854,23 +1018,22 @@ SubtitleLine *
 LinesWidget::currentLine() const
 {
 	QModelIndex currentIndex = this->currentIndex();
-	return currentIndex.isValid() ? model()->subtitle()->line(currentIndex.row()) : 0;
+	return currentIndex.isValid() ? model()->subtitle()->line(lineIndex(currentIndex)) : 0;
 }
 
 int
 LinesWidget::currentLineIndex() const
 {
-	QModelIndex currentIndex = this->currentIndex();
-	return currentIndex.isValid() ? currentIndex.row() : -1;
+	return lineIndex(currentIndex());
 }
 
 int
 LinesWidget::firstSelectedIndex() const
 {
 	QItemSelectionModel *selection = selectionModel();
-	for(int row = 0, rowCount = model()->rowCount(); row < rowCount; ++row)
-		if(selection->isSelected(model()->index(row, 0)))
-			return row;
+	for(int row = 0, rowCount = filterModel()->rowCount(); row < rowCount; ++row)
+		if(selection->isSelected(filterModel()->index(row, 0)))
+			return lineIndex(filterModel()->index(row, 0));
 	return -1;
 }
 
@@ -878,9 +1041,9 @@ int
 LinesWidget::lastSelectedIndex() const
 {
 	QItemSelectionModel *selection = selectionModel();
-	for(int row = model()->rowCount() - 1; row >= 0; --row)
-		if(selection->isSelected(model()->index(row, 0)))
-			return row;
+	for(int row = filterModel()->rowCount() - 1; row >= 0; --row)
+		if(selection->isSelected(filterModel()->index(row, 0)))
+			return lineIndex(filterModel()->index(row, 0));
 	return -1;
 }
 
@@ -891,19 +1054,20 @@ LinesWidget::selectionHasMultipleRanges() const
 
 	QItemSelectionModel *selection = selectionModel();
 
-	int rangeFirstRow = -1, row = 0;
-	for(int rowCount = model()->rowCount(); row < rowCount; ++row) {
-		if(selection->isSelected(model()->index(row, 0))) {
-			if(rangeFirstRow == -1) { // mark start of selected range
-				rangeFirstRow = row;
-
+	// adjacent rows of filtered view can be lines from different ranges
+	int prevLine = -2;
+	for(int row = 0, rowCount = filterModel()->rowCount(); row < rowCount; ++row) {
+		const QModelIndex index = filterModel()->index(row, 0);
+		if(selection->isSelected(index)) {
+			const int line = lineIndex(index);
+			if(line != prevLine + 1) { // mark start of selected range
 				selectionRanges++;
 				if(selectionRanges > 1)
 					break;
 			}
+			prevLine = line;
 		} else {
-			if(rangeFirstRow != -1)
-				rangeFirstRow = -1;
+			prevLine = -2;
 		}
 	}
 
@@ -917,21 +1081,22 @@ LinesWidget::selectionRanges() const
 
 	QItemSelectionModel *selection = selectionModel();
 
-	int rangeFirstRow = -1, row = 0;
-	for(const int rowCount = model()->rowCount(); row < rowCount; ++row) {
-		if(selection->isSelected(model()->index(row, 0))) {
-			if(rangeFirstRow == -1) // mark start of selected range
-				rangeFirstRow = row;
-		} else {
-			if(rangeFirstRow != -1) {
-				ranges << Range(rangeFirstRow, row - 1);
-				rangeFirstRow = -1;
-			}
+	// adjacent rows of filtered view can be lines from different ranges
+	int rangeFirstLine = -1, prevLine = -1;
+	for(int row = 0, rowCount = filterModel()->rowCount(); row < rowCount; ++row) {
+		const QModelIndex index = filterModel()->index(row, 0);
+		const int line = selection->isSelected(index) ? lineIndex(index) : -1;
+		if(rangeFirstLine != -1 && line != prevLine + 1) {
+			ranges << Range(rangeFirstLine, prevLine);
+			rangeFirstLine = -1;
 		}
+		if(line != -1 && rangeFirstLine == -1) // mark start of selected range
+			rangeFirstLine = line;
+		prevLine = line;
 	}
 
-	if(rangeFirstRow != -1)
-		ranges << Range(rangeFirstRow, row - 1);
+	if(rangeFirstLine != -1)
+		ranges << Range(rangeFirstLine, prevLine);
 
 	return ranges;
 }
@@ -939,16 +1104,25 @@ LinesWidget::selectionRanges() const
 RangeList
 LinesWidget::targetRanges(int target) const
 {
+	// with the filter set, actions don't touch hidden lines
 	switch(target) {
 	case ActionWithTargetDialog::AllLines:
-		return Range::full();
+		return filterModel()->shownRanges();
 	case ActionWithTargetDialog::Selection: return selectionRanges();
 	case ActionWithTargetDialog::FromSelected: {
 		int index = firstSelectedIndex();
-		return index < 0 ? RangeList() : Range::upper(index);
+		if(index < 0)
+			return RangeList();
+		RangeList ranges = filterModel()->shownRanges();
+		ranges.trimToRange(Range::upper(index));
+		return ranges;
 	} case ActionWithTargetDialog::UpToSelected: {
 		int index = lastSelectedIndex();
-		return index < 0 ? RangeList() : Range::lower(index);
+		if(index < 0)
+			return RangeList();
+		RangeList ranges = filterModel()->shownRanges();
+		ranges.trimToRange(Range::lower(index));
+		return ranges;
 	}
 	default:
 		return RangeList();
@@ -985,6 +1159,12 @@ LinesWidget::setSubtitle(Subtitle *subtitle)
 	model()->setSubtitle(subtitle);
 }
 
+void
+LinesWidget::setBackgroundSpeller(BackgroundSpeller *speller)
+{
+	model()->setBackgroundSpeller(speller);
+}
+
 void
 LinesWidget::setTranslationMode(bool enabled)
 {
@@ -1009,8 +1189,10 @@ LinesWidget::setTranslationMode(bool enabled)
 void
 LinesWidget::setCurrentLine(SubtitleLine *line, bool clearSelection)
 {
-	if(line) {
-		selectionModel()->setCurrentIndex(model()->index(line->index(), 0), clearSelection ? QItemSelectionModel::Select | QItemSelectionModel::Rows | QItemSelectionModel::Clear : QItemSelectionModel::Select | QItemSelectionModel::Rows);
+	// lines hidden by the filter can't become current
+	const QModelIndex index = line ? filterModel()->mapFromSource(model()->index(line->index(), 0)) : QModelIndex();
+	if(index.isValid()) {
+		selectionModel()->setCurrentIndex(index, clearSelection ? QItemSelectionModel::Select | QItemSelectionModel::Rows | QItemSelectionModel::Clear : QItemSelectionModel::Select | QItemSelectionModel::Rows);
 	}
 }
 
@@ -1025,7 +1207,7 @@ LinesWidget::mouseDoubleClickEvent(QMouseEvent *e)
 {
 	QModelIndex index = indexAt(viewport()->mapFromGlobal(e->globalPos()));
 	if(index.isValid())
-		emit lineDoubleClicked(model()->subtitle()->line(index.row()));
+		emit lineDoubleClicked(model()->subtitle()->line(lineIndex(index)));
 }
 
 bool
@@ -1063,9 +1245,9 @@ LinesWidget::contextMenuEvent(QContextMenuEvent *e)
 {
 	SubtitleLine *referenceLine = 0;
 	QItemSelectionModel *selection = selectionModel();
-	for(int row = 0, rowCount = model()->rowCount(); row < rowCount; ++row) {
-		if(selection->isSelected(model()->index(row, 0))) {
-			referenceLine = model()->subtitle()->line(row);
+	for(int row = 0, rowCount = filterModel()->rowCount(); row < rowCount; ++row) {
+		if(selection->isSelected(filterModel()->index(row, 0))) {
+			referenceLine = model()->subtitle()->line(lineIndex(filterModel()->index(row, 0)));
 			break;
 		}
 	}
@@ -1154,7 +1336,7 @@ void
 LinesWidget::onCurrentRowChanged()
 {
 	QModelIndex current = this->currentIndex();
-	emit currentLineChanged(current.isValid() ? model()->subtitle()->line(current.row()) : 0);
+	emit currentLineChanged(current.isValid() ? model()->subtitle()->line(lineIndex(current)) : 0);
 }
 
 void
@@ -1196,8 +1378,8 @@ LinesWidget::drawRow(QPainter *painter, const QStyleOptionViewItem &option, cons
 	const int row = index.row();
 	const bool rowSelected = selectionModel()->isSelected(index);
 	const QPalette palette = this->palette();
-	const QRect rowRect = QRect(visualRect(model()->index(row, 0)).topLeft(),
-								visualRect(model()->index(row, visibleColumns - 1)).bottomRight()
+	const QRect rowRect = QRect(visualRect(filterModel()->index(row, 0)).topLeft(),
+								visualRect(filterModel()->index(row, visibleColumns - 1)).bottomRight()
 								);
 
 	// draw row grid
@@ -1205,7 +1387,7 @@ LinesWidget::drawRow(QPainter *painter, const QStyleOptionViewItem &option, cons
 	if(!rowSelected)
 		drawHorizontalDotLine(painter, rowRect.left(), rowRect.right(), rowRect.bottom());
 	for(int column = 0; column < visibleColumns - 1; ++column) {
-		const QRect cellRect = visualRect(model()->index(row, column));
+		const QRect cellRect = visualRect(filterModel()->index(row, column));
 		drawVerticalDotLine(painter, cellRect.right(), rowRect.top(), rowRect.bottom());
 	}
 	if(index.row() == currentIndex().row()) {
@@ -20,10 +20,12 @@
  *   Boston, MA 02110-1301, USA.                                           *
  ***************************************************************************/
 
+#include "linesfiltermodel.h"
 #include "../core/rangelist.h"
 #include "../core/subtitle.h"
 #include "../core/subtitleline.h"
 #include "../widgets/treeview.h"
+#include "utils/backgroundspeller.h"
 
 #include <QAbstractItemModel>
 #include <QStyledItemDelegate>
@@ -32,8 +34,11 @@
 #include <QIcon>
 #include <QPixmap>
 #include <QList>
+#include <QVector>
+#include <QCache>
+#include <QFont>
+#include <QStaticText>
 
-QT_FORWARD_DECLARE_CLASS(QTextDocument)
 QT_FORWARD_DECLARE_CLASS(QTimer)
 
 namespace SubtitleComposer {
@@ -43,13 +48,15 @@ class LinesModel : public QAbstractListModel
 
 public:
 	enum { Number = 0, ShowTime, HideTime, Text, Translation, ColumnCount };
-	enum { PlayingLineRole = Qt::UserRole, MarkedRole, ErrorRole, AnchoredRole };
+	enum { PlayingLineRole = Qt::UserRole, MarkedRole, ErrorRole, AnchoredRole, TextRevisionRole, MisspellingsRole };
 
 	explicit LinesModel(QObject *parent = 0);
 
 	Subtitle * subtitle() const;
 	void setSubtitle(Subtitle *subtitle);
 
+	void setBackgroundSpeller(BackgroundSpeller *speller);
+
 	const QList<Subtitle *> & graftPoints() const;
 
 	SubtitleLine * playingLine() const;
@@ -70,18 +77,48 @@ private slots:
 	void onLinesRemoved(int firstIndex, int lastIndex);
 
 	void onLineChanged(const SubtitleLine *line);
+	void onMisspellingsChanged(const QStringList &texts);
+	void onMisspellingsReset();
 	void emitDataChanged();
 
 private:
+	/**
+	 * @brief Display data of one row, formatted the first time the row is shown
+	 */
+	struct RowCache {
+		RowCache() : valid(false), anchored(false), primaryMisspellings(0), secondaryMisspellings(0) {}
+
+		bool valid;
+		bool anchored;
+		QString showTime;
+		QString hideTime;
+		QString primaryText;
+		QString secondaryText;
+		quint32 primaryMisspellings;    // revision of misspellings from background speller, 0 if there are none
+		quint32 secondaryMisspellings;
+	};
+
 	static QString buildToolTip(SubtitleLine *line, bool primary);
+	QString richText(const SString &text, quint32 *misspellingsRevision) const;
+	void emitMisspellingsChanged(int firstRow, int lastRow);
+
+	const RowCache & rowCache(int row) const;
+	void invalidateRowCache(int firstRow, int lastRow);
+	void updateSizeHints() const;
 
 private:
 	Subtitle *m_subtitle;
+	BackgroundSpeller *m_speller;
 	SubtitleLine *m_playingLine;
 	QTimer *m_dataChangedTimer;
 	int m_minChangedLineIndex;
 	int m_maxChangedLineIndex;
 	QList<Subtitle *> m_graftPoints;
+
+	mutable QVector<RowCache> m_rowCache;
+	mutable int m_sizeHintDigits;           // digits of the row count size hints were computed for
+	mutable QSize m_numberSizeHint;
+	mutable QSize m_timeSizeHint;
 };
 
 class LinesWidget;
@@ -132,9 +169,30 @@ protected:
 	void drawTextPrimitive(QPainter *painter, const QStyle *style, const QStyleOptionViewItem &option, const QRect &rect, QPalette::ColorGroup cg, const QModelIndex &index) const;
 
 private:
+	/**
+	 * @brief Identifies laid out rich text of a cell, text revisions never repeat so they identify line text
+	 */
+	struct TextLayoutKey {
+		quint32 textRevision;
+		quint32 misspellings;
+		int column;
+		int width;
+		QRgb color;
+		int alignment;
+
+		inline bool operator==(const TextLayoutKey &other) const {
+			return textRevision == other.textRevision && misspellings == other.misspellings && column == other.column && width == other.width
+				&& color == other.color && alignment == other.alignment;
+		}
+	};
+	friend uint qHash(const TextLayoutKey &key, uint seed);
+
 	bool m_useStyle;
 	bool m_singleLineMode;
-	QTextDocument *m_textDocument;
+	bool m_richTextMode;
+
+	mutable QCache<TextLayoutKey, QStaticText> m_textLayouts;
+	mutable QFont m_textLayoutFont;     // font of cached layouts, they are dropped when it changes
 };
 
 class LinesWidget : public TreeView
@@ -147,6 +205,8 @@ public:
 
 	bool showingContextMenu();
 
+	void setBackgroundSpeller(BackgroundSpeller *speller);
+
 	SubtitleLine * currentLine() const;
 	int currentLineIndex() const;
 
@@ -156,7 +216,8 @@ public:
 	RangeList selectionRanges() const;
 	RangeList targetRanges(int target) const;
 
-	inline LinesModel * model() const { return static_cast<LinesModel *>(TreeView::model()); }
+	inline LinesFilterModel * filterModel() const { return static_cast<LinesFilterModel *>(TreeView::model()); }
+	inline LinesModel * model() const { return filterModel()->linesModel(); }
 
 	void loadConfig();
 	void saveConfig();
@@ -191,6 +252,9 @@ private:
 
 	virtual void drawRow(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const;
 
+	/// line index of a (filtered) view row, -1 for invalid index
+	inline int lineIndex(const QModelIndex &index) const { return index.isValid() ? filterModel()->mapToSource(index).row() : -1; }
+
 private slots:
 	void onCurrentRowChanged();
 
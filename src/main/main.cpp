@@ -21,6 +21,7 @@
 #include "application.h"
 #include "mainwindow.h"
 #include "../common/commondefs.h"
+#include "../profiler.h"
 
 #include <KAboutData>
 #include <KLocalizedString>
@@ -110,9 +111,13 @@ main(int argc, char **argv)
 	// handle standard options
 	aboutData.processCommandLine(&parser);
 
-	app.init();
+	{
+		PROFILE2("Application startup");
 
-	app.mainWindow()->show();
+		app.init();
+
+		app.mainWindow()->show();
+	}
 
 	// load files
 	const QStringList args = parser.positionalArguments();
@@ -22,7 +22,9 @@
 #include "application.h"
 #include "playerwidget.h"
 #include "lineswidget.h"
+#include "linesfilterbar.h"
 #include "currentlinewidget.h"
+#include "findresultswidget.h"
 #include "../videoplayer/videoplayer.h"
 #include "../widgets/waveformwidget.h"
 
@@ -71,18 +73,36 @@ MainWindow::MainWindow() :
 	addDockWidget(Qt::TopDockWidgetArea, playerDock);
 
 
+	m_findResultsDock = new QDockWidget(i18n("Find Results"), this);
+	m_findResultsDock->setObjectName(QStringLiteral("find_results_dock"));
+	m_findResultsDock->setAllowedAreas(Qt::AllDockWidgetAreas);
+	m_findResultsDock->setFeatures(QDockWidget::DockWidgetMovable | QDockWidget::DockWidgetClosable);
+	m_findResultsDock->setFloating(false);
+
+	m_findResultsWidget = new FindResultsWidget(m_findResultsDock);
+
+	m_findResultsDock->setWidget(m_findResultsWidget);
+	addDockWidget(Qt::BottomDockWidgetArea, m_findResultsDock);
+	m_findResultsDock->hide();
+
+
 	QWidget *mainWidget = new QWidget(this);
 	mainWidget->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
 
 	m_linesWidget = new LinesWidget(mainWidget);
 	m_linesWidget->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
 
+	m_linesFilterBar = new LinesFilterBar(mainWidget);
+	m_linesFilterBar->setFilterModel(m_linesWidget->filterModel());
+	m_linesFilterBar->hide();
+
 	m_curLineWidget = new CurrentLineWidget(mainWidget);
 	m_curLineWidget->setMaximumHeight(m_curLineWidget->minimumSizeHint().height());
 
 	QLayout *mainWidgetLayout = new QBoxLayout(QBoxLayout::TopToBottom, mainWidget);
 	mainWidgetLayout->setContentsMargins(5, 1, 5, 2);
 	mainWidgetLayout->setSpacing(5);
+	mainWidgetLayout->addWidget(m_linesFilterBar);
 	mainWidgetLayout->addWidget(m_linesWidget);
 	mainWidgetLayout->addWidget(m_curLineWidget);
 
@@ -25,9 +25,13 @@
 
 #include <kxmlguiwindow.h>
 
+QT_FORWARD_DECLARE_CLASS(QDockWidget)
+
 namespace SubtitleComposer {
 class PlayerWidget;
 class LinesWidget;
+class LinesFilterBar;
+class FindResultsWidget;
 class CurrentLineWidget;
 class WaveformWidget;
 
@@ -53,8 +57,11 @@ protected:
 protected:
 	PlayerWidget *m_playerWidget;
 	LinesWidget *m_linesWidget;
+	LinesFilterBar *m_linesFilterBar;
 	CurrentLineWidget *m_curLineWidget;
 	WaveformWidget *m_waveformWidget;
+	QDockWidget *m_findResultsDock;
+	FindResultsWidget *m_findResultsWidget;
 };
 }
 #endif
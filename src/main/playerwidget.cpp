@@ -54,6 +54,8 @@ using namespace SubtitleComposer;
 #define MAGIC_NUMBER -1
 #define HIDE_MOUSE_MSECS 1000
 #define UNKNOWN_LENGTH_STRING (" / " + Time().toString(false) + ' ')
+// overlays of this many lines following the shown one are rendered in advance
+#define OVERLAY_PRERENDER_LINES 3
 
 PlayerWidget::PlayerWidget(QWidget *parent) :
 	QWidget(parent),
@@ -61,6 +63,8 @@ PlayerWidget::PlayerWidget(QWidget *parent) :
 	m_translationMode(false),
 	m_showTranslation(false),
 	m_overlayLine(0),
+	m_shownLine(nullptr),
+	m_shownLineRevision(0),
 	m_playingLine(nullptr),
 	m_pauseAfterPlayingLine(nullptr),
 	m_fullScreenTID(0),
@@ -257,7 +261,9 @@ PlayerWidget::PlayerWidget(QWidget *parent) :
 	connect(m_player, SIGNAL(playbacqCritical(const QString &)), this, SLOT(onPlayerPlaybacqCritical(const QString &)));
 	connect(m_player, SIGNAL(playing()), this, SLOT(onPlayerPlaying()));
 	connect(m_player, SIGNAL(stopped()), this, SLOT(onPlayerStopped()));
-	connect(m_player, SIGNAL(positionChanged(double)), this, SLOT(onPlayerPositionChanged(double)));
+	// subtitle overlay follows every frame, position controls don't need more than a few updates per second
+	m_player->subscribePosition(this, &PlayerWidget::onPlayerPositionChanged, 100);
+	m_player->subscribePosition(this, &PlayerWidget::onPlayerOverlayPositionChanged, VideoPlayer::FrameInterval);
 	connect(m_player, SIGNAL(lengthChanged(double)), this, SLOT(onPlayerLengthChanged(double)));
 	connect(m_player, SIGNAL(framesPerSecondChanged(double)), this, SLOT(onPlayerFramesPerSecondChanged(double)));
 	connect(m_player, SIGNAL(playbackRateChanged(double)), this, SLOT(onPlayerPlaybackRateChanged(double)));
@@ -510,6 +516,7 @@ PlayerWidget::setSubtitle(Subtitle *subtitle)
 	}
 
 	m_subtitle = subtitle;
+	m_textOverlay->renderer()->clear();
 
 	if(m_subtitle) {
 		connect(m_subtitle, SIGNAL(linesInserted(int, int)), this, SLOT(invalidateOverlayLine()));
@@ -561,14 +568,12 @@ PlayerWidget::updateOverlayLine(const Time &videoPosition)
 	if(m_overlayLine) {
 		if(!seekedBackwards && videoPosition <= m_overlayLine->hideTime()) {
 			// m_overlayLine is the line to show or the next line to show
-			if(videoPosition >= m_overlayLine->showTime()) { // m_overlayLine is the line to show
-				const SString &text = m_showTranslation ? m_overlayLine->secondaryText() : m_overlayLine->primaryText();
-				m_textOverlay->setText(text.richString(SString::Verbose));
-			}
+			if(videoPosition >= m_overlayLine->showTime()) // m_overlayLine is the line to show
+				showOverlayLine(m_overlayLine);
 			return;
 		} else {
 			// m_overlayLine is no longer the line to show nor the next line to show
-			m_textOverlay->setText(QString());
+			showOverlayLine(nullptr);
 
 			setOverlayLine(0);
 		}
@@ -582,10 +587,8 @@ PlayerWidget::updateOverlayLine(const Time &videoPosition)
 
 				setOverlayLine(it.current());
 
-				if(m_overlayLine->showTime() <= videoPosition && videoPosition <= m_overlayLine->hideTime()) {
-					const SString &text = m_showTranslation ? m_overlayLine->secondaryText() : m_overlayLine->primaryText();
-					m_textOverlay->setText(text.richString(SString::Verbose));
-				}
+				if(m_overlayLine->showTime() <= videoPosition && videoPosition <= m_overlayLine->hideTime())
+					showOverlayLine(m_overlayLine);
 				return;
 			}
 		}
@@ -638,7 +641,7 @@ PlayerWidget::pauseAfterPlayingLine(const SubtitleLine *line)
 void
 PlayerWidget::invalidateOverlayLine()
 {
-	m_textOverlay->setText(QString());
+	showOverlayLine(nullptr);
 
 	setOverlayLine(0);
 
@@ -657,12 +660,38 @@ PlayerWidget::setOverlayLine(SubtitleLine *line)
 	m_overlayLine = line;
 
 	if(m_overlayLine) {
+		// line that will be shown next
+		m_textOverlay->renderer()->prerender(m_overlayLine, m_showTranslation ? SubtitleLine::Secondary : SubtitleLine::Primary);
+
 		connect(m_overlayLine, SIGNAL(showTimeChanged(const Time &)), this, SLOT(invalidateOverlayLine()));
 		connect(m_overlayLine, SIGNAL(hideTimeChanged(const Time &)), this, SLOT(invalidateOverlayLine()));
 	} else
 		m_lastSearchedLineToShowTime = Time::MaxMseconds;
 }
 
+void
+PlayerWidget::showOverlayLine(SubtitleLine *line)
+{
+	// called on every frame, overlay only changes when another line or text revision is shown
+	if(line == m_shownLine && (!line || line->textRevision() == m_shownLineRevision))
+		return;
+
+	m_shownLine = line;
+	m_shownLineRevision = line ? line->textRevision() : 0;
+
+	if(!line) {
+		m_textOverlay->setOverlay(TextOverlayRenderer::Overlay());
+		return;
+	}
+
+	const SubtitleLine::TextTarget target = m_showTranslation ? SubtitleLine::Secondary : SubtitleLine::Primary;
+	TextOverlayRenderer *renderer = m_textOverlay->renderer();
+	m_textOverlay->setOverlay(renderer->overlay(line, target));
+
+	for(int i = 0; i < OVERLAY_PRERENDER_LINES && (line = line->nextLine()); i++)
+		renderer->prerender(line, target);
+}
+
 void
 PlayerWidget::setPlayingLine(SubtitleLine *line)
 {
@@ -766,6 +795,9 @@ PlayerWidget::onConfigChanged()
 	m_textOverlay->setOutlineColor(SCConfig::outlineColor());
 	m_textOverlay->setOutlineWidth(SCConfig::outlineWidth());
 	m_textOverlay->setAntialias(SCConfig::antialias());
+
+	// style change has dropped cached overlays
+	invalidateOverlayLine();
 }
 
 void
@@ -848,9 +880,6 @@ PlayerWidget::onPlayerPositionChanged(double seconds)
 			if(m_showPositionTimeEdit && !m_positionEdit->hasFocus())
 				m_positionEdit->setValue(videoPosition.toMillis());
 
-			updateOverlayLine(videoPosition);
-			updatePlayingLine(videoPosition);
-
 			int sliderValue = (int)((seconds / m_player->length()) * 1000);
 
 			m_updateVideoPosition = false;
@@ -866,6 +895,17 @@ PlayerWidget::onPlayerPositionChanged(double seconds)
 	}
 }
 
+void
+PlayerWidget::onPlayerOverlayPositionChanged(double seconds)
+{
+	if(seconds < 0)
+		return;
+
+	Time videoPosition(seconds * 1000.);
+	updateOverlayLine(videoPosition);
+	updatePlayingLine(videoPosition);
+}
+
 void
 PlayerWidget::onPlayerLengthChanged(double seconds)
 {
@@ -894,6 +934,7 @@ void
 PlayerWidget::onPlayerStopped()
 {
 	onPlayerPositionChanged(0);
+	onPlayerOverlayPositionChanged(0);
 
 	m_seekSlider->setEnabled(false);
 	m_fsSeekSlider->setEnabled(false);
@@ -87,6 +87,7 @@ private:
 	void updateOverlayLine(const Time &videoPosition);
 	void updatePlayingLine(const Time &videoPosition);
 	void setOverlayLine(SubtitleLine *line);
+	void showOverlayLine(SubtitleLine *line);
 	void setPlayingLine(SubtitleLine *line);
 
 	void updatePositionEditVisibility();
@@ -110,6 +111,7 @@ private slots:
 	void onPlayerPlaying();
 	void onPlayerStopped();
 	void onPlayerPositionChanged(double seconds);
+	void onPlayerOverlayPositionChanged(double seconds);
 	void onPlayerLengthChanged(double seconds);
 	void onPlayerFramesPerSecondChanged(double fps);
 	void onPlayerPlaybackRateChanged(double rate);
@@ -126,6 +128,8 @@ private:
 	bool m_translationMode;
 	bool m_showTranslation;
 	SubtitleLine *m_overlayLine;            // the line being shown or to be shown next
+	const SubtitleLine *m_shownLine;        // the line whose text is in the overlay
+	quint32 m_shownLineRevision;
 	SubtitleLine *m_playingLine;            // the line being shown or the last one shown
 
 	const SubtitleLine *m_pauseAfterPlayingLine;
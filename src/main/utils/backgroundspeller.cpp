@@ -0,0 +1,357 @@
+/**
+ * Copyright (C) 2010-2017 Mladen Milinkovic <max@smoothware.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "backgroundspeller.h"
+
+#include <QRunnable>
+#include <QTextBoundaryFinder>
+#include <QTimer>
+
+#include <sonnet/speller.h>
+
+// texts checked by one job
+#define JOB_TEXTS 200
+// milliseconds checked texts are gathered for before views are told to update
+#define NOTIFY_DELAY 100
+// cache of checked texts is rebuilt from current lines when it grows over this size
+#define MAX_CACHED_TEXTS 50000
+
+using namespace SubtitleComposer;
+
+/// SPELLING JOB
+/// ============
+
+class BackgroundSpeller::Job : public QRunnable
+{
+public:
+	Job(BackgroundSpeller *speller, const QStringList &texts)
+		: m_speller(speller),
+		  m_generation(speller->m_generation),
+		  m_texts(texts)
+	{}
+
+	void run() Q_DECL_OVERRIDE
+	{
+		// each text is stored as misspellings count followed by start and length of each one
+		QVector<int> results;
+		foreach(const QString &text, m_texts) {
+			const int countIndex = results.size();
+			results.append(0);
+
+			QTextBoundaryFinder finder(QTextBoundaryFinder::Word, text);
+			int start = 0;
+			for(int end = finder.toNextBoundary(); end != -1; end = finder.toNextBoundary()) {
+				if(finder.boundaryReasons() & QTextBoundaryFinder::EndOfItem && isMisspelled(text.mid(start, end - start))) {
+					results.append(start);
+					results.append(end - start);
+					results[countIndex]++;
+				}
+				start = end;
+			}
+		}
+
+		QMetaObject::invokeMethod(m_speller, "onTextsChecked", Qt::QueuedConnection,
+			Q_ARG(int, m_generation), Q_ARG(QStringList, m_texts), Q_ARG(QVector<int>, results));
+	}
+
+private:
+	bool isMisspelled(const QString &word) const
+	{
+		bool hasLetters = false;
+		foreach(const QChar &ch, word) {
+			if(ch.isDigit())
+				return false;
+			if(ch.isLetter())
+				hasLetters = true;
+		}
+		if(!hasLetters)
+			return false;
+		if(!m_speller->m_checkUppercase && word == word.toUpper())
+			return false;
+
+		// thread pool runs one job at a time, word cache and sonnet aren't shared
+		QHash<QString, bool> &wordMisspelled = m_speller->m_wordMisspelled;
+		QHash<QString, bool>::ConstIterator it = wordMisspelled.constFind(word);
+		if(it != wordMisspelled.constEnd())
+			return it.value();
+		return *wordMisspelled.insert(word, m_speller->isWordMisspelled(word));
+	}
+
+private:
+	BackgroundSpeller *m_speller;
+	int m_generation;
+	QStringList m_texts;
+};
+
+/// BACKGROUND SPELLER
+/// ==================
+
+BackgroundSpeller::BackgroundSpeller(QObject *parent)
+	: QObject(parent),
+	  m_subtitle(0),
+	  m_enabled(false),
+	  m_revision(0),
+	  m_startTimer(new QTimer(this)),
+	  m_notifyTimer(new QTimer(this)),
+	  m_generation(0),
+	  m_sonnetSpeller(new Sonnet::Speller()),
+	  m_checkUppercase(m_sonnetSpeller->testAttribute(Sonnet::Speller::CheckUppercase))
+{
+	qRegisterMetaType<QVector<int> >("QVector<int>");
+
+	// sonnet speller is not reentrant, jobs have to run one after another
+	m_threadPool.setMaxThreadCount(1);
+
+	// texts queued while handling one event are checked together
+	m_startTimer->setSingleShot(true);
+	m_startTimer->setInterval(0);
+	connect(m_startTimer, &QTimer::timeout, this, &BackgroundSpeller::startJobs);
+
+	m_notifyTimer->setSingleShot(true);
+	m_notifyTimer->setInterval(NOTIFY_DELAY);
+	connect(m_notifyTimer, &QTimer::timeout, this, &BackgroundSpeller::emitMisspellingsChanged);
+}
+
+BackgroundSpeller::~BackgroundSpeller()
+{
+	m_threadPool.clear();
+	m_threadPool.waitForDone();
+
+	delete m_sonnetSpeller;
+}
+
+void
+BackgroundSpeller::setSubtitle(Subtitle *subtitle)
+{
+	if(m_subtitle)
+		disconnect(m_subtitle, 0, this, 0);
+
+	m_subtitle = subtitle;
+
+	if(m_subtitle) {
+		connect(m_subtitle, &Subtitle::linesInserted, this, &BackgroundSpeller::onLinesInserted);
+		connect(m_subtitle, &Subtitle::linePrimaryTextChanged, this, &BackgroundSpeller::onLineTextChanged);
+		connect(m_subtitle, &Subtitle::lineSecondaryTextChanged, this, &BackgroundSpeller::onLineTextChanged);
+	}
+
+	// texts of previous subtitle won't be seen again
+	m_checkedTexts.clear();
+	restart();
+}
+
+void
+BackgroundSpeller::setEnabled(bool enabled)
+{
+	if(m_enabled == enabled)
+		return;
+
+	m_enabled = enabled;
+	restart();
+}
+
+void
+BackgroundSpeller::requeue()
+{
+	// texts of dropped jobs are queued again with all unchecked lines
+	const QSet<QString> pendingTexts = m_pendingTexts;
+
+	m_threadPool.clear();
+	m_generation++;
+	m_pendingTexts.clear();
+	m_queuedTexts.clear();
+
+	if(m_enabled) {
+		foreach(const QString &text, pendingTexts)
+			queueText(text);
+		if(m_subtitle)
+			queueLines(0, m_subtitle->lastIndex());
+	}
+}
+
+void
+BackgroundSpeller::restart()
+{
+	m_pendingTexts.clear();
+	requeue();
+
+	m_notifyTimer->stop();
+	m_changedTexts.clear();
+	emit misspellingsReset();
+}
+
+void
+BackgroundSpeller::resetSpeller()
+{
+	// language could have changed, nothing that was checked is valid anymore
+	m_threadPool.clear();
+	m_threadPool.waitForDone();
+
+	delete m_sonnetSpeller;
+	m_sonnetSpeller = new Sonnet::Speller();
+	m_checkUppercase = m_sonnetSpeller->testAttribute(Sonnet::Speller::CheckUppercase);
+	m_wordMisspelled.clear();
+
+	m_checkedTexts.clear();
+	restart();
+}
+
+bool
+BackgroundSpeller::isWordMisspelled(const QString &word)
+{
+	return m_sonnetSpeller->isMisspelled(word);
+}
+
+void
+BackgroundSpeller::acceptWord(const QString &word)
+{
+	// word cache is used by jobs, it can only be changed while none is running
+	m_threadPool.clear();
+	m_threadPool.waitForDone();
+	m_wordMisspelled.insert(word, false);
+
+	// texts that had the word are checked again, others keep their results
+	QHash<QString, CheckedText>::Iterator it = m_checkedTexts.begin();
+	while(it != m_checkedTexts.end()) {
+		bool hasWord = false;
+		foreach(const Misspelling &misspelling, it->misspellings) {
+			if(it.key().midRef(misspelling.start, misspelling.length) == word) {
+				hasWord = true;
+				break;
+			}
+		}
+		if(hasWord) {
+			m_changedTexts.append(it.key());
+			it = m_checkedTexts.erase(it);
+		} else {
+			++it;
+		}
+	}
+
+	requeue();
+	if(!m_changedTexts.isEmpty() && !m_notifyTimer->isActive())
+		m_notifyTimer->start();
+}
+
+BackgroundSpeller::Misspellings
+BackgroundSpeller::misspellings(const QString &text, bool *checked, quint32 *revision)
+{
+	if(checked)
+		*checked = false;
+	if(revision)
+		*revision = 0;
+	if(!m_enabled)
+		return Misspellings();
+
+	QHash<QString, CheckedText>::ConstIterator it = m_checkedTexts.constFind(text);
+	if(it != m_checkedTexts.constEnd()) {
+		if(checked)
+			*checked = true;
+		if(revision)
+			*revision = it->revision;
+		return it->misspellings;
+	}
+
+	queueText(text);
+	return Misspellings();
+}
+
+void
+BackgroundSpeller::queueText(const QString &text)
+{
+	if(text.isEmpty() || m_pendingTexts.contains(text) || m_checkedTexts.contains(text))
+		return;
+
+	m_pendingTexts.insert(text);
+	m_queuedTexts.append(text);
+	m_startTimer->start();
+}
+
+void
+BackgroundSpeller::queueLines(int firstIndex, int lastIndex)
+{
+	for(int i = firstIndex; i <= lastIndex; i++) {
+		const SubtitleLine *line = m_subtitle->line(i);
+		queueText(line->primaryText().string());
+		queueText(line->secondaryText().string());
+	}
+}
+
+void
+BackgroundSpeller::onLinesInserted(int firstIndex, int lastIndex)
+{
+	if(m_enabled)
+		queueLines(firstIndex, lastIndex);
+}
+
+void
+BackgroundSpeller::onLineTextChanged(SubtitleLine */*line*/, const SString &text)
+{
+	// unchanged texts are in cache, only edited one is checked
+	if(m_enabled)
+		queueText(text.string());
+}
+
+void
+BackgroundSpeller::startJobs()
+{
+	for(int i = 0, n = m_queuedTexts.size(); i < n; i += JOB_TEXTS)
+		m_threadPool.start(new Job(this, m_queuedTexts.mid(i, JOB_TEXTS)));
+	m_queuedTexts.clear();
+}
+
+void
+BackgroundSpeller::onTextsChecked(int generation, const QStringList &texts, const QVector<int> &results)
+{
+	if(generation != m_generation)
+		return;
+
+	int r = 0;
+	foreach(const QString &text, texts) {
+		Misspellings misspellings;
+		for(int count = results.at(r++); count > 0; count--, r += 2)
+			misspellings.append({ results.at(r), results.at(r + 1) });
+		m_pendingTexts.remove(text);
+
+		// unchecked texts were shown without misspellings, only texts that look different are reported
+		CheckedText &cached = m_checkedTexts[text];
+		if(cached.misspellings != misspellings) {
+			cached.misspellings = misspellings;
+			cached.revision = misspellings.isEmpty() ? 0 : ++m_revision;
+			m_changedTexts.append(text);
+		}
+	}
+
+	// every edit leaves its intermediate texts in cache
+	if(m_checkedTexts.size() > MAX_CACHED_TEXTS) {
+		m_checkedTexts.clear();
+		restart();
+		return;
+	}
+
+	if(!m_changedTexts.isEmpty() && !m_notifyTimer->isActive())
+		m_notifyTimer->start();
+}
+
+void
+BackgroundSpeller::emitMisspellingsChanged()
+{
+	const QStringList texts = m_changedTexts;
+	m_changedTexts.clear();
+	emit misspellingsChanged(texts);
+}
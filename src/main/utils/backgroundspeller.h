@@ -0,0 +1,136 @@
+#ifndef BACKGROUNDSPELLER_H
+#define BACKGROUNDSPELLER_H
+/**
+ * Copyright (C) 2010-2017 Mladen Milinkovic <max@smoothware.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "../../core/sstring.h"
+
+#include "../../core/subtitle.h"
+#include "../../core/subtitleline.h"
+
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+#include <QThreadPool>
+#include <QVector>
+
+QT_FORWARD_DECLARE_CLASS(QTimer)
+
+namespace Sonnet {
+class Speller;
+}
+
+namespace SubtitleComposer {
+/**
+ * @brief Checks spelling of all subtitle texts in background.
+ *
+ * Texts are tokenized and checked on a worker thread. Results are cached per word and per text,
+ * so only texts that were never seen before are checked again after an edit. Words are checked
+ * with Sonnet by isWordMisspelled().
+ */
+class BackgroundSpeller : public QObject
+{
+	Q_OBJECT
+
+public:
+	struct Misspelling {
+		int start;
+		int length;
+
+		inline bool operator==(const Misspelling &other) const { return start == other.start && length == other.length; }
+	};
+	typedef QVector<Misspelling> Misspellings;
+
+	explicit BackgroundSpeller(QObject *parent = 0);
+	virtual ~BackgroundSpeller();
+
+	inline bool isEnabled() const { return m_enabled; }
+
+	/**
+	 * @brief misspellings - finds misspelled words of @p text
+	 * @param checked set to false if @p text wasn't checked yet, it is queued for checking then
+	 * @param revision set to revision of returned misspellings, 0 if there are none; it is
+	 *  different whenever misspellings of the text change and is never given to other misspellings
+	 */
+	Misspellings misspellings(const QString &text, bool *checked = 0, quint32 *revision = 0);
+
+public slots:
+	void setSubtitle(Subtitle *subtitle = 0);
+	void setEnabled(bool enabled);
+	/// stops reporting @p word after it was ignored or added to dictionary
+	void acceptWord(const QString &word);
+	/// dictionary or its options could have changed, everything is checked again
+	void resetSpeller();
+
+signals:
+	/// misspellings of @p texts differ from what was returned for them before
+	void misspellingsChanged(const QStringList &texts);
+	/// misspellings of any text could have changed
+	void misspellingsReset();
+
+protected:
+	/// checks single @p word, called from worker thread by one job at a time
+	virtual bool isWordMisspelled(const QString &word);
+
+private slots:
+	void onLinesInserted(int firstIndex, int lastIndex);
+	void onLineTextChanged(SubtitleLine *line, const SString &text);
+	void startJobs();
+	void onTextsChecked(int generation, const QStringList &texts, const QVector<int> &results);
+	void emitMisspellingsChanged();
+
+private:
+	void queueText(const QString &text);
+	void queueLines(int firstIndex, int lastIndex);
+	void requeue();
+	void restart();
+
+private:
+	class Job;
+
+	struct CheckedText {
+		CheckedText() : revision(0) {}
+
+		Misspellings misspellings;
+		quint32 revision;
+	};
+
+	Subtitle *m_subtitle;
+	bool m_enabled;
+
+	QHash<QString, CheckedText> m_checkedTexts;
+	quint32 m_revision;                 // last revision given to misspellings of a text
+	QSet<QString> m_pendingTexts;       // queued or being checked
+	QStringList m_queuedTexts;
+	QTimer *m_startTimer;
+	QTimer *m_notifyTimer;
+	QStringList m_changedTexts;         // reported by next misspellingsChanged()
+
+	QThreadPool m_threadPool;
+	int m_generation;
+
+	// used only by jobs
+	Sonnet::Speller *m_sonnetSpeller;
+	bool m_checkUppercase;
+	QHash<QString, bool> m_wordMisspelled;
+};
+}
+
+#endif // BACKGROUNDSPELLER_H
@@ -0,0 +1,129 @@
+/**
+ * Copyright (C) 2010-2017 Mladen Milinkovic <max@smoothware.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "batchreplacer.h"
+#include "../../core/subtitleiterator.h"
+
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+#include <QVector>
+
+#include <KLocalizedString>
+
+// texts replaced by one job, smaller batches are not worth a thread
+#define JOB_SIZE 256
+
+using namespace SubtitleComposer;
+
+namespace SubtitleComposer {
+class ReplaceJob : public QRunnable
+{
+public:
+	ReplaceJob(const TextReplacer &replacer, QVector<BatchReplacer::Edit> &edits, int first, int last)
+		: m_replacer(replacer),
+		  m_edits(edits),
+		  m_first(first),
+		  m_last(last)
+	{}
+
+	void run() Q_DECL_OVERRIDE
+	{
+		// every job writes only to its own part of edits
+		for(int i = m_first; i < m_last; i++) {
+			BatchReplacer::Edit &edit = m_edits[i];
+			edit.newText = edit.oldText;
+			edit.replacements = m_replacer.replaceAll(edit.newText);
+		}
+	}
+
+private:
+	const TextReplacer &m_replacer;
+	QVector<BatchReplacer::Edit> &m_edits;
+	const int m_first;
+	const int m_last;
+};
+}
+
+/*static*/ QList<BatchReplacer::Edit>
+BatchReplacer::evaluate(const TextReplacer &replacer, const Subtitle &subtitle, const RangeList &ranges, Subtitle::TextTarget target)
+{
+	QList<Edit> result;
+	if(!replacer.isValid() || target >= Subtitle::TextTargetSIZE)
+		return result;
+
+	// texts are copied here, jobs never touch the lines
+	QVector<Edit> edits;
+	for(SubtitleIterator it(subtitle, ranges); it.current(); ++it) {
+		SubtitleLine *line = it.current();
+		if(target != Subtitle::Secondary)
+			edits.append({ line, true, line->primaryText(), SString(), 0 });
+		if(target != Subtitle::Primary)
+			edits.append({ line, false, line->secondaryText(), SString(), 0 });
+	}
+	if(edits.isEmpty())
+		return result;
+
+	// edits vector is not resized while the jobs run
+	if(edits.size() <= JOB_SIZE) {
+		ReplaceJob(replacer, edits, 0, edits.size()).run();
+	} else {
+		QThreadPool threadPool;
+		threadPool.setMaxThreadCount(QThread::idealThreadCount());
+		for(int first = 0, n = edits.size(); first < n; first += JOB_SIZE)
+			threadPool.start(new ReplaceJob(replacer, edits, first, qMin(first + JOB_SIZE, n)));
+		threadPool.waitForDone();
+	}
+
+	foreach(const Edit &edit, edits) {
+		if(edit.replacements)
+			result.append(edit);
+	}
+	return result;
+}
+
+/*static*/ int
+BatchReplacer::replacementsCount(const QList<Edit> &edits)
+{
+	int count = 0;
+	foreach(const Edit &edit, edits)
+		count += edit.replacements;
+	return count;
+}
+
+/*static*/ void
+BatchReplacer::apply(Subtitle &subtitle, const QList<Edit> &edits)
+{
+	if(edits.isEmpty())
+		return;
+
+	SubtitleCompositeActionExecutor executor(subtitle, i18n("Replace All"));
+
+	for(int i = 0, n = edits.size(); i < n; i++) {
+		const Edit &edit = edits.at(i);
+		// both texts of a line are set by a single action
+		if(edit.primary && i + 1 < n && edits.at(i + 1).line == edit.line) {
+			edit.line->setTexts(edit.newText, edits.at(++i).newText);
+		} else if(edit.primary) {
+			edit.line->setPrimaryText(edit.newText);
+		} else {
+			edit.line->setSecondaryText(edit.newText);
+		}
+	}
+}
@@ -0,0 +1,59 @@
+#ifndef BATCHREPLACER_H
+#define BATCHREPLACER_H
+/**
+ * Copyright (C) 2010-2017 Mladen Milinkovic <max@smoothware.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "sstring.h"
+
+#include "../../core/rangelist.h"
+#include "../../core/sstring.h"
+#include "../../core/subtitle.h"
+#include "../../core/textreplacer.h"
+
+#include <QList>
+
+namespace SubtitleComposer {
+/**
+ * @brief Replaces all matches of a TextReplacer in many lines at once.
+ *
+ * Replacements are first evaluated on copies of the texts, on all processors, so they can be
+ * previewed before any line changes. Applying them is a single undoable action.
+ */
+class BatchReplacer
+{
+public:
+	struct Edit {
+		SubtitleLine *line;
+		bool primary;
+		SString oldText;
+		SString newText;
+		int replacements;
+	};
+
+	/// evaluates replacements in @p target texts of lines in @p ranges, returns edits of changed texts in line order
+	static QList<Edit> evaluate(const TextReplacer &replacer, const Subtitle &subtitle, const RangeList &ranges, Subtitle::TextTarget target);
+
+	static int replacementsCount(const QList<Edit> &edits);
+
+	/// sets new texts of @p edits as one action
+	static void apply(Subtitle &subtitle, const QList<Edit> &edits);
+};
+}
+
+#endif // BATCHREPLACER_H
@@ -20,6 +20,7 @@
 
 #include "finder.h"
 #include "../../core/subtitleiterator.h"
+#include "../../core/textindex.h"
 
 #include <QGroupBox>
 #include <QRadioButton>
@@ -40,7 +41,9 @@ Finder::Finder(QWidget *parent) :
 	m_feedingPrimary(false),
 	m_find(0),
 	m_iterator(0),
-	m_dataLine(0)
+	m_dataLine(0),
+	m_textIndex(0),
+	m_dataSkipped(false)
 {
 	m_dialog = new KFindDialog(parent);
 	m_dialog->setHasSelection(true);
@@ -110,6 +113,12 @@ Finder::parentWidget()
 	return static_cast<QWidget *>(parent());
 }
 
+void
+Finder::setTextIndex(TextIndex *textIndex)
+{
+	m_textIndex = textIndex;
+}
+
 void
 Finder::setSubtitle(Subtitle *subtitle)
 {
@@ -175,6 +184,8 @@ Finder::find(const RangeList &selectionRanges, int currentIndex, const QString &
 	m_find->setPattern(m_dialog->pattern());
 	m_find->setOptions(m_dialog->options());
 
+	m_patternLiterals = TextIndex::queryLiterals(m_dialog->pattern(), m_dialog->options() & KFind::RegularExpression);
+
 	m_instancesFound = false;
 
 	advance();
@@ -222,15 +233,18 @@ Finder::advance()
 			m_dataLine = m_iterator->current();
 
 			if(m_dataLine) {
+				// index tells which lines can't match, those are fed empty
+				m_dataSkipped = m_textIndex && !m_textIndex->mayContain(m_dataLine, m_patternLiterals);
+
 				if(!m_translationMode || m_targetRadioButtons[SubtitleLine::Primary]->isChecked()) {
 					m_feedingPrimary = true;
-					m_find->setData(m_dataLine->primaryText().string());
+					m_find->setData(searchedText(m_dataLine->primaryText()));
 				} else if(m_targetRadioButtons[SubtitleLine::Secondary]->isChecked()) {
 					m_feedingPrimary = false;
-					m_find->setData(m_dataLine->secondaryText().string());
+					m_find->setData(searchedText(m_dataLine->secondaryText()));
 				} else {                // m_translationMode && m_targetRadioButtons[SubtitleLine::Both]->isChecked()
 					m_feedingPrimary = !m_feedingPrimary;   // we alternate the source of data
-					m_find->setData((m_feedingPrimary ? m_dataLine->primaryText() : m_dataLine->secondaryText()).string());
+					m_find->setData(searchedText(m_feedingPrimary ? m_dataLine->primaryText() : m_dataLine->secondaryText()));
 				}
 
 				connect(m_dataLine, SIGNAL(primaryTextChanged(const SString &)), this, SLOT(onLinePrimaryTextChanged(const SString &)));
@@ -273,6 +287,12 @@ Finder::advance()
 	} while(res == KFind::NoMatch);
 }
 
+QString
+Finder::searchedText(const SString &text) const
+{
+	return m_dataSkipped ? QString() : text.string();
+}
+
 void
 Finder::onHighlight(const QString &, int matchingIndex, int matchedLength)
 {
@@ -284,6 +304,7 @@ Finder::onHighlight(const QString &, int matchingIndex, int matchedLength)
 void
 Finder::onLinePrimaryTextChanged(const SString &text)
 {
+	m_dataSkipped = false;
 	if(m_feedingPrimary)
 		m_find->setData(text.string());
 }
@@ -291,6 +312,7 @@ Finder::onLinePrimaryTextChanged(const SString &text)
 void
 Finder::onLineSecondaryTextChanged(const SString &text)
 {
+	m_dataSkipped = false;
 	if(!m_feedingPrimary)
 		m_find->setData(text.string());
 }
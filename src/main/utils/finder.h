@@ -24,6 +24,7 @@
 #include "../../core/subtitleline.h"
 
 #include <QObject>
+#include <QStringList>
 
 QT_FORWARD_DECLARE_CLASS(QGroupBox)
 QT_FORWARD_DECLARE_CLASS(QRadioButton)
@@ -32,6 +33,7 @@ class KFindDialog;
 
 namespace SubtitleComposer {
 class SubtitleIterator;
+class TextIndex;
 
 class Finder : public QObject
 {
@@ -43,6 +45,9 @@ public:
 
 	QWidget * parentWidget();
 
+	/// lines which can't contain the pattern according to @p textIndex are skipped without searching
+	void setTextIndex(TextIndex *textIndex);
+
 public slots:
 	void setSubtitle(Subtitle *subtitle = 0);
 	void setTranslationMode(bool enabled);
@@ -66,6 +71,7 @@ private slots:
 
 private:
 	void advance();
+	QString searchedText(const SString &text) const;
 
 private:
 	Subtitle *m_subtitle;
@@ -78,6 +84,9 @@ private:
 	QRadioButton *m_targetRadioButtons[SubtitleLine::TextTargetSIZE];
 	SubtitleIterator *m_iterator;
 	SubtitleLine *m_dataLine;
+	TextIndex *m_textIndex;
+	QStringList m_patternLiterals;
+	bool m_dataSkipped;
 	bool m_instancesFound;
 	int m_allSearchedIndex;
 };
@@ -0,0 +1,168 @@
+/**
+ * Copyright (C) 2010-2017 Mladen Milinkovic <max@smoothware.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "backgroundspellertest.h"
+
+#include <QMutexLocker>
+#include <QSignalSpy>
+#include <QTest>                               // krazy:exclude=c++/includes
+
+using namespace SubtitleComposer;
+
+QStringList
+StubSpeller::takeCheckedWords()
+{
+	QMutexLocker locker(&m_mutex);
+	const QStringList words = m_checkedWords;
+	m_checkedWords.clear();
+	return words;
+}
+
+bool
+StubSpeller::isWordMisspelled(const QString &word)
+{
+	QMutexLocker locker(&m_mutex);
+	m_checkedWords.append(word);
+	return word.startsWith(QLatin1Char('x'));
+}
+
+void
+BackgroundSpellerTest::init()
+{
+	m_subtitle = new Subtitle();
+	m_subtitle->insertLine(new SubtitleLine(SString("one xtwo"), Time(0.), Time(1000.)));
+	m_subtitle->insertLine(new SubtitleLine(SString("xtwo three"), Time(1000.), Time(2000.)));
+	m_subtitle->insertLine(new SubtitleLine(SString("four five"), Time(2000.), Time(3000.)));
+	m_subtitle->insertLine(new SubtitleLine(SString("xsix one"), Time(3000.), Time(4000.)));
+
+	m_speller = new StubSpeller();
+	m_speller->setEnabled(true);
+	m_speller->setSubtitle(m_subtitle);
+}
+
+void
+BackgroundSpellerTest::cleanup()
+{
+	delete m_speller;
+	delete m_subtitle;
+}
+
+bool
+BackgroundSpellerTest::isChecked(const QString &text)
+{
+	bool checked;
+	m_speller->misspellings(text, &checked);
+	return checked;
+}
+
+quint32
+BackgroundSpellerTest::revision(const QString &text)
+{
+	quint32 revision;
+	m_speller->misspellings(text, 0, &revision);
+	return revision;
+}
+
+void
+BackgroundSpellerTest::testMisspellings()
+{
+	QTRY_VERIFY(isChecked("one xtwo") && isChecked("xtwo three") && isChecked("four five") && isChecked("xsix one"));
+
+	BackgroundSpeller::Misspellings misspellings = m_speller->misspellings("one xtwo");
+	QCOMPARE(misspellings.size(), 1);
+	QCOMPARE(misspellings.at(0).start, 4);
+	QCOMPARE(misspellings.at(0).length, 4);
+
+	misspellings = m_speller->misspellings("xtwo three");
+	QCOMPARE(misspellings.size(), 1);
+	QCOMPARE(misspellings.at(0).start, 0);
+
+	QVERIFY(m_speller->misspellings("four five").isEmpty());
+
+	// texts without misspellings have no revision, others never share one
+	QCOMPARE(revision("four five"), 0u);
+	QVERIFY(revision("one xtwo") != 0);
+	QVERIFY(revision("xtwo three") != 0);
+	QVERIFY(revision("one xtwo") != revision("xtwo three"));
+}
+
+void
+BackgroundSpellerTest::testWordCache()
+{
+	QTRY_VERIFY(isChecked("one xtwo") && isChecked("xtwo three") && isChecked("four five") && isChecked("xsix one"));
+
+	// words repeated in several lines go to speller once
+	QStringList words = m_speller->takeCheckedWords();
+	words.sort();
+	QCOMPARE(words, QStringList() << "five" << "four" << "one" << "three" << "xsix" << "xtwo");
+
+	// new text made of known words is checked without speller
+	m_subtitle->line(2)->setPrimaryText(SString("three one xtwo"));
+	QTRY_VERIFY(isChecked("three one xtwo"));
+	QVERIFY(m_speller->takeCheckedWords().isEmpty());
+	QCOMPARE(m_speller->misspellings("three one xtwo").size(), 1);
+}
+
+void
+BackgroundSpellerTest::testOnlyEditedTextChecked()
+{
+	QTRY_VERIFY(isChecked("one xtwo") && isChecked("xtwo three") && isChecked("four five") && isChecked("xsix one"));
+	m_speller->takeCheckedWords();
+	const quint32 untouchedRevision = revision("xtwo three");
+
+	QSignalSpy spy(m_speller, SIGNAL(misspellingsChanged(const QStringList &)));
+
+	m_subtitle->line(0)->setPrimaryText(SString("one xseven"));
+	QTRY_COMPARE(spy.count(), 1);
+	QCOMPARE(spy.at(0).at(0).toStringList(), QStringList() << "one xseven");
+	QCOMPARE(m_speller->takeCheckedWords(), QStringList() << "xseven");
+	QCOMPARE(revision("xtwo three"), untouchedRevision);
+
+	// going back to text that was checked before needs no checking at all
+	m_subtitle->line(0)->setPrimaryText(SString("one xtwo"));
+	QVERIFY(isChecked("one xtwo"));
+	QVERIFY(!spy.wait(500));
+	QVERIFY(m_speller->takeCheckedWords().isEmpty());
+}
+
+void
+BackgroundSpellerTest::testAcceptWord()
+{
+	QTRY_VERIFY(isChecked("one xtwo") && isChecked("xtwo three") && isChecked("four five") && isChecked("xsix one"));
+	m_speller->takeCheckedWords();
+	const quint32 untouchedRevision = revision("xsix one");
+
+	QSignalSpy spy(m_speller, SIGNAL(misspellingsChanged(const QStringList &)));
+
+	// only texts with the accepted word are checked again, their words come from cache
+	m_speller->acceptWord("xtwo");
+	QTRY_VERIFY(isChecked("one xtwo") && isChecked("xtwo three"));
+	QTRY_COMPARE(spy.count(), 1);
+	QStringList texts = spy.at(0).at(0).toStringList();
+	texts.sort();
+	QCOMPARE(texts, QStringList() << "one xtwo" << "xtwo three");
+	QVERIFY(m_speller->takeCheckedWords().isEmpty());
+
+	QVERIFY(m_speller->misspellings("one xtwo").isEmpty());
+	QCOMPARE(revision("one xtwo"), 0u);
+	QCOMPARE(revision("xsix one"), untouchedRevision);
+	QCOMPARE(m_speller->misspellings("xsix one").size(), 1);
+}
+
+QTEST_GUILESS_MAIN(BackgroundSpellerTest)
@@ -0,0 +1,68 @@
+#ifndef BACKGROUNDSPELLERTEST_H
+#define BACKGROUNDSPELLERTEST_H
+/**
+ * Copyright (C) 2010-2017 Mladen Milinkovic <max@smoothware.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "../backgroundspeller.h"
+
+#include <QMutex>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+
+/**
+ * @brief Stands in for Sonnet, words starting with "x" are misspelled and every checked word is recorded.
+ */
+class StubSpeller : public SubtitleComposer::BackgroundSpeller
+{
+public:
+	/// words passed to isWordMisspelled() since last call
+	QStringList takeCheckedWords();
+
+protected:
+	bool isWordMisspelled(const QString &word) Q_DECL_OVERRIDE;
+
+private:
+	QMutex m_mutex;
+	QStringList m_checkedWords;
+};
+
+class BackgroundSpellerTest : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void init();
+	void cleanup();
+
+	void testMisspellings();
+	void testWordCache();
+	void testOnlyEditedTextChecked();
+	void testAcceptWord();
+
+private:
+	bool isChecked(const QString &text);
+	quint32 revision(const QString &text);
+
+private:
+	SubtitleComposer::Subtitle *m_subtitle;
+	StubSpeller *m_speller;
+};
+
+#endif
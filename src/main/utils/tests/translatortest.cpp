@@ -0,0 +1,238 @@
+/**
+ * Copyright (C) 2010-2017 Mladen Milinkovic <max@smoothware.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "translatortest.h"
+#include "../translator.h"
+
+#include <QHostAddress>
+#include <QRegExp>
+#include <QSignalSpy>
+#include <QStandardPaths>
+#include <QStringList>
+#include <QTcpSocket>
+#include <QTest>                               // krazy:exclude=c++/includes
+#include <QTimer>
+#include <QUrl>
+#include <QUrlQuery>
+
+// lines of translated text, enough for several chunks
+#define TEXT_LINES 4000
+// milliseconds to wait for translation to finish, retries take a few seconds
+#define TRANSLATE_TIMEOUT 30000
+// text of the first chunk starts with
+#define FIRST_LINE "line 00001 "
+
+using namespace SubtitleComposer;
+
+TranslationServer::TranslationServer(QObject *parent)
+	: QTcpServer(parent),
+	  m_firstChunkDelay(0),
+	  m_delay(0),
+	  m_requests(0),
+	  m_openRequests(0),
+	  m_maxOpenRequests(0)
+{
+	connect(this, &QTcpServer::newConnection, this, &TranslationServer::onNewConnection);
+}
+
+void
+TranslationServer::onNewConnection()
+{
+	while(QTcpSocket *socket = nextPendingConnection()) {
+		connect(socket, &QTcpSocket::readyRead, this, &TranslationServer::onReadyRead);
+		connect(socket, &QTcpSocket::disconnected, this, [this, socket](){
+			m_received.remove(socket);
+			socket->deleteLater();
+		});
+	}
+}
+
+void
+TranslationServer::onReadyRead()
+{
+	QTcpSocket *socket = qobject_cast<QTcpSocket *>(sender());
+	QByteArray &received = m_received[socket];
+	received += socket->readAll();
+
+	// requests are answered once their whole body is here
+	const int headerEnd = received.indexOf("\r\n\r\n");
+	if(headerEnd < 0)
+		return;
+	QRegExp contentLength(QStringLiteral("content-length: *(\\d+)"), Qt::CaseInsensitive);
+	const int length = contentLength.indexIn(QString::fromLatin1(received.left(headerEnd))) < 0 ? 0 : contentLength.cap(1).toInt();
+	if(received.size() < headerEnd + 4 + length)
+		return;
+
+	const QUrlQuery query(QString::fromUtf8(received.mid(headerEnd + 4, length)));
+	received.clear();
+
+	const QString text = query.queryItemValue(QStringLiteral("text"), QUrl::FullyDecoded);
+	const int statusCode = m_requests < m_failures.size() ? m_failures.at(m_requests) : 200;
+	const int delay = text.startsWith(QLatin1String(FIRST_LINE)) ? m_firstChunkDelay : m_delay;
+	m_requests++;
+	m_maxOpenRequests = qMax(m_maxOpenRequests, ++m_openRequests);
+
+	QTimer::singleShot(delay, socket, [this, socket, statusCode, text](){
+		m_openRequests--;
+		reply(socket, statusCode, text);
+	});
+}
+
+void
+TranslationServer::reply(QTcpSocket *socket, int statusCode, const QString &text)
+{
+	const QByteArray body = statusCode == 200
+		? "<html><body><textarea name=utrans dir=ltr>translated " + text.section(QLatin1Char('\n'), 0, 0).toUtf8() + "</textarea></body></html>"
+		: QByteArray("<html><body>try again later</body></html>");
+
+	socket->write("HTTP/1.1 " + QByteArray::number(statusCode) + (statusCode == 200 ? " OK" : " Error") + "\r\n"
+		"Content-Type: text/html; charset=UTF-8\r\n"
+		"Content-Length: " + QByteArray::number(body.size()) + "\r\n"
+		"Connection: close\r\n"
+		"\r\n" + body);
+	socket->disconnectFromHost();
+}
+
+void
+TranslatorTest::initTestCase()
+{
+	// KIO must not pick up proxies or other settings of the user
+	QStandardPaths::setTestModeEnabled(true);
+
+	for(int i = 1; i <= TEXT_LINES; i++)
+		m_text += QStringLiteral("line %1 of the text that is translated\n").arg(i, 5, 10, QLatin1Char('0'));
+}
+
+void
+TranslatorTest::init()
+{
+	m_server = new TranslationServer(this);
+	QVERIFY(m_server->listen(QHostAddress::LocalHost));
+}
+
+void
+TranslatorTest::cleanup()
+{
+	delete m_server;
+	m_server = 0;
+}
+
+bool
+TranslatorTest::translate(Translator *translator)
+{
+	translator->setEndpoint(QUrl(QStringLiteral("http://127.0.0.1:%1/translate_t").arg(m_server->serverPort())));
+
+	QSignalSpy finished(translator, SIGNAL(finished()));
+	translator->translate(m_text, Language::English, Language::Spanish);
+	return !finished.isEmpty() || finished.wait(TRANSLATE_TIMEOUT);
+}
+
+void
+TranslatorTest::verifyOutput(const Translator *translator)
+{
+	QVERIFY(!translator->isFinishedWithError());
+
+	// one line for every chunk, in the order of the input
+	const QStringList lines = translator->outputText().split(QLatin1Char('\n'), QString::SkipEmptyParts);
+	QCOMPARE(lines.size(), translator->chunksCount());
+	int previousLine = 0;
+	foreach(const QString &line, lines) {
+		QVERIFY(line.startsWith(QLatin1String("translated line ")));
+		const int firstLine = line.mid(16, 5).toInt();
+		QVERIFY(firstLine > previousLine);
+		previousLine = firstLine;
+	}
+}
+
+void
+TranslatorTest::testOrderedOutput()
+{
+	Translator translator;
+	translator.setMaxChunksInFlight(3);
+	// first chunk is answered after the ones requested with it
+	m_server->setDelays(1000, 50);
+
+	QSignalSpy received(&translator, SIGNAL(chunkReceived(int, int, qint64)));
+	QVERIFY(translate(&translator));
+	QVERIFY(translator.chunksCount() >= 4);
+	QCOMPARE(received.count(), translator.chunksCount());
+	QVERIFY(received.first().first().toInt() != 1);
+
+	verifyOutput(&translator);
+}
+
+void
+TranslatorTest::testRetry()
+{
+	Translator translator;
+	translator.setMaxChunksInFlight(2);
+	m_server->setFailures(QList<int>() << 503 << 429 << 500);
+
+	QVERIFY(translate(&translator));
+	verifyOutput(&translator);
+
+	int attempts = 0;
+	for(int chunk = 1; chunk <= translator.chunksCount(); chunk++) {
+		QVERIFY(translator.chunkTiming(chunk).elapsed >= 0);
+		attempts += translator.chunkTiming(chunk).attempts;
+	}
+	QCOMPARE(attempts, translator.chunksCount() + 3);
+	QCOMPARE(m_server->requests(), attempts);
+}
+
+void
+TranslatorTest::testRetryLimit()
+{
+	Translator translator;
+	translator.setMaxChunksInFlight(1);
+	m_server->setFailures(QList<int>() << 503 << 503 << 503 << 503);
+
+	// first chunk fails every attempt, nothing else is requested after that
+	QVERIFY(translate(&translator));
+	QVERIFY(translator.isFinishedWithError());
+	QCOMPARE(translator.chunkTiming(1).attempts, 4);
+	QCOMPARE(m_server->requests(), 4);
+}
+
+void
+TranslatorTest::testChunksInFlight_data()
+{
+	QTest::addColumn<int>("maxChunksInFlight");
+
+	QTest::newRow("sequential") << 1;
+	QTest::newRow("parallel") << 3;
+}
+
+void
+TranslatorTest::testChunksInFlight()
+{
+	QFETCH(int, maxChunksInFlight);
+
+	Translator translator;
+	translator.setMaxChunksInFlight(maxChunksInFlight);
+	m_server->setDelays(200, 200);
+
+	QVERIFY(translate(&translator));
+	verifyOutput(&translator);
+	QCOMPARE(m_server->requests(), translator.chunksCount());
+	QVERIFY(m_server->maxOpenRequests() <= maxChunksInFlight);
+	QVERIFY(m_server->maxOpenRequests() > 1 || maxChunksInFlight == 1);
+}
+
+QTEST_GUILESS_MAIN(TranslatorTest);
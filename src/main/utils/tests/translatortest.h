@@ -0,0 +1,95 @@
+#ifndef TRANSLATORTEST_H
+#define TRANSLATORTEST_H
+/**
+ * Copyright (C) 2010-2017 Mladen Milinkovic <max@smoothware.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QTcpServer>
+
+QT_FORWARD_DECLARE_CLASS(QTcpSocket)
+
+namespace SubtitleComposer {
+class Translator;
+}
+
+/**
+ * @brief Stands in for translation service, replies with "translated " and first line of the text.
+ */
+class TranslationServer : public QTcpServer
+{
+	Q_OBJECT
+
+public:
+	explicit TranslationServer(QObject *parent = 0);
+
+	/// status codes of replies to the first requests, following ones succeed
+	inline void setFailures(const QList<int> &statusCodes) { m_failures = statusCodes; }
+	/// milliseconds before the first chunk of the text and other chunks are answered
+	inline void setDelays(int firstChunkDelay, int delay) { m_firstChunkDelay = firstChunkDelay; m_delay = delay; }
+
+	inline int requests() const { return m_requests; }
+	/// most requests that were received at the same time without being answered
+	inline int maxOpenRequests() const { return m_maxOpenRequests; }
+
+private slots:
+	void onNewConnection();
+	void onReadyRead();
+
+private:
+	void reply(QTcpSocket *socket, int statusCode, const QString &text);
+
+private:
+	QHash<QTcpSocket *, QByteArray> m_received;
+	QList<int> m_failures;
+	int m_firstChunkDelay;
+	int m_delay;
+	int m_requests;
+	int m_openRequests;
+	int m_maxOpenRequests;
+};
+
+class TranslatorTest : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void initTestCase();
+	void init();
+	void cleanup();
+
+	void testOrderedOutput();
+	void testRetry();
+	void testRetryLimit();
+	void testChunksInFlight_data();
+	void testChunksInFlight();
+
+private:
+	bool translate(SubtitleComposer::Translator *translator);
+	void verifyOutput(const SubtitleComposer::Translator *translator);
+
+private:
+	TranslationServer *m_server;
+	QString m_text;
+};
+
+#endif
@@ -27,6 +27,7 @@
 #include <QBoxLayout>
 #include <QUrlQuery>
 #include <QEventLoop>
+#include <QTimer>
 #include <QDebug>
 
 #include <KLocalizedString>
@@ -37,19 +38,56 @@ using namespace SubtitleComposer;
 
 #define MULTIPART_DATA_BOUNDARY "----------nOtA5FcjrNZuZ3TMioysxHGGCO69vA5iYysdBTL2osuNwOjcCfU7uiN"
 
+// requests of a chunk are given up after this many failures
+#define MAX_CHUNK_ATTEMPTS 4
+// milliseconds before a failed chunk is requested again, doubled on each failure
+#define RETRY_DELAY 500
+
 Translator::Translator(QObject *parent) :
 	QObject(parent),
-	m_currentTransferJob(0),
+	m_endpoint(QStringLiteral("http://translate.google.com/translate_t")),
+	m_maxChunksInFlight(1),
+	m_retryingChunks(0),
+	m_generation(0),
 	m_inputLanguage(Language::INVALID),
 	m_outputLanguage(Language::INVALID),
-	m_lastReceivedChunk(0)
+	m_nextChunk(1),
+	m_receivedChunks(0),
+	m_aborted(false)
 {
 	connect(this, SIGNAL(finished(const QString &)), this, SIGNAL(finished()));
 	connect(this, SIGNAL(finishedWithError(const QString &)), this, SIGNAL(finished()));
 }
 
 Translator::~Translator()
-{}
+{
+	for(QHash<KJob *, int>::ConstIterator it = m_transferJobChunks.constBegin(), end = m_transferJobChunks.constEnd(); it != end; ++it)
+		it.key()->kill();
+}
+
+QUrl
+Translator::endpoint() const
+{
+	return m_endpoint;
+}
+
+void
+Translator::setEndpoint(const QUrl &url)
+{
+	m_endpoint = url;
+}
+
+int
+Translator::maxChunksInFlight() const
+{
+	return m_maxChunksInFlight;
+}
+
+void
+Translator::setMaxChunksInFlight(int count)
+{
+	m_maxChunksInFlight = qMax(1, count);
+}
 
 QString
 Translator::inputText() const
@@ -81,10 +119,17 @@ Translator::chunksCount() const
 	return m_inputTextChunks.count();
 }
 
+Translator::ChunkTiming
+Translator::chunkTiming(int chunkNumber) const
+{
+	const Chunk &chunk = m_chunks.at(chunkNumber - 1);
+	return { chunk.attempts, chunk.received ? chunk.elapsed : -1 };
+}
+
 bool
 Translator::isFinished() const
 {
-	return isFinishedWithError() || m_lastReceivedChunk == chunksCount();
+	return isFinishedWithError() || m_receivedChunks == chunksCount();
 }
 
 bool
@@ -154,7 +199,19 @@ Translator::translate(const QString &text, Language::Value inputLanguage, Langua
 		splitIndex = findOptimalSplitIndex(text, index);
 		m_inputTextChunks << text.mid(index, splitIndex - index + 1);
 	}
-	m_lastReceivedChunk = 0;
+
+	m_chunks.clear();
+	m_chunks.resize(m_inputTextChunks.count());
+	for(int i = 0, n = m_chunks.size(); i < n; i++) {
+		m_chunks[i].percent = 0;
+		m_chunks[i].attempts = 0;
+		m_chunks[i].received = false;
+		m_chunks[i].elapsed = 0;
+	}
+	m_nextChunk = 1;
+	m_receivedChunks = 0;
+	m_retryingChunks = 0;
+	m_generation++;
 
 	Q_ASSERT(text == inputText());
 
@@ -164,20 +221,35 @@ Translator::translate(const QString &text, Language::Value inputLanguage, Langua
 	m_errorMessage.clear();
 	m_aborted = false;
 
-	startChunkDownload(1);
+	if(m_inputTextChunks.isEmpty())
+		emit finished(m_outputText);
+	else
+		startChunkDownloads();
 }
 
 void
 Translator::abort()
 {
-	if(m_currentTransferJob) {
-		m_currentTransferJob->kill();   // deletes the job
+	if(!m_transferJobChunks.isEmpty() || m_retryingChunks) {
 		m_aborted = true;
-		m_errorMessage = i18n("Operation cancelled by user");
-		emit finishedWithError(m_errorMessage);
+		finishWithError(i18n("Operation cancelled by user"));
 	}
 }
 
+void
+Translator::finishWithError(const QString &errorMessage)
+{
+	for(QHash<KJob *, int>::ConstIterator it = m_transferJobChunks.constBegin(), end = m_transferJobChunks.constEnd(); it != end; ++it)
+		it.key()->kill();   // deletes the job
+	m_transferJobChunks.clear();
+	m_retryingChunks = 0;
+	m_generation++;
+
+	m_errorMessage = errorMessage;
+	qDebug() << m_errorMessage;
+	emit finishedWithError(m_errorMessage);
+}
+
 // "Content-type" => "application/x-www-form-urlencoded"
 QByteArray
 Translator::prepareUrlEncodedData(const QMap<QString, QString> &params)
@@ -212,6 +284,13 @@ Translator::prepareMultipartData(const QMap<QString, QString> &params)
 	return data;
 }
 
+void
+Translator::startChunkDownloads()
+{
+	while(m_nextChunk <= chunksCount() && m_transferJobChunks.size() + m_retryingChunks < m_maxChunksInFlight)
+		startChunkDownload(m_nextChunk++);
+}
+
 void
 Translator::startChunkDownload(int chunkNumber)
 {
@@ -224,69 +303,121 @@ Translator::startChunkDownload(int chunkNumber)
 	// QByteArray postData = prepareMultipartData( params );
 	QByteArray postData = prepareUrlEncodedData(params);
 
-	m_currentTransferJob = KIO::http_post(QUrl("http://translate.google.com/translate_t"), postData, KIO::HideProgressInfo);
+	KIO::TransferJob *transferJob = KIO::http_post(m_endpoint, postData, KIO::HideProgressInfo);
 
-//  m_currentTransferJob->addMetaData( "content-type", "Content-Type: multipart/form-data; boundary=" MULTIPART_DATA_BOUNDARY );
-	m_currentTransferJob->addMetaData("content-type", "Content-Type: application/x-www-form-urlencoded");
-	m_currentTransferJob->setTotalSize(postData.length());
+//  transferJob->addMetaData( "content-type", "Content-Type: multipart/form-data; boundary=" MULTIPART_DATA_BOUNDARY );
+	transferJob->addMetaData("content-type", "Content-Type: application/x-www-form-urlencoded");
+	transferJob->setTotalSize(postData.length());
 
-	connect(m_currentTransferJob, SIGNAL(percent(KJob *, unsigned long)), this, SLOT(onTransferJobProgress(KJob *, unsigned long)));
-	connect(m_currentTransferJob, SIGNAL(result(KJob *)), this, SLOT(onTransferJobResult(KJob *)));
-	connect(m_currentTransferJob, SIGNAL(data(KIO::Job *, const QByteArray &)), this, SLOT(onTransferJobData(KIO::Job *, const QByteArray &)));
+	connect(transferJob, SIGNAL(percent(KJob *, unsigned long)), this, SLOT(onTransferJobProgress(KJob *, unsigned long)));
+	connect(transferJob, SIGNAL(result(KJob *)), this, SLOT(onTransferJobResult(KJob *)));
+	connect(transferJob, SIGNAL(data(KIO::Job *, const QByteArray &)), this, SLOT(onTransferJobData(KIO::Job *, const QByteArray &)));
 
-	m_currentTransferData.clear();
+	Chunk &chunk = m_chunks[chunkNumber - 1];
+	if(!chunk.attempts++)
+		chunk.timer.start();
+	chunk.data.clear();
+	chunk.percent = 0;
 
-	m_currentTransferJob->start();
+	m_transferJobChunks.insert(transferJob, chunkNumber);
+
+	transferJob->start();
 }
 
 void
-Translator::onTransferJobProgress(KJob * /*job */, unsigned long percent)
+Translator::onTransferJobProgress(KJob *job, unsigned long percent)
 {
-	const double r = 1.0 / chunksCount();
-	int percentage = (int)(m_lastReceivedChunk * 100.0 * r + percent * r);
-	emit progress(percentage);
+	if(!m_transferJobChunks.contains(job))
+		return;
+	m_chunks[m_transferJobChunks.value(job) - 1].percent = percent;
+
+	unsigned long totalPercent = 0;
+	foreach(const Chunk &chunk, m_chunks)
+		totalPercent += chunk.received ? 100 : chunk.percent;
+	emit progress(totalPercent / chunksCount());
 }
 
 void
-Translator::onTransferJobData(KIO::Job * /*job */, const QByteArray &data)
+Translator::onTransferJobData(KIO::Job *job, const QByteArray &data)
 {
-	m_currentTransferData.append(data);
+	if(m_transferJobChunks.contains(job))
+		m_chunks[m_transferJobChunks.value(job) - 1].data.append(data);
 }
 
 void
 Translator::onTransferJobResult(KJob *job)
 {
-	m_currentTransferJob = 0;
+	const int chunkNumber = m_transferJobChunks.take(job);
+	if(!chunkNumber)
+		return;
+
+	Chunk &chunk = m_chunks[chunkNumber - 1];
+
+	// connection failures and overloaded service are worth trying again
+	const int responseCode = static_cast<KIO::TransferJob *>(job)->queryMetaData(QStringLiteral("responsecode")).toInt();
+	if(job->error() || responseCode == 429 || responseCode >= 500) {
+		const QString errorMessage = job->error() ? job->errorString() : i18n("Translation service responded with error %1", responseCode);
 
-	if(job->error()) {
-		m_aborted = false;
-		m_errorMessage = job->errorString();
-		qDebug() << m_errorMessage;
-		emit finishedWithError(m_errorMessage);
+		if(chunk.attempts >= MAX_CHUNK_ATTEMPTS) {
+			finishWithError(errorMessage);
+			return;
+		}
+
+		m_retryingChunks++;
+		const int generation = m_generation;
+		QTimer::singleShot(RETRY_DELAY << (chunk.attempts - 1), this, [this, generation, chunkNumber](){
+			if(generation != m_generation)
+				return;
+			m_retryingChunks--;
+			startChunkDownload(chunkNumber);
+		});
 		return;
 	}
 
-	QTextCodec *codec = QTextCodec::codecForHtml(m_currentTransferData, QTextCodec::codecForName("UTF-8"));
-	QString content = codec->toUnicode(m_currentTransferData);
-
-	static const QRegExp resultStartRegExp(QStringLiteral("^.*<textarea name=utrans [^>]+>"), Qt::CaseInsensitive);
-	if(content.contains(resultStartRegExp)) {
-		content.remove(resultStartRegExp);
-	} else {
-		m_errorMessage = i18n("Unexpected contents received from translation service");
-		emit finishedWithError(m_errorMessage);
+	if(!parseChunkData(chunkNumber)) {
+		finishWithError(i18n("Unexpected contents received from translation service"));
 		return;
 	}
 
-	QRegExp resultEndRegExp(QStringLiteral("</textarea>.*$"), Qt::CaseInsensitive);
-	if(content.contains(resultEndRegExp)) {
-		content.remove(resultEndRegExp);
-	} else {
-		m_errorMessage = i18n("Unexpected contents received from translation service");
-		emit finishedWithError(m_errorMessage);
+	chunk.received = true;
+	chunk.elapsed = chunk.timer.elapsed();
+	chunk.data.clear();
+	m_receivedChunks++;
+	emit chunkReceived(chunkNumber, chunk.attempts, chunk.elapsed);
+
+	if(m_receivedChunks < chunksCount()) {
+		startChunkDownloads();
 		return;
 	}
 
+	// chunks arrive in any order, output is put together only once all of them are here
+	m_outputText.clear();
+	foreach(const Chunk &received, m_chunks) {
+		if(!m_outputText.isEmpty())
+			m_outputText += "\n";
+		m_outputText += received.outputText;
+	}
+	emit finished(m_outputText);
+}
+
+bool
+Translator::parseChunkData(int chunkNumber)
+{
+	Chunk &chunk = m_chunks[chunkNumber - 1];
+
+	QTextCodec *codec = QTextCodec::codecForHtml(chunk.data, QTextCodec::codecForName("UTF-8"));
+	QString content = codec->toUnicode(chunk.data);
+
+	static const QRegExp resultStartRegExp(QStringLiteral("^.*<textarea name=utrans [^>]+>"), Qt::CaseInsensitive);
+	if(!content.contains(resultStartRegExp))
+		return false;
+	content.remove(resultStartRegExp);
+
+	QRegExp resultEndRegExp(QStringLiteral("</textarea>.*$"), Qt::CaseInsensitive);
+	if(!content.contains(resultEndRegExp))
+		return false;
+	content.remove(resultEndRegExp);
+
 	replaceHTMLEntities(content);
 	content.replace(QLatin1String("&quot;"), QLatin1String("\""));
 	content.replace(QLatin1String("&lt;"), QLatin1String("<"));
@@ -296,16 +427,8 @@ Translator::onTransferJobResult(KJob *job)
 	content.replace(QRegExp(QStringLiteral(" ?<br ?/?> ?"), Qt::CaseInsensitive), QStringLiteral("\n"));
 	content.replace(QRegExp(QStringLiteral("\n{2,}"), Qt::CaseInsensitive), QStringLiteral("\n"));
 
-	if(!m_outputText.isEmpty())
-		m_outputText += "\n";
-	m_outputText += content;
-
-	m_lastReceivedChunk += 1;
-
-	if(m_lastReceivedChunk >= chunksCount())
-		emit finished(m_outputText);
-	else
-		startChunkDownload(m_lastReceivedChunk + 1);
+	chunk.outputText = content;
+	return true;
 }
 
 QString &
@@ -25,7 +25,11 @@
 
 #include <QObject>
 #include <QMap>
+#include <QHash>
 #include <QByteArray>
+#include <QElapsedTimer>
+#include <QUrl>
+#include <QVector>
 
 class KJob;
 namespace KIO {
@@ -40,9 +44,25 @@ class Translator : public QObject
 public:
 	static const int MaxChunkSize = 25000; // in characters
 
+	/**
+	 * @brief How long a received chunk took to translate
+	 */
+	struct ChunkTiming {
+		int attempts;
+		qint64 elapsed;         // milliseconds from first request to received result, including retries
+	};
+
 	Translator(QObject *parent = 0);
 	~Translator();
 
+	QUrl endpoint() const;
+	/// translation requests are posted to @p url, a local server can stand in for the service
+	void setEndpoint(const QUrl &url);
+
+	int maxChunksInFlight() const;
+	/// chunks are requested concurrently, results are still put together in input order
+	void setMaxChunksInFlight(int count);
+
 	QString inputText() const;
 	QString outputText() const;
 
@@ -50,6 +70,7 @@ public:
 	Language::Value outputLanguage() const;
 
 	int chunksCount() const; // upon how many chunks will the imput text be split on?
+	ChunkTiming chunkTiming(int chunkNumber) const; // first chunk is number 1
 
 	bool isFinished() const;
 	bool isFinishedWithError() const;
@@ -65,6 +86,7 @@ public slots:
 
 signals:
 	void progress(int percentage);
+	void chunkReceived(int chunkNumber, int attempts, qint64 elapsed);
 
 	void finished(const QString &translatedText);
 	void finishedWithError(const QString &errorMessage);
@@ -77,7 +99,10 @@ private:
 	static QString & replaceHTMLEntities(QString &text);
 	static const QMap<QString, QChar> & namedEntities();
 
+	void startChunkDownloads();
 	void startChunkDownload(int chunkNumber); // first chunk is number 1
+	bool parseChunkData(int chunkNumber);
+	void finishWithError(const QString &errorMessage);
 
 private slots:
 	void onTransferJobProgress(KJob *job, unsigned long percent);
@@ -85,13 +110,28 @@ private slots:
 	void onTransferJobResult(KJob *job);
 
 private:
-	KIO::TransferJob *m_currentTransferJob;
-	QByteArray m_currentTransferData;
+	struct Chunk {
+		QString outputText;
+		QByteArray data;
+		unsigned long percent;
+		int attempts;
+		bool received;
+		QElapsedTimer timer;
+		qint64 elapsed;
+	};
+
+	QUrl m_endpoint;
+	int m_maxChunksInFlight;
+	QHash<KJob *, int> m_transferJobChunks;     // running job => chunk number
+	int m_retryingChunks;                       // chunks waiting to be requested again
+	int m_generation;                           // retries of aborted translations are ignored
 	QStringList m_inputTextChunks;
+	QVector<Chunk> m_chunks;
 	QString m_outputText;
 	Language::Value m_inputLanguage;
 	Language::Value m_outputLanguage;
-	int m_lastReceivedChunk;
+	int m_nextChunk;
+	int m_receivedChunks;
 	QString m_errorMessage;
 	bool m_aborted;
 };
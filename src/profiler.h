@@ -30,6 +30,15 @@
 
 #include <QtCore/QTime>
 #include <QDebug>
+#include <QLoggingCategory>
+
+// timings are logged with QT_LOGGING_RULES="subtitlecomposer.profile.debug=true"
+inline const QLoggingCategory &
+profilerCategory()
+{
+	static const QLoggingCategory category("subtitlecomposer.profile", QtWarningMsg);
+	return category;
+}
 
 class Profiler
 {
@@ -44,9 +53,9 @@ public:
 	{
 		int elapsed = m_time.elapsed();
 		if(m_description)
-			qDebug() << m_description << " took" << elapsed << "msecs";
+			qCDebug(profilerCategory) << m_description << " took" << elapsed << "msecs";
 		else
-			qDebug() << "took" << elapsed << "msecs";
+			qCDebug(profilerCategory) << "took" << elapsed << "msecs";
 	}
 
 private:
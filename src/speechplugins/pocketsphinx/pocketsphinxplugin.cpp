@@ -40,6 +40,19 @@ PocketSphinxPlugin::name()
 	return name;
 }
 
+/*virtual*/ bool
+PocketSphinxPlugin::isThreadSafe() const
+{
+	// every instance has its own decoder
+	return true;
+}
+
+/*virtual*/ SpeechPlugin *
+PocketSphinxPlugin::createInstance() const
+{
+	return new PocketSphinxPlugin();
+}
+
 /*virtual*/ bool
 PocketSphinxPlugin::init()
 {
@@ -65,10 +78,14 @@ PocketSphinxPlugin::init()
 	}
 
 	m_psFrameRate = cmd_ln_int32_r(m_psConfig, "-frate");
+	m_psSampleRate = cmd_ln_float32_r(m_psConfig, "-samprate");
 
 	m_lineText.clear();
 	m_lineIn = m_lineOut = 0;
 
+	m_samplesProcessed = 0;
+	m_utteranceOffset = 0.;
+
 	m_utteranceStarted = false;
 	m_speechStarted = false;
 
@@ -105,8 +122,8 @@ PocketSphinxPlugin::processUtterance()
 			// "<s>" "</s>" "<sil>" "[SPEECH]"
 			if(!m_lineText.isEmpty()) {
 				emit textRecognized(m_lineText,
-									  double(m_lineIn) * 1000. / double(m_psFrameRate),
-									  double(m_lineOut) * 1000. / double(m_psFrameRate));
+									  m_utteranceOffset + double(m_lineIn) * 1000. / double(m_psFrameRate),
+									  m_utteranceOffset + double(m_lineOut) * 1000. / double(m_psFrameRate));
 				m_lineText.clear();
 			}
 		} else {
@@ -132,8 +149,8 @@ PocketSphinxPlugin::processUtterance()
 	}
 	if(!m_lineText.isEmpty()) {
 		emit textRecognized(m_lineText,
-							  double(m_lineIn) * 1000. / double(m_psFrameRate),
-							  double(m_lineOut) * 1000. / double(m_psFrameRate));
+							  m_utteranceOffset + double(m_lineIn) * 1000. / double(m_psFrameRate),
+							  m_utteranceOffset + double(m_lineOut) * 1000. / double(m_psFrameRate));
 		m_lineText.clear();
 	}
 }
@@ -142,12 +159,15 @@ PocketSphinxPlugin::processUtterance()
 PocketSphinxPlugin::processSamples(const qint16 *sampleData, qint32 sampleCount)
 {
 	if(!m_utteranceStarted) {
+		// frame numbers are relative to utterance start
 		ps_start_utt(m_psDecoder);
 		m_utteranceStarted = true;
 		m_speechStarted = false;
+		m_utteranceOffset = double(m_samplesProcessed) * 1000. / m_psSampleRate;
 	}
 
 	ps_process_raw(m_psDecoder, sampleData, sampleCount, FALSE, FALSE);
+	m_samplesProcessed += sampleCount;
 
 	if(ps_get_in_speech(m_psDecoder)) {
 		m_speechStarted = true;
@@ -169,6 +189,12 @@ PocketSphinxPlugin::processComplete()
 			ps_end_utt(m_psDecoder);
 		processUtterance();
 	}
+
+	// next samples belong to a new audio segment
+	m_samplesProcessed = 0;
+	m_utteranceOffset = 0.;
+	m_utteranceStarted = false;
+	m_speechStarted = false;
 }
 
 /*virtual*/ void
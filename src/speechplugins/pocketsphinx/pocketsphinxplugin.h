@@ -39,6 +39,9 @@ public:
 private:
 	virtual const QString & name();
 
+	virtual bool isThreadSafe() const;
+	virtual SpeechPlugin * createInstance() const;
+
 	virtual bool init();
 	virtual void cleanup();
 
@@ -53,6 +56,10 @@ private:
 	cmd_ln_t *m_psConfig;
 	ps_decoder_t *m_psDecoder;
 	qint32 m_psFrameRate;
+	double m_psSampleRate;
+
+	qint64 m_samplesProcessed;
+	double m_utteranceOffset;
 
 	QString m_lineText;
 	int m_lineIn;
@@ -38,11 +38,35 @@ protected:
 private:
 	virtual const QString & name() = 0;
 
+	/**
+	 * @brief Tells whether separate instances can process audio concurrently
+	 * @return true if instances returned by createInstance() don't share any
+	 * unsynchronized state and can be used from different threads at the same time
+	 */
+	virtual bool isThreadSafe() const { return false; }
+	/**
+	 * @brief Creates new independent instance of the plugin
+	 * @return new instance owned by caller or nullptr if plugin supports single instance only
+	 */
+	virtual SpeechPlugin * createInstance() const { return nullptr; }
+
 	virtual bool init() = 0;
 	virtual void cleanup() = 0;
 
+	/**
+	 * Times of recognized text are relative to the first sample passed after
+	 * init() or processComplete(), so single instance can process several
+	 * independent audio segments one after another.
+	 */
 	virtual void processSamples(const qint16 *sampleData, qint32 sampleCount) = 0;
 	virtual void processComplete() = 0;
+	/**
+	 * @brief Asks running processSamples() or processComplete() to return as soon as possible
+	 *
+	 * Called from main thread while the instance is processing audio in another thread.
+	 * Results don't matter anymore, only cleanup() is called on the instance afterwards.
+	 */
+	virtual void cancel() {}
 
 	virtual void setSCConfig(SCConfig *scConfig) = 0;
 
@@ -25,6 +25,7 @@
 #include "speechplugin.h"
 #include "application.h"
 #include "lineswidget.h"
+#include "streamprocessor/samplekernels.h"
 
 #include "scconfig.h"
 
@@ -32,6 +33,8 @@
 #include <QProgressBar>
 #include <QBoxLayout>
 #include <QThread>
+#include <QRunnable>
+#include <QMutexLocker>
 
 #include <QPluginLoader>
 #include <QDir>
@@ -41,8 +44,77 @@
 
 #include <KLocalizedString>
 
+#include <cmath>
+
+#define SPEECH_SAMPLE_RATE 16000
+// audio is analyzed for silence in 10ms frames
+#define SEGMENT_FRAME_SAMPLES (SPEECH_SAMPLE_RATE / 100)
+// segments are cut in the middle of first long enough silence after minimum length
+#define SEGMENT_MIN_SAMPLES (SPEECH_SAMPLE_RATE * 10)
+#define SEGMENT_MAX_SAMPLES (SPEECH_SAMPLE_RATE * 60)
+#define SEGMENT_SILENCE_FRAMES 30
+// frames quieter than this above the noise floor are silent
+#define SEGMENT_SILENCE_DB 10.f
+// noise floor follows the quietest frames and slowly rises (1dB/s) to adapt to louder background
+#define SEGMENT_NOISE_RISE_DB .01f
+// samples passed to plugin at once
+#define SEGMENT_CHUNK_SAMPLES 4096
+
 using namespace SubtitleComposer;
 
+class SpeechProcessor::RecognizeJob : public QRunnable
+{
+public:
+	RecognizeJob(SpeechProcessor *processor, int generation, int segment, quint64 sampleOffset, const QVector<qint16> &samples)
+		: m_processor(processor),
+		  m_generation(generation),
+		  m_segment(segment),
+		  m_sampleOffset(sampleOffset),
+		  m_samples(samples)
+	{
+	}
+
+	void run() Q_DECL_OVERRIDE
+	{
+		SpeechPlugin *plugin = m_processor->acquireInstance();
+
+		const double msecOffset = double(m_sampleOffset) * 1000. / SPEECH_SAMPLE_RATE;
+		SegmentResult result;
+		result.msecEnd = (m_sampleOffset + m_samples.size()) * 1000 / SPEECH_SAMPLE_RATE;
+
+		// plugin emits from this thread, results are collected without going through event loop
+		QMetaObject::Connection connection = QObject::connect(plugin, &SpeechPlugin::textRecognized,
+			[&](const QString &text, const double milliShow, const double milliHide) {
+				result.texts.append(RecognizedText{ text, msecOffset + milliShow, msecOffset + milliHide });
+			});
+
+		// cancelled segment is abandoned after current chunk
+		const qint16 *samples = m_samples.constData();
+		for(int i = 0; i < m_samples.size() && !m_processor->isCancelled(m_generation); i += SEGMENT_CHUNK_SAMPLES)
+			plugin->processSamples(samples + i, qMin(SEGMENT_CHUNK_SAMPLES, m_samples.size() - i));
+		if(!m_processor->isCancelled(m_generation))
+			plugin->processComplete();
+
+		QObject::disconnect(connection);
+		m_processor->releaseInstance(plugin);
+
+		{
+			QMutexLocker locker(&m_processor->m_mutex);
+			if(m_generation != m_processor->m_generation)
+				return;
+			m_processor->m_segmentResults.insert(m_segment, result);
+		}
+		QMetaObject::invokeMethod(m_processor, "onSegmentFinished", Qt::QueuedConnection, Q_ARG(int, m_generation));
+	}
+
+private:
+	SpeechProcessor *m_processor;
+	int m_generation;
+	int m_segment;
+	quint64 m_sampleOffset;
+	QVector<qint16> m_samples;
+};
+
 SpeechProcessor::SpeechProcessor(QWidget *parent)
 	: QObject(parent),
 	  m_mediaFile(QString()),
@@ -50,7 +122,15 @@ SpeechProcessor::SpeechProcessor(QWidget *parent)
 	  m_stream(new StreamProcessor(this)),
 	  m_subtitle(nullptr),
 	  m_progressWidget(new QWidget(parent)),
-	  m_plugin(nullptr)
+	  m_plugin(nullptr),
+	  m_segmentAnalyzed(0),
+	  m_segmentStart(0),
+	  m_silentFrames(0),
+	  m_noiseFloor(0.f),
+	  m_generation(0),
+	  m_segmentsQueued(0),
+	  m_streamFinished(false),
+	  m_nextSegment(0)
 {
 	// Progress Bar
 	m_progressWidget->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Expanding);
@@ -159,20 +239,44 @@ SpeechProcessor::setAudioStream(const QString &mediaFile, int audioStream)
 		return;
 	}
 
-	if(!m_plugin->init()) {
-		onStreamError(1, i18n("Initialization of speech recognition plugin failed"), QString());
-		return;
+	// segments are recognized concurrently only if plugin can run several instances in parallel
+	const int instanceCount = m_plugin->isThreadSafe() ? qMax(1, QThread::idealThreadCount()) : 1;
+	m_instances.append(m_plugin);
+	while(m_instances.size() < instanceCount) {
+		SpeechPlugin *instance = m_plugin->createInstance();
+		if(!instance)
+			break;
+		instance->setParent(this);
+		m_instances.append(instance);
 	}
 
-	connect(m_plugin, &SpeechPlugin::textRecognized, this, &SpeechProcessor::onTextRecognized);
-	connect(m_plugin, &SpeechPlugin::error, [this](int code, const QString &message) { onStreamError(code, message, QString()); });
+	foreach(SpeechPlugin *instance, m_instances) {
+		if(!instance->init()) {
+			onStreamError(1, i18n("Initialization of speech recognition plugin failed"), QString());
+			return;
+		}
+		connect(instance, &SpeechPlugin::error, this, [this](int code, const QString &message) { onStreamError(code, message, QString()); });
+	}
+
+	m_freeInstances = m_instances;
+	m_threadPool.setMaxThreadCount(m_instances.size());
 
 	m_mediaFile = mediaFile;
 	m_streamIndex = audioStream;
 
 	m_audioDuration = 0;
 
-	static WaveFormat waveFormat(16000, 1, 16, true);
+	m_segmentSamples.clear();
+	m_segmentAnalyzed = 0;
+	m_segmentStart = 0;
+	m_silentFrames = 0;
+	m_noiseFloor = 1000.f;
+
+	m_segmentsQueued = 0;
+	m_streamFinished = false;
+	m_nextSegment = 0;
+
+	static WaveFormat waveFormat(SPEECH_SAMPLE_RATE, 1, 16, true);
 	if(m_stream->open(mediaFile) && m_stream->initAudio(audioStream, waveFormat))
 		m_stream->start();
 }
@@ -188,30 +292,91 @@ SpeechProcessor::clearAudioStream()
 	m_mediaFile.clear();
 	m_streamIndex = -1;
 
-	if(m_plugin) {
-		m_plugin->disconnect();
-		m_plugin->cleanup();
-		m_plugin = nullptr;
+	// results of segments that are still being recognized will be ignored
+	m_threadPool.clear();
+	{
+		QMutexLocker locker(&m_mutex);
+		m_generation++;
+		m_segmentResults.clear();
+
+		// running jobs stop after current chunk, busy plugins are asked to stop too so GUI isn't blocked
+		foreach(SpeechPlugin *instance, m_instances) {
+			if(!m_freeInstances.contains(instance))
+				instance->cancel();
+		}
+	}
+	m_threadPool.waitForDone();
+	m_freeInstances.clear();
+
+	m_segmentSamples.clear();
+
+	foreach(SpeechPlugin *instance, m_instances) {
+		instance->disconnect();
+		instance->cleanup();
+		if(instance != m_plugin)
+			delete instance;
 	}
+	m_instances.clear();
+	m_plugin = nullptr;
+}
+
+bool
+SpeechProcessor::isCancelled(int generation)
+{
+	QMutexLocker locker(&m_mutex);
+	return generation != m_generation;
+}
+
+SpeechPlugin *
+SpeechProcessor::acquireInstance()
+{
+	// thread pool never runs more jobs than there are instances
+	QMutexLocker locker(&m_mutex);
+	Q_ASSERT(!m_freeInstances.isEmpty());
+	return m_freeInstances.takeLast();
 }
 
 void
-SpeechProcessor::onStreamProgress(quint64 msecPos, quint64 msecLength)
+SpeechProcessor::releaseInstance(SpeechPlugin *instance)
 {
+	QMutexLocker locker(&m_mutex);
+	m_freeInstances.append(instance);
+}
+
+void
+SpeechProcessor::onStreamProgress(quint64 /*msecPos*/, quint64 msecLength)
+{
+	// progress shows recognized audio instead of decoded position
 	if(!m_audioDuration) {
 		m_audioDuration = msecLength / 1000;
 		m_progressBar->setRange(0, m_audioDuration);
+		m_progressBar->setValue(0);
+		m_progressBar->setFormat(QStringLiteral("%p%"));
 		m_progressWidget->show();
 	}
-	m_progressBar->setValue(msecPos / 1000);
 }
 
 void
 SpeechProcessor::onStreamFinished()
 {
-	if(m_plugin)
-		m_plugin->processComplete();
-	clearAudioStream();
+	if(!m_plugin) {
+		clearAudioStream();
+		return;
+	}
+
+	m_stream->close();
+
+	if(!m_segmentSamples.isEmpty())
+		queueSegment(m_segmentSamples.size());
+
+	bool finished;
+	{
+		QMutexLocker locker(&m_mutex);
+		m_streamFinished = true;
+		finished = m_nextSegment == m_segmentsQueued;
+	}
+	if(finished)
+		clearAudioStream();
 }
 
 void
@@ -224,7 +389,89 @@ SpeechProcessor::onStreamData(const void *buffer, const qint32 size, const WaveF
 	Q_ASSERT(size % sizeof(qint16) == 0);
 
 	if(m_plugin)
-		m_plugin->processSamples(reinterpret_cast<const qint16 *>(buffer), size / sizeof(qint16));
+		appendSamples(reinterpret_cast<const qint16 *>(buffer), size / sizeof(qint16));
+}
+
+void
+SpeechProcessor::appendSamples(const qint16 *samples, qint32 sampleCount)
+{
+	const int oldSize = m_segmentSamples.size();
+	m_segmentSamples.resize(oldSize + sampleCount);
+	memcpy(m_segmentSamples.data() + oldSize, samples, sampleCount * sizeof(qint16));
+
+	while(m_segmentAnalyzed + SEGMENT_FRAME_SAMPLES <= m_segmentSamples.size()) {
+		const qint16 *frame = m_segmentSamples.constData() + m_segmentAnalyzed;
+		m_segmentAnalyzed += SEGMENT_FRAME_SAMPLES;
+
+		const double power = double(SampleKernels::sumSquares(frame, SEGMENT_FRAME_SAMPLES)) / SEGMENT_FRAME_SAMPLES;
+		const float energy = 10. * std::log10(power + 1.);
+		m_noiseFloor = qMin(m_noiseFloor + SEGMENT_NOISE_RISE_DB, energy);
+		if(energy < m_noiseFloor + SEGMENT_SILENCE_DB)
+			m_silentFrames++;
+		else
+			m_silentFrames = 0;
+
+		if(m_segmentAnalyzed >= SEGMENT_MIN_SAMPLES && m_silentFrames >= SEGMENT_SILENCE_FRAMES)
+			queueSegment(m_segmentAnalyzed - m_silentFrames / 2 * SEGMENT_FRAME_SAMPLES);
+		else if(m_segmentAnalyzed >= SEGMENT_MAX_SAMPLES)
+			queueSegment(m_segmentAnalyzed);
+	}
+}
+
+void
+SpeechProcessor::queueSegment(int length)
+{
+	int segment;
+	int generation;
+	{
+		QMutexLocker locker(&m_mutex);
+		segment = m_segmentsQueued++;
+		generation = m_generation;
+	}
+
+	m_threadPool.start(new RecognizeJob(this, generation, segment, m_segmentStart, m_segmentSamples.mid(0, length)));
+
+	m_segmentSamples.remove(0, length);
+	m_segmentStart += length;
+	m_segmentAnalyzed = qMax(0, m_segmentAnalyzed - length);
+	m_silentFrames = 0;
+}
+
+void
+SpeechProcessor::onSegmentFinished(int generation)
+{
+	// segments can finish in any order, their text is inserted in time order
+	QList<SegmentResult> results;
+	bool finished;
+	{
+		QMutexLocker locker(&m_mutex);
+		if(generation != m_generation)
+			return;
+		while(m_segmentResults.contains(m_nextSegment))
+			results.append(m_segmentResults.take(m_nextSegment++));
+		finished = m_streamFinished && m_nextSegment == m_segmentsQueued;
+	}
+
+	// all lines of finished segments are inserted with single action
+	QList<SubtitleLine *> lines;
+	foreach(const SegmentResult &result, results) {
+		foreach(const RecognizedText &text, result.texts)
+			lines.append(new SubtitleLine(SString(text.text), text.milliShow, text.milliHide));
+	}
+	if(m_subtitle && !lines.isEmpty()) {
+		LinesWidgetScrollToModelDetacher detacher(*Application::instance()->linesWidget());
+		m_subtitle->insertLinesSorted(lines);
+	} else {
+		qDeleteAll(lines);
+	}
+
+	if(!results.isEmpty()) {
+		m_progressBar->setValue(results.last().msecEnd / 1000);
+		m_progressBar->setFormat(i18np("%p% (%1 segment)", "%p% (%1 segments)", m_nextSegment));
+	}
+
+	if(finished)
+		clearAudioStream();
 }
 
 void
@@ -238,13 +485,3 @@ SpeechProcessor::onStreamError(int code, const QString &message, const QString &
 	clearAudioStream();
 }
 
-void
-SpeechProcessor::onTextRecognized(const QString &text, const double milliShow, const double milliHide)
-{
-	if(!m_subtitle)
-		return;
-
-	LinesWidgetScrollToModelDetacher detacher(*Application::instance()->linesWidget());
-	m_subtitle->insertLine(new SubtitleLine(SString(text), milliShow, milliHide));
-}
-
@@ -25,6 +25,10 @@
 #include "streamprocessor/streamprocessor.h"
 
 #include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QThreadPool>
+#include <QVector>
 
 QT_FORWARD_DECLARE_CLASS(QWidget)
 QT_FORWARD_DECLARE_CLASS(QProgressBar)
@@ -54,12 +58,19 @@ private slots:
 	void onStreamError(int code, const QString &message, const QString &debug);
 	void onStreamFinished();
 	void onStreamData(const void *buffer, const qint32 size, const WaveFormat *waveFormat, const quint64 msecStart, const quint64 msecDuration);
-	void onTextRecognized(const QString &text, const double milliShow, const double milliHide);
+	void onSegmentFinished(int generation);
 
 private:
 	SpeechPlugin * pluginLoad(const QString &pluginPath);
 	void pluginAdd(SpeechPlugin *plugin);
 
+	void appendSamples(const qint16 *samples, qint32 sampleCount);
+	void queueSegment(int length);
+
+	bool isCancelled(int generation);
+	SpeechPlugin * acquireInstance();
+	void releaseInstance(SpeechPlugin *instance);
+
 private:
 	QString m_mediaFile;
 	int m_streamIndex;
@@ -74,6 +85,40 @@ private:
 
 	SpeechPlugin *m_plugin;
 	QMap<QString, SpeechPlugin *> m_plugins;
+
+	class RecognizeJob;
+
+	struct RecognizedText {
+		QString text;
+		double milliShow;
+		double milliHide;
+	};
+
+	struct SegmentResult {
+		quint64 msecEnd;
+		QList<RecognizedText> texts;
+	};
+
+	// plugin instances recognizing segments concurrently, first one is m_plugin
+	QThreadPool m_threadPool;
+	QList<SpeechPlugin *> m_instances;
+
+	// audio is split into segments at silence in GStreamer's thread
+	QVector<qint16> m_segmentSamples;
+	int m_segmentAnalyzed;
+	quint64 m_segmentStart;
+	int m_silentFrames;
+	float m_noiseFloor;
+
+	// shared between GStreamer's, worker and main thread
+	QMutex m_mutex;
+	QList<SpeechPlugin *> m_freeInstances;
+	QMap<int, SegmentResult> m_segmentResults;
+	int m_generation;
+	int m_segmentsQueued;
+	bool m_streamFinished;
+
+	int m_nextSegment;
 };
 }
 
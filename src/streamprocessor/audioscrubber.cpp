@@ -0,0 +1,244 @@
+/**
+ * Copyright (C) 2010-2017 Mladen Milinkovic <max@smoothware.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "audioscrubber.h"
+#include "gstreamer.h"
+
+#include <QTimer>
+
+// length of played window in milliseconds, new position is picked up after each window
+#define SCRUB_WINDOW 80
+// length of fade in/out at window edges in milliseconds, avoids clicks between windows
+#define SCRUB_FADE 5
+// audio device is released after this many milliseconds without scrubbing
+#define SCRUB_IDLE_TIMEOUT 3000
+// sink buffering in microseconds, defaults of audio sinks add hundreds of milliseconds of latency
+#define SINK_BUFFER_TIME 40000
+#define SINK_LATENCY_TIME 10000
+
+using namespace SubtitleComposer;
+
+AudioScrubber::AudioScrubber(QObject *parent)
+	: QObject(parent),
+	  m_gstInited(false),
+	  m_channels(Q_NULLPTR),
+	  m_channelCount(0),
+	  m_sampleRate(0),
+	  m_pipeline(NULL),
+	  m_pipelineBus(NULL),
+	  m_source(NULL),
+	  m_streamTime(0),
+	  m_position(-1),
+	  m_lastPosition(-1),
+	  m_samplesAvailable(0),
+	  m_windowTimer(new QTimer(this)),
+	  m_idleTimer(new QTimer(this))
+{
+	m_windowTimer->setSingleShot(true);
+	m_windowTimer->setTimerType(Qt::PreciseTimer);
+	connect(m_windowTimer, &QTimer::timeout, this, &AudioScrubber::onWindowTimeout);
+
+	m_idleTimer->setSingleShot(true);
+	m_idleTimer->setInterval(SCRUB_IDLE_TIMEOUT);
+	connect(m_idleTimer, &QTimer::timeout, this, &AudioScrubber::closePipeline);
+}
+
+AudioScrubber::~AudioScrubber()
+{
+	closePipeline();
+
+	if(m_gstInited)
+		GStreamer::deinit();
+}
+
+void
+AudioScrubber::setSource(const qint16 * const *channels, quint32 channelCount, quint32 sampleRate)
+{
+	if(m_channels == channels && m_channelCount == channelCount && m_sampleRate == sampleRate)
+		return;
+
+	clear();
+	m_channels = channels;
+	m_channelCount = channelCount;
+	m_sampleRate = sampleRate;
+}
+
+void
+AudioScrubber::clear()
+{
+	stop();
+	// pipeline caps depend on the source format
+	closePipeline();
+
+	m_channels = Q_NULLPTR;
+	m_channelCount = 0;
+	m_sampleRate = 0;
+	m_samplesAvailable = 0;
+}
+
+void
+AudioScrubber::scrub(qint64 msecPosition, quint32 samplesAvailable)
+{
+	m_position = msecPosition;
+	m_samplesAvailable = samplesAvailable;
+
+	// while a window is playing only the latest position is remembered
+	if(!m_windowTimer->isActive())
+		pushWindow();
+}
+
+void
+AudioScrubber::stop()
+{
+	// window that is already queued is short enough to let it play out
+	m_windowTimer->stop();
+	m_position = m_lastPosition = -1;
+}
+
+void
+AudioScrubber::onWindowTimeout()
+{
+	if(m_position != m_lastPosition)
+		pushWindow();
+}
+
+void
+AudioScrubber::pushWindow()
+{
+	const qint64 windowSize = qint64(m_sampleRate) * SCRUB_WINDOW / 1000;
+	if(!m_channels || !m_channelCount || m_position < 0 || windowSize <= 0 || m_samplesAvailable < windowSize)
+		return;
+	if(!openPipeline())
+		return;
+
+	m_lastPosition = m_position;
+
+	const qint64 start = qBound(qint64(0), m_position * m_sampleRate / 1000 - windowSize / 2, qint64(m_samplesAvailable) - windowSize);
+	const qint64 fadeSize = qMax(qint64(1), qint64(m_sampleRate) * SCRUB_FADE / 1000);
+
+	GstBuffer *buffer = gst_buffer_new_allocate(NULL, windowSize * m_channelCount * sizeof(qint16), NULL);
+	GstMapInfo map;
+	gst_buffer_map(buffer, &map, GST_MAP_WRITE);
+	qint16 *out = reinterpret_cast<qint16 *>(map.data);
+	for(qint64 i = 0; i < windowSize; i++) {
+		const qint64 edge = qMin(i, windowSize - 1 - i);
+		const qint32 gain = edge < fadeSize ? qint32(edge * 256 / fadeSize) : 256;
+		for(quint32 ch = 0; ch < m_channelCount; ch++)
+			*out++ = qint16(m_channels[ch][start + i] * gain / 256);
+	}
+	gst_buffer_unmap(buffer, &map);
+
+	// windows are played back to back as one continuous stream
+	const GstClockTime duration = gst_util_uint64_scale_int(windowSize, GST_SECOND, m_sampleRate);
+	GST_BUFFER_PTS(buffer) = m_streamTime;
+	GST_BUFFER_DURATION(buffer) = duration;
+	m_streamTime += duration;
+
+	GstFlowReturn ret;
+	g_signal_emit_by_name(m_source, "push-buffer", buffer, &ret);
+	gst_buffer_unref(buffer);
+
+	m_windowTimer->start(SCRUB_WINDOW);
+	m_idleTimer->start();
+}
+
+bool
+AudioScrubber::openPipeline()
+{
+	if(m_pipeline)
+		return true;
+
+	// scrubber is created with the waveform, GStreamer is initialized on first scrub
+	if(!m_gstInited && !(m_gstInited = GStreamer::init()))
+		return false;
+
+	m_pipeline = GST_PIPELINE(gst_pipeline_new("audioscrubber"));
+	GstElement *source = gst_element_factory_make("appsrc", "source");
+	GstElement *convert = gst_element_factory_make("audioconvert", "convert");
+	GstElement *resample = gst_element_factory_make("audioresample", "resample");
+	GstElement *sink = gst_element_factory_make("autoaudiosink", "sink");
+
+	if(!m_pipeline || !source || !convert || !resample || !sink) {
+		if(source)
+			gst_object_unref(GST_OBJECT(source));
+		if(convert)
+			gst_object_unref(GST_OBJECT(convert));
+		if(resample)
+			gst_object_unref(GST_OBJECT(resample));
+		if(sink)
+			gst_object_unref(GST_OBJECT(sink));
+		GStreamer::freePipeline(&m_pipeline, &m_pipelineBus);
+		return false;
+	}
+
+	GstCaps *caps = gst_caps_new_simple("audio/x-raw",
+			"format", G_TYPE_STRING, "S16LE",
+			"layout", G_TYPE_STRING, "interleaved",
+			"rate", G_TYPE_INT, gint(m_sampleRate),
+			"channels", G_TYPE_INT, gint(m_channelCount),
+			NULL);
+	g_object_set(G_OBJECT(source), "caps", caps, "format", GST_FORMAT_TIME, "is-live", TRUE, "block", FALSE, NULL);
+	gst_caps_unref(caps);
+
+	// the actual sink is created by autoaudiosink when it changes state
+	g_signal_connect(m_pipeline, "deep-element-added", G_CALLBACK(onElementAdded), this);
+
+	gst_bin_add_many(GST_BIN(m_pipeline), source, convert, resample, sink, NULL);
+
+	m_pipelineBus = gst_pipeline_get_bus(m_pipeline);
+	// nobody is listening, errors are noticed as failed state changes
+	gst_bus_set_flushing(m_pipelineBus, TRUE);
+
+	m_source = source;
+	m_streamTime = 0;
+
+	if(!gst_element_link_many(source, convert, resample, sink, NULL)
+			|| GStreamer::setElementState(GST_ELEMENT(m_pipeline), GST_STATE_PLAYING, 0) == GST_STATE_CHANGE_FAILURE) {
+		closePipeline();
+		return false;
+	}
+
+	return true;
+}
+
+void
+AudioScrubber::closePipeline()
+{
+	m_idleTimer->stop();
+
+	if(!m_pipeline)
+		return;
+
+	GStreamer::setElementState(GST_ELEMENT(m_pipeline), GST_STATE_NULL, 0);
+	GStreamer::freePipeline(&m_pipeline, &m_pipelineBus);
+	m_source = NULL;
+}
+
+/*static*/ void
+AudioScrubber::onElementAdded(GstBin */*bin*/, GstBin */*subBin*/, GstElement *element, gpointer /*userData*/)
+{
+	GObjectClass *elementClass = G_OBJECT_GET_CLASS(element);
+	// play samples as soon as they arrive instead of syncing them to the clock
+	if(g_object_class_find_property(elementClass, "sync"))
+		g_object_set(G_OBJECT(element), "sync", FALSE, NULL);
+	if(g_object_class_find_property(elementClass, "buffer-time"))
+		g_object_set(G_OBJECT(element), "buffer-time", gint64(SINK_BUFFER_TIME), NULL);
+	if(g_object_class_find_property(elementClass, "latency-time"))
+		g_object_set(G_OBJECT(element), "latency-time", gint64(SINK_LATENCY_TIME), NULL);
+}
@@ -0,0 +1,90 @@
+#ifndef AUDIOSCRUBBER_H
+#define AUDIOSCRUBBER_H
+/**
+ * Copyright (C) 2010-2017 Mladen Milinkovic <max@smoothware.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <QObject>
+
+#include <gst/gst.h>
+
+QT_FORWARD_DECLARE_CLASS(QTimer)
+
+namespace SubtitleComposer {
+/**
+ * @brief Plays short windows of already decoded PCM while the user drags along the timeline.
+ *
+ * Samples are pushed through a small appsrc ! audioconvert ! audioresample ! autoaudiosink
+ * pipeline that is independent of the video player backend. At most one window is queued at
+ * a time, so the played audio follows the latest requested position instead of lagging
+ * behind a backlog of mouse moves. The audio device is released after a while of inactivity.
+ */
+class AudioScrubber : public QObject
+{
+	Q_OBJECT
+
+public:
+	explicit AudioScrubber(QObject *parent = Q_NULLPTR);
+	virtual ~AudioScrubber();
+
+	/**
+	 * @brief Sets deinterleaved 16 bit samples that will be played
+	 * @param channels buffers of samples, they are read only from scrub()
+	 */
+	void setSource(const qint16 * const *channels, quint32 channelCount, quint32 sampleRate);
+	void clear();
+
+	/**
+	 * @brief Plays window of samples centered at @p msecPosition
+	 * @param samplesAvailable number of samples per channel that have been decoded
+	 */
+	void scrub(qint64 msecPosition, quint32 samplesAvailable);
+	void stop();
+
+private slots:
+	void onWindowTimeout();
+	void closePipeline();
+
+private:
+	bool openPipeline();
+	void pushWindow();
+
+	static void onElementAdded(GstBin *bin, GstBin *subBin, GstElement *element, gpointer userData);
+
+private:
+	bool m_gstInited;
+
+	const qint16 * const *m_channels;
+	quint32 m_channelCount;
+	quint32 m_sampleRate;
+
+	GstPipeline *m_pipeline;
+	GstBus *m_pipelineBus;
+	GstElement *m_source;
+	GstClockTime m_streamTime;
+
+	qint64 m_position;
+	qint64 m_lastPosition;
+	quint32 m_samplesAvailable;
+
+	QTimer *m_windowTimer;
+	QTimer *m_idleTimer;
+};
+}
+
+#endif // AUDIOSCRUBBER_H
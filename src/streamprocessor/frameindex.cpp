@@ -0,0 +1,138 @@
+/**
+ * Copyright (C) 2010-2017 Mladen Milinkovic <max@smoothware.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "frameindex.h"
+#include "mediacachefile.h"
+
+#include <algorithm>
+
+// identifies index files, version has to be bumped whenever the format changes
+#define INDEX_MAGIC 0x53434649
+#define INDEX_VERSION 1
+
+using namespace SubtitleComposer;
+
+FrameIndex::FrameIndex()
+{
+}
+
+void
+FrameIndex::clear()
+{
+	m_frames.clear();
+	m_keyframes.clear();
+}
+
+void
+FrameIndex::append(qint64 usecTime, bool keyframe)
+{
+	m_frames.append(usecTime);
+	if(keyframe)
+		m_keyframes.append(usecTime);
+}
+
+void
+FrameIndex::finalize()
+{
+	// frames with B-frames are stored out of presentation order
+	std::sort(m_frames.begin(), m_frames.end());
+	m_frames.erase(std::unique(m_frames.begin(), m_frames.end()), m_frames.end());
+	std::sort(m_keyframes.begin(), m_keyframes.end());
+	m_keyframes.erase(std::unique(m_keyframes.begin(), m_keyframes.end()), m_keyframes.end());
+	m_frames.squeeze();
+	m_keyframes.squeeze();
+}
+
+int
+FrameIndex::frameAt(qint64 usecTime) const
+{
+	auto it = std::upper_bound(m_frames.cbegin(), m_frames.cend(), usecTime);
+	return int(it - m_frames.cbegin()) - 1;
+}
+
+int
+FrameIndex::frameAfter(qint64 usecTime) const
+{
+	auto it = std::lower_bound(m_frames.cbegin(), m_frames.cend(), usecTime);
+	return int(it - m_frames.cbegin());
+}
+
+qint64
+FrameIndex::snapToFrame(qint64 usecTime) const
+{
+	const int next = frameAfter(usecTime);
+	if(next == m_frames.size())
+		return m_frames.isEmpty() ? usecTime : m_frames.last();
+	if(next == 0)
+		return m_frames.first();
+
+	const qint64 after = m_frames.at(next);
+	const qint64 before = m_frames.at(next - 1);
+	return after - usecTime < usecTime - before ? after : before;
+}
+
+bool
+FrameIndex::isKeyframe(qint64 frameTime) const
+{
+	return std::binary_search(m_keyframes.cbegin(), m_keyframes.cend(), frameTime);
+}
+
+qint64
+FrameIndex::keyframeBefore(qint64 usecTime) const
+{
+	auto it = std::upper_bound(m_keyframes.cbegin(), m_keyframes.cend(), usecTime);
+	return it == m_keyframes.cbegin() ? -1 : *(it - 1);
+}
+
+bool
+FrameIndex::load(const QString &indexFile, const QString &mediaFile)
+{
+	clear();
+
+	QFile file(indexFile);
+	QDataStream stream;
+	// stale index of modified file is rebuilt
+	if(!MediaCacheFile::openForReading(file, stream, INDEX_MAGIC, INDEX_VERSION, mediaFile))
+		return false;
+
+	stream >> m_frames >> m_keyframes;
+	if(stream.status() != QDataStream::Ok) {
+		clear();
+		return false;
+	}
+	return true;
+}
+
+bool
+FrameIndex::save(const QString &indexFile, const QString &mediaFile) const
+{
+	QFile file(indexFile);
+	QDataStream stream;
+	if(!MediaCacheFile::openForWriting(file, stream, INDEX_MAGIC, INDEX_VERSION, mediaFile))
+		return false;
+
+	stream << m_frames << m_keyframes;
+	return stream.status() == QDataStream::Ok;
+}
+
+/*static*/ QString
+FrameIndex::cacheFile(const QString &mediaFile)
+{
+	return MediaCacheFile::path(QStringLiteral("frameindex"), mediaFile, QStringLiteral("idx"));
+}
@@ -0,0 +1,70 @@
+#ifndef FRAMEINDEX_H
+#define FRAMEINDEX_H
+/**
+ * Copyright (C) 2010-2017 Mladen Milinkovic <max@smoothware.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <QString>
+#include <QVector>
+
+namespace SubtitleComposer {
+/**
+ * @brief Presentation times of all video frames and keyframes of a file.
+ *
+ * Timestamps are collected from demuxed (not decoded) video in decoding order
+ * and sorted by finalize(). All times are in microseconds.
+ */
+class FrameIndex
+{
+public:
+	FrameIndex();
+
+	inline bool isEmpty() const { return m_frames.isEmpty(); }
+	void clear();
+
+	void append(qint64 usecTime, bool keyframe);
+	/// sorts timestamps, must be called after last append()
+	void finalize();
+
+	inline int frameCount() const { return m_frames.size(); }
+	inline qint64 frameTime(int index) const { return m_frames.at(index); }
+	inline const QVector<qint64> & frames() const { return m_frames; }
+	inline const QVector<qint64> & keyframes() const { return m_keyframes; }
+
+	/// @return index of the frame presented at @p usecTime or -1 if it's before the first one
+	int frameAt(qint64 usecTime) const;
+	/// @return index of the first frame presented at or after @p usecTime
+	int frameAfter(qint64 usecTime) const;
+	/// @return start of the frame boundary closest to @p usecTime or @p usecTime if index is empty
+	qint64 snapToFrame(qint64 usecTime) const;
+	bool isKeyframe(qint64 frameTime) const;
+	/// @return last keyframe at or before @p usecTime or -1 if there's none
+	qint64 keyframeBefore(qint64 usecTime) const;
+
+	bool load(const QString &indexFile, const QString &mediaFile);
+	bool save(const QString &indexFile, const QString &mediaFile) const;
+	/// @return path of cached index of @p mediaFile
+	static QString cacheFile(const QString &mediaFile);
+
+private:
+	QVector<qint64> m_frames;
+	QVector<qint64> m_keyframes;
+};
+}
+
+#endif // FRAMEINDEX_H
@@ -105,6 +105,22 @@ GStreamer::setElementState(GstElement *element, int state, unsigned timeout)
 		return GST_STATE_CHANGE_SUCCESS;
 }
 
+GstClockTime
+GStreamer::streamTime(GstPad *pad, GstClockTime time)
+{
+	// players report stream time, it starts at zero even if container timestamps don't
+	GstEvent *event = gst_pad_get_sticky_event(pad, GST_EVENT_SEGMENT, 0);
+	if(!event)
+		return time;
+
+	const GstSegment *segment;
+	gst_event_parse_segment(event, &segment);
+	if(segment->format == GST_FORMAT_TIME)
+		time = gst_segment_to_stream_time(segment, GST_FORMAT_TIME, time);
+	gst_event_unref(event);
+	return time;
+}
+
 static int
 intValue(const GValue *gvalue, bool maximum, const QList<int> suggested)
 {
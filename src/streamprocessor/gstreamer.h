@@ -27,10 +27,50 @@
 
 #include <gst/gst.h>
 
+#ifndef __GST_PLAY_ENUM_H__
+/**
+ * GstPlayFlags:
+ * @GST_PLAY_FLAG_VIDEO: Enable rendering of the video stream
+ * @GST_PLAY_FLAG_AUDIO: Enable rendering of the audio stream
+ * @GST_PLAY_FLAG_TEXT: Enable rendering of subtitles
+ * @GST_PLAY_FLAG_VIS: Enable rendering of visualisations when there is
+ *       no video stream.
+ * @GST_PLAY_FLAG_SOFT_VOLUME: Use software volume
+ * @GST_PLAY_FLAG_NATIVE_AUDIO: only allow native audio formats, this omits
+ *   configuration of audioconvert and audioresample.
+ * @GST_PLAY_FLAG_NATIVE_VIDEO: only allow native video formats, this omits
+ *   configuration of videoconvert and videoscale.
+ * @GST_PLAY_FLAG_DOWNLOAD: enable progressice download buffering for selected
+ *   formats.
+ * @GST_PLAY_FLAG_BUFFERING: enable buffering of the demuxed or parsed data.
+ * @GST_PLAY_FLAG_DEINTERLACE: deinterlace raw video (if native not forced).
+ * @GST_PLAY_FLAG_FORCE_FILTERS: force audio/video filters to be applied if
+ *   set.
+ *
+ * Extra flags to configure the behaviour of the sinks.
+ */
+typedef enum {
+  GST_PLAY_FLAG_VIDEO         = (1 << 0),
+  GST_PLAY_FLAG_AUDIO         = (1 << 1),
+  GST_PLAY_FLAG_TEXT          = (1 << 2),
+  GST_PLAY_FLAG_VIS           = (1 << 3),
+  GST_PLAY_FLAG_SOFT_VOLUME   = (1 << 4),
+  GST_PLAY_FLAG_NATIVE_AUDIO  = (1 << 5),
+  GST_PLAY_FLAG_NATIVE_VIDEO  = (1 << 6),
+  GST_PLAY_FLAG_DOWNLOAD      = (1 << 7),
+  GST_PLAY_FLAG_BUFFERING     = (1 << 8),
+  GST_PLAY_FLAG_DEINTERLACE   = (1 << 9),
+  GST_PLAY_FLAG_SOFT_COLORBALANCE = (1 << 10),
+  GST_PLAY_FLAG_FORCE_FILTERS = (1 << 11),
+} GstPlayFlags;
+#endif /* __GST_PLAY_ENUM_H__ */
+
 namespace SubtitleComposer {
 class GStreamer
 {
+	friend class AudioScrubber;
 	friend class GStreamerPlayerBackend;
+	friend class GStreamerFrameCache;
 	friend class StreamProcessor;
 
 private:
@@ -42,6 +82,9 @@ private:
 
 	static GstStateChangeReturn setElementState(GstElement *element, int state, unsigned timeout = 0);
 
+	/// converts buffer @p time to stream time of segment on @p pad, GST_CLOCK_TIME_NONE if it is outside segment
+	static GstClockTime streamTime(GstPad *pad, GstClockTime time);
+
 	static WaveFormat formatFromAudioCaps(GstCaps *caps);
 	static GstCaps * audioCapsFromFormat(const WaveFormat &format, bool addSampleRate = true);
 	static GstCaps * textCapsFromEncoding(const char *encoding);
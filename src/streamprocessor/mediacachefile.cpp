@@ -0,0 +1,64 @@
+/**
+ * Copyright (C) 2010-2017 Mladen Milinkovic <max@smoothware.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "mediacachefile.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QStandardPaths>
+
+using namespace SubtitleComposer;
+
+/*static*/ QString
+MediaCacheFile::path(const QString &directory, const QString &mediaFile, const QString &extension)
+{
+	const QByteArray hash = QCryptographicHash::hash(QFileInfo(mediaFile).absoluteFilePath().toUtf8(), QCryptographicHash::Sha1);
+	return QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+		+ QLatin1Char('/') + directory + QLatin1Char('/') + QString::fromLatin1(hash.toHex()) + QLatin1Char('.') + extension;
+}
+
+/*static*/ bool
+MediaCacheFile::openForReading(QFile &file, QDataStream &stream, quint32 magic, quint32 version, const QString &mediaFile)
+{
+	if(!file.open(QIODevice::ReadOnly))
+		return false;
+
+	const QFileInfo mediaInfo(mediaFile);
+	stream.setDevice(&file);
+	quint32 fileMagic, fileVersion;
+	qint64 mediaSize, mediaModified;
+	stream >> fileMagic >> fileVersion >> mediaSize >> mediaModified;
+	return stream.status() == QDataStream::Ok && fileMagic == magic && fileVersion == version
+		&& mediaSize == mediaInfo.size() && mediaModified == mediaInfo.lastModified().toMSecsSinceEpoch();
+}
+
+/*static*/ bool
+MediaCacheFile::openForWriting(QFile &file, QDataStream &stream, quint32 magic, quint32 version, const QString &mediaFile)
+{
+	QDir().mkpath(QFileInfo(file).absolutePath());
+	if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+		return false;
+
+	const QFileInfo mediaInfo(mediaFile);
+	stream.setDevice(&file);
+	stream << magic << version << qint64(mediaInfo.size()) << qint64(mediaInfo.lastModified().toMSecsSinceEpoch());
+	return stream.status() == QDataStream::Ok;
+}
@@ -0,0 +1,46 @@
+#ifndef MEDIACACHEFILE_H
+#define MEDIACACHEFILE_H
+/**
+ * Copyright (C) 2010-2017 Mladen Milinkovic <max@smoothware.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <QDataStream>
+#include <QFile>
+#include <QString>
+
+namespace SubtitleComposer {
+/**
+ * @brief Data derived from a media file, kept in user cache between sessions.
+ *
+ * Header of the file identifies format of the data and size and modification time
+ * of the media file, data of modified media is stale.
+ */
+class MediaCacheFile
+{
+public:
+	/// @return path of the file in @p directory of user cache, named by hash of absolute path of @p mediaFile
+	static QString path(const QString &directory, const QString &mediaFile, const QString &extension);
+
+	/// opens @p file and reads the header, fails if it doesn't match @p magic, @p version or @p mediaFile
+	static bool openForReading(QFile &file, QDataStream &stream, quint32 magic, quint32 version, const QString &mediaFile);
+	/// creates @p file with its directory and writes the header
+	static bool openForWriting(QFile &file, QDataStream &stream, quint32 magic, quint32 version, const QString &mediaFile);
+};
+}
+
+#endif // MEDIACACHEFILE_H
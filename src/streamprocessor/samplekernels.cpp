@@ -0,0 +1,463 @@
+/**
+ * Copyright (C) 2010-2017 Mladen Milinkovic <max@smoothware.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "samplekernels.h"
+
+#include <cmath>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SAMPLEKERNELS_X86
+#include <immintrin.h>
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+using namespace SubtitleComposer;
+
+// Scalar implementation
+
+static void
+minMaxScalar(const qint16 *samples, quint32 count, qint16 *min, qint16 *max)
+{
+	qint16 vMin = 32767;
+	qint16 vMax = -32768;
+	for(const qint16 *end = samples + count; samples != end; samples++) {
+		if(vMin > *samples)
+			vMin = *samples;
+		if(vMax < *samples)
+			vMax = *samples;
+	}
+	*min = vMin;
+	*max = vMax;
+}
+
+static quint64
+sumAbsScalar(const qint16 *samples, quint32 count)
+{
+	quint64 sum = 0;
+	for(const qint16 *end = samples + count; samples != end; samples++)
+		sum += *samples < 0 ? -qint32(*samples) : qint32(*samples);
+	return sum;
+}
+
+static quint64
+sumSquaresScalar(const qint16 *samples, quint32 count)
+{
+	quint64 sum = 0;
+	for(const qint16 *end = samples + count; samples != end; samples++)
+		sum += quint32(qint32(*samples) * qint32(*samples));
+	return sum;
+}
+
+static quint32
+zeroCrossingsScalar(const qint16 *samples, quint32 count)
+{
+	quint32 crossings = 0;
+	for(quint32 i = 1; i < count; i++)
+		crossings += (samples[i - 1] ^ samples[i]) < 0;
+	return crossings;
+}
+
+static quint64
+sumAbsDiffScalar(const quint8 *pixels, const quint8 *other, quint32 count)
+{
+	quint64 sum = 0;
+	for(const quint8 *end = pixels + count; pixels != end; pixels++, other++)
+		sum += *pixels > *other ? *pixels - *other : *other - *pixels;
+	return sum;
+}
+
+#ifdef SAMPLEKERNELS_X86
+
+// SSE2 implementation - 8 samples per iteration
+
+TARGET_SSE2 static void
+minMaxSSE2(const qint16 *samples, quint32 count, qint16 *min, qint16 *max)
+{
+	const quint32 vecCount = count / 8;
+	if(!vecCount)
+		return minMaxScalar(samples, count, min, max);
+
+	__m128i vMin = _mm_set1_epi16(32767);
+	__m128i vMax = _mm_set1_epi16(-32768);
+	for(quint32 i = 0; i < vecCount; i++) {
+		const __m128i val = _mm_loadu_si128(reinterpret_cast<const __m128i *>(samples) + i);
+		vMin = _mm_min_epi16(vMin, val);
+		vMax = _mm_max_epi16(vMax, val);
+	}
+
+	qint16 lanesMin[8];
+	qint16 lanesMax[8];
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(lanesMin), vMin);
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(lanesMax), vMax);
+	minMaxScalar(samples + vecCount * 8, count - vecCount * 8, min, max);
+	for(int i = 0; i < 8; i++) {
+		if(*min > lanesMin[i])
+			*min = lanesMin[i];
+		if(*max < lanesMax[i])
+			*max = lanesMax[i];
+	}
+}
+
+TARGET_SSE2 static quint64
+sumAbsSSE2(const qint16 *samples, quint32 count)
+{
+	const quint32 vecCount = count / 8;
+	const __m128i zero = _mm_setzero_si128();
+	__m128i sum64 = zero;
+	quint32 i = 0;
+	while(i < vecCount) {
+		// 32bit lanes can hold at least 32768 iterations of 2 * 32768 without overflowing
+		const quint32 chunkEnd = qMin(vecCount, i + 32768);
+		__m128i sum32 = zero;
+		for(; i < chunkEnd; i++) {
+			const __m128i val = _mm_loadu_si128(reinterpret_cast<const __m128i *>(samples) + i);
+			const __m128i sign = _mm_srai_epi16(val, 15);
+			// abs(-32768) wraps to 0x8000 which is correct when treated as unsigned
+			const __m128i abs = _mm_sub_epi16(_mm_xor_si128(val, sign), sign);
+			sum32 = _mm_add_epi32(sum32, _mm_unpacklo_epi16(abs, zero));
+			sum32 = _mm_add_epi32(sum32, _mm_unpackhi_epi16(abs, zero));
+		}
+		sum64 = _mm_add_epi64(sum64, _mm_unpacklo_epi32(sum32, zero));
+		sum64 = _mm_add_epi64(sum64, _mm_unpackhi_epi32(sum32, zero));
+	}
+
+	quint64 lanes[2];
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), sum64);
+	return lanes[0] + lanes[1] + sumAbsScalar(samples + vecCount * 8, count - vecCount * 8);
+}
+
+TARGET_SSE2 static quint64
+sumSquaresSSE2(const qint16 *samples, quint32 count)
+{
+	const quint32 vecCount = count / 8;
+	const __m128i zero = _mm_setzero_si128();
+	__m128i sum64 = zero;
+	for(quint32 i = 0; i < vecCount; i++) {
+		const __m128i val = _mm_loadu_si128(reinterpret_cast<const __m128i *>(samples) + i);
+		// pair sums are at most 2^31 which fits when treated as unsigned
+		const __m128i squares = _mm_madd_epi16(val, val);
+		sum64 = _mm_add_epi64(sum64, _mm_unpacklo_epi32(squares, zero));
+		sum64 = _mm_add_epi64(sum64, _mm_unpackhi_epi32(squares, zero));
+	}
+
+	quint64 lanes[2];
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), sum64);
+	return lanes[0] + lanes[1] + sumSquaresScalar(samples + vecCount * 8, count - vecCount * 8);
+}
+
+TARGET_SSE2 static quint32
+zeroCrossingsSSE2(const qint16 *samples, quint32 count)
+{
+	// every vector compares samples[i..i+7] with samples[i+1..i+8]
+	const quint32 vecCount = count > 8 ? (count - 1) / 8 : 0;
+	const __m128i ones = _mm_set1_epi16(1);
+	__m128i sum32 = _mm_setzero_si128();
+	quint32 i = 0;
+	while(i < vecCount) {
+		// 16bit lanes can count up to 32767 crossings
+		const quint32 chunkEnd = qMin(vecCount, i + 32767);
+		__m128i sum16 = _mm_setzero_si128();
+		for(; i < chunkEnd; i++) {
+			const __m128i cur = _mm_loadu_si128(reinterpret_cast<const __m128i *>(samples + i * 8));
+			const __m128i next = _mm_loadu_si128(reinterpret_cast<const __m128i *>(samples + i * 8 + 1));
+			// -1 in lanes where sign differs
+			sum16 = _mm_sub_epi16(sum16, _mm_srai_epi16(_mm_xor_si128(cur, next), 15));
+		}
+		sum32 = _mm_add_epi32(sum32, _mm_madd_epi16(sum16, ones));
+	}
+
+	quint32 lanes[4];
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), sum32);
+	const quint32 done = vecCount * 8;
+	return lanes[0] + lanes[1] + lanes[2] + lanes[3] + (count > done ? zeroCrossingsScalar(samples + done, count - done) : 0);
+}
+
+TARGET_SSE2 static quint64
+sumAbsDiffSSE2(const quint8 *pixels, const quint8 *other, quint32 count)
+{
+	// 16 pixels per iteration, psadbw sums them into two 64bit lanes
+	const quint32 vecCount = count / 16;
+	__m128i sum64 = _mm_setzero_si128();
+	for(quint32 i = 0; i < vecCount; i++) {
+		const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pixels) + i);
+		const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(other) + i);
+		sum64 = _mm_add_epi64(sum64, _mm_sad_epu8(a, b));
+	}
+
+	quint64 lanes[2];
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), sum64);
+	const quint32 done = vecCount * 16;
+	return lanes[0] + lanes[1] + sumAbsDiffScalar(pixels + done, other + done, count - done);
+}
+
+// AVX2 implementation - 16 samples per iteration
+
+TARGET_AVX2 static void
+minMaxAVX2(const qint16 *samples, quint32 count, qint16 *min, qint16 *max)
+{
+	const quint32 vecCount = count / 16;
+	if(!vecCount)
+		return minMaxScalar(samples, count, min, max);
+
+	__m256i vMin = _mm256_set1_epi16(32767);
+	__m256i vMax = _mm256_set1_epi16(-32768);
+	for(quint32 i = 0; i < vecCount; i++) {
+		const __m256i val = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(samples) + i);
+		vMin = _mm256_min_epi16(vMin, val);
+		vMax = _mm256_max_epi16(vMax, val);
+	}
+
+	qint16 lanesMin[16];
+	qint16 lanesMax[16];
+	_mm256_storeu_si256(reinterpret_cast<__m256i *>(lanesMin), vMin);
+	_mm256_storeu_si256(reinterpret_cast<__m256i *>(lanesMax), vMax);
+	minMaxScalar(samples + vecCount * 16, count - vecCount * 16, min, max);
+	for(int i = 0; i < 16; i++) {
+		if(*min > lanesMin[i])
+			*min = lanesMin[i];
+		if(*max < lanesMax[i])
+			*max = lanesMax[i];
+	}
+}
+
+TARGET_AVX2 static quint64
+sumAbsAVX2(const qint16 *samples, quint32 count)
+{
+	const quint32 vecCount = count / 16;
+	const __m256i zero = _mm256_setzero_si256();
+	__m256i sum64 = zero;
+	quint32 i = 0;
+	while(i < vecCount) {
+		const quint32 chunkEnd = qMin(vecCount, i + 32768);
+		__m256i sum32 = zero;
+		for(; i < chunkEnd; i++) {
+			const __m256i val = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(samples) + i);
+			const __m256i abs = _mm256_abs_epi16(val);
+			sum32 = _mm256_add_epi32(sum32, _mm256_unpacklo_epi16(abs, zero));
+			sum32 = _mm256_add_epi32(sum32, _mm256_unpackhi_epi16(abs, zero));
+		}
+		sum64 = _mm256_add_epi64(sum64, _mm256_unpacklo_epi32(sum32, zero));
+		sum64 = _mm256_add_epi64(sum64, _mm256_unpackhi_epi32(sum32, zero));
+	}
+
+	quint64 lanes[4];
+	_mm256_storeu_si256(reinterpret_cast<__m256i *>(lanes), sum64);
+	return lanes[0] + lanes[1] + lanes[2] + lanes[3] + sumAbsScalar(samples + vecCount * 16, count - vecCount * 16);
+}
+
+TARGET_AVX2 static quint64
+sumSquaresAVX2(const qint16 *samples, quint32 count)
+{
+	const quint32 vecCount = count / 16;
+	const __m256i zero = _mm256_setzero_si256();
+	__m256i sum64 = zero;
+	for(quint32 i = 0; i < vecCount; i++) {
+		const __m256i val = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(samples) + i);
+		const __m256i squares = _mm256_madd_epi16(val, val);
+		sum64 = _mm256_add_epi64(sum64, _mm256_unpacklo_epi32(squares, zero));
+		sum64 = _mm256_add_epi64(sum64, _mm256_unpackhi_epi32(squares, zero));
+	}
+
+	quint64 lanes[4];
+	_mm256_storeu_si256(reinterpret_cast<__m256i *>(lanes), sum64);
+	return lanes[0] + lanes[1] + lanes[2] + lanes[3] + sumSquaresScalar(samples + vecCount * 16, count - vecCount * 16);
+}
+
+TARGET_AVX2 static quint32
+zeroCrossingsAVX2(const qint16 *samples, quint32 count)
+{
+	const quint32 vecCount = count > 16 ? (count - 1) / 16 : 0;
+	const __m256i ones = _mm256_set1_epi16(1);
+	__m256i sum32 = _mm256_setzero_si256();
+	quint32 i = 0;
+	while(i < vecCount) {
+		const quint32 chunkEnd = qMin(vecCount, i + 32767);
+		__m256i sum16 = _mm256_setzero_si256();
+		for(; i < chunkEnd; i++) {
+			const __m256i cur = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(samples + i * 16));
+			const __m256i next = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(samples + i * 16 + 1));
+			sum16 = _mm256_sub_epi16(sum16, _mm256_srai_epi16(_mm256_xor_si256(cur, next), 15));
+		}
+		sum32 = _mm256_add_epi32(sum32, _mm256_madd_epi16(sum16, ones));
+	}
+
+	quint32 lanes[8];
+	_mm256_storeu_si256(reinterpret_cast<__m256i *>(lanes), sum32);
+	quint32 crossings = 0;
+	for(int lane = 0; lane < 8; lane++)
+		crossings += lanes[lane];
+	const quint32 done = vecCount * 16;
+	return crossings + (count > done ? zeroCrossingsScalar(samples + done, count - done) : 0);
+}
+
+TARGET_AVX2 static quint64
+sumAbsDiffAVX2(const quint8 *pixels, const quint8 *other, quint32 count)
+{
+	const quint32 vecCount = count / 32;
+	__m256i sum64 = _mm256_setzero_si256();
+	for(quint32 i = 0; i < vecCount; i++) {
+		const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pixels) + i);
+		const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(other) + i);
+		sum64 = _mm256_add_epi64(sum64, _mm256_sad_epu8(a, b));
+	}
+
+	quint64 lanes[4];
+	_mm256_storeu_si256(reinterpret_cast<__m256i *>(lanes), sum64);
+	const quint32 done = vecCount * 32;
+	return lanes[0] + lanes[1] + lanes[2] + lanes[3] + sumAbsDiffScalar(pixels + done, other + done, count - done);
+}
+
+#endif // SAMPLEKERNELS_X86
+
+SampleKernels::Implementation SampleKernels::s_implementation = SampleKernels::Scalar;
+SampleKernels::MinMaxFunc SampleKernels::s_minMax = minMaxScalar;
+SampleKernels::SumFunc SampleKernels::s_sumAbs = sumAbsScalar;
+SampleKernels::SumFunc SampleKernels::s_sumSquares = sumSquaresScalar;
+SampleKernels::CountFunc SampleKernels::s_zeroCrossings = zeroCrossingsScalar;
+SampleKernels::DiffFunc SampleKernels::s_sumAbsDiff = sumAbsDiffScalar;
+// must be defined after the function pointers so they are set when init() runs
+bool SampleKernels::s_initialized = SampleKernels::init();
+
+/*static*/ bool
+SampleKernels::init()
+{
+	for(int impl = ImplementationSIZE - 1; impl > Scalar; impl--) {
+		if(setImplementation(Implementation(impl)))
+			return true;
+	}
+	return setImplementation(Scalar);
+}
+
+/*static*/ bool
+SampleKernels::isSupported(Implementation implementation)
+{
+	switch(implementation) {
+	case Scalar:
+		return true;
+#ifdef SAMPLEKERNELS_X86
+	case SSE2:
+		return __builtin_cpu_supports("sse2");
+	case AVX2:
+		return __builtin_cpu_supports("avx2");
+#endif
+	default:
+		return false;
+	}
+}
+
+/*static*/ SampleKernels::Implementation
+SampleKernels::implementation()
+{
+	return s_implementation;
+}
+
+/*static*/ bool
+SampleKernels::setImplementation(Implementation implementation)
+{
+	if(!isSupported(implementation))
+		return false;
+
+	switch(implementation) {
+#ifdef SAMPLEKERNELS_X86
+	case SSE2:
+		s_minMax = minMaxSSE2;
+		s_sumAbs = sumAbsSSE2;
+		s_sumSquares = sumSquaresSSE2;
+		s_zeroCrossings = zeroCrossingsSSE2;
+		s_sumAbsDiff = sumAbsDiffSSE2;
+		break;
+	case AVX2:
+		s_minMax = minMaxAVX2;
+		s_sumAbs = sumAbsAVX2;
+		s_sumSquares = sumSquaresAVX2;
+		s_zeroCrossings = zeroCrossingsAVX2;
+		s_sumAbsDiff = sumAbsDiffAVX2;
+		break;
+#endif
+	default:
+		s_minMax = minMaxScalar;
+		s_sumAbs = sumAbsScalar;
+		s_sumSquares = sumSquaresScalar;
+		s_zeroCrossings = zeroCrossingsScalar;
+		s_sumAbsDiff = sumAbsDiffScalar;
+		break;
+	}
+	s_implementation = implementation;
+	return true;
+}
+
+/*static*/ const char *
+SampleKernels::implementationName(Implementation implementation)
+{
+	switch(implementation) {
+	case SSE2:
+		return "SSE2";
+	case AVX2:
+		return "AVX2";
+	default:
+		return "Scalar";
+	}
+}
+
+/*static*/ void
+SampleKernels::minMax(const qint16 *samples, quint32 count, qint16 *min, qint16 *max)
+{
+	s_minMax(samples, count, min, max);
+}
+
+/*static*/ quint64
+SampleKernels::sumAbs(const qint16 *samples, quint32 count)
+{
+	return s_sumAbs(samples, count);
+}
+
+/*static*/ quint64
+SampleKernels::sumSquares(const qint16 *samples, quint32 count)
+{
+	return s_sumSquares(samples, count);
+}
+
+/*static*/ quint32
+SampleKernels::zeroCrossings(const qint16 *samples, quint32 count)
+{
+	return s_zeroCrossings(samples, count);
+}
+
+/*static*/ quint64
+SampleKernels::sumAbsDiff(const quint8 *pixels, const quint8 *other, quint32 count)
+{
+	return s_sumAbsDiff(pixels, other, count);
+}
+
+/*static*/ qint32
+SampleKernels::mean(const qint16 *samples, quint32 count)
+{
+	if(!count)
+		return 0;
+	return s_sumAbs(samples, count) / count;
+}
+
+/*static*/ qint32
+SampleKernels::rms(const qint16 *samples, quint32 count)
+{
+	if(!count)
+		return 0;
+	return std::sqrt(double(s_sumSquares(samples, count)) / count);
+}
@@ -0,0 +1,78 @@
+#ifndef SAMPLEKERNELS_H
+#define SAMPLEKERNELS_H
+/**
+ * Copyright (C) 2010-2017 Mladen Milinkovic <max@smoothware.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <QtGlobal>
+
+namespace SubtitleComposer {
+/**
+ * @brief Reduction kernels over blocks of signed 16bit samples and 8bit pixels.
+ *
+ * Best implementation supported by the CPU (AVX2, SSE2 or plain C) is selected
+ * on first use, setImplementation() can be used to override it.
+ */
+class SampleKernels
+{
+public:
+	typedef enum {
+		Scalar = 0,
+		SSE2,
+		AVX2,
+		ImplementationSIZE
+	} Implementation;
+
+	static void minMax(const qint16 *samples, quint32 count, qint16 *min, qint16 *max);
+	static quint64 sumAbs(const qint16 *samples, quint32 count);
+	static quint64 sumSquares(const qint16 *samples, quint32 count);
+	/// number of sign changes between neighbouring samples
+	static quint32 zeroCrossings(const qint16 *samples, quint32 count);
+	/// sum of absolute differences between two blocks of grayscale pixels
+	static quint64 sumAbsDiff(const quint8 *pixels, const quint8 *other, quint32 count);
+
+	/// average absolute amplitude
+	static qint32 mean(const qint16 *samples, quint32 count);
+	/// root mean square amplitude
+	static qint32 rms(const qint16 *samples, quint32 count);
+
+	static bool isSupported(Implementation implementation);
+	static Implementation implementation();
+	static bool setImplementation(Implementation implementation);
+	static const char * implementationName(Implementation implementation);
+
+private:
+	static bool init();
+
+private:
+	typedef void (*MinMaxFunc)(const qint16 *, quint32, qint16 *, qint16 *);
+	typedef quint64 (*SumFunc)(const qint16 *, quint32);
+	typedef quint32 (*CountFunc)(const qint16 *, quint32);
+	typedef quint64 (*DiffFunc)(const quint8 *, const quint8 *, quint32);
+
+	static bool s_initialized;
+	static Implementation s_implementation;
+	static MinMaxFunc s_minMax;
+	static SumFunc s_sumAbs;
+	static SumFunc s_sumSquares;
+	static CountFunc s_zeroCrossings;
+	static DiffFunc s_sumAbsDiff;
+};
+}
+
+#endif // SAMPLEKERNELS_H
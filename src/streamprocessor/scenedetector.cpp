@@ -0,0 +1,224 @@
+/**
+ * Copyright (C) 2010-2017 Mladen Milinkovic <max@smoothware.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "scenedetector.h"
+#include "mediacachefile.h"
+#include "samplekernels.h"
+
+#include <algorithm>
+#include <cstring>
+
+// luma histogram bins, coarse enough to ignore noise and compression artifacts
+#define HISTOGRAM_BINS 64
+// number of previous frames whose motion is the reference for next frame
+#define MOTION_WINDOW 8
+// fraction of histogram that has to change at a cut
+#define HISTOGRAM_THRESHOLD .3
+// pixel difference at a cut has to exceed the minimum and multiple of recent motion
+#define PIXEL_THRESHOLD 20.
+#define MOTION_RATIO 3.
+// shots shorter than this number of frames are flashes or glitches
+#define MIN_SHOT_FRAMES 6
+// histogram difference to the frame before a cut under which the cut was a flash
+#define FLASH_THRESHOLD .15
+
+// identifies cut list files, version has to be bumped whenever the format changes
+#define CUTS_MAGIC 0x53435343
+#define CUTS_VERSION 1
+
+using namespace SubtitleComposer;
+
+SceneDetector::SceneDetector()
+	: m_recentIndex(0),
+	  m_framesSinceCut(0),
+	  m_pendingCut(-1)
+{
+}
+
+void
+SceneDetector::clear()
+{
+	m_cuts.clear();
+	m_prevFrame.clear();
+	m_prevHistogram.clear();
+	m_preCutHistogram.clear();
+	m_recentDifferences.clear();
+	m_recentIndex = 0;
+	m_framesSinceCut = 0;
+	m_pendingCut = -1;
+}
+
+bool
+SceneDetector::addFrame(const quint8 *pixels, int width, int height, qint64 usecTime)
+{
+	const int count = width * height;
+	if(count <= 0)
+		return false;
+
+	const QVector<quint32> frameHistogram = histogram(pixels, count);
+
+	bool candidate = false;
+	// frames of different size are not comparable
+	if(m_prevFrame.size() == count) {
+		const double pixelDiff = pixelDifference(pixels, m_prevFrame.constData(), count);
+		const double histogramDiff = histogramDifference(frameHistogram, m_prevHistogram);
+
+		double motion = 0.;
+		for(double diff : m_recentDifferences)
+			motion += diff;
+		if(!m_recentDifferences.isEmpty())
+			motion /= m_recentDifferences.size();
+
+		candidate = m_pendingCut < 0
+			&& m_framesSinceCut >= MIN_SHOT_FRAMES
+			&& histogramDiff > HISTOGRAM_THRESHOLD
+			&& pixelDiff > PIXEL_THRESHOLD
+			&& pixelDiff > motion * MOTION_RATIO;
+
+		if(m_recentDifferences.size() < MOTION_WINDOW)
+			m_recentDifferences.append(pixelDiff);
+		else
+			m_recentDifferences[m_recentIndex] = pixelDiff;
+		m_recentIndex = (m_recentIndex + 1) % MOTION_WINDOW;
+	}
+
+	bool confirmed = false;
+	if(candidate) {
+		m_pendingCut = usecTime;
+		m_preCutHistogram = m_prevHistogram;
+		m_framesSinceCut = 0;
+		// motion of the previous shot says nothing about the new one
+		m_recentDifferences.clear();
+		m_recentIndex = 0;
+	} else {
+		m_framesSinceCut++;
+		if(m_pendingCut >= 0) {
+			if(histogramDifference(frameHistogram, m_preCutHistogram) < FLASH_THRESHOLD) {
+				// picture went back to the previous shot
+				m_pendingCut = -1;
+			} else if(m_framesSinceCut >= MIN_SHOT_FRAMES) {
+				m_cuts.append(m_pendingCut);
+				m_pendingCut = -1;
+				confirmed = true;
+			}
+		}
+	}
+
+	m_prevFrame.resize(count);
+	std::memcpy(m_prevFrame.data(), pixels, count);
+	m_prevHistogram = frameHistogram;
+
+	return confirmed;
+}
+
+void
+SceneDetector::finalize()
+{
+	if(m_pendingCut >= 0) {
+		m_cuts.append(m_pendingCut);
+		m_pendingCut = -1;
+	}
+	m_prevFrame.clear();
+	m_prevHistogram.clear();
+	m_preCutHistogram.clear();
+	m_recentDifferences.clear();
+	m_cuts.squeeze();
+}
+
+qint64
+SceneDetector::nearestCut(qint64 usecTime, qint64 maxDistance) const
+{
+	auto it = std::lower_bound(m_cuts.cbegin(), m_cuts.cend(), usecTime);
+	qint64 best = -1;
+	qint64 bestDistance = maxDistance + 1;
+	if(it != m_cuts.cend() && *it - usecTime < bestDistance) {
+		best = *it;
+		bestDistance = *it - usecTime;
+	}
+	if(it != m_cuts.cbegin() && usecTime - *(it - 1) < bestDistance)
+		best = *(it - 1);
+	return best;
+}
+
+bool
+SceneDetector::load(const QString &cutsFile, const QString &mediaFile)
+{
+	clear();
+
+	QFile file(cutsFile);
+	QDataStream stream;
+	// stale cut list of modified file is rebuilt
+	if(!MediaCacheFile::openForReading(file, stream, CUTS_MAGIC, CUTS_VERSION, mediaFile))
+		return false;
+
+	stream >> m_cuts;
+	if(stream.status() != QDataStream::Ok) {
+		clear();
+		return false;
+	}
+	return true;
+}
+
+bool
+SceneDetector::save(const QString &cutsFile, const QString &mediaFile) const
+{
+	QFile file(cutsFile);
+	QDataStream stream;
+	if(!MediaCacheFile::openForWriting(file, stream, CUTS_MAGIC, CUTS_VERSION, mediaFile))
+		return false;
+
+	stream << m_cuts;
+	return stream.status() == QDataStream::Ok;
+}
+
+/*static*/ QString
+SceneDetector::cacheFile(const QString &mediaFile)
+{
+	return MediaCacheFile::path(QStringLiteral("scenecuts"), mediaFile, QStringLiteral("cuts"));
+}
+
+/*static*/ double
+SceneDetector::pixelDifference(const quint8 *pixels, const quint8 *other, int count)
+{
+	if(count <= 0)
+		return 0.;
+	return double(SampleKernels::sumAbsDiff(pixels, other, count)) / count;
+}
+
+/*static*/ double
+SceneDetector::histogramDifference(const QVector<quint32> &histogram, const QVector<quint32> &other)
+{
+	quint64 total = 0;
+	quint64 diff = 0;
+	for(int i = 0, n = qMin(histogram.size(), other.size()); i < n; i++) {
+		total += histogram.at(i) + other.at(i);
+		diff += histogram.at(i) > other.at(i) ? histogram.at(i) - other.at(i) : other.at(i) - histogram.at(i);
+	}
+	return total ? double(diff) / total : 0.;
+}
+
+/*static*/ QVector<quint32>
+SceneDetector::histogram(const quint8 *pixels, int count)
+{
+	QVector<quint32> bins(HISTOGRAM_BINS, 0);
+	quint32 *data = bins.data();
+	for(const quint8 *end = pixels + count; pixels != end; pixels++)
+		data[*pixels * HISTOGRAM_BINS / 256]++;
+	return bins;
+}
@@ -0,0 +1,80 @@
+#ifndef SCENEDETECTOR_H
+#define SCENEDETECTOR_H
+/**
+ * Copyright (C) 2010-2017 Mladen Milinkovic <max@smoothware.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <QString>
+#include <QVector>
+
+namespace SubtitleComposer {
+/**
+ * @brief Finds shot changes in a sequence of small grayscale video frames.
+ *
+ * Every frame is compared to the previous one using mean absolute pixel difference
+ * and luma histogram difference. A cut is detected when histogram changes
+ * considerably and pixel difference stands out against recent motion, so camera
+ * pans are not mistaken for shot changes. Cut is confirmed only after the new shot
+ * lasted a few frames, so flashes are ignored. All times are in microseconds.
+ */
+class SceneDetector
+{
+public:
+	SceneDetector();
+
+	void clear();
+
+	/**
+	 * @brief Analyzes next frame, frames have to be added in presentation order
+	 * @return true if a cut a few frames back was confirmed
+	 */
+	bool addFrame(const quint8 *pixels, int width, int height, qint64 usecTime);
+	/// confirms cut near the end of the stream, must be called after last addFrame()
+	void finalize();
+
+	inline bool isEmpty() const { return m_cuts.isEmpty(); }
+	/// presentation times of first frames of new shots
+	inline const QVector<qint64> & cuts() const { return m_cuts; }
+	/// @return cut closest to @p usecTime or -1 if there's none within @p maxDistance
+	qint64 nearestCut(qint64 usecTime, qint64 maxDistance) const;
+
+	bool load(const QString &cutsFile, const QString &mediaFile);
+	bool save(const QString &cutsFile, const QString &mediaFile) const;
+	/// @return path of cached cut list of @p mediaFile
+	static QString cacheFile(const QString &mediaFile);
+
+	/// @return mean absolute difference of two frames, from 0 to 255
+	static double pixelDifference(const quint8 *pixels, const quint8 *other, int count);
+	/// @return difference of two luma histograms, from 0 (same) to 1 (disjoint)
+	static double histogramDifference(const QVector<quint32> &histogram, const QVector<quint32> &other);
+	static QVector<quint32> histogram(const quint8 *pixels, int count);
+
+private:
+	QVector<qint64> m_cuts;
+
+	QVector<quint8> m_prevFrame;
+	QVector<quint32> m_prevHistogram;
+	QVector<quint32> m_preCutHistogram;     // last frame before pending cut
+	QVector<double> m_recentDifferences;    // pixel differences of last frames
+	int m_recentIndex;
+	int m_framesSinceCut;
+	qint64 m_pendingCut;
+};
+}
+
+#endif // SCENEDETECTOR_H
@@ -30,23 +30,29 @@ using namespace SubtitleComposer;
 
 StreamProcessor::StreamProcessor(QObject *parent)
 	: QObject(parent),
+	  m_gstInited(false),
 	  m_opened(false),
 	  m_audioReady(false),
 	  m_textReady(false),
+	  m_videoReady(false),
+	  m_videoDecoded(false),
+	  m_videoFrameWidth(0),
+	  m_videoFrameHeight(0),
+	  m_videoFrameBytes(1),
+	  m_videoFrameInterval(0),
 	  m_decodingPipeline(NULL),
 	  m_decodingBus(NULL),
 	  m_decodingTimer(new QTimer(this))
 {
 	connect(m_decodingTimer, &QTimer::timeout, this, &StreamProcessor::decoderMessageProc);
-
-	GStreamer::init();
 }
 
 StreamProcessor::~StreamProcessor()
 {
 	close();
 
-	GStreamer::deinit();
+	if(m_gstInited)
+		GStreamer::deinit();
 }
 
 bool
@@ -55,9 +61,14 @@ StreamProcessor::open(const QString &filename)
 	if(m_opened)
 		close();
 
+	// processors are created with their widgets, GStreamer is initialized only once something is decoded
+	if(!m_gstInited && !(m_gstInited = GStreamer::init()))
+		return false;
+
 	m_filename = filename;
 	m_audioStreamIndex = -1;
 	m_textStreamIndex = -1;
+	m_videoStreamIndex = -1;
 	m_streamLen = m_streamPos = 0;
 
 	m_decodingPipeline = GST_PIPELINE(gst_pipeline_new("streamprocessor_pipeline"));
@@ -105,6 +116,10 @@ StreamProcessor::close()
 	m_opened = false;
 	m_audioReady = false;
 	m_textReady = false;
+	m_videoReady = false;
+	m_videoDecoded = false;
+	m_videoFrameBytes = 1;
+	m_videoFrameInterval = 0;
 }
 
 bool
@@ -176,10 +191,114 @@ StreamProcessor::initText(const int streamIndex)
 	return m_textReady;
 }
 
+bool
+StreamProcessor::initVideo(const int streamIndex)
+{
+	if(!m_opened)
+		return false;
+
+	m_videoStreamCurrent = -1;
+	m_videoStreamIndex = streamIndex;
+	m_videoDecoded = false;
+	m_videoReady = false;
+
+	GstElement *videosink = gst_element_factory_make("fakesink", "videosink");
+
+	if(!videosink)
+		return false;
+
+	// demuxing runs as fast as possible
+	g_object_set(G_OBJECT(videosink), "signal-handoffs", TRUE, "sync", FALSE, NULL);
+	g_signal_connect(videosink, "handoff", G_CALLBACK(onVideoDataReady), this);
+
+	gst_bin_add_many(GST_BIN(m_decodingPipeline), videosink, NULL);
+
+	m_decodingBus = gst_pipeline_get_bus(GST_PIPELINE(m_decodingPipeline));
+	m_videoReady = true;
+
+	return m_videoReady;
+}
+
+bool
+StreamProcessor::initVideoFrames(const int streamIndex, const int width, const int height)
+{
+	// GRAY8 rows are padded to 4 bytes, keep them packed
+	return initVideoDecoding(streamIndex, "GRAY8", 1, width & ~3, height, 0);
+}
+
+bool
+StreamProcessor::initVideoThumbnails(const int streamIndex, const int width, const int height, const qint64 usecInterval)
+{
+	return initVideoDecoding(streamIndex, "BGRx", 4, width, height, usecInterval);
+}
+
+bool
+StreamProcessor::initVideoDecoding(const int streamIndex, const char *format, const int bytesPerPixel, const int width, const int height, const qint64 usecInterval)
+{
+	if(!m_opened)
+		return false;
+
+	m_videoStreamCurrent = -1;
+	m_videoStreamIndex = streamIndex;
+	m_videoDecoded = true;
+	m_videoFrameWidth = qMax(4, width);
+	m_videoFrameHeight = qMax(1, height);
+	m_videoFrameBytes = bytesPerPixel;
+	m_videoFrameInterval = usecInterval;
+	m_videoReady = false;
+
+	// frames are dropped right after decoding so they are never converted or scaled
+	GstElement *videorate = usecInterval > 0 ? gst_element_factory_make("videorate", "videorate") : NULL;
+	GstElement *videoconvert = gst_element_factory_make("videoconvert", "videoconvert");
+	GstElement *videoscale = gst_element_factory_make("videoscale", "videoscale");
+	GstElement *videosink = gst_element_factory_make("fakesink", "videosink");
+
+	if((usecInterval > 0 && !videorate) || !videoconvert || !videoscale || !videosink) {
+		if(videorate)
+			gst_object_unref(GST_OBJECT(videorate));
+		if(videoconvert)
+			gst_object_unref(GST_OBJECT(videoconvert));
+		if(videoscale)
+			gst_object_unref(GST_OBJECT(videoscale));
+		if(videosink)
+			gst_object_unref(GST_OBJECT(videosink));
+		return false;
+	}
+
+	g_object_set(G_OBJECT(videosink), "signal-handoffs", TRUE, "sync", FALSE, NULL);
+	g_signal_connect(videosink, "handoff", G_CALLBACK(onVideoFrameReady), this);
+
+	gst_bin_add_many(GST_BIN(m_decodingPipeline), videoconvert, videoscale, videosink, NULL);
+
+	if(videorate) {
+		g_object_set(G_OBJECT(videorate), "drop-only", TRUE, NULL);
+		gst_bin_add(GST_BIN(m_decodingPipeline), videorate);
+
+		GstCaps *rateFilter = gst_caps_new_simple("video/x-raw",
+				"framerate", GST_TYPE_FRACTION, 1000000, int(qMin(usecInterval, qint64(G_MAXINT))),
+				NULL);
+		if(GST_PAD_LINK_FAILED(GStreamer::link(GST_BIN(m_decodingPipeline), "videorate", "videoconvert", rateFilter)))
+			return false;
+	}
+
+	GstCaps *outputFilter = gst_caps_new_simple("video/x-raw",
+			"format", G_TYPE_STRING, format,
+			"width", G_TYPE_INT, m_videoFrameWidth,
+			"height", G_TYPE_INT, m_videoFrameHeight,
+			NULL);
+	if(gst_element_link(videoconvert, videoscale)
+			&& GST_PAD_LINK_SUCCESSFUL(GStreamer::link(GST_BIN(m_decodingPipeline), "videoscale", "videosink", outputFilter))) {
+		m_decodingBus = gst_pipeline_get_bus(GST_PIPELINE(m_decodingPipeline));
+		m_videoReady = true;
+	}
+
+	return m_videoReady;
+}
+
 bool
 StreamProcessor::start()
 {
-	if(!m_opened || !(m_audioReady || m_textReady))
+	if(!m_opened || !(m_audioReady || m_textReady || m_videoReady))
 		return false;
 
 	// do not start twice
@@ -234,6 +353,36 @@ StreamProcessor::onTextDataReady(GstElement */*fakesrc*/, GstBuffer *buffer, Gst
 	gst_buffer_unmap(buffer, &map);
 }
 
+/*static*/ void
+StreamProcessor::onVideoDataReady(GstElement */*fakesrc*/, GstBuffer *buffer, GstPad *pad, gpointer userData)
+{
+	StreamProcessor *me = reinterpret_cast<StreamProcessor *>(userData);
+
+	// some containers only store decoding timestamps, frames are indexed by same positions player reports
+	const GstClockTime time = GStreamer::streamTime(pad, GST_BUFFER_PTS_IS_VALID(buffer) ? GST_BUFFER_PTS(buffer) : GST_BUFFER_DTS(buffer));
+	if(!GST_CLOCK_TIME_IS_VALID(time))
+		return;
+
+	emit me->videoFrameAvailable(time / GST_USECOND, !GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_DELTA_UNIT));
+}
+
+/*static*/ void
+StreamProcessor::onVideoFrameReady(GstElement */*fakesrc*/, GstBuffer *buffer, GstPad *pad, gpointer userData)
+{
+	StreamProcessor *me = reinterpret_cast<StreamProcessor *>(userData);
+
+	// decoded frames are matched with player positions, same as frame index
+	const GstClockTime time = GStreamer::streamTime(pad, GST_BUFFER_PTS(buffer));
+	if(!GST_CLOCK_TIME_IS_VALID(time))
+		return;
+
+	GstMapInfo map;
+	gst_buffer_map(buffer, &map, GST_MAP_READ);
+	if(map.size >= gsize(me->m_videoFrameWidth * me->m_videoFrameHeight * me->m_videoFrameBytes))
+		emit me->videoFrameDecoded(map.data, me->m_videoFrameWidth, me->m_videoFrameHeight, time / GST_USECOND);
+	gst_buffer_unmap(buffer, &map);
+}
+
 /*static*/ void
 StreamProcessor::onPadAdded(GstElement */*decodebin*/, GstPad *pad, gpointer userData)
 {
@@ -274,6 +423,15 @@ StreamProcessor::onPadAdded(GstElement */*decodebin*/, GstPad *pad, gpointer use
 			}
 			qDebug() << "Selected text stream #" << me->m_audioStreamCurrent << " [" << padName << "] " << gst_caps_to_string(caps);
 		}
+	} else if(strncmp(mimeType, "video/", 6) == 0) {
+		if(++(me->m_videoStreamCurrent) == me->m_videoStreamIndex) {
+			// link decoded stream to videorate/videoconvert or undecoded stream directly to videosink
+			const gchar *padName = gst_pad_get_name(pad);
+			const char *sinkElement = !me->m_videoDecoded ? "videosink" : (me->m_videoFrameInterval > 0 ? "videorate" : "videoconvert");
+			if(GST_PAD_LINK_FAILED(GStreamer::link(GST_BIN(me->m_decodingPipeline), "decodebin", padName, sinkElement, "sink")))
+				qCritical() << "Failed to connect decodebin pad" << padName;
+			qDebug() << "Selected video stream #" << me->m_videoStreamCurrent << " [" << padName << "] " << gst_caps_to_string(caps);
+		}
 	}
 
 	gst_caps_unref(caps);
@@ -310,6 +468,18 @@ StreamProcessor::onPadCheck(GstElement */*decodebin*/, GstPad *pad, GstCaps *cap
 		GStreamer::inspectCaps(caps, QStringLiteral("Probing stream"));
 #endif
 		return TRUE;
+	} else if(strncmp(mimeType, "video/", 6) == 0 && me->m_videoStreamIndex >= 0) {
+		if(me->m_videoDecoded) {
+#if defined(VERBOSE) || !defined(NDEBUG)
+			GStreamer::inspectCaps(caps, QStringLiteral("Probing stream"));
+#endif
+			return TRUE;
+		}
+		// demuxed video is exposed as it is, frame timestamps and keyframe flags are known without decoding
+#if defined(VERBOSE) || !defined(NDEBUG)
+		GStreamer::inspectCaps(caps, QStringLiteral("Indexing stream"));
+#endif
+		return FALSE;
 	}
 
 	// we don't want to decode unused streams as they will unnecessarily hog the cpu/gpu
@@ -42,6 +42,12 @@ public:
 	bool open(const QString &filename);
 	bool initAudio(const int streamIndex, const WaveFormat &waveFormat);
 	bool initText(const int streamIndex);
+	/// video stream is only demuxed, videoFrameAvailable() reports timestamps of its frames
+	bool initVideo(const int streamIndex);
+	/// video stream is decoded and scaled, videoFrameDecoded() delivers grayscale pixels of its frames
+	bool initVideoFrames(const int streamIndex, const int width, const int height);
+	/// video stream is decimated to one frame per @p usecInterval, videoFrameDecoded() delivers its frames as BGRx pixels
+	bool initVideoThumbnails(const int streamIndex, const int width, const int height, const qint64 usecInterval);
 	void close();
 
 	bool start();
@@ -49,6 +55,8 @@ public:
 signals:
 	void audioDataAvailable(const void *buffer, const qint32 size, const WaveFormat *waveFormat, const quint64 msecStart, const quint64 msecDuration);
 	void textDataAvailable(const QString &text, const quint64 msecStart, const quint64 msecDuration);
+	void videoFrameAvailable(const qint64 usecTime, const bool keyframe);
+	void videoFrameDecoded(const quint8 *pixels, const int width, const int height, const qint64 usecTime);
 	void streamProgress(quint64 msecPosition, quint64 msecLength);
 	void streamError(int code, const QString &message, const QString &debug);
 	void streamFinished();
@@ -56,11 +64,15 @@ signals:
 private:
 	static void onAudioDataReady(GstElement *fakesrc, GstBuffer *buffer, GstPad *pad, gpointer userData);
 	static void onTextDataReady(GstElement *fakesrc, GstBuffer *buffer, GstPad *pad, gpointer userData);
+	static void onVideoDataReady(GstElement *fakesrc, GstBuffer *buffer, GstPad *pad, gpointer userData);
+	static void onVideoFrameReady(GstElement *fakesrc, GstBuffer *buffer, GstPad *pad, gpointer userData);
 	static void onPadAdded(GstElement *decodebin, GstPad *pad, gpointer userData);
 	static gboolean onPadCheck(GstElement *decodebin, GstPad *pad, GstCaps *caps, gpointer userData);
 	void decoderMessageProc();
+	bool initVideoDecoding(const int streamIndex, const char *format, const int bytesPerPixel, const int width, const int height, const qint64 usecInterval);
 
 private:
+	bool m_gstInited;
 	bool m_opened;
 	QString m_filename;
 
@@ -73,6 +85,15 @@ private:
 	int m_textStreamIndex;
 	int m_textStreamCurrent;
 
+	bool m_videoReady;
+	int m_videoStreamIndex;
+	int m_videoStreamCurrent;
+	bool m_videoDecoded;
+	int m_videoFrameWidth;
+	int m_videoFrameHeight;
+	int m_videoFrameBytes;
+	qint64 m_videoFrameInterval;
+
 	quint64 m_streamPos;
 	quint64 m_streamLen;
 
@@ -0,0 +1,126 @@
+/**
+ * Copyright (C) 2010-2017 Mladen Milinkovic <max@smoothware.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#include "frameindextest.h"
+
+#include <QTest>                               // krazy:exclude=c++/includes
+#include <QTemporaryDir>
+#include <QTemporaryFile>
+
+using namespace SubtitleComposer;
+
+// 25fps video with keyframe every 12 frames, stored in decoding order with B-frames
+#define FRAME_USEC 40000
+#define GOP_SIZE 12
+#define FRAME_COUNT 120
+
+void
+FrameIndexTest::initTestCase()
+{
+	for(int gop = 0; gop < FRAME_COUNT / GOP_SIZE; gop++) {
+		const int first = gop * GOP_SIZE;
+		m_index.append(qint64(first) * FRAME_USEC, true);
+		// every P frame is stored before the two B frames that precede it
+		for(int i = 3; i < GOP_SIZE + 2; i += 3) {
+			if(first + i < FRAME_COUNT && i < GOP_SIZE)
+				m_index.append(qint64(first + i) * FRAME_USEC, false);
+			m_index.append(qint64(first + i - 2) * FRAME_USEC, false);
+			m_index.append(qint64(first + i - 1) * FRAME_USEC, false);
+		}
+	}
+	// duplicates are dropped
+	m_index.append(0, true);
+	m_index.finalize();
+}
+
+void
+FrameIndexTest::testFinalize()
+{
+	QCOMPARE(m_index.frameCount(), FRAME_COUNT);
+	QCOMPARE(m_index.keyframes().size(), FRAME_COUNT / GOP_SIZE);
+	for(int i = 0; i < FRAME_COUNT; i++)
+		QCOMPARE(m_index.frameTime(i), qint64(i) * FRAME_USEC);
+}
+
+void
+FrameIndexTest::testFrameLookup()
+{
+	QCOMPARE(m_index.frameAt(-1), -1);
+	QCOMPARE(m_index.frameAt(0), 0);
+	QCOMPARE(m_index.frameAt(FRAME_USEC - 1), 0);
+	QCOMPARE(m_index.frameAt(FRAME_USEC), 1);
+	QCOMPARE(m_index.frameAt(qint64(FRAME_COUNT) * FRAME_USEC * 2), FRAME_COUNT - 1);
+
+	QCOMPARE(m_index.frameAfter(0), 0);
+	QCOMPARE(m_index.frameAfter(1), 1);
+	QCOMPARE(m_index.frameAfter(qint64(FRAME_COUNT) * FRAME_USEC), FRAME_COUNT);
+}
+
+void
+FrameIndexTest::testSnapToFrame()
+{
+	QCOMPARE(m_index.snapToFrame(-5000), qint64(0));
+	QCOMPARE(m_index.snapToFrame(19000), qint64(0));
+	QCOMPARE(m_index.snapToFrame(21000), qint64(FRAME_USEC));
+	QCOMPARE(m_index.snapToFrame(10 * FRAME_USEC + 5), qint64(10 * FRAME_USEC));
+	QCOMPARE(m_index.snapToFrame(qint64(FRAME_COUNT) * FRAME_USEC * 2), qint64(FRAME_COUNT - 1) * FRAME_USEC);
+
+	FrameIndex empty;
+	QCOMPARE(empty.snapToFrame(12345), qint64(12345));
+}
+
+void
+FrameIndexTest::testKeyframes()
+{
+	QVERIFY(m_index.isKeyframe(0));
+	QVERIFY(m_index.isKeyframe(GOP_SIZE * FRAME_USEC));
+	QVERIFY(!m_index.isKeyframe(FRAME_USEC));
+
+	QCOMPARE(m_index.keyframeBefore(-1), qint64(-1));
+	QCOMPARE(m_index.keyframeBefore(GOP_SIZE * FRAME_USEC - 1), qint64(0));
+	QCOMPARE(m_index.keyframeBefore(GOP_SIZE * FRAME_USEC), qint64(GOP_SIZE * FRAME_USEC));
+	QCOMPARE(m_index.keyframeBefore(qint64(FRAME_COUNT) * FRAME_USEC), qint64(FRAME_COUNT - GOP_SIZE) * FRAME_USEC);
+}
+
+void
+FrameIndexTest::testCache()
+{
+	QTemporaryFile media;
+	QVERIFY(media.open());
+	media.write("video");
+	media.flush();
+
+	QTemporaryDir dir;
+	const QString indexFile = dir.path() + QStringLiteral("/index/media.idx");
+	QVERIFY(m_index.save(indexFile, media.fileName()));
+
+	FrameIndex loaded;
+	QVERIFY(loaded.load(indexFile, media.fileName()));
+	QCOMPARE(loaded.frames(), m_index.frames());
+	QCOMPARE(loaded.keyframes(), m_index.keyframes());
+
+	// index of modified file is stale
+	media.write("more video");
+	media.flush();
+	QVERIFY(!loaded.load(indexFile, media.fileName()));
+	QVERIFY(loaded.isEmpty());
+}
+
+QTEST_MAIN(FrameIndexTest);
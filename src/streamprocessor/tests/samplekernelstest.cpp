@@ -0,0 +1,166 @@
+/**
+ * Copyright (C) 2010-2017 Mladen Milinkovic <max@smoothware.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "samplekernelstest.h"
+#include "../samplekernels.h"
+
+#include <QTest>                               // krazy:exclude=c++/includes
+
+#include <cmath>
+
+using namespace SubtitleComposer;
+
+// one minute of 8kHz audio, same as WaveformWidget uses
+#define BENCHMARK_SAMPLES (8000 * 60)
+
+void
+SampleKernelsTest::initTestCase()
+{
+	qsrand(1);
+	m_samples.resize(BENCHMARK_SAMPLES);
+	for(int i = 0; i < m_samples.size(); i++)
+		m_samples[i] = qint16((qrand() & 0xffff) - 32768);
+	// make sure the extremes are present
+	m_samples[11] = -32768;
+	m_samples[77] = 32767;
+}
+
+void
+SampleKernelsTest::implementationData()
+{
+	QTest::addColumn<int>("implementation");
+
+	for(int i = 0; i < SampleKernels::ImplementationSIZE; i++) {
+		SampleKernels::Implementation impl = SampleKernels::Implementation(i);
+		if(SampleKernels::isSupported(impl))
+			QTest::newRow(SampleKernels::implementationName(impl)) << i;
+	}
+}
+
+void
+SampleKernelsTest::testKernels_data()
+{
+	implementationData();
+}
+
+void
+SampleKernelsTest::testKernels()
+{
+	QFETCH(int, implementation);
+	QVERIFY(SampleKernels::setImplementation(SampleKernels::Implementation(implementation)));
+
+	// odd sizes exercise the scalar tail of vectorized implementations
+	const quint32 sizes[] = { 1, 7, 15, 16, 17, 33, 1001, BENCHMARK_SAMPLES };
+	for(quint32 size : sizes) {
+		const qint16 *samples = m_samples.constData();
+
+		qint16 expectedMin = 32767;
+		qint16 expectedMax = -32768;
+		quint64 expectedAbs = 0;
+		quint64 expectedSquares = 0;
+		quint32 expectedCrossings = 0;
+		for(quint32 i = 0; i < size; i++) {
+			if(i && (samples[i - 1] < 0) != (samples[i] < 0))
+				expectedCrossings++;
+			expectedMin = qMin(expectedMin, samples[i]);
+			expectedMax = qMax(expectedMax, samples[i]);
+			expectedAbs += qAbs(qint32(samples[i]));
+			expectedSquares += quint64(qint64(samples[i]) * samples[i]);
+		}
+
+		qint16 min;
+		qint16 max;
+		SampleKernels::minMax(samples, size, &min, &max);
+		QCOMPARE(min, expectedMin);
+		QCOMPARE(max, expectedMax);
+		QCOMPARE(SampleKernels::sumAbs(samples, size), expectedAbs);
+		QCOMPARE(SampleKernels::sumSquares(samples, size), expectedSquares);
+		QCOMPARE(SampleKernels::zeroCrossings(samples, size), expectedCrossings);
+		QCOMPARE(SampleKernels::mean(samples, size), qint32(expectedAbs / size));
+		QCOMPARE(SampleKernels::rms(samples, size), qint32(std::sqrt(double(expectedSquares) / size)));
+
+		// sample buffer holds twice as many bytes, compare its halves as pixels
+		const quint8 *pixels = reinterpret_cast<const quint8 *>(samples);
+		const quint8 *other = pixels + size;
+		quint64 expectedDiff = 0;
+		for(quint32 i = 0; i < size; i++)
+			expectedDiff += qAbs(int(pixels[i]) - int(other[i]));
+		QCOMPARE(SampleKernels::sumAbsDiff(pixels, other, size), expectedDiff);
+	}
+
+	// full scale negative samples must not overflow
+	const QVector<qint16> negative(100, -32768);
+	QCOMPARE(SampleKernels::sumAbs(negative.constData(), negative.size()), quint64(100 * 32768));
+	QCOMPARE(SampleKernels::rms(negative.constData(), negative.size()), 32768);
+}
+
+void
+SampleKernelsTest::benchmarkMinMax_data()
+{
+	implementationData();
+}
+
+void
+SampleKernelsTest::benchmarkMinMax()
+{
+	QFETCH(int, implementation);
+	SampleKernels::setImplementation(SampleKernels::Implementation(implementation));
+
+	qint16 min;
+	qint16 max;
+	QBENCHMARK {
+		SampleKernels::minMax(m_samples.constData(), m_samples.size(), &min, &max);
+	}
+}
+
+void
+SampleKernelsTest::benchmarkMean_data()
+{
+	implementationData();
+}
+
+void
+SampleKernelsTest::benchmarkMean()
+{
+	QFETCH(int, implementation);
+	SampleKernels::setImplementation(SampleKernels::Implementation(implementation));
+
+	QBENCHMARK {
+		SampleKernels::mean(m_samples.constData(), m_samples.size());
+	}
+}
+
+void
+SampleKernelsTest::benchmarkRMS_data()
+{
+	implementationData();
+}
+
+void
+SampleKernelsTest::benchmarkRMS()
+{
+	QFETCH(int, implementation);
+	SampleKernels::setImplementation(SampleKernels::Implementation(implementation));
+
+	QBENCHMARK {
+		SampleKernels::rms(m_samples.constData(), m_samples.size());
+	}
+}
+
+QTEST_MAIN(SampleKernelsTest);
@@ -0,0 +1,148 @@
+/**
+ * Copyright (C) 2010-2017 Mladen Milinkovic <max@smoothware.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "scenedetectortest.h"
+#include "../scenedetector.h"
+
+#include <QTest>                               // krazy:exclude=c++/includes
+#include <QTemporaryDir>
+#include <QTemporaryFile>
+
+using namespace SubtitleComposer;
+
+#define FRAME_WIDTH 64
+#define FRAME_HEIGHT 36
+#define FRAME_USEC 40000
+
+/*static*/ QVector<quint8>
+SceneDetectorTest::frame(int shot, int offset)
+{
+	// every shot is a differently oriented gradient, offset moves the camera
+	QVector<quint8> pixels(FRAME_WIDTH * FRAME_HEIGHT);
+	for(int y = 0; y < FRAME_HEIGHT; y++) {
+		for(int x = 0; x < FRAME_WIDTH; x++) {
+			int value;
+			switch(shot % 3) {
+			case 0: value = (x + offset) * 2; break;
+			case 1: value = 255 - (y + offset) * 4; break;
+			default: value = 40 + ((x + y + offset) & 15); break;
+			}
+			pixels[y * FRAME_WIDTH + x] = quint8(qBound(0, value, 255));
+		}
+	}
+	return pixels;
+}
+
+void
+SceneDetectorTest::testDifferences()
+{
+	const QVector<quint8> a(100, 10);
+	const QVector<quint8> b(100, 40);
+	QCOMPARE(SceneDetector::pixelDifference(a.constData(), a.constData(), a.size()), 0.);
+	QCOMPARE(SceneDetector::pixelDifference(a.constData(), b.constData(), a.size()), 30.);
+
+	const QVector<quint32> histA = SceneDetector::histogram(a.constData(), a.size());
+	const QVector<quint32> histB = SceneDetector::histogram(b.constData(), b.size());
+	QCOMPARE(SceneDetector::histogramDifference(histA, histA), 0.);
+	QCOMPARE(SceneDetector::histogramDifference(histA, histB), 1.);
+}
+
+void
+SceneDetectorTest::testCuts()
+{
+	SceneDetector detector;
+	int frameNo = 0;
+	const int shotFrames[] = { 30, 20, 1, 25, 30 };
+	const int shots[] = { 0, 1, 2, 1, 0 };
+	QVector<qint64> expected;
+	for(int i = 0; i < 5; i++) {
+		// single frame flash is not a shot
+		if(i && i != 2 && i != 3)
+			expected.append(qint64(frameNo) * FRAME_USEC);
+		for(int f = 0; f < shotFrames[i]; f++, frameNo++) {
+			const QVector<quint8> pixels = frame(shots[i], f / 4);
+			detector.addFrame(pixels.constData(), FRAME_WIDTH, FRAME_HEIGHT, qint64(frameNo) * FRAME_USEC);
+		}
+	}
+	detector.finalize();
+	QCOMPARE(detector.cuts(), expected);
+
+	detector.clear();
+	QVERIFY(detector.isEmpty());
+}
+
+void
+SceneDetectorTest::testPanIsNotCut()
+{
+	SceneDetector detector;
+	for(int f = 0; f < 100; f++) {
+		const QVector<quint8> pixels = frame(0, f);
+		QVERIFY(!detector.addFrame(pixels.constData(), FRAME_WIDTH, FRAME_HEIGHT, qint64(f) * FRAME_USEC));
+	}
+	detector.finalize();
+	QVERIFY(detector.isEmpty());
+}
+
+void
+SceneDetectorTest::testNearestCut()
+{
+	SceneDetector detector;
+	for(int f = 0; f < 60; f++) {
+		const QVector<quint8> pixels = frame(f < 30 ? 0 : 1, 0);
+		detector.addFrame(pixels.constData(), FRAME_WIDTH, FRAME_HEIGHT, qint64(f) * FRAME_USEC);
+	}
+	detector.finalize();
+	const qint64 cut = 30 * FRAME_USEC;
+	QCOMPARE(detector.cuts().size(), 1);
+	QCOMPARE(detector.nearestCut(cut - 2 * FRAME_USEC, 2 * FRAME_USEC), cut);
+	QCOMPARE(detector.nearestCut(cut + FRAME_USEC, 2 * FRAME_USEC), cut);
+	QCOMPARE(detector.nearestCut(cut - 3 * FRAME_USEC, 2 * FRAME_USEC), qint64(-1));
+}
+
+void
+SceneDetectorTest::testCache()
+{
+	SceneDetector detector;
+	for(int f = 0; f < 60; f++) {
+		const QVector<quint8> pixels = frame(f < 30 ? 0 : 1, 0);
+		detector.addFrame(pixels.constData(), FRAME_WIDTH, FRAME_HEIGHT, qint64(f) * FRAME_USEC);
+	}
+	detector.finalize();
+
+	QTemporaryFile media;
+	QVERIFY(media.open());
+	media.write("video");
+	media.flush();
+
+	QTemporaryDir dir;
+	const QString cutsFile = dir.path() + QStringLiteral("/cuts/media.cuts");
+	QVERIFY(detector.save(cutsFile, media.fileName()));
+
+	SceneDetector loaded;
+	QVERIFY(loaded.load(cutsFile, media.fileName()));
+	QCOMPARE(loaded.cuts(), detector.cuts());
+
+	// cut list of modified file is stale
+	media.write("more video");
+	media.flush();
+	QVERIFY(!loaded.load(cutsFile, media.fileName()));
+	QVERIFY(loaded.isEmpty());
+}
+
+QTEST_MAIN(SceneDetectorTest);
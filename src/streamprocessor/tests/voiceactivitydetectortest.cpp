@@ -0,0 +1,112 @@
+/**
+ * Copyright (C) 2010-2017 Mladen Milinkovic <max@smoothware.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#include "voiceactivitydetectortest.h"
+#include "../voiceactivitydetector.h"
+
+#include <QTest>                               // krazy:exclude=c++/includes
+#include <QSignalSpy>
+
+#include <QtMath>
+
+using namespace SubtitleComposer;
+
+#define TEST_SAMPLE_RATE 8000
+// boundaries are detected with frame precision
+#define TOLERANCE_MS 30
+
+void
+VoiceActivityDetectorTest::appendNoise(int msecs)
+{
+	for(int i = 0, n = msecs * TEST_SAMPLE_RATE / 1000; i < n; i++)
+		m_samples.append(qint16(qrand() % 201 - 100));
+}
+
+void
+VoiceActivityDetectorTest::appendTone(int msecs)
+{
+	for(int i = 0, n = msecs * TEST_SAMPLE_RATE / 1000; i < n; i++) {
+		const double phase = 2. * M_PI * 200. * m_samples.size() / TEST_SAMPLE_RATE;
+		m_samples.append(qint16(8000. * qSin(phase) + qrand() % 201 - 100));
+	}
+}
+
+void
+VoiceActivityDetectorTest::initTestCase()
+{
+	qsrand(1);
+	appendNoise(1000);
+	appendTone(1000);
+	appendNoise(500);
+	// click that should be ignored
+	appendTone(50);
+	appendNoise(950);
+	// short pause that shouldn't split the segment
+	appendTone(500);
+	appendNoise(100);
+	appendTone(400);
+	appendNoise(1500);
+}
+
+void
+VoiceActivityDetectorTest::testDetect()
+{
+	const qint16 *channels[] = { m_samples.constData(), m_samples.constData() };
+	const QVector<VoiceActivityDetector::Segment> segments = VoiceActivityDetector::detect(channels, 2, m_samples.size(), TEST_SAMPLE_RATE);
+
+	QCOMPARE(segments.size(), 2);
+	QVERIFY(qAbs(segments.at(0).start - 1000) <= TOLERANCE_MS);
+	QVERIFY(qAbs(segments.at(0).end - 2000) <= TOLERANCE_MS);
+	QVERIFY(qAbs(segments.at(1).start - 3500) <= TOLERANCE_MS);
+	QVERIFY(qAbs(segments.at(1).end - 4500) <= TOLERANCE_MS);
+}
+
+void
+VoiceActivityDetectorTest::testSilence()
+{
+	const QVector<qint16> silence(TEST_SAMPLE_RATE * 5, 0);
+	const qint16 *channels[] = { silence.constData() };
+	QVERIFY(VoiceActivityDetector::detect(channels, 1, silence.size(), TEST_SAMPLE_RATE).isEmpty());
+}
+
+void
+VoiceActivityDetectorTest::testNearestBoundary()
+{
+	const qint16 *channels[] = { m_samples.constData() };
+	VoiceActivityDetector detector;
+	QSignalSpy spy(&detector, SIGNAL(finished()));
+	detector.analyze(channels, 1, m_samples.size(), TEST_SAMPLE_RATE);
+	QVERIFY(spy.wait());
+	QVERIFY(detector.isReady());
+
+	const QVector<VoiceActivityDetector::Segment> &segments = detector.segments();
+	QCOMPARE(segments.size(), 2);
+	QCOMPARE(detector.nearestSpeechStart(1100, 500), segments.at(0).start);
+	QCOMPARE(detector.nearestSpeechStart(3300, 500), segments.at(1).start);
+	QCOMPARE(detector.nearestSpeechStart(2900, 500), -1);
+	QCOMPARE(detector.nearestSpeechEnd(4300, 300), segments.at(1).end);
+	QCOMPARE(detector.nearestSpeechEnd(2400, 300), -1);
+
+	detector.clear();
+	QVERIFY(!detector.isReady());
+	QCOMPARE(detector.nearestSpeechStart(1000, 500), -1);
+}
+
+QTEST_MAIN(VoiceActivityDetectorTest);
@@ -0,0 +1,252 @@
+/**
+ * Copyright (C) 2010-2017 Mladen Milinkovic <max@smoothware.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "voiceactivitydetector.h"
+#include "samplekernels.h"
+
+#include <QMutexLocker>
+#include <QRunnable>
+
+#include <algorithm>
+#include <cmath>
+
+// length of analysis frame
+#define VAD_FRAME_MS 10
+// frames quieter than this above the noise floor can't start speech
+#define VAD_ON_DB 9.f
+// frames quieter than this above the noise floor end speech
+#define VAD_OFF_DB 6.f
+// audio with smaller difference between noise floor and loud parts is considered silent
+#define VAD_MIN_DYNAMIC_RANGE_DB 6.f
+// zero crossings per sample above which quiet frames are treated as unvoiced consonants
+#define VAD_FRICATIVE_ZCR .25f
+// how far before voiced onset unvoiced consonants are searched for
+#define VAD_ONSET_MS 150
+// silence needed after speech before the segment is closed
+#define VAD_HANGOVER_MS 80
+// pauses shorter than this don't split segments
+#define VAD_MIN_PAUSE_MS 200
+// segments shorter than this are dropped as clicks and noise
+#define VAD_MIN_SPEECH_MS 100
+
+using namespace SubtitleComposer;
+
+namespace {
+qint32
+nearestBoundary(const QVector<VoiceActivityDetector::Segment> &segments, qint32 VoiceActivityDetector::Segment::*boundary, qint32 msecs, qint32 maxDistance)
+{
+	// segments don't overlap so both starts and ends are sorted
+	auto it = std::lower_bound(segments.cbegin(), segments.cend(), msecs,
+		[boundary](const VoiceActivityDetector::Segment &segment, qint32 time) { return segment.*boundary < time; });
+
+	qint32 best = -1;
+	qint32 bestDistance = maxDistance;
+	if(it != segments.cend() && (*it).*boundary - msecs <= bestDistance) {
+		best = (*it).*boundary;
+		bestDistance = best - msecs;
+	}
+	if(it != segments.cbegin()) {
+		--it;
+		if(msecs - (*it).*boundary <= bestDistance)
+			best = (*it).*boundary;
+	}
+	return best;
+}
+}
+
+class VoiceActivityDetector::DetectJob : public QRunnable
+{
+public:
+	DetectJob(VoiceActivityDetector *detector, int generation, const qint16 * const *channels, quint32 channelCount, quint32 sampleCount, quint32 sampleRate)
+		: m_detector(detector),
+		  m_generation(generation),
+		  m_channels(channels),
+		  m_channelCount(channelCount),
+		  m_sampleCount(sampleCount),
+		  m_sampleRate(sampleRate)
+	{
+	}
+
+	void run() Q_DECL_OVERRIDE
+	{
+		const QVector<Segment> segments = detect(m_channels, m_channelCount, m_sampleCount, m_sampleRate);
+		{
+			QMutexLocker locker(&m_detector->m_resultMutex);
+			m_detector->m_result = segments;
+		}
+		QMetaObject::invokeMethod(m_detector, "onDetectionFinished", Qt::QueuedConnection, Q_ARG(int, m_generation));
+	}
+
+private:
+	VoiceActivityDetector *m_detector;
+	int m_generation;
+	const qint16 * const *m_channels;
+	quint32 m_channelCount;
+	quint32 m_sampleCount;
+	quint32 m_sampleRate;
+};
+
+VoiceActivityDetector::VoiceActivityDetector(QObject *parent)
+	: QObject(parent),
+	  m_generation(0),
+	  m_ready(false)
+{
+	m_threadPool.setMaxThreadCount(1);
+}
+
+VoiceActivityDetector::~VoiceActivityDetector()
+{
+	clear();
+}
+
+void
+VoiceActivityDetector::analyze(const qint16 * const *channels, quint32 channelCount, quint32 sampleCount, quint32 sampleRate)
+{
+	clear();
+
+	DetectJob *job = new DetectJob(this, m_generation, channels, channelCount, sampleCount, sampleRate);
+	job->setAutoDelete(true);
+	m_threadPool.start(job);
+}
+
+void
+VoiceActivityDetector::clear()
+{
+	// result of job that is still running will be ignored
+	m_generation++;
+	m_threadPool.clear();
+	m_threadPool.waitForDone();
+
+	m_ready = false;
+	m_segments.clear();
+}
+
+void
+VoiceActivityDetector::onDetectionFinished(int generation)
+{
+	if(generation != m_generation)
+		return;
+
+	{
+		QMutexLocker locker(&m_resultMutex);
+		m_segments.swap(m_result);
+		m_result.clear();
+	}
+	m_ready = true;
+
+	emit finished();
+}
+
+qint32
+VoiceActivityDetector::nearestSpeechStart(qint32 msecs, qint32 maxDistance) const
+{
+	return nearestBoundary(m_segments, &Segment::start, msecs, maxDistance);
+}
+
+qint32
+VoiceActivityDetector::nearestSpeechEnd(qint32 msecs, qint32 maxDistance) const
+{
+	return nearestBoundary(m_segments, &Segment::end, msecs, maxDistance);
+}
+
+/*static*/ QVector<VoiceActivityDetector::Segment>
+VoiceActivityDetector::detect(const qint16 * const *channels, quint32 channelCount, quint32 sampleCount, quint32 sampleRate)
+{
+	QVector<Segment> segments;
+
+	const quint32 frameSize = sampleRate * VAD_FRAME_MS / 1000;
+	if(!channelCount || !frameSize || sampleCount < frameSize)
+		return segments;
+	const quint32 frameCount = sampleCount / frameSize;
+
+	// per frame energy in dB and zero crossing rate of mono downmix
+	QVector<float> energy(frameCount);
+	QVector<float> zcr(frameCount);
+	QVector<qint16> mono(channelCount > 1 ? frameSize : 0);
+	for(quint32 frame = 0; frame < frameCount; frame++) {
+		const quint32 offset = frame * frameSize;
+		const qint16 *samples = channels[0] + offset;
+		if(channelCount > 1) {
+			for(quint32 i = 0; i < frameSize; i++) {
+				qint32 sum = 0;
+				for(quint32 ch = 0; ch < channelCount; ch++)
+					sum += channels[ch][offset + i];
+				mono[i] = sum / qint32(channelCount);
+			}
+			samples = mono.constData();
+		}
+		const double power = double(SampleKernels::sumSquares(samples, frameSize)) / frameSize;
+		energy[frame] = 10. * std::log10(power + 1.);
+		zcr[frame] = float(SampleKernels::zeroCrossings(samples, frameSize)) / frameSize;
+	}
+
+	// adapt thresholds to the recording - quiet percentile is background noise, loud one is speech
+	QVector<float> sorted = energy;
+	std::sort(sorted.begin(), sorted.end());
+	const float noiseFloor = sorted.at(frameCount / 10);
+	const float dynamicRange = sorted.at(frameCount * 95 / 100) - noiseFloor;
+	if(dynamicRange < VAD_MIN_DYNAMIC_RANGE_DB)
+		return segments;
+	const float onThreshold = noiseFloor + qMax(VAD_ON_DB, dynamicRange * .4f);
+	const float offThreshold = noiseFloor + qMax(VAD_OFF_DB, dynamicRange * .25f);
+	const float fricativeThreshold = qMax(noiseFloor + VAD_OFF_DB / 2.f, offThreshold - VAD_OFF_DB);
+
+	auto isFricative = [&](quint32 frame) -> bool {
+		return zcr.at(frame) >= VAD_FRICATIVE_ZCR && energy.at(frame) >= fricativeThreshold;
+	};
+	auto appendSegment = [&](quint32 startFrame, quint32 endFrame) {
+		const qint32 start = startFrame * VAD_FRAME_MS;
+		const qint32 end = endFrame * VAD_FRAME_MS;
+		if(!segments.isEmpty() && start - segments.last().end < VAD_MIN_PAUSE_MS)
+			segments.last().end = qMax(segments.last().end, end);
+		else
+			segments.append(Segment{ start, end });
+	};
+
+	const quint32 onsetFrames = VAD_ONSET_MS / VAD_FRAME_MS;
+	const quint32 hangoverFrames = VAD_HANGOVER_MS / VAD_FRAME_MS;
+	bool inSpeech = false;
+	quint32 startFrame = 0;
+	quint32 lastActiveFrame = 0;
+	for(quint32 frame = 0; frame < frameCount; frame++) {
+		if(!inSpeech) {
+			// only voiced frames can start speech, unvoiced consonants before them are included
+			if(energy.at(frame) >= onThreshold) {
+				inSpeech = true;
+				startFrame = frame;
+				while(startFrame > 0 && frame - startFrame < onsetFrames && isFricative(startFrame - 1))
+					startFrame--;
+				lastActiveFrame = frame;
+			}
+		} else if(energy.at(frame) >= offThreshold || isFricative(frame)) {
+			lastActiveFrame = frame;
+		} else if(frame - lastActiveFrame > hangoverFrames) {
+			appendSegment(startFrame, lastActiveFrame + 1);
+			inSpeech = false;
+		}
+	}
+	if(inSpeech)
+		appendSegment(startFrame, lastActiveFrame + 1);
+
+	// drop clicks after merging so short syllables close to other speech are kept
+	auto isShort = [](const Segment &segment) { return segment.end - segment.start < VAD_MIN_SPEECH_MS; };
+	segments.erase(std::remove_if(segments.begin(), segments.end(), isShort), segments.end());
+
+	return segments;
+}
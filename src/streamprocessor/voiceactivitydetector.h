@@ -0,0 +1,85 @@
+#ifndef VOICEACTIVITYDETECTOR_H
+#define VOICEACTIVITYDETECTOR_H
+/**
+ * Copyright (C) 2010-2017 Mladen Milinkovic <max@smoothware.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <QObject>
+#include <QMutex>
+#include <QThreadPool>
+#include <QVector>
+
+namespace SubtitleComposer {
+/**
+ * @brief Finds speech regions in decoded PCM.
+ *
+ * Audio is split into short frames which are classified using their energy and
+ * zero crossing rate against an adaptive noise floor. Classification uses
+ * hysteresis, very short bursts are dropped and short pauses are bridged, so
+ * resulting segments roughly correspond to spoken phrases.
+ */
+class VoiceActivityDetector : public QObject
+{
+	Q_OBJECT
+
+public:
+	struct Segment {
+		qint32 start; ///< milliseconds
+		qint32 end; ///< milliseconds
+	};
+
+	explicit VoiceActivityDetector(QObject *parent = Q_NULLPTR);
+	virtual ~VoiceActivityDetector();
+
+	/**
+	 * @brief Starts detection in background thread, finished() is emitted when done
+	 * @param channels deinterleaved samples, must stay valid until finished() or clear()
+	 */
+	void analyze(const qint16 * const *channels, quint32 channelCount, quint32 sampleCount, quint32 sampleRate);
+	void clear();
+
+	inline bool isReady() const { return m_ready; }
+	inline const QVector<Segment> & segments() const { return m_segments; }
+
+	/// @return start of speech segment closest to @p msecs or -1 if there's none within @p maxDistance
+	qint32 nearestSpeechStart(qint32 msecs, qint32 maxDistance) const;
+	/// @return end of speech segment closest to @p msecs or -1 if there's none within @p maxDistance
+	qint32 nearestSpeechEnd(qint32 msecs, qint32 maxDistance) const;
+
+	static QVector<Segment> detect(const qint16 * const *channels, quint32 channelCount, quint32 sampleCount, quint32 sampleRate);
+
+signals:
+	void finished();
+
+private slots:
+	void onDetectionFinished(int generation);
+
+private:
+	class DetectJob;
+
+	QThreadPool m_threadPool;
+	int m_generation;
+	bool m_ready;
+	QVector<Segment> m_segments;
+
+	QMutex m_resultMutex;
+	QVector<Segment> m_result;
+};
+}
+
+#endif // VOICEACTIVITYDETECTOR_H
@@ -73,6 +73,27 @@ PlayerBackend::supportsChangingAudioStream(bool *onTheFly) const
 	return true;
 }
 
+/*virtual*/ bool
+PlayerBackend::step(int frames)
+{
+	const FrameIndex &index = m_player->frameIndex();
+	if(!index.isEmpty()) {
+		const int current = index.frameAt(index.snapToFrame(qint64(m_player->position() * 1e6 + .5)));
+		const int target = qBound(0, current + frames, index.frameCount() - 1);
+		const qint64 frameTime = index.frameTime(target);
+		return seek(frameTime / 1e6, !index.isKeyframe(frameTime));
+	}
+
+	const double fps = m_player->framesPerSecond() > 0. ? m_player->framesPerSecond() : 25.;
+	return seek(qMax(0., m_player->snapToFrame(m_player->position() + frames / fps)), true);
+}
+
+/*virtual*/ bool
+PlayerBackend::setLoop(double /*start*/, double /*end*/)
+{
+	return false;
+}
+
 void
 PlayerBackend::playbackRateNotify(double newRate)
 {
@@ -124,6 +124,24 @@ protected:
 	 */
 	virtual bool seek(double seconds, bool accurate) = 0;
 
+	/**
+	 * @brief step - moves paused video by given number of frames, default implementation
+	 *  performs an accurate seek to the target frame
+	 * @param frames negative values step backwards
+	 * @return false if there is an error and playback must be aborted; true (all internal cleanup must be done before returning).
+	 */
+	virtual bool step(int frames);
+
+	/**
+	 * @brief setLoop - makes playback repeat range from @p start to @p end without a gap; backend
+	 *  seeks to @p start itself. Default implementation doesn't support looping and VideoPlayer
+	 *  falls back to seeking back when it's notified about position past the end.
+	 * @param start value in seconds
+	 * @param end value in seconds, negative value stops looping and playback continues past the end
+	 * @return false if looping is not supported
+	 */
+	virtual bool setLoop(double start, double end);
+
 	/**
 	 * @brief stop
 	 * @return false if there is an error and playback must be aborted; true (all internal cleanup must be done before returning).
@@ -24,8 +24,10 @@
 
 #include "videoplayer.h"
 #include "playerbackend.h"
+#include "../streamprocessor/streamprocessor.h"
 
 #include "main/scconfig.h"
+#include "../profiler.h"
 
 #include <math.h>
 
@@ -36,12 +38,21 @@
 #include <QPluginLoader>
 #include <QDir>
 #include <QFile>
+#include <QJsonObject>
 
 #include <QDebug>
 
 #include <KLocalizedString>
 
-#define DEFAULT_MIN_POSITION_DELTA 0.02
+// interpolated position can be ahead of backend by this much before it's treated as a seek
+#define CLOCK_MAX_DRIFT 0.25
+// interpolation slows down to let backend catch up within this many seconds
+#define CLOCK_SLEW_TIME 1.0
+// frame interval used for subscriptions until video frame rate is known
+#define DEFAULT_FRAME_INTERVAL 40
+// size of grayscale frames analyzed for shot changes
+#define SCENE_FRAME_WIDTH 64
+#define SCENE_FRAME_HEIGHT 36
 
 namespace SubtitleComposer {
 class DummyPlayerBackend : public PlayerBackend
@@ -93,34 +104,42 @@ VideoPlayer::VideoPlayer() :
 	m_videoWidget(NULL),
 	m_filePath(),
 	m_position(-1.0),
+	m_positionClockSpeed(1.0),
 	m_savedPosition(-1.0),
+	m_loopStart(-1.0),
+	m_loopEnd(-1.0),
+	m_backendLoops(false),
 	m_length(-1.0),
 	m_framesPerSecond(-1.0),
 	m_playbackRate(.0),
-	m_minPositionDelta(DEFAULT_MIN_POSITION_DELTA),
 	m_textStreams(),
 	m_activeAudioStream(-1),
 	m_audioStreams(),
 	m_muted(false),
 	m_volume(100.0),
 	m_backendVolume(100.0),
-	m_openFileTimer(new QTimer(this))
+	m_openFileTimer(new QTimer(this)),
+	m_frameIndexer(Q_NULLPTR),
+	m_sceneAnalyzer(Q_NULLPTR)
 {
+	PROFILE2("VideoPlayer backend discovery");
+
 	backendAdd(new DummyPlayerBackend());
 
+	// plugins pull in whole multimedia frameworks, only the one that gets used is loaded
 	const QString buildPluginPath(qApp->applicationDirPath() + QStringLiteral("/../videoplayerplugins"));
 	if(QDir(buildPluginPath).exists()) {
 		// if application is launched from build directory it will load plugins from build directory
-		backendLoad(buildPluginPath + QStringLiteral("/gstreamer/gstplayer.so"));
-		backendLoad(buildPluginPath + QStringLiteral("/mplayer/mplayer.so"));
-		backendLoad(buildPluginPath + QStringLiteral("/mpv/mpvplayer.so"));
-		backendLoad(buildPluginPath + QStringLiteral("/phonon/phononplayer.so"));
-		backendLoad(buildPluginPath + QStringLiteral("/xine/xineplayer.so"));
+		backendDiscover(buildPluginPath + QStringLiteral("/gstreamer/gstplayer.so"));
+		backendDiscover(buildPluginPath + QStringLiteral("/mplayer/mplayer.so"));
+		backendDiscover(buildPluginPath + QStringLiteral("/mpv/mpvplayer.so"));
+		backendDiscover(buildPluginPath + QStringLiteral("/phonon/phononplayer.so"));
+		backendDiscover(buildPluginPath + QStringLiteral("/xine/xineplayer.so"));
 	} else {
 		QDir pluginsDir(QStringLiteral(SCPLUGIN_PATH));
 		foreach(const QString pluginFile, pluginsDir.entryList(QDir::Files, QDir::Name)) {
 			if(QLibrary::isLibrary(pluginFile))
-				backendLoad(pluginsDir.filePath(pluginFile));
+				backendDiscover(pluginsDir.filePath(pluginFile));
 		}
 	}
 
@@ -153,16 +172,16 @@ VideoPlayer::initialize(QWidget *widgetParent, const QString &prefBackendName)
 		return false;
 	}
 
+	PROFILE2("VideoPlayer backend initialization");
+
 	m_widgetParent = widgetParent;
 
-	if(m_backends.contains(prefBackendName)) {
-		// we first try to set the requested backend as active
-		backendInitializePrivate(m_backends[prefBackendName]);
-	}
+	// we first try to set the requested backend as active
+	backendInitializePrivate(backend(prefBackendName));
 	// if that fails, we set the first available backend as active
 	if(!m_activeBackend) {
-		for(QMap<QString, PlayerBackend *>::ConstIterator it = m_backends.begin(), end = m_backends.end(); it != end; ++it)
-			if(backendInitializePrivate(it.value()))
+		foreach(const QString &name, backendNames())
+			if(backendInitializePrivate(backend(name)))
 				break;
 	}
 
@@ -180,13 +199,15 @@ VideoPlayer::reinitialize(const QString &prefBackendName)
 
 	QString currentFile = m_filePath;
 
-	PlayerBackend *targetBackend = m_backends.contains(prefBackendName) ? m_backends[prefBackendName] : m_activeBackend;
+	PlayerBackend *targetBackend = backend(prefBackendName);
+	if(!targetBackend)
+		targetBackend = m_activeBackend;
 
 	finalize();
 
 	if(!backendInitializePrivate(targetBackend)) {
-		for(QMap<QString, PlayerBackend *>::ConstIterator it = m_backends.begin(), end = m_backends.end(); it != end; ++it)
-			if(backendInitializePrivate(it.value()))
+		foreach(const QString &name, backendNames())
+			if(backendInitializePrivate(backend(name)))
 				break;
 	}
 
@@ -226,9 +247,52 @@ VideoPlayer::reconfigure()
 	return m_activeBackend->reconfigure();
 }
 
+void
+VideoPlayer::backendDiscover(const QString &pluginPath)
+{
+	const QString realPath = QDir(pluginPath).canonicalPath();
+	if(realPath.isEmpty())
+		return;
+
+	// metadata is read from the file, the library itself is not loaded
+	const QJsonObject metaData = QPluginLoader(realPath).metaData();
+	if(metaData.value(QStringLiteral("IID")).toString() != QStringLiteral(PlayerBackend_iid))
+		return;
+
+	const QString name = metaData.value(QStringLiteral("MetaData")).toObject().value(QStringLiteral("name")).toString();
+	if(name.isEmpty()) {
+		// plugin without metadata can only be identified by loading it
+		backendLoad(realPath);
+		return;
+	}
+
+	if(m_backends.contains(name) || m_backendPlugins.contains(name)) {
+		qCritical() << "Attempted to insert duplicate VideoPlayer backend" << name;
+		return;
+	}
+
+	m_backendPlugins[name] = realPath;
+}
+
+PlayerBackend *
+VideoPlayer::backend(const QString &name)
+{
+	if(m_backends.contains(name))
+		return m_backends[name];
+	if(!m_backendPlugins.contains(name))
+		return NULL;
+
+	PlayerBackend *backend = backendLoad(m_backendPlugins.take(name));
+	if(backend && backend->name() != name)
+		qWarning() << "VideoPlayer plugin metadata name" << name << "doesn't match backend name" << backend->name();
+	return backend;
+}
+
 PlayerBackend *
 VideoPlayer::backendLoad(const QString &pluginPath)
 {
+	PROFILE2("VideoPlayer plugin load");
+
 	const QString realPath = QDir(pluginPath).canonicalPath();
 	if(realPath.isEmpty())
 		return NULL;
@@ -254,6 +318,9 @@ VideoPlayer::backendLoad(const QString &pluginPath)
 bool
 VideoPlayer::backendInitializePrivate(PlayerBackend *backend)
 {
+	if(!backend)
+		return false;
+
 	if(m_activeBackend == backend)
 		return true;
 
@@ -293,7 +360,9 @@ VideoPlayer::activeBackendName() const
 QStringList
 VideoPlayer::backendNames() const
 {
-	return m_backends.keys();
+	QStringList names = m_backends.keys() + m_backendPlugins.keys();
+	names.sort();
+	return names;
 }
 
 void
@@ -396,11 +465,19 @@ VideoPlayer::resetState()
 
 	m_filePath.clear();
 
+	cancelFrameIndex();
+	cancelSceneCuts();
+
 	m_position = -1.0;
+	m_positionClock.invalidate();
+	m_positionClockSpeed = 1.0;
 	m_savedPosition = -1.0;
 	m_length = -1.0;
 	m_framesPerSecond = -1.0;
-	m_minPositionDelta = DEFAULT_MIN_POSITION_DELTA;
+
+	const bool wasLooping = isLooping();
+	m_loopStart = m_loopEnd = -1.0;
+	m_backendLoops = false;
 
 	m_activeAudioStream = -1;
 	m_textStreams.clear();
@@ -408,8 +485,13 @@ VideoPlayer::resetState()
 
 	m_state = VideoPlayer::Closed;
 
+	updatePositionSubscribers();
+
 	if(m_videoWidget)
 		m_videoWidget->videoLayer()->hide();
+
+	if(wasLooping)
+		emit loopChanged(false);
 }
 
 void
@@ -444,17 +526,143 @@ VideoPlayer::notifyPosition(double position)
 	if(position > m_length && m_length > 0)
 		notifyLength(position);
 
-	if(m_position != position) {
-		if(m_position <= 0 || m_minPositionDelta <= 0.0) {
-			m_position = position;
-			emit positionChanged(position);
+	if(isLooping() && !m_backendLoops && m_state == VideoPlayer::Playing && position >= m_loopEnd) {
+		// backend can't loop by itself, this overshoots by up to one position update
+		activeBackend()->seek(m_loopStart, true);
+		return;
+	}
+
+	if(m_state != VideoPlayer::Playing || m_position < 0.0) {
+		if(m_position != position) {
+			restartPositionClock(position);
+			publishPosition();
+		}
+		return;
+	}
+
+	const double interpolated = interpolatedPosition();
+	const double drift = interpolated - position;
+	if(drift > 0.0 && drift < CLOCK_MAX_DRIFT) {
+		// backend is slightly behind, keep going forward slower until it catches up
+		restartPositionClock(interpolated);
+		m_positionClockSpeed = qMax(0.5, 1.0 - drift / CLOCK_SLEW_TIME);
+	} else if(drift >= CLOCK_MAX_DRIFT || -drift >= CLOCK_MAX_DRIFT) {
+		// seek or stall
+		restartPositionClock(position);
+		publishPosition();
+	} else {
+		restartPositionClock(position);
+	}
+}
+
+double
+VideoPlayer::position() const
+{
+	return m_state <= VideoPlayer::Opening ? -1.0 : (m_state == VideoPlayer::Ready ? 0.0 : interpolatedPosition());
+}
+
+double
+VideoPlayer::interpolatedPosition() const
+{
+	if(m_state != VideoPlayer::Playing || m_position < 0.0 || !m_positionClock.isValid())
+		return m_position;
+
+	const double rate = m_playbackRate > 0.0 ? m_playbackRate : 1.0;
+	const double position = m_position + double(m_positionClock.nsecsElapsed()) / 1e9 * rate * m_positionClockSpeed;
+	// backend will report the jump back to loop start
+	if(isLooping() && m_position <= m_loopEnd && position > m_loopEnd)
+		return m_loopEnd;
+	return m_length > 0.0 && position > m_length ? m_length : position;
+}
+
+void
+VideoPlayer::restartPositionClock(double position)
+{
+	m_position = position;
+	m_positionClock.start();
+	m_positionClockSpeed = 1.0;
+
+	emit positionChanged(position);
+}
+
+void
+VideoPlayer::publishPosition()
+{
+	// receivers might unsubscribe while being notified
+	const QList<PositionSubscriber> subscribers = m_positionSubscribers;
+	for(const PositionSubscriber &subscriber : subscribers)
+		onPositionSubscriberTimeout(subscriber.timer);
+}
+
+void
+VideoPlayer::updatePositionSubscribers()
+{
+	const int frameInterval = m_framesPerSecond > 0.0 ? qRound(1000.0 / m_framesPerSecond) : DEFAULT_FRAME_INTERVAL;
+	for(const PositionSubscriber &subscriber : m_positionSubscribers) {
+		subscriber.timer->setInterval(subscriber.interval == FrameInterval ? frameInterval : subscriber.interval);
+		if(m_state == VideoPlayer::Playing)
+			subscriber.timer->start();
+		else
+			subscriber.timer->stop();
+	}
+}
+
+void
+VideoPlayer::subscribePosition(QObject *receiver, const std::function<void(double)> &callback, int interval)
+{
+	PositionSubscriber subscriber;
+	subscriber.receiver = receiver;
+	subscriber.callback = callback;
+	subscriber.interval = interval;
+	subscriber.timer = new QTimer(this);
+	subscriber.timer->setTimerType(interval == FrameInterval ? Qt::PreciseTimer : Qt::CoarseTimer);
+	subscriber.lastPosition = -1.0;
+
+	QTimer *timer = subscriber.timer;
+	connect(timer, &QTimer::timeout, this, [this, timer]() { onPositionSubscriberTimeout(timer); });
+	connect(receiver, &QObject::destroyed, this, &VideoPlayer::onPositionSubscriberDestroyed, Qt::UniqueConnection);
+
+	m_positionSubscribers.append(subscriber);
+	updatePositionSubscribers();
+}
+
+void
+VideoPlayer::unsubscribePosition(QObject *receiver)
+{
+	disconnect(receiver, &QObject::destroyed, this, &VideoPlayer::onPositionSubscriberDestroyed);
+	onPositionSubscriberDestroyed(receiver);
+}
+
+void
+VideoPlayer::onPositionSubscriberDestroyed(QObject *receiver)
+{
+	for(auto it = m_positionSubscribers.begin(); it != m_positionSubscribers.end();) {
+		if(it->receiver == receiver) {
+			// we might be inside the timer's timeout()
+			it->timer->stop();
+			it->timer->deleteLater();
+			it = m_positionSubscribers.erase(it);
 		} else {
-			double positionDelta = m_position - position;
-			if(positionDelta >= m_minPositionDelta || -positionDelta >= m_minPositionDelta) {
-				m_position = position;
-				emit positionChanged(position);
-			}
+			++it;
+		}
+	}
+}
+
+void
+VideoPlayer::onPositionSubscriberTimeout(QTimer *timer)
+{
+	for(PositionSubscriber &subscriber : m_positionSubscribers) {
+		if(subscriber.timer != timer)
+			continue;
+
+		const double position = this->position();
+		if(subscriber.lastPosition != position) {
+			subscriber.lastPosition = position;
+			// receiver might unsubscribe from the callback, it can't be called through the list
+			const std::function<void(double)> callback = subscriber.callback;
+			callback(position);
 		}
+		return;
 	}
 }
 
@@ -478,7 +686,7 @@ VideoPlayer::notifyFramesPerSecond(double framesPerSecond)
 
 	if(framesPerSecond > 0 && m_framesPerSecond != framesPerSecond) {
 		m_framesPerSecond = framesPerSecond;
-		m_minPositionDelta = 1.0 / framesPerSecond;
+		updatePositionSubscribers();
 		emit framesPerSecondChanged(framesPerSecond);
 	}
 }
@@ -519,6 +727,10 @@ VideoPlayer::notifyState(VideoPlayer::State newState)
 			m_videoWidget->videoLayer()->show();
 			activeBackend()->setVolume(m_backendVolume);
 
+			if(m_position >= 0.0)
+				restartPositionClock(m_position);
+			updatePositionSubscribers();
+
 			emit fileOpened(m_filePath);
 
 			// we emit this signals in case their values were already set
@@ -533,7 +745,12 @@ VideoPlayer::notifyState(VideoPlayer::State newState)
 		}
 	} else if(m_state > VideoPlayer::Opening) {
 		if(m_state != newState && newState > VideoPlayer::Opening) {
+			// freeze interpolated position when leaving playing state, restart clock when entering it
+			if(m_position >= 0.0)
+				restartPositionClock(interpolatedPosition());
 			m_state = newState;
+			updatePositionSubscribers();
+			publishPosition();
 			switch(m_state) {
 			case VideoPlayer::Playing:
 				m_videoWidget->videoLayer()->show();
@@ -599,9 +816,160 @@ VideoPlayer::openFile(const QString &filePath)
 	if(!playingAfterCall)
 		activeBackend()->play();
 
+	buildFrameIndex();
+
 	return true;
 }
 
+void
+VideoPlayer::buildFrameIndex()
+{
+	cancelFrameIndex();
+
+	const QString cacheFile = FrameIndex::cacheFile(m_filePath);
+	if(m_frameIndex.load(cacheFile, m_filePath)) {
+		emit frameIndexChanged();
+		buildSceneCuts();
+		return;
+	}
+
+	m_frameIndexer = new StreamProcessor(this);
+	if(!m_frameIndexer->open(m_filePath) || !m_frameIndexer->initVideo(0)) {
+		cancelFrameIndex();
+		return;
+	}
+
+	// frames are reported from GStreamer thread, index is used only after the stream has finished
+	connect(m_frameIndexer, &StreamProcessor::videoFrameAvailable, this, [this](const qint64 usecTime, const bool keyframe) {
+		m_pendingFrameIndex.append(usecTime, keyframe);
+	}, Qt::DirectConnection);
+	connect(m_frameIndexer, &StreamProcessor::streamFinished, this, &VideoPlayer::onFrameIndexFinished);
+	connect(m_frameIndexer, &StreamProcessor::streamError, this, &VideoPlayer::cancelFrameIndex);
+
+	if(!m_frameIndexer->start())
+		cancelFrameIndex();
+}
+
+void
+VideoPlayer::cancelFrameIndex()
+{
+	if(m_frameIndexer) {
+		// stops the pipeline, so no more frames will be appended
+		m_frameIndexer->close();
+		m_frameIndexer->deleteLater();
+		m_frameIndexer = Q_NULLPTR;
+	}
+	m_pendingFrameIndex.clear();
+
+	if(!m_frameIndex.isEmpty()) {
+		m_frameIndex.clear();
+		emit frameIndexChanged();
+	}
+}
+
+void
+VideoPlayer::onFrameIndexFinished()
+{
+	if(!m_frameIndexer || sender() != m_frameIndexer)
+		return;
+
+	m_frameIndexer->close();
+	m_frameIndexer->deleteLater();
+	m_frameIndexer = Q_NULLPTR;
+
+	m_pendingFrameIndex.finalize();
+	if(!m_pendingFrameIndex.isEmpty()) {
+		m_frameIndex = m_pendingFrameIndex;
+		m_pendingFrameIndex.clear();
+		m_frameIndex.save(FrameIndex::cacheFile(m_filePath), m_filePath);
+
+		emit frameIndexChanged();
+	}
+
+	// decoding is much heavier than indexing, don't run both at once
+	buildSceneCuts();
+}
+
+void
+VideoPlayer::buildSceneCuts()
+{
+	cancelSceneCuts();
+
+	const QString cacheFile = SceneDetector::cacheFile(m_filePath);
+	if(m_sceneCuts.load(cacheFile, m_filePath)) {
+		emit sceneCutsChanged();
+		return;
+	}
+
+	m_sceneAnalyzer = new StreamProcessor(this);
+	if(!m_sceneAnalyzer->open(m_filePath) || !m_sceneAnalyzer->initVideoFrames(0, SCENE_FRAME_WIDTH, SCENE_FRAME_HEIGHT)) {
+		cancelSceneCuts();
+		return;
+	}
+
+	// frames are analyzed on GStreamer thread, cuts are used only after the stream has finished
+	connect(m_sceneAnalyzer, &StreamProcessor::videoFrameDecoded, this, [this](const quint8 *pixels, const int width, const int height, const qint64 usecTime) {
+		m_pendingSceneCuts.addFrame(pixels, width, height, usecTime);
+	}, Qt::DirectConnection);
+	connect(m_sceneAnalyzer, &StreamProcessor::streamFinished, this, &VideoPlayer::onSceneCutsFinished);
+	connect(m_sceneAnalyzer, &StreamProcessor::streamError, this, &VideoPlayer::cancelSceneCuts);
+
+	if(!m_sceneAnalyzer->start())
+		cancelSceneCuts();
+}
+
+void
+VideoPlayer::cancelSceneCuts()
+{
+	if(m_sceneAnalyzer) {
+		m_sceneAnalyzer->close();
+		m_sceneAnalyzer->deleteLater();
+		m_sceneAnalyzer = Q_NULLPTR;
+	}
+	m_pendingSceneCuts.clear();
+
+	if(!m_sceneCuts.isEmpty()) {
+		m_sceneCuts.clear();
+		emit sceneCutsChanged();
+	}
+}
+
+void
+VideoPlayer::onSceneCutsFinished()
+{
+	if(!m_sceneAnalyzer || sender() != m_sceneAnalyzer)
+		return;
+
+	m_sceneAnalyzer->close();
+	m_sceneAnalyzer->deleteLater();
+	m_sceneAnalyzer = Q_NULLPTR;
+
+	m_pendingSceneCuts.finalize();
+	m_sceneCuts = m_pendingSceneCuts;
+	m_pendingSceneCuts.clear();
+	// file without shot changes is cached too, so it's not analyzed again
+	m_sceneCuts.save(SceneDetector::cacheFile(m_filePath), m_filePath);
+
+	emit sceneCutsChanged();
+}
+
+double
+VideoPlayer::nearestSceneCut(double seconds, double maxDistance) const
+{
+	const qint64 cut = m_sceneCuts.nearestCut(qint64(seconds * 1e6 + .5), qint64(maxDistance * 1e6 + .5));
+	return cut < 0 ? -1.0 : cut / 1e6;
+}
+
+double
+VideoPlayer::snapToFrame(double seconds) const
+{
+	if(!m_frameIndex.isEmpty())
+		return m_frameIndex.snapToFrame(qint64(seconds * 1e6 + .5)) / 1e6;
+	if(m_framesPerSecond > 0.0)
+		return qRound64(seconds * m_framesPerSecond) / m_framesPerSecond;
+	return seconds;
+}
+
 void
 VideoPlayer::onOpenFileTimeout(const QString &reason)
 {
@@ -689,9 +1057,19 @@ VideoPlayer::seek(double seconds, bool accurate)
 	if((m_state != VideoPlayer::Playing && m_state != VideoPlayer::Paused) || seconds < 0 || seconds > m_length)
 		return false;
 
+	if(accurate && !m_frameIndex.isEmpty()) {
+		// target exact frame start, keyframes can be reached by fast seek without decoding previous frames
+		const qint64 frameTime = m_frameIndex.snapToFrame(qint64(seconds * 1e6 + .5));
+		seconds = frameTime / 1e6;
+		accurate = !m_frameIndex.isKeyframe(frameTime);
+	}
+
 	if(seconds == m_position)
 		return true;
 
+	if(isLooping() && (seconds < m_loopStart || seconds > m_loopEnd))
+		clearLoop();
+
 	if(!activeBackend()->seek(seconds, accurate)) {
 		resetState();
 		emit playbacqCritical();
@@ -700,6 +1078,23 @@ VideoPlayer::seek(double seconds, bool accurate)
 	return true;
 }
 
+bool
+VideoPlayer::step(int frames)
+{
+	if((m_state != VideoPlayer::Playing && m_state != VideoPlayer::Paused) || !frames)
+		return false;
+
+	if(m_state == VideoPlayer::Playing)
+		pause();
+
+	if(!activeBackend()->step(frames)) {
+		resetState();
+		emit playbacqCritical();
+	}
+
+	return true;
+}
+
 void
 VideoPlayer::seekToSavedPosition()
 {
@@ -709,12 +1104,57 @@ VideoPlayer::seekToSavedPosition()
 	}
 }
 
+bool
+VideoPlayer::setLoop(double start, double end)
+{
+	if((m_state != VideoPlayer::Playing && m_state != VideoPlayer::Paused) || start < 0.0 || end <= start)
+		return false;
+
+	m_loopStart = snapToFrame(start);
+	m_loopEnd = qMin(end, m_length);
+	if(m_loopEnd <= m_loopStart) {
+		m_loopStart = m_loopEnd = -1.0;
+		return false;
+	}
+
+	m_backendLoops = activeBackend()->setLoop(m_loopStart, m_loopEnd);
+	if(!m_backendLoops && !activeBackend()->seek(m_loopStart, true)) {
+		resetState();
+		emit playbacqCritical();
+		return true;
+	}
+
+	if(m_state == VideoPlayer::Paused)
+		play();
+
+	emit loopChanged(true);
+
+	return true;
+}
+
+void
+VideoPlayer::clearLoop()
+{
+	if(!isLooping())
+		return;
+
+	if(m_backendLoops)
+		activeBackend()->setLoop(-1.0, -1.0);
+
+	m_loopStart = m_loopEnd = -1.0;
+	m_backendLoops = false;
+
+	emit loopChanged(false);
+}
+
 bool
 VideoPlayer::stop()
 {
 	if(m_state <= VideoPlayer::Opening || m_state == VideoPlayer::Ready)
 		return false;
 
+	clearLoop();
+
 	if(!activeBackend()->stop()) {
 		resetState();
 		emit playbacqCritical();
@@ -740,7 +1180,7 @@ VideoPlayer::setActiveAudioStream(int audioStreamIndex)
 	m_activeAudioStream = audioStreamIndex;
 
 	if(m_state != VideoPlayer::Ready) {
-		double savedPosition = m_position;
+		double savedPosition = position();
 
 		if(!activeBackend()->setActiveAudioStream(audioStreamIndex)) {
 			resetState();
@@ -22,16 +22,23 @@
  */
 
 #include "videowidget.h"
+#include "../streamprocessor/frameindex.h"
+#include "../streamprocessor/scenedetector.h"
 
 #include <QString>
 #include <QStringList>
 #include <QMap>
+#include <QList>
+#include <QElapsedTimer>
 #include <QWidget>
 
+#include <functional>
+
 QT_FORWARD_DECLARE_CLASS(QTimer)
 
 namespace SubtitleComposer {
 class PlayerBackend;
+class StreamProcessor;
 
 class VideoPlayer : public QObject
 {
@@ -49,6 +56,10 @@ public:
 		Ready                                   // same as Stopped or Finished
 	} State;
 
+	enum {
+		FrameInterval = 0                       // position subscription interval of one video frame
+	};
+
 	static VideoPlayer * instance();
 
 	/**
@@ -92,7 +103,11 @@ public:
 
 	inline bool isActiveBackendDummy() const;
 
-	inline PlayerBackend * backend(const QString &name) const;
+	/**
+	 * @brief backend - returns backend named @p name, loading its plugin if it wasn't used yet
+	 * @return NULL if there is no such backend or its plugin couldn't be loaded
+	 */
+	PlayerBackend * backend(const QString &name);
 	inline PlayerBackend * activeBackend() const;
 
 	/**
@@ -111,7 +126,12 @@ public:
 
 	inline bool isPlaying() const;
 	inline bool isPaused() const;
-	inline double position() const;
+	/**
+	 * @brief position - while playing, position is interpolated from the last position reported
+	 *  by backend using steady clock and never goes backwards unless there was a seek
+	 * @return position in seconds
+	 */
+	double position() const;
 	inline double length() const;
 	inline double framesPerSecond() const;
 	inline double playbackRate() const;
@@ -125,6 +145,48 @@ public:
 	inline int activeAudioStream() const;
 	const QStringList & audioStreams() const;
 
+	/**
+	 * @brief frameIndex - timestamps of all video frames and keyframes of the opened file; it's
+	 *  built in background (or loaded from cache) after the file is opened and frameIndexChanged()
+	 *  is emitted when it becomes available
+	 */
+	inline const FrameIndex & frameIndex() const { return m_frameIndex; }
+	/**
+	 * @brief snapToFrame - uses frame index or frame rate if index is not available yet
+	 * @return start time of the video frame closest to @p seconds
+	 */
+	double snapToFrame(double seconds) const;
+
+	/**
+	 * @brief sceneCuts - start times of shots (in microseconds) of the opened file; video is analyzed
+	 *  in background (or loaded from cache) after the frame index is ready and sceneCutsChanged()
+	 *  is emitted when they become available
+	 */
+	inline const QVector<qint64> & sceneCuts() const { return m_sceneCuts.cuts(); }
+	/// @return time of shot change closest to @p seconds or -1.0 if there's none within @p maxDistance
+	double nearestSceneCut(double seconds, double maxDistance) const;
+
+	/**
+	 * @brief subscribePosition - makes the player call @p method of @p receiver with current
+	 *  position in seconds every @p interval milliseconds while playing.
+	 *  Seeks, pausing and position changes while paused are delivered immediately.
+	 * @param receiver subscription is removed automatically when receiver is destroyed
+	 * @param method member function taking position in seconds
+	 * @param interval update interval in milliseconds or FrameInterval
+	 */
+	template<class T>
+	inline void subscribePosition(T *receiver, void (T::*method)(double), int interval)
+	{
+		subscribePosition(receiver, [receiver, method](double position) { (receiver->*method)(position); }, interval);
+	}
+	/// same as above, @p callback is called instead of receiver's method
+	void subscribePosition(QObject *receiver, const std::function<void(double)> &callback, int interval);
+	void unsubscribePosition(QObject *receiver);
+
+	inline bool isLooping() const { return m_loopEnd > m_loopStart; }
+	inline double loopStart() const { return m_loopStart; }
+	inline double loopEnd() const { return m_loopEnd; }
+
 public slots:
 	/**
 	 * @brief setApplicationClosingDown - Used to indicate the active backend that the application is closing down
@@ -142,6 +204,14 @@ public slots:
 	bool pause();
 	bool togglePlayPaused();
 	bool seek(double seconds, bool accurate);
+	/// pauses playback and moves by @p frames video frames, negative values step backwards
+	bool step(int frames);
+	/**
+	 * @brief setLoop - starts playback from @p start and repeats range up to @p end until
+	 *  clearLoop() is called or the player seeks outside of it
+	 */
+	bool setLoop(double start, double end);
+	void clearLoop();
 	bool stop();
 	bool setActiveAudioStream(int audioStreamIndex);
 
@@ -170,6 +240,9 @@ signals:
 	void textStreamsChanged(const QStringList &textStreams);
 	void activeAudioStreamChanged(int audioStreamIndex);
 	void audioStreamsChanged(const QStringList &audioStreams);
+	void frameIndexChanged();
+	void sceneCutsChanged();
+	void loopChanged(bool looping);
 
 	void volumeChanged(double volume);
 	void muteChanged(bool muted);
@@ -199,6 +272,10 @@ private:
 	 */
 	virtual void backendFinalize(PlayerBackend *backend);
 
+	/**
+	 * @brief backendDiscover - reads backend name from plugin metadata without loading the plugin
+	 */
+	void backendDiscover(const QString &pluginPath);
 	PlayerBackend * backendLoad(const QString &pluginPath);
 
 	void backendAdd(PlayerBackend *backend);
@@ -214,7 +291,7 @@ private:
 	void notifyVolume(double volume);
 	void notifyMute(bool muted);
 
-	void notifyPosition(double position);              // value in seconds
+	void notifyPosition(double position);              // value in seconds, authoritative timestamp from backend
 	void notifyLength(double length);          // value in seconds
 
 	void notifyState(VideoPlayer::State state);
@@ -224,6 +301,16 @@ private:
 	void notifyTextStreams(const QStringList &textStreams);
 	void notifyAudioStreams(const QStringList &audioStreams, int activeAudioStream);
 
+	double interpolatedPosition() const;
+	void restartPositionClock(double position);
+	void publishPosition();
+	void updatePositionSubscribers();
+
+	void buildFrameIndex();
+	void cancelFrameIndex();
+	void buildSceneCuts();
+	void cancelSceneCuts();
+
 private slots:
 	void seekToSavedPosition();
 
@@ -233,8 +320,15 @@ private slots:
 	/** called if the player fails to set the state to Playing after opening the file */
 	void onOpenFileTimeout(const QString &reason = QString());
 
+	void onPositionSubscriberTimeout(QTimer *timer);
+	void onPositionSubscriberDestroyed(QObject *receiver);
+
+	void onFrameIndexFinished();
+	void onSceneCutsFinished();
+
 private:
 	QMap<QString, PlayerBackend *> m_backends;
+	QMap<QString, QString> m_backendPlugins;   // discovered backends that aren't loaded yet, name -> plugin path
 	PlayerBackend *m_activeBackend;
 	QWidget *m_widgetParent;
 
@@ -246,12 +340,16 @@ private:
 
 	QString m_filePath;
 
-	double m_position;
+	double m_position;                      // last position reported by backend
+	QElapsedTimer m_positionClock;          // time since m_position was reported
+	double m_positionClockSpeed;            // below 1.0 while backend catches up with interpolated position
 	double m_savedPosition;
+	double m_loopStart;                     // seconds, loop is active when m_loopEnd > m_loopStart
+	double m_loopEnd;
+	bool m_backendLoops;                    // false if player seeks back when position passes m_loopEnd
 	double m_length;
 	double m_framesPerSecond;
 	double m_playbackRate;
-	double m_minPositionDelta;
 	QStringList m_textStreams;
 	int m_activeAudioStream;
 	QStringList m_audioStreams;
@@ -262,6 +360,23 @@ private:
 
 	QTimer *m_openFileTimer;
 
+	FrameIndex m_frameIndex;
+	FrameIndex m_pendingFrameIndex;         // filled from GStreamer thread while indexing
+	StreamProcessor *m_frameIndexer;
+
+	SceneDetector m_sceneCuts;
+	SceneDetector m_pendingSceneCuts;       // fed from GStreamer thread while analyzing
+	StreamProcessor *m_sceneAnalyzer;
+
+	struct PositionSubscriber {
+		QObject *receiver;
+		std::function<void(double)> callback;
+		int interval;
+		QTimer *timer;
+		double lastPosition;
+	};
+	QList<PositionSubscriber> m_positionSubscribers;
+
 	friend class PlayerBackend;
 };
 
@@ -283,12 +398,6 @@ VideoPlayer::activeBackend() const
 	return m_activeBackend;
 }
 
-PlayerBackend *
-VideoPlayer::backend(const QString &backendName) const
-{
-	return m_backends.contains(backendName) ? m_backends[backendName] : 0;
-}
-
 bool
 VideoPlayer::isActiveBackendDummy() const
 {
@@ -319,12 +428,6 @@ VideoPlayer::isPaused() const
 	return m_state == VideoPlayer::Paused;
 }
 
-double
-VideoPlayer::position() const
-{
-	return m_state <= VideoPlayer::Opening ? -1.0 : (m_state == VideoPlayer::Ready ? 0.0 : m_position);
-}
-
 double
 VideoPlayer::length() const
 {
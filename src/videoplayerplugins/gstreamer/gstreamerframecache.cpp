@@ -0,0 +1,420 @@
+/**
+ * Copyright (C) 2010-2017 Mladen Milinkovic <max@smoothware.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "gstreamerframecache.h"
+#include "../../streamprocessor/gstreamer.h"
+
+#include <QDebug>
+#include <QMutexLocker>
+
+#include <cstring>
+
+#define INFINITE_WAIT 60000
+
+// position reported by player can be slightly before the start of displayed frame
+#define POSITION_TOLERANCE 1000
+
+using namespace SubtitleComposer;
+
+GStreamerFrameCache::GStreamerFrameCache(QObject *parent)
+	: QObject(parent),
+	  m_pipeline(NULL),
+	  m_pipelineBus(NULL),
+	  m_filter(NULL),
+	  m_busMessagesPending(0),
+	  m_prerolled(false),
+	  m_decoding(false),
+	  m_maxSize(0),
+	  m_requestPosition(0),
+	  m_frameDuration(0),
+	  m_size(0),
+	  m_center(0),
+	  m_rangeStart(0),
+	  m_rangeEnd(-1)
+{
+}
+
+GStreamerFrameCache::~GStreamerFrameCache()
+{
+	close();
+}
+
+bool
+GStreamerFrameCache::open(const QString &uri)
+{
+	close();
+
+	m_pipeline = GST_PIPELINE(gst_element_factory_make("playbin", "framecache"));
+	GstElement *videobin = gst_bin_new("framecachebin");
+	GstElement *convert = gst_element_factory_make("videoconvert", "convert");
+	GstElement *scale = gst_element_factory_make("videoscale", "scale");
+	GstElement *filter = gst_element_factory_make("capsfilter", "filter");
+	GstElement *fakesink = gst_element_factory_make("fakesink", "sink");
+
+	if(!m_pipeline || !videobin || !convert || !scale || !filter || !fakesink) {
+		if(convert)
+			gst_object_unref(GST_OBJECT(convert));
+		if(scale)
+			gst_object_unref(GST_OBJECT(scale));
+		if(filter)
+			gst_object_unref(GST_OBJECT(filter));
+		if(fakesink)
+			gst_object_unref(GST_OBJECT(fakesink));
+		if(videobin)
+			gst_object_unref(GST_OBJECT(videobin));
+		if(m_pipeline)
+			gst_object_unref(GST_OBJECT(m_pipeline));
+		m_pipeline = NULL;
+		return false;
+	}
+
+	GstPad *padSink = NULL;
+	gst_bin_add_many(GST_BIN(videobin), convert, scale, filter, fakesink, NULL);
+	const bool videobin_ok = gst_element_link_many(convert, scale, filter, fakesink, NULL)
+		&& (padSink = gst_element_get_static_pad(convert, "sink")) != NULL
+		&& gst_element_add_pad(videobin, gst_ghost_pad_new("sink", padSink));
+	if(padSink)
+		g_object_unref(padSink);
+
+	if(!videobin_ok) {
+		// bin owns the elements that were added to it
+		gst_object_unref(GST_OBJECT(videobin));
+		gst_object_unref(GST_OBJECT(m_pipeline));
+		m_pipeline = NULL;
+		return false;
+	}
+
+	m_filter = GST_ELEMENT(gst_object_ref(filter));
+
+	// frames are decoded as fast as possible
+	g_object_set(G_OBJECT(fakesink), "signal-handoffs", TRUE, "sync", FALSE, NULL);
+	g_signal_connect(fakesink, "handoff", G_CALLBACK(onFrameReady), this);
+
+	g_object_set(G_OBJECT(m_pipeline), "uri", uri.toUtf8().constData(), NULL);
+	// our bin converts and scales, there's no need for audio
+	g_object_set(G_OBJECT(m_pipeline), "flags", GST_PLAY_FLAG_VIDEO | GST_PLAY_FLAG_NATIVE_VIDEO, NULL);
+	g_object_set(G_OBJECT(m_pipeline), "video-sink", videobin, NULL);
+
+	m_busMessagesPending = 0;
+	m_pipelineBus = gst_pipeline_get_bus(GST_PIPELINE(m_pipeline));
+	gst_bus_set_sync_handler(m_pipelineBus, &GStreamerFrameCache::busSyncHandler, this, NULL);
+
+	m_prerolled = false;
+	m_decoding = false;
+
+	return true;
+}
+
+void
+GStreamerFrameCache::close()
+{
+	if(m_pipeline) {
+		gst_bus_set_sync_handler(m_pipelineBus, NULL, NULL, NULL);
+		GStreamer::setElementState(GST_ELEMENT(m_pipeline), GST_STATE_NULL, INFINITE_WAIT);
+		GStreamer::freePipeline(&m_pipeline, &m_pipelineBus);
+	}
+	if(m_filter) {
+		gst_object_unref(GST_OBJECT(m_filter));
+		m_filter = NULL;
+	}
+
+	m_prerolled = false;
+	m_decoding = false;
+
+	QMutexLocker lock(&m_mutex);
+	m_frames.clear();
+	m_size = 0;
+	m_rangeStart = 0;
+	m_rangeEnd = -1;
+}
+
+void
+GStreamerFrameCache::setMaxSize(qint64 bytes)
+{
+	QMutexLocker lock(&m_mutex);
+	m_maxSize = bytes;
+	trim();
+}
+
+void
+GStreamerFrameCache::prefetch(qint64 usecPosition, qint64 frameDuration, const QSize &frameSize)
+{
+	if(!m_pipeline || m_maxSize <= 0 || frameDuration <= 0 || frameSize.isEmpty())
+		return;
+
+	m_requestPosition = usecPosition;
+	m_frameDuration = frameDuration;
+	m_frameSize = frameSize;
+
+	startPrefetch();
+}
+
+void
+GStreamerFrameCache::cancel()
+{
+	if(!m_pipeline || !m_decoding)
+		return;
+
+	m_decoding = false;
+	if(m_prerolled)
+		GStreamer::setElementState(GST_ELEMENT(m_pipeline), GST_STATE_PAUSED, 0);
+}
+
+void
+GStreamerFrameCache::startPrefetch()
+{
+	const qint64 frameBytes = qint64(m_frameSize.width()) * m_frameSize.height() * 4;
+	const int frameCount = m_maxSize / frameBytes;
+	if(frameCount < 2)
+		return;
+	// stepping forwards is more common
+	const int framesBefore = frameCount / 3;
+	const int framesAfter = frameCount - framesBefore - 1;
+
+	{
+		QMutexLocker lock(&m_mutex);
+		m_center = m_requestPosition;
+		m_rangeStart = qMax(Q_INT64_C(0), m_requestPosition - framesBefore * m_frameDuration);
+		m_rangeEnd = m_requestPosition + framesAfter * m_frameDuration;
+		// widget was resized since frames were cached
+		if(!m_frames.isEmpty() && m_frames.first().size() != m_frameSize) {
+			m_frames.clear();
+			m_size = 0;
+		}
+		trim();
+	}
+
+	// nothing to do if the whole range is cached already
+	qint64 frameTime;
+	QImage image;
+	const int neededBefore = (m_requestPosition - m_rangeStart) / m_frameDuration;
+	if(frame(m_requestPosition, 0, &frameTime, &image)
+			&& framesAvailable(m_requestPosition, -1) >= neededBefore - 1
+			&& framesAvailable(m_requestPosition, 1) >= framesAfter - 1)
+		return;
+
+	GstCaps *caps = gst_caps_new_simple("video/x-raw",
+			"format", G_TYPE_STRING, "BGRx",
+			"width", G_TYPE_INT, m_frameSize.width(),
+			"height", G_TYPE_INT, m_frameSize.height(),
+			NULL);
+	g_object_set(G_OBJECT(m_filter), "caps", caps, NULL);
+	gst_caps_unref(caps);
+
+	m_decoding = true;
+	if(m_prerolled)
+		seekPipeline();
+	else // seek is performed once the pipeline is prerolled
+		GStreamer::setElementState(GST_ELEMENT(m_pipeline), GST_STATE_PAUSED, 0);
+}
+
+void
+GStreamerFrameCache::seekPipeline()
+{
+	// decoding stops at the end of requested range
+	gst_element_seek(GST_ELEMENT(m_pipeline), 1.0,
+		GST_FORMAT_TIME, (GstSeekFlags)(GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE),
+		GST_SEEK_TYPE_SET, m_rangeStart * GST_USECOND,
+		GST_SEEK_TYPE_SET, (m_rangeEnd + m_frameDuration) * GST_USECOND);
+	GStreamer::setElementState(GST_ELEMENT(m_pipeline), GST_STATE_PLAYING, 0);
+}
+
+void
+GStreamerFrameCache::trim()
+{
+	// frames farthest from requested position are dropped first
+	while(m_size > m_maxSize && !m_frames.isEmpty()) {
+		QMap<qint64, QImage>::iterator first = m_frames.begin();
+		QMap<qint64, QImage>::iterator last = m_frames.end() - 1;
+		QMap<qint64, QImage>::iterator drop = m_center - first.key() > last.key() - m_center ? first : last;
+		m_size -= drop.value().byteCount();
+		m_frames.erase(drop);
+	}
+}
+
+QMap<qint64, QImage>::const_iterator
+GStreamerFrameCache::frameAt(qint64 usecPosition) const
+{
+	QMap<qint64, QImage>::const_iterator it = m_frames.upperBound(usecPosition + POSITION_TOLERANCE);
+	if(it == m_frames.constBegin())
+		return m_frames.constEnd();
+	--it;
+	if(usecPosition - it.key() > m_frameDuration * 3 / 2)
+		return m_frames.constEnd();
+	return it;
+}
+
+bool
+GStreamerFrameCache::frame(qint64 usecPosition, int frames, qint64 *frameTime, QImage *image) const
+{
+	QMutexLocker lock(&m_mutex);
+
+	QMap<qint64, QImage>::const_iterator it = frameAt(usecPosition);
+	if(it == m_frames.constEnd())
+		return false;
+
+	// frames in between have to be cached, otherwise some would be skipped
+	const qint64 maxGap = m_frameDuration * 3 / 2;
+	for(; frames > 0; frames--) {
+		QMap<qint64, QImage>::const_iterator next = it + 1;
+		if(next == m_frames.constEnd() || next.key() - it.key() > maxGap)
+			return false;
+		it = next;
+	}
+	for(; frames < 0; frames++) {
+		if(it == m_frames.constBegin() || it.key() - (it - 1).key() > maxGap)
+			return false;
+		--it;
+	}
+
+	*frameTime = it.key();
+	*image = it.value();
+	return true;
+}
+
+int
+GStreamerFrameCache::framesAvailable(qint64 usecPosition, int direction) const
+{
+	QMutexLocker lock(&m_mutex);
+
+	QMap<qint64, QImage>::const_iterator it = frameAt(usecPosition);
+	if(it == m_frames.constEnd())
+		return 0;
+
+	const qint64 maxGap = m_frameDuration * 3 / 2;
+	int available = 0;
+	if(direction > 0) {
+		for(QMap<qint64, QImage>::const_iterator next = it + 1; next != m_frames.constEnd() && next.key() - it.key() <= maxGap; it = next++)
+			available++;
+	} else {
+		for(; it != m_frames.constBegin() && it.key() - (it - 1).key() <= maxGap; --it)
+			available++;
+	}
+	return available;
+}
+
+/*static*/ void
+GStreamerFrameCache::onFrameReady(GstElement */*fakesink*/, GstBuffer *buffer, GstPad *pad, gpointer userData)
+{
+	// called from streaming thread
+	GStreamerFrameCache *me = reinterpret_cast<GStreamerFrameCache *>(userData);
+
+	// frames are looked up by player positions, which are stream times
+	const GstClockTime streamTime = GStreamer::streamTime(pad, GST_BUFFER_PTS(buffer));
+	if(!GST_CLOCK_TIME_IS_VALID(streamTime))
+		return;
+	const qint64 time = streamTime / GST_USECOND;
+
+	{
+		QMutexLocker lock(&me->m_mutex);
+		if(time < me->m_rangeStart || time > me->m_rangeEnd || me->m_frames.contains(time))
+			return;
+	}
+
+	GstCaps *caps = gst_pad_get_current_caps(pad);
+	if(!caps)
+		return;
+	gint width = 0, height = 0;
+	const GstStructure *capsStruct = gst_caps_get_structure(caps, 0);
+	gst_structure_get_int(capsStruct, "width", &width);
+	gst_structure_get_int(capsStruct, "height", &height);
+	gst_caps_unref(caps);
+
+	// BGRx rows are never padded
+	const int stride = width * 4;
+	GstMapInfo map;
+	if(width <= 0 || height <= 0 || !gst_buffer_map(buffer, &map, GST_MAP_READ))
+		return;
+	if(map.size < gsize(stride * height)) {
+		gst_buffer_unmap(buffer, &map);
+		return;
+	}
+	QImage image(width, height, QImage::Format_RGB32);
+	for(int y = 0; y < height; y++)
+		std::memcpy(image.scanLine(y), map.data + y * stride, stride);
+	gst_buffer_unmap(buffer, &map);
+
+	QMutexLocker lock(&me->m_mutex);
+	me->m_frames.insert(time, image);
+	me->m_size += image.byteCount();
+	me->trim();
+}
+
+/*static*/ GstBusSyncReply
+GStreamerFrameCache::busSyncHandler(GstBus */*bus*/, GstMessage *msg, gpointer userData)
+{
+	// called from streaming threads
+	GStreamerFrameCache *me = reinterpret_cast<GStreamerFrameCache *>(userData);
+
+	if(GST_MESSAGE_TYPE(msg) != GST_MESSAGE_ERROR && GST_MESSAGE_SRC(msg) != GST_OBJECT(me->m_pipeline))
+		return GST_BUS_DROP;
+
+	if(me->m_busMessagesPending.testAndSetOrdered(0, 1))
+		QMetaObject::invokeMethod(me, "onBusMessages", Qt::QueuedConnection);
+
+	return GST_BUS_PASS;
+}
+
+void
+GStreamerFrameCache::onBusMessages()
+{
+	m_busMessagesPending = 0;
+
+	bool failed = false;
+	GstMessage *msg;
+	while(!failed && m_pipeline && m_pipelineBus && (msg = gst_bus_pop(m_pipelineBus))) {
+		switch(GST_MESSAGE_TYPE(msg)) {
+		case GST_MESSAGE_ASYNC_DONE:
+			if(!m_prerolled) {
+				m_prerolled = true;
+				if(m_decoding)
+					seekPipeline();
+			}
+			break;
+
+		case GST_MESSAGE_EOS:
+			// requested range was decoded
+			if(m_decoding) {
+				m_decoding = false;
+				GStreamer::setElementState(GST_ELEMENT(m_pipeline), GST_STATE_PAUSED, 0);
+			}
+			break;
+
+		case GST_MESSAGE_ERROR: {
+			gchar *debug = NULL;
+			GError *error = NULL;
+			gst_message_parse_error(msg, &error, &debug);
+			qWarning() << "Frame cache decoding failed:" << error->message;
+			g_error_free(error);
+			g_free(debug);
+			failed = true;
+			break;
+		}
+
+		default:
+			break;
+		}
+
+		gst_message_unref(msg);
+	}
+
+	// frame stepping will seek in playback pipeline instead
+	if(failed)
+		close();
+}
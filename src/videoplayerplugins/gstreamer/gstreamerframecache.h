@@ -0,0 +1,107 @@
+#ifndef GSTREAMERFRAMECACHE_H
+#define GSTREAMERFRAMECACHE_H
+/**
+ * Copyright (C) 2010-2017 Mladen Milinkovic <max@smoothware.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <QObject>
+#include <QAtomicInt>
+#include <QImage>
+#include <QMap>
+#include <QMutex>
+#include <QSize>
+#include <QString>
+
+#include <gst/gst.h>
+
+namespace SubtitleComposer {
+/**
+ * @brief Decoded video frames around paused position used for instant frame stepping.
+ *
+ * Frames are decoded by a separate video only pipeline, so playback pipeline is not
+ * disturbed. Decoding runs in background while playback is paused, frames are scaled
+ * to the size they're displayed at and kept within configured memory budget, frames
+ * farthest from the requested position are dropped first. All times are in microseconds.
+ */
+class GStreamerFrameCache : public QObject
+{
+	Q_OBJECT
+
+public:
+	explicit GStreamerFrameCache(QObject *parent = Q_NULLPTR);
+	virtual ~GStreamerFrameCache();
+
+	bool open(const QString &uri);
+	void close();
+
+	/// memory budget in bytes, zero disables the cache
+	void setMaxSize(qint64 bytes);
+
+	/**
+	 * @brief Starts decoding frames surrounding @p usecPosition which aren't cached yet
+	 * @param frameDuration expected distance of frames in microseconds
+	 * @param frameSize size at which frames are displayed
+	 */
+	void prefetch(qint64 usecPosition, qint64 frameDuration, const QSize &frameSize);
+	/// stops background decoding, cached frames are kept
+	void cancel();
+
+	/**
+	 * @brief Finds frame that is @p frames away from the frame shown at @p usecPosition
+	 * @return false if that frame or any frame in between is not cached
+	 */
+	bool frame(qint64 usecPosition, int frames, qint64 *frameTime, QImage *image) const;
+	/// @return number of consecutive cached frames following (or preceding if @p direction is negative) @p usecPosition
+	int framesAvailable(qint64 usecPosition, int direction) const;
+
+private slots:
+	void onBusMessages();
+
+private:
+	static GstBusSyncReply busSyncHandler(GstBus *bus, GstMessage *msg, gpointer userData);
+	static void onFrameReady(GstElement *fakesink, GstBuffer *buffer, GstPad *pad, gpointer userData);
+
+	void startPrefetch();
+	void seekPipeline();
+	void trim();
+
+	QMap<qint64, QImage>::const_iterator frameAt(qint64 usecPosition) const;
+
+private:
+	GstPipeline *m_pipeline;
+	GstBus *m_pipelineBus;
+	GstElement *m_filter;                   // caps of decoded frames, playbin contains it only after PAUSED
+	QAtomicInt m_busMessagesPending;
+	bool m_prerolled;
+	bool m_decoding;
+
+	qint64 m_maxSize;
+	qint64 m_requestPosition;
+	qint64 m_frameDuration;
+	QSize m_frameSize;
+
+	mutable QMutex m_mutex;                 // guards everything below, frames are added from GStreamer thread
+	QMap<qint64, QImage> m_frames;
+	qint64 m_size;
+	qint64 m_center;
+	qint64 m_rangeStart;
+	qint64 m_rangeEnd;
+};
+}
+
+#endif // GSTREAMERFRAMECACHE_H
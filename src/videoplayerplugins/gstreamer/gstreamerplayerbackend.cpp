@@ -20,6 +20,7 @@
 
 #include "gstreamerplayerbackend.h"
 #include "gstreamerconfigwidget.h"
+#include "gstreamerframecache.h"
 #include "../scconfigdummy.h"
 #include "../../streamprocessor/gstreamer.h"
 #include "../../common/languagecode.h"
@@ -28,6 +29,7 @@
 
 #include <QTimer>
 #include <QtMath>
+#include <QLabel>
 
 #include <QDebug>
 #include <QUrl>
@@ -43,58 +45,33 @@
 
 #define MAX_VOLUME 3.548
 
-using namespace SubtitleComposer;
+// while playing position is interpolated by VideoPlayer, pipeline is queried only to correct drift
+#define POSITION_RESYNC_INTERVAL 500
 
-#ifndef __GST_PLAY_ENUM_H__
-/**
- * GstPlayFlags:
- * @GST_PLAY_FLAG_VIDEO: Enable rendering of the video stream
- * @GST_PLAY_FLAG_AUDIO: Enable rendering of the audio stream
- * @GST_PLAY_FLAG_TEXT: Enable rendering of subtitles
- * @GST_PLAY_FLAG_VIS: Enable rendering of visualisations when there is
- *       no video stream.
- * @GST_PLAY_FLAG_SOFT_VOLUME: Use software volume
- * @GST_PLAY_FLAG_NATIVE_AUDIO: only allow native audio formats, this omits
- *   configuration of audioconvert and audioresample.
- * @GST_PLAY_FLAG_NATIVE_VIDEO: only allow native video formats, this omits
- *   configuration of videoconvert and videoscale.
- * @GST_PLAY_FLAG_DOWNLOAD: enable progressice download buffering for selected
- *   formats.
- * @GST_PLAY_FLAG_BUFFERING: enable buffering of the demuxed or parsed data.
- * @GST_PLAY_FLAG_DEINTERLACE: deinterlace raw video (if native not forced).
- * @GST_PLAY_FLAG_FORCE_FILTERS: force audio/video filters to be applied if
- *   set.
- *
- * Extra flags to configure the behaviour of the sinks.
- */
-typedef enum {
-  GST_PLAY_FLAG_VIDEO         = (1 << 0),
-  GST_PLAY_FLAG_AUDIO         = (1 << 1),
-  GST_PLAY_FLAG_TEXT          = (1 << 2),
-  GST_PLAY_FLAG_VIS           = (1 << 3),
-  GST_PLAY_FLAG_SOFT_VOLUME   = (1 << 4),
-  GST_PLAY_FLAG_NATIVE_AUDIO  = (1 << 5),
-  GST_PLAY_FLAG_NATIVE_VIDEO  = (1 << 6),
-  GST_PLAY_FLAG_DOWNLOAD      = (1 << 7),
-  GST_PLAY_FLAG_BUFFERING     = (1 << 8),
-  GST_PLAY_FLAG_DEINTERLACE   = (1 << 9),
-  GST_PLAY_FLAG_SOFT_COLORBALANCE = (1 << 10),
-  GST_PLAY_FLAG_FORCE_FILTERS = (1 << 11),
-} GstPlayFlags;
-#endif /* __GST_PLAY_ENUM_H__ */
+// frame cache is refilled around current position when fewer frames remain in stepping direction
+#define PREFETCH_MARGIN 5
+
+using namespace SubtitleComposer;
 
 GStreamerPlayerBackend::GStreamerPlayerBackend()
 	: PlayerBackend(),
 	m_pipeline(NULL),
 	m_pipelineBus(NULL),
-	m_pipelineTimer(new QTimer(this)),
+	m_positionTimer(new QTimer(this)),
+	m_busMessagesPending(0),
 	m_lengthInformed(false),
 	m_playbackRate(1.),
 	m_volume(.0),
-	m_muted(true)
+	m_muted(true),
+	m_loopStart(-1),
+	m_loopEnd(-1),
+	m_frameCache(new GStreamerFrameCache(this)),
+	m_stillFrame(NULL),
+	m_stillFrameTime(-1)
 {
 	m_name = QStringLiteral("GStreamer");
-	connect(m_pipelineTimer, SIGNAL(timeout()), this, SLOT(onPlaybinTimerTimeout()));
+	m_positionTimer->setInterval(POSITION_RESYNC_INTERVAL);
+	connect(m_positionTimer, SIGNAL(timeout()), this, SLOT(onPositionTimerTimeout()));
 }
 
 GStreamerPlayerBackend::~GStreamerPlayerBackend()
@@ -118,13 +95,22 @@ GStreamerPlayerBackend::initialize(VideoWidget *videoWidget)
 	QWidget *videoLayer = new QWidget();
 	videoWidget->setVideoLayer(videoLayer);
 	videoLayer->installEventFilter(this);
-	onPlaybinTimerTimeout();
+
+	// native child window stays above the video drawn by the sink
+	m_stillFrame = new QLabel(videoLayer);
+	m_stillFrame->setAttribute(Qt::WA_NativeWindow);
+	m_stillFrame->setAttribute(Qt::WA_TransparentForMouseEvents);
+	m_stillFrame->setScaledContents(true);
+	m_stillFrame->hide();
 	return true;
 }
 
 void
 GStreamerPlayerBackend::finalize()
 {
+	// still frame is destroyed together with video layer
+	m_stillFrame = NULL;
+	m_stillFrameTime = -1;
 	return GStreamer::deinit();
 }
 
@@ -234,11 +220,18 @@ GStreamerPlayerBackend::openFile(const QString &filePath, bool &playingAfterCall
 	g_object_set(G_OBJECT(m_pipeline), "audio-sink", audiobin, NULL);
 	g_object_set(G_OBJECT(m_pipeline), "video-sink", videosink, NULL);
 
+	// bus messages and property changes wake us up instead of polling the pipeline
+	m_busMessagesPending = 0;
 	m_pipelineBus = gst_pipeline_get_bus(GST_PIPELINE(m_pipeline));
-	m_pipelineTimer->start(20);
+	gst_bus_set_sync_handler(m_pipelineBus, &GStreamerPlayerBackend::busSyncHandler, this, NULL);
+	g_signal_connect(G_OBJECT(m_pipeline), "notify::volume", G_CALLBACK(&GStreamerPlayerBackend::onVolumeNotify), this);
+	g_signal_connect(G_OBJECT(m_pipeline), "notify::mute", G_CALLBACK(&GStreamerPlayerBackend::onVolumeNotify), this);
 
 	setupVideoOverlay();
 
+	m_frameCache->setMaxSize(qint64(SCConfig::gstFrameCacheSize()) * 1024 * 1024);
+	m_frameCache->open(fileUrl.url());
+
 	GStreamer::setElementState(GST_ELEMENT(m_pipeline), GST_STATE_PLAYING, 0);
 
 	return true;
@@ -247,8 +240,14 @@ GStreamerPlayerBackend::openFile(const QString &filePath, bool &playingAfterCall
 void
 GStreamerPlayerBackend::closeFile()
 {
+	hideStillFrame();
+	m_frameCache->close();
+	m_loopStart = m_loopEnd = -1;
+
 	if(m_pipeline) {
-		m_pipelineTimer->stop();
+		m_positionTimer->stop();
+		gst_bus_set_sync_handler(m_pipelineBus, NULL, NULL, NULL);
+		g_signal_handlers_disconnect_by_data(G_OBJECT(m_pipeline), this);
 		GStreamer::setElementState(GST_ELEMENT(m_pipeline), GST_STATE_NULL, INFINITE_WAIT);
 		GStreamer::freePipeline(&m_pipeline, &m_pipelineBus);
 	}
@@ -257,6 +256,13 @@ GStreamerPlayerBackend::closeFile()
 bool
 GStreamerPlayerBackend::play()
 {
+	m_frameCache->cancel();
+	if(m_stillFrameTime >= 0) {
+		// playback pipeline didn't follow steps served from frame cache
+		seekPipeline(m_playbackRate, m_stillFrameTime * GST_USECOND, GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE);
+		hideStillFrame();
+	}
+
 	setupVideoOverlay();
 	GStreamer::setElementState(GST_ELEMENT(m_pipeline), GST_STATE_PLAYING, 0);
 
@@ -274,14 +280,52 @@ GStreamerPlayerBackend::pause()
 bool
 GStreamerPlayerBackend::seek(double seconds, bool accurate)
 {
-	gst_element_seek(GST_ELEMENT(m_pipeline), m_playbackRate,
-		GST_FORMAT_TIME, (GstSeekFlags)(GST_SEEK_FLAG_FLUSH | (accurate ? GST_SEEK_FLAG_ACCURATE : GST_SEEK_FLAG_KEY_UNIT)),
-		GST_SEEK_TYPE_SET, (gint64)(seconds * GST_SECOND),
-		GST_SEEK_TYPE_NONE, GST_CLOCK_TIME_NONE);
+	hideStillFrame();
+
+	seekPipeline(m_playbackRate, (gint64)(seconds * GST_SECOND), GST_SEEK_FLAG_FLUSH | (accurate ? GST_SEEK_FLAG_ACCURATE : GST_SEEK_FLAG_KEY_UNIT));
+
+	return true;
+}
+
+/*virtual*/ bool
+GStreamerPlayerBackend::setLoop(double start, double end)
+{
+	hideStillFrame();
+
+	if(end < 0.) {
+		m_loopStart = m_loopEnd = -1;
+		// stop of the current segment can only be removed by flushing seek
+		gint64 time;
+		if(gst_element_query_position(GST_ELEMENT(m_pipeline), GST_FORMAT_TIME, &time))
+			seekPipeline(m_playbackRate, time, GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE);
+		return true;
+	}
+
+	m_loopStart = (gint64)(start * GST_SECOND);
+	m_loopEnd = (gint64)(end * GST_SECOND);
+	seekPipeline(m_playbackRate, m_loopStart, GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE);
 
 	return true;
 }
 
+void
+GStreamerPlayerBackend::seekPipeline(gdouble rate, gint64 time, int flags)
+{
+	if(m_loopEnd < 0) {
+		gst_element_seek(GST_ELEMENT(m_pipeline), rate,
+			GST_FORMAT_TIME, (GstSeekFlags)flags,
+			GST_SEEK_TYPE_SET, time,
+			GST_SEEK_TYPE_NONE, GST_CLOCK_TIME_NONE);
+		return;
+	}
+
+	// segment seek keeps the loop end, pipeline posts SEGMENT_DONE instead of EOS when it's reached
+	gst_element_seek(GST_ELEMENT(m_pipeline), rate,
+		GST_FORMAT_TIME, (GstSeekFlags)(flags | GST_SEEK_FLAG_SEGMENT),
+		GST_SEEK_TYPE_SET, qBound(m_loopStart, time, m_loopEnd),
+		GST_SEEK_TYPE_SET, m_loopEnd);
+}
+
 /*virtual*/ void
 GStreamerPlayerBackend::playbackRate(double newRate)
 {
@@ -291,16 +335,84 @@ GStreamerPlayerBackend::playbackRate(double newRate)
 	if(gst_element_query_position(GST_ELEMENT(m_pipeline), GST_FORMAT_TIME, &time)) {
 		setPlayerPosition((double)time / GST_SECOND);
 
-		gst_element_seek(GST_ELEMENT(m_pipeline), newRate,
-			GST_FORMAT_TIME, (GstSeekFlags)(GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE),
-			GST_SEEK_TYPE_SET, time, // we need to set the time otherwise playback will jump
-			GST_SEEK_TYPE_NONE, GST_CLOCK_TIME_NONE);
+		// we need to set the time otherwise playback will jump
+		seekPipeline(newRate, time, GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE);
 	}
+
+	playbackRateNotify(newRate);
+}
+
+/*virtual*/ bool
+GStreamerPlayerBackend::step(int frames)
+{
+	gint64 time;
+	qint64 position = m_stillFrameTime;
+	if(position < 0 && gst_element_query_position(GST_ELEMENT(m_pipeline), GST_FORMAT_TIME, &time))
+		position = time / GST_USECOND;
+
+	qint64 frameTime;
+	QImage image;
+	if(position < 0 || !m_frameCache->frame(position, frames, &frameTime, &image))
+		return PlayerBackend::step(frames);
+
+	showStillFrame(frameTime, image);
+	setPlayerPosition(frameTime / 1e6);
+
+	if(m_frameCache->framesAvailable(frameTime, frames) < PREFETCH_MARGIN)
+		prefetchFrames();
+
+	return true;
+}
+
+void
+GStreamerPlayerBackend::prefetchFrames()
+{
+	if(!m_pipeline || !m_stillFrame)
+		return;
+
+	qint64 position = m_stillFrameTime;
+	gint64 time;
+	if(position < 0 && gst_element_query_position(GST_ELEMENT(m_pipeline), GST_FORMAT_TIME, &time))
+		position = time / GST_USECOND;
+	if(position < 0)
+		return;
+
+	const double fps = player()->framesPerSecond();
+	const qint64 frameDuration = fps > 0. ? qint64(1e6 / fps) : 40000;
+	const QWidget *videoLayer = m_stillFrame->parentWidget();
+	m_frameCache->prefetch(position, frameDuration, videoLayer->size() * videoLayer->devicePixelRatioF());
+}
+
+void
+GStreamerPlayerBackend::showStillFrame(qint64 frameTime, const QImage &image)
+{
+	m_stillFrameTime = frameTime;
+	if(!m_stillFrame)
+		return;
+
+	m_stillFrame->setPixmap(QPixmap::fromImage(image));
+	m_stillFrame->setGeometry(m_stillFrame->parentWidget()->rect());
+	m_stillFrame->show();
+}
+
+void
+GStreamerPlayerBackend::hideStillFrame()
+{
+	m_stillFrameTime = -1;
+	if(!m_stillFrame)
+		return;
+
+	m_stillFrame->hide();
+	m_stillFrame->clear();
 }
 
 bool
 GStreamerPlayerBackend::stop()
 {
+	hideStillFrame();
+	m_frameCache->cancel();
+	m_loopStart = m_loopEnd = -1;
+
 	GStreamer::setElementState(GST_ELEMENT(m_pipeline), GST_STATE_READY, 0);
 
 	return true;
@@ -323,19 +435,84 @@ GStreamerPlayerBackend::setVolume(double volume)
 	return true;
 }
 
+/*static*/ GstBusSyncReply
+GStreamerPlayerBackend::busSyncHandler(GstBus */*bus*/, GstMessage *msg, gpointer userData)
+{
+	// called from streaming threads
+	GStreamerPlayerBackend *backend = reinterpret_cast<GStreamerPlayerBackend *>(userData);
+
+	// we are only interested in error messages or messages directed to the playbin
+	if(GST_MESSAGE_TYPE(msg) != GST_MESSAGE_ERROR && GST_MESSAGE_SRC(msg) != GST_OBJECT(backend->m_pipeline))
+		return GST_BUS_DROP;
+
+	// main thread is woken up once for all messages that got queued until it handles them
+	if(backend->m_busMessagesPending.testAndSetOrdered(0, 1))
+		QMetaObject::invokeMethod(backend, "onBusMessages", Qt::QueuedConnection);
+
+	return GST_BUS_PASS;
+}
+
+/*static*/ void
+GStreamerPlayerBackend::onVolumeNotify(GObject */*object*/, GParamSpec */*pspec*/, gpointer userData)
+{
+	QMetaObject::invokeMethod(reinterpret_cast<GStreamerPlayerBackend *>(userData), "updateVolume", Qt::QueuedConnection);
+}
+
 void
-GStreamerPlayerBackend::onPlaybinTimerTimeout()
+GStreamerPlayerBackend::onPositionTimerTimeout()
 {
-	if(!isInitialized() || !m_pipeline || !m_pipelineBus)
+	updatePosition();
+}
+
+void
+GStreamerPlayerBackend::updatePosition()
+{
+	if(!isInitialized() || !m_pipeline)
+		return;
+
+	// playback pipeline stays where it was while stepping through cached frames
+	if(m_stillFrameTime >= 0) {
+		setPlayerPosition(m_stillFrameTime / 1e6);
+		return;
+	}
+
+	gint64 time;
+	if(gst_element_query_position(GST_ELEMENT(m_pipeline), GST_FORMAT_TIME, &time))
+		setPlayerPosition((double)time / GST_SECOND);
+}
+
+void
+GStreamerPlayerBackend::updateLength()
+{
+	if(!isInitialized() || !m_pipeline || m_lengthInformed)
 		return;
 
 	gint64 time;
-	if(!m_lengthInformed && gst_element_query_duration(GST_ELEMENT(m_pipeline), GST_FORMAT_TIME, &time) && GST_CLOCK_TIME_IS_VALID(time)) {
+	if(gst_element_query_duration(GST_ELEMENT(m_pipeline), GST_FORMAT_TIME, &time) && GST_CLOCK_TIME_IS_VALID(time)) {
 		setPlayerLength((double)time / GST_SECOND);
 		m_lengthInformed = true;
 	}
-	if(gst_element_query_position(GST_ELEMENT(m_pipeline), GST_FORMAT_TIME, &time))
-		setPlayerPosition((double)time / GST_SECOND);
+}
+
+void
+GStreamerPlayerBackend::updatePlaybackRate()
+{
+	if(!isInitialized() || !m_pipeline)
+		return;
+
+	GstQuery *rateQuery = gst_query_new_segment(GST_FORMAT_DEFAULT);
+	if(gst_element_query(GST_ELEMENT(m_pipeline), rateQuery)) {
+		gst_query_parse_segment(rateQuery, &m_playbackRate, NULL, NULL, NULL);
+		playbackRateNotify(m_playbackRate);
+	}
+	gst_query_unref(rateQuery);
+}
+
+void
+GStreamerPlayerBackend::updateVolume()
+{
+	if(!isInitialized() || !m_pipeline)
+		return;
 
 	gboolean muted = false;
 	g_object_get(G_OBJECT(m_pipeline), "mute", &muted, NULL);
@@ -351,24 +528,18 @@ GStreamerPlayerBackend::onPlaybinTimerTimeout()
 			setPlayerVolume(qPow(volume / MAX_VOLUME, .33333) * 100.);
 		}
 	}
+}
 
-	GstQuery *rateQuery = gst_query_new_segment(GST_FORMAT_DEFAULT);
-	if(gst_element_query(GST_ELEMENT(m_pipeline), rateQuery)) {
-		gst_query_parse_segment(rateQuery, &m_playbackRate, NULL, NULL, NULL);
-		playbackRateNotify(m_playbackRate);
-	}
-	gst_query_unref(rateQuery);
+void
+GStreamerPlayerBackend::onBusMessages()
+{
+	m_busMessagesPending = 0;
+
+	if(!isInitialized() || !m_pipeline || !m_pipelineBus)
+		return;
 
 	GstMessage *msg;
 	while(m_pipeline && m_pipelineBus && (msg = gst_bus_pop(m_pipelineBus))) {
-		GstObject *src = GST_MESSAGE_SRC(msg);
-
-		// we are only interested in error messages or messages directed to the playbin
-		if(GST_MESSAGE_TYPE(msg) != GST_MESSAGE_ERROR && src != GST_OBJECT(m_pipeline)) {
-			gst_message_unref(msg);
-			continue;
-		}
-
 #if defined(VERBOSE) || !defined(NDEBUG)
 		GStreamer::inspectMessage(msg);
 #endif
@@ -390,9 +561,45 @@ GStreamerPlayerBackend::onPlaybinTimerTimeout()
 				updateAudioData();
 				updateVideoData();
 			}
+
+			if(current == GST_STATE_PLAYING)
+				m_positionTimer->start();
+			else
+				m_positionTimer->stop();
+
+			if(current != GST_STATE_PAUSED)
+				m_frameCache->cancel();
+
+			updateLength();
+			updatePosition();
+			break;
+		}
+
+		case GST_MESSAGE_ASYNC_DONE: {
+			// preroll or seek has finished
+			updateLength();
+			updatePosition();
+			updatePlaybackRate();
+
+			// paused video is likely to be stepped through
+			GstState state = GST_STATE_VOID_PENDING;
+			if(gst_element_get_state(GST_ELEMENT(m_pipeline), &state, NULL, 0) == GST_STATE_CHANGE_SUCCESS && state == GST_STATE_PAUSED)
+				prefetchFrames();
 			break;
 		}
 
+		case GST_MESSAGE_SEGMENT_DONE:
+			// non-flushing seek continues right after the data already queued in sinks, there's
+			// no preroll and the loop restarts without a gap
+			if(m_loopEnd >= 0)
+				seekPipeline(m_playbackRate, m_loopStart, GST_SEEK_FLAG_ACCURATE);
+			break;
+
+		case GST_MESSAGE_DURATION_CHANGED:
+			m_lengthInformed = false;
+			updateLength();
+			break;
+
 		case GST_MESSAGE_ERROR: {
 			gchar *debug = NULL;
 			GError *error = NULL;
@@ -531,6 +738,9 @@ GStreamerPlayerBackend::eventFilter(QObject *obj, QEvent *event)
 {
 	bool res = QObject::eventFilter(obj, event);
 
+	if(m_stillFrame && event->type() == QEvent::Resize)
+		m_stillFrame->setGeometry(QRect(QPoint(0, 0), static_cast<QResizeEvent *>(event)->size()));
+
 	if(m_pipeline && GST_IS_VIDEO_OVERLAY(m_pipeline) && (event->type() == QEvent::Resize || event->type() == QEvent::Move)) {
 		QResizeEvent *evt = static_cast<QResizeEvent *>(event);
 		if(evt->size().width() > 0 && evt->size().height() > 0)
@@ -576,7 +786,7 @@ GStreamerPlayerBackend::reconfigure()
 	GStreamer::setElementState(GST_ELEMENT(m_pipeline), GST_STATE_NULL, INFINITE_WAIT);
 	if(state == GST_STATE_PLAYING || state == GST_STATE_PAUSED) {
 		GStreamer::setElementState(GST_ELEMENT(m_pipeline), GST_STATE_PLAYING, INFINITE_WAIT);
-		onPlaybinTimerTimeout();
+		onBusMessages();
 		seek((double)time / GST_SECOND, true);
 		if(state == GST_STATE_PAUSED)
 			GStreamer::setElementState(GST_ELEMENT(m_pipeline), GST_STATE_PAUSED, INFINITE_WAIT);
@@ -25,16 +25,21 @@
 
 #include <QWidget>
 #include <QString>
+#include <QAtomicInt>
+#include <QImage>
 
 #include <gst/gst.h>
 
 QT_FORWARD_DECLARE_CLASS(QTimer)
+QT_FORWARD_DECLARE_CLASS(QLabel)
 
 namespace SubtitleComposer {
+class GStreamerFrameCache;
+
 class GStreamerPlayerBackend : public PlayerBackend
 {
 	Q_OBJECT
-	Q_PLUGIN_METADATA(IID PlayerBackend_iid)
+	Q_PLUGIN_METADATA(IID PlayerBackend_iid FILE "gstplayer.json")
 	Q_INTERFACES(SubtitleComposer::PlayerBackend)
 
 public:
@@ -59,6 +64,8 @@ protected:
 	virtual bool play();
 	virtual bool pause();
 	virtual bool seek(double seconds, bool accurate);
+	virtual bool step(int frames);
+	virtual bool setLoop(double start, double end);
 	virtual bool stop();
 
 	virtual void playbackRate(double newRate);
@@ -70,11 +77,26 @@ protected:
 	bool eventFilter(QObject *obj, QEvent *event);
 
 protected slots:
-	void onPlaybinTimerTimeout();
+	void onBusMessages();
+	void onPositionTimerTimeout();
+	void updateVolume();
 
 private:
+	static GstBusSyncReply busSyncHandler(GstBus *bus, GstMessage *msg, gpointer userData);
+	static void onVolumeNotify(GObject *object, GParamSpec *pspec, gpointer userData);
+
 	void setupVideoOverlay();
 
+	void updatePosition();
+	void updateLength();
+	void updatePlaybackRate();
+
+	void seekPipeline(gdouble rate, gint64 time, int flags);
+
+	void prefetchFrames();
+	void showStillFrame(qint64 frameTime, const QImage &image);
+	void hideStillFrame();
+
 	void updateTextData();
 	void updateAudioData();
 	void updateVideoData();
@@ -84,11 +106,19 @@ private:
 private:
 	GstPipeline *m_pipeline;
 	GstBus *m_pipelineBus;
-	QTimer *m_pipelineTimer;
+	QTimer *m_positionTimer;
+	QAtomicInt m_busMessagesPending;
 	bool m_lengthInformed;
 	gdouble m_playbackRate;
 	gdouble m_volume;
 	gboolean m_muted;
+
+	gint64 m_loopStart;                     // nanoseconds, -1 when not looping
+	gint64 m_loopEnd;
+
+	GStreamerFrameCache *m_frameCache;
+	QLabel *m_stillFrame;                   // cached frame shown over video layer after stepping
+	qint64 m_stillFrameTime;                // microseconds or -1 when video layer shows pipeline output
 };
 }
 
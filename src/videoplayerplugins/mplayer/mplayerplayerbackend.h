@@ -33,7 +33,7 @@ class MPlayerPlayerProcess;
 class MPlayerPlayerBackend : public PlayerBackend
 {
 	Q_OBJECT
-	Q_PLUGIN_METADATA(IID PlayerBackend_iid)
+	Q_PLUGIN_METADATA(IID PlayerBackend_iid FILE "mplayer.json")
 	Q_INTERFACES(SubtitleComposer::PlayerBackend)
 
 public:
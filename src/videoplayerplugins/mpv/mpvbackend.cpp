@@ -20,6 +20,7 @@
 
 #include "mpvbackend.h"
 #include "mpvconfigwidget.h"
+#include "mpvrenderwidget.h"
 
 #include "../scconfigdummy.h"
 
@@ -59,6 +60,16 @@ MPVBackend::setSCConfig(SCConfig *scConfig)
 bool
 MPVBackend::initialize(VideoWidget *videoWidget)
 {
+#ifdef MPV_SOFTWARE_RENDER
+	if(SCConfig::mpvSoftwareRender()) {
+		m_renderWidget = new MPVRenderWidget();
+		videoWidget->setVideoLayer(m_renderWidget);
+		// frames are painted by Qt, a native window would hide the subtitle overlay
+		m_renderWidget->setAttribute(Qt::WA_PaintOnScreen, false);
+		return true;
+	}
+#endif
+	m_renderWidget = Q_NULLPTR;
 	videoWidget->setVideoLayer(new QWidget());
 	return true;
 }
@@ -97,9 +108,11 @@ MPVBackend::mpvInit()
 
 	reconfigure();
 
-	// window id
-	int64_t winId = player()->videoWidget()->videoLayer()->winId();
-	mpv_set_option(m_mpv, "wid", MPV_FORMAT_INT64, &winId);
+	if(!m_renderWidget) {
+		// window id
+		int64_t winId = player()->videoWidget()->videoLayer()->winId();
+		mpv_set_option(m_mpv, "wid", MPV_FORMAT_INT64, &winId);
+	}
 
 	// no OSD
 	mpv_set_option_string(m_mpv, "osd-level", "0");
@@ -133,12 +146,18 @@ MPVBackend::mpvInit()
 	mpv_set_wakeup_callback(m_mpv, wakeup, this);
 
 	m_initialized = mpv_initialize(m_mpv) >= 0;
+	if(m_initialized && m_renderWidget && !m_renderWidget->attach(m_mpv)) {
+		qWarning() << "[MPV] software render context could not be created";
+		m_initialized = false;
+	}
 	return m_initialized;
 }
 
 void
 MPVBackend::mpvExit()
 {
+	if(m_renderWidget)
+		m_renderWidget->detach();
 	if(m_mpv) {
 		mpv_terminate_destroy(m_mpv);
 		m_mpv = NULL;
@@ -195,6 +214,8 @@ MPVBackend::mpvEventHandle(mpv_event *event)
 		break;
 	}
 	case MPV_EVENT_SHUTDOWN: {
+		if(m_renderWidget)
+			m_renderWidget->detach();
 		mpv_terminate_destroy(m_mpv);
 		m_mpv = NULL;
 		setPlayerState(VideoPlayer::Ready);
@@ -350,6 +371,8 @@ MPVBackend::closeFile()
 bool
 MPVBackend::stop()
 {
+	setLoop(-1., -1.);
+
 	const char *args[] = { "stop", NULL };
 	mpv_command_async(m_mpv, 0, args);
 	return true;
@@ -394,6 +417,21 @@ MPVBackend::seek(double seconds, bool accurate)
 	return true;
 }
 
+/*virtual*/ bool
+MPVBackend::setLoop(double start, double end)
+{
+	if(end < 0.) {
+		mpv_set_property_string(m_mpv, "ab-loop-a", "no");
+		mpv_set_property_string(m_mpv, "ab-loop-b", "no");
+		return true;
+	}
+
+	// mpv seeks back to A by itself as soon as B is reached
+	mpv_set_property(m_mpv, "ab-loop-a", MPV_FORMAT_DOUBLE, &start);
+	mpv_set_property(m_mpv, "ab-loop-b", MPV_FORMAT_DOUBLE, &end);
+	return seek(start, true);
+}
+
 /*virtual*/ void
 MPVBackend::playbackRate(double newRate)
 {
@@ -437,7 +475,10 @@ MPVBackend::reconfigure()
 	if(!m_mpv)
 		return false;
 
-	if(SCConfig::mpvVideoOutputEnabled()) {
+	if(m_renderWidget) {
+		// render API works only with libmpv video output
+		mpv_set_option_string(m_mpv, "vo", "libmpv");
+	} else if(SCConfig::mpvVideoOutputEnabled()) {
 #if MPV_CLIENT_API_VERSION >= MPV_MAKE_VERSION(1, 21)
 		if(SCConfig::mpvVideoOutput() == QStringLiteral("opengl-hq")) {
 			mpv_set_option_string(m_mpv, "vo", "opengl");
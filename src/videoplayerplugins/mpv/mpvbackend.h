@@ -25,16 +25,18 @@
 
 #include <mpv/qthelper.hpp>
 
+#include <QPointer>
 #include <QWidget>
 #include <QString>
 
 namespace SubtitleComposer {
 class MPVProcess;
+class MPVRenderWidget;
 
 class MPVBackend : public PlayerBackend
 {
 	Q_OBJECT
-	Q_PLUGIN_METADATA(IID PlayerBackend_iid)
+	Q_PLUGIN_METADATA(IID PlayerBackend_iid FILE "mpvplayer.json")
 	Q_INTERFACES(SubtitleComposer::PlayerBackend)
 
 public:
@@ -57,6 +59,7 @@ protected:
 	virtual bool play();
 	virtual bool pause();
 	virtual bool seek(double seconds, bool accurate);
+	virtual bool setLoop(double start, double end);
 	virtual bool stop();
 
 	virtual void playbackRate(double newRate);
@@ -91,6 +94,7 @@ private:
 protected:
 	mpv_handle *m_mpv;
 	bool m_initialized;
+	QPointer<MPVRenderWidget> m_renderWidget;    // owned by VideoWidget, null unless rendering in software
 	QString m_currentFilePath;
 };
 }
@@ -0,0 +1,213 @@
+/**
+ * Copyright (C) 2010-2017 Mladen Milinkovic <max@smoothware.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "mpvrenderwidget.h"
+
+#ifdef MPV_SOFTWARE_RENDER
+#include <mpv/render.h>
+#endif
+
+#include <QLoggingCategory>
+#include <QPainter>
+
+// frame timing statistics are logged with QT_LOGGING_RULES="subtitlecomposer.mpv.stats.debug=true"
+Q_LOGGING_CATEGORY(mpvStats, "subtitlecomposer.mpv.stats", QtWarningMsg)
+
+using namespace SubtitleComposer;
+
+MPVRenderWidget::MPVRenderWidget(QWidget *parent)
+	: QWidget(parent),
+	  m_renderContext(Q_NULLPTR),
+	  m_renderPending(0),
+	  m_forceRender(false),
+	  m_displayed(0),
+	  m_painted(true),
+	  m_statsFrames(0),
+	  m_statsDropped(0),
+	  m_statsRenderTotal(0),
+	  m_statsRenderMax(0)
+{
+}
+
+MPVRenderWidget::~MPVRenderWidget()
+{
+	detach();
+}
+
+bool
+MPVRenderWidget::attach(mpv_handle *mpv)
+{
+	detach();
+
+#ifdef MPV_SOFTWARE_RENDER
+	mpv_render_param params[] = {
+		{ MPV_RENDER_PARAM_API_TYPE, const_cast<char *>(MPV_RENDER_API_TYPE_SW) },
+		{ MPV_RENDER_PARAM_INVALID, Q_NULLPTR }
+	};
+	if(mpv_render_context_create(&m_renderContext, mpv, params) < 0) {
+		m_renderContext = Q_NULLPTR;
+		return false;
+	}
+
+	m_statsTimer.start();
+	mpv_render_context_set_update_callback(m_renderContext, onUpdate, this);
+	return true;
+#else
+	Q_UNUSED(mpv);
+	return false;
+#endif
+}
+
+void
+MPVRenderWidget::detach()
+{
+#ifdef MPV_SOFTWARE_RENDER
+	if(m_renderContext) {
+		// blocks until mpv stops calling onUpdate()
+		mpv_render_context_free(m_renderContext);
+		m_renderContext = Q_NULLPTR;
+	}
+#endif
+	for(int i = 0; i < FRAME_POOL_SIZE; i++)
+		m_frames[i] = QImage();
+	update();
+}
+
+/*static*/ void
+MPVRenderWidget::onUpdate(void *ctx)
+{
+	// called from mpv thread, rendering is done in GUI thread
+	MPVRenderWidget *me = reinterpret_cast<MPVRenderWidget *>(ctx);
+	me->requestRender(false);
+}
+
+void
+MPVRenderWidget::requestRender(bool force)
+{
+	if(force)
+		m_forceRender = true;
+	// multiple updates before the queued call runs are rendered once
+	if(m_renderPending.testAndSetOrdered(0, 1))
+		QMetaObject::invokeMethod(this, "renderFrame", Qt::QueuedConnection);
+}
+
+void
+MPVRenderWidget::renderFrame()
+{
+	m_renderPending = 0;
+
+#ifdef MPV_SOFTWARE_RENDER
+	if(!m_renderContext)
+		return;
+
+	const bool force = m_forceRender;
+	m_forceRender = false;
+	// update() has to be called after every callback, even if there is nothing to render
+	if(!(mpv_render_context_update(m_renderContext) & MPV_RENDER_UPDATE_FRAME) && !force)
+		return;
+
+	const QSize size = this->size() * devicePixelRatioF();
+	if(size.isEmpty())
+		return;
+
+	// the displayed frame stays intact until the new one is completely rendered
+	const int next = (m_displayed + 1) % FRAME_POOL_SIZE;
+	QImage &image = m_frames[next];
+	if(image.size() != size)
+		image = QImage(size, QImage::Format_RGB32);
+
+	// Format_RGB32 is 0xffRRGGBB, which is stored in memory as "bgr0" on little endian
+	int swSize[2] = { image.width(), image.height() };
+	size_t swStride = image.bytesPerLine();
+	mpv_render_param params[] = {
+		{ MPV_RENDER_PARAM_SW_SIZE, swSize },
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+		{ MPV_RENDER_PARAM_SW_FORMAT, const_cast<char *>("bgr0") },
+#else
+		{ MPV_RENDER_PARAM_SW_FORMAT, const_cast<char *>("0rgb") },
+#endif
+		{ MPV_RENDER_PARAM_SW_STRIDE, &swStride },
+		{ MPV_RENDER_PARAM_SW_POINTER, image.bits() },
+		{ MPV_RENDER_PARAM_INVALID, Q_NULLPTR }
+	};
+
+	QElapsedTimer renderTimer;
+	renderTimer.start();
+	if(mpv_render_context_render(m_renderContext, params) < 0)
+		return;
+	const qint64 nsecRender = renderTimer.nsecsElapsed();
+
+	if(!m_painted)
+		m_statsDropped++;
+	m_displayed = next;
+	m_painted = false;
+	image.setDevicePixelRatio(devicePixelRatioF());
+
+	updateStats(nsecRender);
+	update();
+#endif
+}
+
+void
+MPVRenderWidget::updateStats(qint64 nsecRender)
+{
+	m_statsFrames++;
+	m_statsRenderTotal += nsecRender;
+	m_statsRenderMax = qMax(m_statsRenderMax, nsecRender);
+
+	const qint64 elapsed = m_statsTimer.elapsed();
+	if(elapsed < STATS_INTERVAL)
+		return;
+
+	const QSize &size = m_frames[m_displayed].size();
+	qCDebug(mpvStats) << "software render" << size.width() << "x" << size.height()
+			 << "fps:" << m_statsFrames * 1000. / elapsed
+			 << "avg ms:" << m_statsRenderTotal / 1e6 / m_statsFrames
+			 << "max ms:" << m_statsRenderMax / 1e6
+			 << "dropped:" << m_statsDropped;
+
+	m_statsTimer.restart();
+	m_statsFrames = 0;
+	m_statsDropped = 0;
+	m_statsRenderTotal = 0;
+	m_statsRenderMax = 0;
+}
+
+/*virtual*/ void
+MPVRenderWidget::paintEvent(QPaintEvent * /*event*/)
+{
+	QPainter painter(this);
+	const QImage &image = m_frames[m_displayed];
+	if(image.isNull()) {
+		painter.fillRect(rect(), Qt::black);
+		return;
+	}
+
+	// frame is already rendered at widget size, scaling only happens until the next frame after a resize
+	painter.drawImage(rect(), image);
+	m_painted = true;
+}
+
+/*virtual*/ void
+MPVRenderWidget::resizeEvent(QResizeEvent *event)
+{
+	QWidget::resizeEvent(event);
+	// paused video has to be rendered again at new size
+	requestRender(true);
+}
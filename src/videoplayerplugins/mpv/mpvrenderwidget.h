@@ -0,0 +1,97 @@
+#ifndef MPVRENDERWIDGET_H
+#define MPVRENDERWIDGET_H
+/**
+ * Copyright (C) 2010-2017 Mladen Milinkovic <max@smoothware.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <mpv/client.h>
+
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QWidget>
+
+// software rendering API was added in mpv 0.33
+#if MPV_CLIENT_API_VERSION >= MPV_MAKE_VERSION(1, 109)
+#define MPV_SOFTWARE_RENDER
+#endif
+
+struct mpv_render_context;
+
+namespace SubtitleComposer {
+/**
+ * @brief Video layer that paints frames rendered by mpv on CPU.
+ *
+ * Unlike the "wid" embedding this is an ordinary non-native widget, so the subtitle
+ * overlay, screenshots and grab() see video and subtitles composited together. Frames
+ * are rendered into a small pool of QImage buffers that are reused as long as the
+ * widget size doesn't change; a frame that gets replaced before it was painted is
+ * counted as dropped. Render timing is logged periodically.
+ */
+class MPVRenderWidget : public QWidget
+{
+	Q_OBJECT
+
+public:
+	enum {
+		FRAME_POOL_SIZE = 3,
+		STATS_INTERVAL = 5000           ///< milliseconds between logged render statistics
+	};
+
+	explicit MPVRenderWidget(QWidget *parent = Q_NULLPTR);
+	virtual ~MPVRenderWidget();
+
+	/// creates render context for @p mpv, has to be called after mpv_initialize()
+	bool attach(mpv_handle *mpv);
+	/// frees render context, has to be called before mpv handle is destroyed
+	void detach();
+
+	/// last rendered frame, without subtitles
+	inline const QImage & frame() const { return m_frames[m_displayed]; }
+
+protected:
+	void paintEvent(QPaintEvent *event) Q_DECL_OVERRIDE;
+	void resizeEvent(QResizeEvent *event) Q_DECL_OVERRIDE;
+
+private slots:
+	void renderFrame();
+
+private:
+	void requestRender(bool force);
+	void updateStats(qint64 nsecRender);
+
+	static void onUpdate(void *ctx);
+
+private:
+	mpv_render_context *m_renderContext;
+	QAtomicInt m_renderPending;
+	bool m_forceRender;
+
+	QImage m_frames[FRAME_POOL_SIZE];
+	int m_displayed;
+	bool m_painted;
+
+	QElapsedTimer m_statsTimer;
+	int m_statsFrames;
+	int m_statsDropped;
+	qint64 m_statsRenderTotal;
+	qint64 m_statsRenderMax;
+};
+}
+
+#endif // MPVRENDERWIDGET_H
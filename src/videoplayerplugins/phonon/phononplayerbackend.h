@@ -41,7 +41,7 @@ namespace SubtitleComposer {
 class PhononPlayerBackend : public PlayerBackend
 {
 	Q_OBJECT
-	Q_PLUGIN_METADATA(IID PlayerBackend_iid)
+	Q_PLUGIN_METADATA(IID PlayerBackend_iid FILE "phononplayer.json")
 	Q_INTERFACES(SubtitleComposer::PlayerBackend)
 
 public:
@@ -43,7 +43,8 @@ using namespace SubtitleComposer;
 #define EVENT_CHANNELS_CHANGED (QEvent::User + 2)
 #define EVENT_FRAME_FORMAT_CHANGED (QEvent::User + 3)
 
-#define UPDATE_INTERVAL 50
+// position is interpolated by VideoPlayer while playing, stream is queried only to correct drift
+#define UPDATE_INTERVAL 500
 
 XinePlayerBackend::XinePlayerBackend()
 	: PlayerBackend(),
@@ -213,6 +214,8 @@ XinePlayerBackend::seek(double seconds, bool accurate)
 			xine_set_param(m_xineStream, XINE_PARAM_SPEED, XINE_SPEED_PAUSE);
 			xine_set_param(m_xineStream, m_softwareMixer ? XINE_PARAM_AUDIO_AMP_MUTE : XINE_PARAM_AUDIO_MUTE, 0);
 		}
+
+		setPlayerPosition(targetTime / 1000.0);
 	}
 
 	return true;
@@ -315,13 +318,13 @@ XinePlayerBackend::updatePosition()
 
 	// some streams make xine sometimes report spurious position data during playback
 	// to compensate this we check if the received position is not too far away from the
-	// previously received one (not further than 200ms).
+	// previously received one (not further than 200ms past the update interval).
 
 	static int prevTime;
 
 	static int time, length;
 	if(xine_get_pos_length(m_xineStream, 0, &time, &length)) {
-		if(time < prevTime + 200 || time < prevTime)
+		if(time < prevTime + UPDATE_INTERVAL + 200 || time < prevTime)
 			setPlayerPosition(time / 1000.0);
 
 		prevTime = time;
@@ -45,7 +45,7 @@ namespace SubtitleComposer {
 class XinePlayerBackend : public PlayerBackend
 {
 	Q_OBJECT
-	Q_PLUGIN_METADATA(IID PlayerBackend_iid)
+	Q_PLUGIN_METADATA(IID PlayerBackend_iid FILE "xineplayer.json")
 	Q_INTERFACES(SubtitleComposer::PlayerBackend)
 
 public:
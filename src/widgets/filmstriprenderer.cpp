@@ -0,0 +1,308 @@
+/**
+ * Copyright (C) 2010-2017 Mladen Milinkovic <max@smoothware.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "filmstriprenderer.h"
+#include "../streamprocessor/mediacachefile.h"
+#include "../streamprocessor/streamprocessor.h"
+
+#include <QMutexLocker>
+#include <QPainter>
+
+// identifies thumbnail cache files, version has to be bumped whenever the format changes
+#define FILMSTRIP_MAGIC 0x5343464d
+#define FILMSTRIP_VERSION 1
+
+using namespace SubtitleComposer;
+
+FilmstripRenderer::FilmstripRenderer(QObject *parent)
+	: QObject(parent),
+	  m_stream(Q_NULLPTR),
+	  m_complete(false),
+	  m_decodedPending(0),
+	  m_thumbnailSize(THUMBNAIL_WIDTH, THUMBNAIL_HEIGHT),
+	  m_vertical(false)
+{
+	setCacheSize(32);
+}
+
+FilmstripRenderer::~FilmstripRenderer()
+{
+	cancelDecoding();
+}
+
+void
+FilmstripRenderer::setMediaFile(const QString &mediaFile)
+{
+	if(m_mediaFile == mediaFile)
+		return;
+
+	clear();
+	m_mediaFile = mediaFile;
+	if(m_mediaFile.isEmpty())
+		return;
+
+	if(load(cacheFile(m_mediaFile))) {
+		m_complete = true;
+		emit thumbnailsChanged();
+		return;
+	}
+
+	m_stream = new StreamProcessor(this);
+	if(!m_stream->open(m_mediaFile) || !m_stream->initVideoThumbnails(0, THUMBNAIL_WIDTH, THUMBNAIL_HEIGHT, qint64(THUMBNAIL_INTERVAL) * 1000)) {
+		cancelDecoding();
+		return;
+	}
+
+	// Using Qt::DirectConnection here makes onVideoFrameDecoded() execute in GStreamer's thread
+	connect(m_stream, &StreamProcessor::videoFrameDecoded, this, &FilmstripRenderer::onVideoFrameDecoded, Qt::DirectConnection);
+	connect(m_stream, &StreamProcessor::streamFinished, this, &FilmstripRenderer::onStreamFinished);
+	connect(m_stream, &StreamProcessor::streamError, this, &FilmstripRenderer::cancelDecoding);
+
+	if(!m_stream->start())
+		cancelDecoding();
+}
+
+void
+FilmstripRenderer::clear()
+{
+	cancelDecoding();
+
+	m_mediaFile.clear();
+	m_complete = false;
+	m_thumbnails.clear();
+	m_tiles.clear();
+	m_incompleteTile = QImage();
+}
+
+void
+FilmstripRenderer::cancelDecoding()
+{
+	if(m_stream) {
+		// stops the pipeline, so no more frames will be decoded
+		m_stream->close();
+		m_stream->deleteLater();
+		m_stream = Q_NULLPTR;
+	}
+
+	QMutexLocker locker(&m_decodedMutex);
+	m_decoded.clear();
+}
+
+void
+FilmstripRenderer::setCacheSize(int megabytes)
+{
+	// cost is in kilobytes
+	m_tiles.setMaxCost(qMax(1, megabytes) * 1024);
+}
+
+void
+FilmstripRenderer::setLayout(const QSize &thumbnailSize, bool vertical)
+{
+	if(m_thumbnailSize == thumbnailSize && m_vertical == vertical)
+		return;
+
+	m_thumbnailSize = thumbnailSize;
+	m_vertical = vertical;
+	m_tiles.clear();
+}
+
+void
+FilmstripRenderer::onVideoFrameDecoded(const quint8 *pixels, const int width, const int height, const qint64 usecTime)
+{
+	// videorate timestamps decimated frames at multiples of the interval
+	const qint64 index = qRound64(usecTime / (THUMBNAIL_INTERVAL * 1000.));
+	const QImage thumbnail = QImage(pixels, width, height, width * 4, QImage::Format_RGB32).convertToFormat(QImage::Format_RGB16);
+
+	QMutexLocker locker(&m_decodedMutex);
+	m_decoded.append(qMakePair(index, thumbnail));
+	// thumbnails are added in batches, one queued call per event loop iteration
+	if(m_decodedPending.testAndSetOrdered(0, 1))
+		QMetaObject::invokeMethod(this, "onThumbnailsDecoded", Qt::QueuedConnection);
+}
+
+void
+FilmstripRenderer::onThumbnailsDecoded()
+{
+	QList<QPair<qint64, QImage>> decoded;
+	{
+		QMutexLocker locker(&m_decodedMutex);
+		m_decodedPending = 0;
+		decoded.swap(m_decoded);
+	}
+	if(decoded.isEmpty())
+		return;
+
+	for(const QPair<qint64, QImage> &thumbnail : decoded) {
+		if(thumbnail.first < 0)
+			continue;
+		if(thumbnail.first >= m_thumbnails.size())
+			m_thumbnails.resize(thumbnail.first + 1);
+		m_thumbnails[thumbnail.first] = thumbnail.second;
+	}
+
+	// only complete tiles are cached, new thumbnails never change them
+	emit thumbnailsChanged();
+}
+
+void
+FilmstripRenderer::onStreamFinished()
+{
+	if(!m_stream || sender() != m_stream)
+		return;
+
+	m_stream->close();
+	m_stream->deleteLater();
+	m_stream = Q_NULLPTR;
+
+	onThumbnailsDecoded();
+	m_complete = true;
+	if(!m_thumbnails.isEmpty())
+		save(cacheFile(m_mediaFile));
+
+	emit thumbnailsChanged();
+}
+
+/*static*/ int
+FilmstripRenderer::zoomKey(double msecPerPixel)
+{
+	return qRound(msecPerPixel * 256.);
+}
+
+/*static*/ quint64
+FilmstripRenderer::cacheKey(int zoomKey, quint32 tileIndex)
+{
+	return (quint64(quint32(zoomKey)) << 32) | tileIndex;
+}
+
+const QImage *
+FilmstripRenderer::tile(double msecPerPixel, quint32 tileIndex)
+{
+	if(m_thumbnails.isEmpty() || msecPerPixel <= 0. || m_thumbnailSize.isEmpty())
+		return Q_NULLPTR;
+
+	const quint64 key = cacheKey(zoomKey(msecPerPixel), tileIndex);
+	if(const QImage *image = m_tiles.object(key))
+		return image;
+
+	bool complete;
+	QImage image = renderTile(msecPerPixel, tileIndex, &complete);
+	if(!complete) {
+		// tiles with thumbnails that are still being decoded are composed again on next paint
+		m_incompleteTile = image;
+		return &m_incompleteTile;
+	}
+
+	QImage *cached = new QImage(image);
+	m_tiles.insert(key, cached, qMax(1, image.byteCount() / 1024));
+	return cached;
+}
+
+QImage
+FilmstripRenderer::renderTile(double msecPerPixel, quint32 tileIndex, bool *complete) const
+{
+	const int slotLength = m_vertical ? m_thumbnailSize.height() : m_thumbnailSize.width();
+	QImage image = m_vertical
+		? QImage(m_thumbnailSize.width(), TILE_LENGTH, QImage::Format_RGB32)
+		: QImage(TILE_LENGTH, m_thumbnailSize.height(), QImage::Format_RGB32);
+	image.fill(Qt::black);
+
+	*complete = true;
+
+	QPainter painter(&image);
+	painter.setRenderHint(QPainter::SmoothPixmapTransform);
+
+	// thumbnails are placed in fixed slots along the time axis, so they don't move when scrolling
+	const qint64 tileStart = qint64(tileIndex) * TILE_LENGTH;
+	for(qint64 slot = tileStart / slotLength; slot * slotLength < tileStart + TILE_LENGTH; slot++) {
+		const double msecCenter = (slot + .5) * slotLength * msecPerPixel;
+		const qint64 index = qRound64(msecCenter / THUMBNAIL_INTERVAL);
+		const QImage *thumbnail = index < m_thumbnails.size() ? &m_thumbnails.at(index) : Q_NULLPTR;
+		if(!thumbnail || thumbnail->isNull()) {
+			if(!m_complete)
+				*complete = false;
+			continue;
+		}
+
+		const int offset = int(slot * slotLength - tileStart);
+		const QRect target = m_vertical
+			? QRect(QPoint(0, offset), m_thumbnailSize)
+			: QRect(QPoint(offset, 0), m_thumbnailSize);
+		painter.drawImage(target, *thumbnail);
+	}
+
+	return image;
+}
+
+bool
+FilmstripRenderer::load(const QString &cacheFile)
+{
+	QFile file(cacheFile);
+	QDataStream stream;
+	// stale thumbnails of modified file are decoded again
+	if(!MediaCacheFile::openForReading(file, stream, FILMSTRIP_MAGIC, FILMSTRIP_VERSION, m_mediaFile))
+		return false;
+
+	quint32 interval, width, height, count;
+	stream >> interval >> width >> height >> count;
+	if(interval != THUMBNAIL_INTERVAL || width != THUMBNAIL_WIDTH || height != THUMBNAIL_HEIGHT)
+		return false;
+
+	QVector<QImage> thumbnails(count);
+	for(quint32 i = 0; i < count; i++) {
+		quint8 present;
+		stream >> present;
+		if(!present)
+			continue;
+		QImage thumbnail(width, height, QImage::Format_RGB16);
+		if(stream.readRawData(reinterpret_cast<char *>(thumbnail.bits()), thumbnail.byteCount()) != thumbnail.byteCount())
+			return false;
+		thumbnails[i] = thumbnail;
+	}
+	if(stream.status() != QDataStream::Ok)
+		return false;
+
+	m_thumbnails = thumbnails;
+	return true;
+}
+
+bool
+FilmstripRenderer::save(const QString &cacheFile) const
+{
+	QFile file(cacheFile);
+	QDataStream stream;
+	if(!MediaCacheFile::openForWriting(file, stream, FILMSTRIP_MAGIC, FILMSTRIP_VERSION, m_mediaFile))
+		return false;
+
+	// thumbnails are stored as raw pixels, loading them has to be much faster than decoding
+	stream << quint32(THUMBNAIL_INTERVAL) << quint32(THUMBNAIL_WIDTH) << quint32(THUMBNAIL_HEIGHT)
+		   << quint32(m_thumbnails.size());
+	for(const QImage &thumbnail : m_thumbnails) {
+		const bool present = thumbnail.size() == QSize(THUMBNAIL_WIDTH, THUMBNAIL_HEIGHT);
+		stream << quint8(present);
+		if(present)
+			stream.writeRawData(reinterpret_cast<const char *>(thumbnail.constBits()), thumbnail.byteCount());
+	}
+	return stream.status() == QDataStream::Ok;
+}
+
+/*static*/ QString
+FilmstripRenderer::cacheFile(const QString &mediaFile)
+{
+	return MediaCacheFile::path(QStringLiteral("filmstrip"), mediaFile, QStringLiteral("thumbs"));
+}
@@ -0,0 +1,119 @@
+#ifndef FILMSTRIPRENDERER_H
+#define FILMSTRIPRENDERER_H
+/**
+ * Copyright (C) 2010-2017 Mladen Milinkovic <max@smoothware.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <QObject>
+#include <QAtomicInt>
+#include <QCache>
+#include <QImage>
+#include <QList>
+#include <QMutex>
+#include <QPair>
+#include <QSize>
+#include <QString>
+#include <QVector>
+
+namespace SubtitleComposer {
+class StreamProcessor;
+
+/**
+ * @brief Video thumbnails laid out along the time axis of WaveformWidget.
+ *
+ * One thumbnail per THUMBNAIL_INTERVAL is decoded in the background by a decimating
+ * StreamProcessor video branch and stored in a per-file disk cache, so the file is
+ * decoded only once. Tiles of the filmstrip are TILE_LENGTH pixels long along the time
+ * axis and are kept in an LRU cache limited by memory size and keyed by zoom level
+ * (milliseconds per pixel) and tile index. Tiles are composed from thumbnails that are
+ * already in memory, so drawing never waits on the decoder.
+ */
+class FilmstripRenderer : public QObject
+{
+	Q_OBJECT
+
+public:
+	enum {
+		THUMBNAIL_WIDTH = 64,
+		THUMBNAIL_HEIGHT = 36,
+		THUMBNAIL_INTERVAL = 1000,      ///< milliseconds between decoded thumbnails
+		TILE_LENGTH = 256
+	};
+
+	explicit FilmstripRenderer(QObject *parent = Q_NULLPTR);
+	virtual ~FilmstripRenderer();
+
+	inline const QString & mediaFile() const { return m_mediaFile; }
+	/// loads cached thumbnails of @p mediaFile or starts decoding them
+	void setMediaFile(const QString &mediaFile);
+	void clear();
+
+	void setCacheSize(int megabytes);
+	/**
+	 * @brief Sets size of the thumbnails in the lane, changing it drops all cached tiles
+	 * @param vertical true if time axis goes from top to bottom, otherwise from left to right
+	 */
+	void setLayout(const QSize &thumbnailSize, bool vertical);
+
+	/**
+	 * @brief Returns the tile, composing it from decoded thumbnails if it's not cached
+	 * @param msecPerPixel zoom level
+	 * @param tileIndex index of the tile starting at pixel (tileIndex * TILE_LENGTH) of time axis
+	 * @return tile or null if there are no thumbnails
+	 */
+	const QImage * tile(double msecPerPixel, quint32 tileIndex);
+
+	static QString cacheFile(const QString &mediaFile);
+
+signals:
+	void thumbnailsChanged();
+
+private slots:
+	void onThumbnailsDecoded();
+	void onStreamFinished();
+	void cancelDecoding();
+
+private:
+	void onVideoFrameDecoded(const quint8 *pixels, const int width, const int height, const qint64 usecTime);
+	QImage renderTile(double msecPerPixel, quint32 tileIndex, bool *complete) const;
+
+	static int zoomKey(double msecPerPixel);
+	static quint64 cacheKey(int zoomKey, quint32 tileIndex);
+
+	bool load(const QString &cacheFile);
+	bool save(const QString &cacheFile) const;
+
+private:
+	QString m_mediaFile;
+	StreamProcessor *m_stream;
+	bool m_complete;
+
+	QVector<QImage> m_thumbnails;           // indexed by time / THUMBNAIL_INTERVAL
+
+	QMutex m_decodedMutex;
+	QList<QPair<qint64, QImage>> m_decoded; // decoded on GStreamer thread, waiting to be added
+	QAtomicInt m_decodedPending;
+
+	QSize m_thumbnailSize;
+	bool m_vertical;
+	QCache<quint64, QImage> m_tiles;
+	QImage m_incompleteTile;
+};
+}
+
+#endif // FILMSTRIPRENDERER_H
@@ -21,6 +21,7 @@
 #include "simplerichtextedit.h"
 
 #include "../main/dialogs/subtitlecolordialog.h"
+#include "../main/utils/backgroundspeller.h"
 
 #include <QRegExp>
 #include <QEvent>
@@ -32,13 +33,58 @@
 #include <QAction>
 #include <QMenu>
 #include <QIcon>
+#include <QTextBlock>
+#include <QTextDocument>
 #include <QDebug>
 
 #include <KStandardShortcut>
 #include <KLocalizedString>
 
+#include <sonnet/highlighter.h>
+
+/**
+ * @brief Underlines misspellings already found by BackgroundSpeller.
+ *
+ * Text that wasn't checked yet is left to Sonnet, so typing is highlighted the same as before.
+ */
+class SimpleRichTextEdit::Highlighter : public Sonnet::Highlighter
+{
+public:
+	Highlighter(SimpleRichTextEdit *textEdit)
+		: Sonnet::Highlighter(textEdit),
+		  m_textEdit(textEdit)
+	{}
+
+protected:
+	void highlightBlock(const QString &text) Q_DECL_OVERRIDE
+	{
+		SubtitleComposer::BackgroundSpeller *speller = m_textEdit->m_backgroundSpeller;
+		if(!speller || !speller->isEnabled() || !isActive() || text.isEmpty()) {
+			Sonnet::Highlighter::highlightBlock(text);
+			return;
+		}
+
+		bool checked;
+		const SubtitleComposer::BackgroundSpeller::Misspellings misspellings = speller->misspellings(text, &checked);
+		if(!checked) {
+			Sonnet::Highlighter::highlightBlock(text);
+			return;
+		}
+
+		// words ignored from this editor aren't known to background speller until it checks again
+		foreach(const SubtitleComposer::BackgroundSpeller::Misspelling &misspelling, misspellings) {
+			if(isWordMisspelled(text.mid(misspelling.start, misspelling.length)))
+				setMisspelled(misspelling.start, misspelling.length);
+		}
+	}
+
+private:
+	SimpleRichTextEdit *m_textEdit;
+};
+
 SimpleRichTextEdit::SimpleRichTextEdit(QWidget *parent)
-	: KTextEdit(parent)
+	: KTextEdit(parent),
+	  m_backgroundSpeller(0)
 {
 	enableFindReplace(false);
 	setCheckSpellingEnabled(true);
@@ -396,6 +442,39 @@ SimpleRichTextEdit::toggleTabChangesFocus()
 	setTabChangesFocus(!tabChangesFocus());
 }
 
+void
+SimpleRichTextEdit::setBackgroundSpeller(SubtitleComposer::BackgroundSpeller *speller)
+{
+	if(m_backgroundSpeller)
+		disconnect(m_backgroundSpeller, 0, this, 0);
+
+	m_backgroundSpeller = speller;
+
+	if(m_backgroundSpeller) {
+		connect(m_backgroundSpeller, &SubtitleComposer::BackgroundSpeller::misspellingsChanged, this, [this](const QStringList &texts){
+			if(!highlighter())
+				return;
+			for(QTextBlock block = document()->begin(); block.isValid(); block = block.next()) {
+				if(texts.contains(block.text()))
+					highlighter()->rehighlightBlock(block);
+			}
+		});
+		connect(m_backgroundSpeller, &SubtitleComposer::BackgroundSpeller::misspellingsReset, this, [this](){
+			if(highlighter())
+				highlighter()->rehighlight();
+		});
+	}
+
+	if(highlighter())
+		highlighter()->rehighlight();
+}
+
+void
+SimpleRichTextEdit::createHighlighter()
+{
+	setHighlighter(new Highlighter(this));
+}
+
 void
 SimpleRichTextEdit::toggleAutoSpellChecking()
 {
@@ -430,6 +509,8 @@ SimpleRichTextEdit::addToIgnoreList()
 {
 	highlighter()->ignoreWord(m_selectedWordCursor.selectedText());
 	highlighter()->rehighlight();
+	if(m_backgroundSpeller)
+		m_backgroundSpeller->acceptWord(m_selectedWordCursor.selectedText());
 	m_selectedWordCursor.clearSelection();
 }
 
@@ -438,6 +519,8 @@ SimpleRichTextEdit::addToDictionary()
 {
 	highlighter()->addWordToDictionary(m_selectedWordCursor.selectedText());
 	highlighter()->rehighlight();
+	if(m_backgroundSpeller)
+		m_backgroundSpeller->acceptWord(m_selectedWordCursor.selectedText());
 	m_selectedWordCursor.clearSelection();
 }
 
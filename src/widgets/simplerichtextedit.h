@@ -33,6 +33,10 @@ QT_FORWARD_DECLARE_CLASS(QFocusEvent)
 QT_FORWARD_DECLARE_CLASS(QAction)
 QT_FORWARD_DECLARE_CLASS(QMenu)
 
+namespace SubtitleComposer {
+class BackgroundSpeller;
+}
+
 class SimpleRichTextEdit : public KTextEdit
 {
 	Q_OBJECT
@@ -61,6 +65,9 @@ public:
 
 	virtual bool event(QEvent *event);
 
+	/// misspellings are taken from @p speller when it has checked the text already
+	void setBackgroundSpeller(SubtitleComposer::BackgroundSpeller *speller);
+
 public slots:
 	SubtitleComposer::SString richText();
 	void setRichText(const SubtitleComposer::SString &richText);
@@ -88,6 +95,8 @@ public slots:
 protected:
 	QMenu * createContextMenu(const QPoint &mousePos);
 
+	virtual void createHighlighter();
+
 	virtual void contextMenuEvent(QContextMenuEvent *event);
 
 	virtual void keyPressEvent(QKeyEvent *event);
@@ -103,6 +112,10 @@ protected:
 	QAction *m_actions[ActionCount];
 	QMenu *m_insertUnicodeControlCharMenu;
 	QTextCursor m_selectedWordCursor;
+	SubtitleComposer::BackgroundSpeller *m_backgroundSpeller;
+
+private:
+	class Highlighter;
 };
 
 #endif
@@ -0,0 +1,284 @@
+/**
+ * Copyright (C) 2010-2017 Mladen Milinkovic <max@smoothware.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "spectrogramrenderer.h"
+
+#include <QRunnable>
+#include <QThread>
+#include <QVector>
+#include <QColor>
+#include <QtMath>
+
+#include <cmath>
+
+// range of displayed magnitudes, anything quieter is drawn black
+#define SPECTROGRAM_DB_RANGE 90.
+
+using namespace SubtitleComposer;
+
+namespace {
+struct FFTTables {
+	FFTTables()
+	{
+		const int size = SpectrogramRenderer::FFT_SIZE;
+		for(int i = 0; i < size; i++)
+			window[i] = 0.5f - 0.5f * std::cos(2. * M_PI * i / (size - 1));
+		for(int i = 0; i < size / 2; i++) {
+			cosTable[i] = std::cos(2. * M_PI * i / size);
+			sinTable[i] = -std::sin(2. * M_PI * i / size);
+		}
+		for(int i = 0, j = 0; i < size; i++) {
+			bitReverse[i] = j;
+			int bit = size >> 1;
+			for(; j & bit; bit >>= 1)
+				j ^= bit;
+			j |= bit;
+		}
+
+		// black -> blue -> magenta -> red -> yellow -> white
+		static const QRgb stops[] = { 0xff000000, 0xff000080, 0xff8000a0, 0xffe00000, 0xffffe000, 0xffffffff };
+		const int stopCount = sizeof(stops) / sizeof(*stops);
+		for(int i = 0; i < 256; i++) {
+			const double pos = double(i) * (stopCount - 1) / 255.;
+			const int stop = qMin(int(pos), stopCount - 2);
+			const double frac = pos - stop;
+			const QRgb from = stops[stop];
+			const QRgb to = stops[stop + 1];
+			palette.append(qRgb(qRed(from) + (qRed(to) - qRed(from)) * frac,
+								qGreen(from) + (qGreen(to) - qGreen(from)) * frac,
+								qBlue(from) + (qBlue(to) - qBlue(from)) * frac));
+		}
+	}
+
+	float window[SpectrogramRenderer::FFT_SIZE];
+	float cosTable[SpectrogramRenderer::FFT_SIZE / 2];
+	float sinTable[SpectrogramRenderer::FFT_SIZE / 2];
+	int bitReverse[SpectrogramRenderer::FFT_SIZE];
+	QVector<QRgb> palette;
+};
+
+const FFTTables &
+fftTables()
+{
+	static const FFTTables tables;
+	return tables;
+}
+
+// in-place iterative radix-2 FFT, input must be in bit reversed order
+void
+fft(float *re, float *im)
+{
+	const FFTTables &tables = fftTables();
+	const int size = SpectrogramRenderer::FFT_SIZE;
+	for(int len = 2; len <= size; len <<= 1) {
+		const int half = len >> 1;
+		const int step = size / len;
+		for(int i = 0; i < size; i += len) {
+			for(int j = 0; j < half; j++) {
+				const float wr = tables.cosTable[j * step];
+				const float wi = tables.sinTable[j * step];
+				const int a = i + j;
+				const int b = a + half;
+				const float tr = re[b] * wr - im[b] * wi;
+				const float ti = re[b] * wi + im[b] * wr;
+				re[b] = re[a] - tr;
+				im[b] = im[a] - ti;
+				re[a] += tr;
+				im[a] += ti;
+			}
+		}
+	}
+}
+}
+
+class SpectrogramRenderer::TileJob : public QRunnable
+{
+public:
+	TileJob(SpectrogramRenderer *renderer, int zoomKey, double samplesPerPixel, quint32 tileIndex, quint32 samplesAvailable)
+		: m_renderer(renderer),
+		  m_zoomKey(zoomKey),
+		  m_samplesPerPixel(samplesPerPixel),
+		  m_tileIndex(tileIndex),
+		  m_samplesAvailable(samplesAvailable),
+		  m_generation(renderer->m_generation),
+		  m_channels(renderer->m_channels),
+		  m_channelCount(renderer->m_channelCount)
+	{
+	}
+
+	void run() Q_DECL_OVERRIDE
+	{
+		const FFTTables &tables = fftTables();
+		const int bins = FFT_SIZE / 2;
+		// full scale sine wave through hann window peaks at 32768 * FFT_SIZE / 4
+		const double reference = 32768. * FFT_SIZE / 4.;
+
+		QImage image(TILE_WIDTH, bins, QImage::Format_Indexed8);
+		image.setColorTable(tables.palette);
+
+		float re[FFT_SIZE];
+		float im[FFT_SIZE];
+		const qint64 firstPixel = qint64(m_tileIndex) * TILE_WIDTH;
+		for(int x = 0; x < TILE_WIDTH; x++) {
+			const qint64 center = qint64((firstPixel + x + .5) * m_samplesPerPixel);
+			if(center >= m_samplesAvailable) {
+				for(int bin = 0; bin < bins; bin++)
+					image.scanLine(bin)[x] = 0;
+				continue;
+			}
+
+			const qint64 start = center - FFT_SIZE / 2;
+			for(int i = 0; i < FFT_SIZE; i++) {
+				const qint64 pos = start + i;
+				float sample = 0.f;
+				if(pos >= 0 && pos < m_samplesAvailable) {
+					for(quint32 ch = 0; ch < m_channelCount; ch++)
+						sample += m_channels[ch][pos];
+					sample /= m_channelCount;
+				}
+				const int j = tables.bitReverse[i];
+				re[j] = sample * tables.window[i];
+				im[j] = 0.f;
+			}
+
+			fft(re, im);
+
+			for(int bin = 0; bin < bins; bin++) {
+				const double magnitude = std::sqrt(re[bin] * re[bin] + im[bin] * im[bin]) / reference;
+				const double db = 20. * std::log10(magnitude + 1e-9);
+				const int level = qBound(0, int((db + SPECTROGRAM_DB_RANGE) * 255. / SPECTROGRAM_DB_RANGE), 255);
+				image.scanLine(bins - 1 - bin)[x] = level;
+			}
+		}
+
+		QMetaObject::invokeMethod(m_renderer, "onTileFinished", Qt::QueuedConnection,
+			Q_ARG(int, m_zoomKey), Q_ARG(int, int(m_tileIndex)), Q_ARG(int, m_generation), Q_ARG(QImage, image));
+	}
+
+private:
+	SpectrogramRenderer *m_renderer;
+	int m_zoomKey;
+	double m_samplesPerPixel;
+	quint32 m_tileIndex;
+	qint64 m_samplesAvailable;
+	int m_generation;
+	qint16 **m_channels;
+	quint32 m_channelCount;
+};
+
+SpectrogramRenderer::SpectrogramRenderer(QObject *parent)
+	: QObject(parent),
+	  m_generation(0),
+	  m_channels(Q_NULLPTR),
+	  m_channelCount(0)
+{
+	// leave one core for GUI and decoder
+	m_threadPool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 1));
+	setCacheSize(64);
+}
+
+SpectrogramRenderer::~SpectrogramRenderer()
+{
+	clear();
+}
+
+void
+SpectrogramRenderer::setSource(qint16 **channels, quint32 channelCount)
+{
+	if(m_channels == channels && m_channelCount == channelCount)
+		return;
+
+	clear();
+	m_channels = channels;
+	m_channelCount = channelCount;
+}
+
+void
+SpectrogramRenderer::clear()
+{
+	// results of jobs that are still running will be ignored
+	m_generation++;
+	m_threadPool.clear();
+	m_threadPool.waitForDone();
+
+	m_tiles.clear();
+	m_pendingTiles.clear();
+	m_channels = Q_NULLPTR;
+	m_channelCount = 0;
+}
+
+void
+SpectrogramRenderer::setCacheSize(int megabytes)
+{
+	// cost is in kilobytes
+	m_tiles.setMaxCost(qMax(1, megabytes) * 1024);
+}
+
+/*static*/ int
+SpectrogramRenderer::zoomKey(double samplesPerPixel)
+{
+	return qRound(samplesPerPixel * 256.);
+}
+
+/*static*/ quint64
+SpectrogramRenderer::cacheKey(int zoomKey, quint32 tileIndex)
+{
+	return (quint64(quint32(zoomKey)) << 32) | tileIndex;
+}
+
+const QImage *
+SpectrogramRenderer::tile(double samplesPerPixel, quint32 tileIndex, quint32 samplesAvailable, bool streamComplete)
+{
+	if(!m_channels || !m_channelCount || samplesPerPixel <= 0.)
+		return Q_NULLPTR;
+
+	const int zoom = zoomKey(samplesPerPixel);
+	const quint64 key = cacheKey(zoom, tileIndex);
+
+	if(const QImage *image = m_tiles.object(key))
+		return image;
+
+	if(m_pendingTiles.contains(key))
+		return Q_NULLPTR;
+
+	const double firstSample = double(tileIndex) * TILE_WIDTH * samplesPerPixel;
+	if(firstSample >= samplesAvailable)
+		return Q_NULLPTR;
+	const double lastSample = (double(tileIndex) + 1.) * TILE_WIDTH * samplesPerPixel + FFT_SIZE / 2;
+	if(!streamComplete && lastSample > samplesAvailable)
+		return Q_NULLPTR;
+
+	m_pendingTiles.insert(key);
+	m_threadPool.start(new TileJob(this, zoom, samplesPerPixel, tileIndex, samplesAvailable));
+
+	return Q_NULLPTR;
+}
+
+void
+SpectrogramRenderer::onTileFinished(int zoomKey, int tileIndex, int generation, const QImage &image)
+{
+	if(generation != m_generation)
+		return;
+
+	const quint64 key = cacheKey(zoomKey, tileIndex);
+	m_pendingTiles.remove(key);
+	m_tiles.insert(key, new QImage(image), qMax(1, image.byteCount() / 1024));
+
+	emit tileReady();
+}
@@ -0,0 +1,90 @@
+#ifndef SPECTROGRAMRENDERER_H
+#define SPECTROGRAMRENDERER_H
+/**
+ * Copyright (C) 2010-2017 Mladen Milinkovic <max@smoothware.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <QObject>
+#include <QCache>
+#include <QImage>
+#include <QSet>
+#include <QThreadPool>
+#include <QVector>
+
+namespace SubtitleComposer {
+/**
+ * @brief Computes spectrogram tiles from decoded PCM on a thread pool.
+ *
+ * Tiles are TILE_WIDTH pixels wide along the time axis and (FFT_SIZE / 2) pixels high,
+ * one row per frequency bin with the highest frequency in the first row.
+ * Finished tiles are kept in an LRU cache limited by memory size and are keyed by
+ * zoom level (samples per pixel) and tile index.
+ */
+class SpectrogramRenderer : public QObject
+{
+	Q_OBJECT
+
+public:
+	enum {
+		FFT_SIZE = 256,
+		TILE_WIDTH = 256
+	};
+
+	explicit SpectrogramRenderer(QObject *parent = Q_NULLPTR);
+	virtual ~SpectrogramRenderer();
+
+	void setSource(qint16 **channels, quint32 channelCount);
+	void clear();
+
+	void setCacheSize(int megabytes);
+
+	/**
+	 * @brief Returns the tile if it's cached, otherwise schedules its computation
+	 * @param samplesPerPixel zoom level
+	 * @param tileIndex index of the tile starting at pixel (tileIndex * TILE_WIDTH)
+	 * @param samplesAvailable number of samples per channel that have been decoded
+	 * @param streamComplete true if no more samples will become available, otherwise
+	 * tiles that are not completely decoded yet are not computed
+	 * @return cached tile or null if it's not ready yet
+	 */
+	const QImage * tile(double samplesPerPixel, quint32 tileIndex, quint32 samplesAvailable, bool streamComplete);
+
+signals:
+	void tileReady();
+
+private slots:
+	void onTileFinished(int zoomKey, int tileIndex, int generation, const QImage &image);
+
+private:
+	static int zoomKey(double samplesPerPixel);
+	static quint64 cacheKey(int zoomKey, quint32 tileIndex);
+
+private:
+	class TileJob;
+
+	QThreadPool m_threadPool;
+	QCache<quint64, QImage> m_tiles;
+	QSet<quint64> m_pendingTiles;
+	int m_generation;
+
+	qint16 **m_channels;
+	quint32 m_channelCount;
+};
+}
+
+#endif // SPECTROGRAMRENDERER_H
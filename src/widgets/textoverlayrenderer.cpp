@@ -0,0 +1,347 @@
+/**
+ * Copyright (C) 2007-2009 Sergio Pistone <sergio_pistone@yahoo.com.ar>
+ * Copyright (C) 2010-2017 Mladen Milinkovic <max@smoothware.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "textoverlayrenderer.h"
+#include "../core/sstring.h"
+
+#include <QAbstractTextDocumentLayout>
+#include <QFontDatabase>
+#include <QPainter>
+#include <QRunnable>
+#include <QTextCursor>
+#include <QTextDocument>
+#include <QVector>
+
+// memory used by cached overlays in kilobytes
+#define OVERLAY_CACHE_SIZE 16384
+
+using namespace SubtitleComposer;
+
+namespace {
+void
+adjustColors(QColor &primaryColor, QColor &outlineColor, QColor &transColor)
+{
+	// the outline drawing algorithm expect different primary and outline colors
+	// so we have to change one if they are the same
+	if(outlineColor == primaryColor) {
+		QRgb rgb = outlineColor.rgb();
+		int blue = qBlue(rgb);
+		outlineColor.setRgb(qRed(rgb), qGreen(rgb), blue > 0 ? blue - 1 : blue + 1);
+	}
+	// the primary and outline colors can't be the same as the translucent color
+	// or they won't be shown. It's also best if the translucent color is as dark
+	// as possible.
+	transColor.setRgb(0, 0, 0);
+	for(int blue = 0; primaryColor == transColor || outlineColor == transColor; ++blue)
+		transColor.setRgb(0, 0, blue);
+}
+
+void
+drawOutline(QImage &image, int outlineWidth, QRgb outlineRGB, QRgb transRGB)
+{
+	const int maxX = image.width() - 1;
+	const int maxY = image.height() - 1;
+
+	QVector<QRgb *> scanLines(image.height());
+	for(int y = 0; y <= maxY; y++)
+		scanLines[y] = (QRgb *)image.scanLine(y);
+
+	QRgb *cc, *cd;
+	for(int y = 0; y <= maxY; y++) {
+		for(int x = outlineWidth; x <= maxX; x++) {
+			int ix = maxX - x;
+			for(int d = 1; d <= outlineWidth; d++) {
+				// left to right
+				cd = &scanLines[y][x - d];
+				if(*cd != outlineRGB) {
+					cc = &scanLines[y][x];
+					if(*cc != transRGB)
+						*cd = *cc;
+				}
+				// right to left
+				cd = &scanLines[y][ix + d];
+				if(*cd != outlineRGB) {
+					cc = &scanLines[y][ix];
+					if(*cc != transRGB)
+						*cd = *cc;
+				}
+			}
+		}
+	}
+
+	for(int x = 0; x <= maxX; x++) {
+		for(int y = outlineWidth; y <= maxY; y++) {
+			int iy = maxY - y;
+			for(int d = 1; d <= outlineWidth; d++) {
+				// top to bottom
+				cd = &scanLines[y - d][x];
+				if(*cd != outlineRGB) {
+					cc = &scanLines[y][x];
+					if(*cc != transRGB)
+						*cd = *cc;
+				}
+				// bottom to top
+				cd = &scanLines[iy + d][x];
+				if(*cd != outlineRGB) {
+					cc = &scanLines[iy][x];
+					if(*cc != transRGB)
+						*cd = *cc;
+				}
+			}
+		}
+	}
+}
+
+QImage
+createMask(const QImage &image, QRgb transRGB)
+{
+	static const QRgb color0 = QColor(Qt::color0).rgb();    // mask transparent
+	static const QRgb color1 = QColor(Qt::color1).rgb();    // mask non transparent
+
+	// NOTE: we use a 32 bits image for the mask creation for performance reasons
+	QImage maskImage(image.size(), QImage::Format_RGB32);
+	maskImage.fill(color0);
+
+	const QRgb *imageBits = (const QRgb *)image.constBits();
+	QRgb *maskImageBits = (QRgb *)maskImage.bits();
+
+	for(int index = 0, count = image.width() * image.height(); index < count; ++index) {
+		if(imageBits[index] != transRGB)
+			maskImageBits[index] = color1;
+	}
+
+	return maskImage.convertToFormat(QImage::Format_MonoLSB, Qt::MonoOnly);
+}
+}
+
+class TextOverlayRenderer::RenderJob : public QRunnable
+{
+public:
+	RenderJob(TextOverlayRenderer *renderer, int request, const SString &text)
+		: m_renderer(renderer),
+		  m_request(request),
+		  m_generation(renderer->m_generation),
+		  m_text(text),
+		  m_style(renderer->m_style)
+	{
+	}
+
+	void run() Q_DECL_OVERRIDE
+	{
+		const Overlay overlay = render(richText(m_text), m_style);
+
+		QMetaObject::invokeMethod(m_renderer, "onOverlayFinished", Qt::QueuedConnection,
+			Q_ARG(int, m_request), Q_ARG(int, m_generation), Q_ARG(QImage, overlay.image), Q_ARG(QImage, overlay.mask));
+	}
+
+private:
+	TextOverlayRenderer *m_renderer;
+	int m_request;
+	int m_generation;
+	SString m_text;
+	Style m_style;
+};
+
+bool
+TextOverlayRenderer::Style::operator==(const Style &other) const
+{
+	return font == other.font
+		&& primaryColor == other.primaryColor
+		&& outlineColor == other.outlineColor
+		&& outlineWidth == other.outlineWidth
+		&& alignment == other.alignment
+		&& antialias == other.antialias;
+}
+
+TextOverlayRenderer::TextOverlayRenderer(QObject *parent)
+	: QObject(parent),
+	  m_lastRequest(0),
+	  m_generation(0)
+{
+	m_style.font.setPointSize(15);
+	m_style.primaryColor = Qt::yellow;
+	m_style.outlineColor = Qt::black;
+	m_style.outlineWidth = 1;
+	m_style.alignment = Qt::AlignVCenter | Qt::AlignHCenter;
+	m_style.antialias = false;
+
+	// prerendering is not urgent, keep it from competing with video decoding
+	m_threadPool.setMaxThreadCount(1);
+
+	m_overlays.setMaxCost(OVERLAY_CACHE_SIZE);
+}
+
+TextOverlayRenderer::~TextOverlayRenderer()
+{
+	m_threadPool.clear();
+	m_threadPool.waitForDone();
+}
+
+void
+TextOverlayRenderer::setStyle(const Style &style)
+{
+	if(m_style == style)
+		return;
+
+	m_style = style;
+	clear();
+}
+
+void
+TextOverlayRenderer::clear()
+{
+	// results of jobs that are still running will be ignored
+	m_generation++;
+	m_threadPool.clear();
+	m_pendingOverlays.clear();
+	m_overlays.clear();
+}
+
+/*static*/ TextOverlayRenderer::Key
+TextOverlayRenderer::cacheKey(const SubtitleLine *line, SubtitleLine::TextTarget target)
+{
+	return Key{ line, line->textRevision(), target };
+}
+
+/*static*/ QString
+TextOverlayRenderer::richText(const SString &text)
+{
+	return text.richString(SString::Verbose);
+}
+
+TextOverlayRenderer::Overlay
+TextOverlayRenderer::overlay(const SubtitleLine *line, SubtitleLine::TextTarget target)
+{
+	const Key key = cacheKey(line, target);
+	if(const Overlay *overlay = m_overlays.object(key))
+		return *overlay;
+
+	const Overlay overlay = render(richText(target == SubtitleLine::Secondary ? line->secondaryText() : line->primaryText()), m_style);
+	insert(key, overlay);
+	return overlay;
+}
+
+void
+TextOverlayRenderer::prerender(const SubtitleLine *line, SubtitleLine::TextTarget target)
+{
+	// some platforms can't draw text outside of GUI thread
+	if(!QFontDatabase::supportsThreadedFontRendering())
+		return;
+
+	const Key key = cacheKey(line, target);
+	if(m_overlays.contains(key) || m_pendingOverlays.key(key, 0))
+		return;
+
+	const int request = ++m_lastRequest;
+	m_pendingOverlays.insert(request, key);
+
+	RenderJob *job = new RenderJob(this, request, target == SubtitleLine::Secondary ? line->secondaryText() : line->primaryText());
+	job->setAutoDelete(true);
+	m_threadPool.start(job);
+}
+
+void
+TextOverlayRenderer::onOverlayFinished(int request, int generation, const QImage &image, const QImage &mask)
+{
+	if(generation != m_generation)
+		return;
+
+	const Key key = m_pendingOverlays.take(request);
+	if(!key.line)
+		return;
+
+	insert(key, Overlay{ image, mask });
+}
+
+void
+TextOverlayRenderer::insert(const Key &key, const Overlay &overlay)
+{
+	const int cost = (overlay.image.byteCount() + overlay.mask.byteCount()) / 1024 + 1;
+	m_overlays.insert(key, new Overlay(overlay), cost);
+}
+
+/*static*/ TextOverlayRenderer::Overlay
+TextOverlayRenderer::render(const QString &richText, const Style &style)
+{
+	Overlay overlay;
+	if(richText.isEmpty())
+		return overlay;
+
+	QColor primaryColor = style.primaryColor;
+	QColor outlineColor = style.outlineColor;
+	QColor transColor;
+	adjustColors(primaryColor, outlineColor, transColor);
+	const QRgb outlineRGB = outlineColor.rgb();
+	const QRgb transRGB = transColor.rgb();
+
+	QFont font = style.font;
+	font.setStyleStrategy(style.antialias ? QFont::PreferAntialias : QFont::NoAntialias);
+
+	QTextDocument document;
+	document.setDefaultFont(font);
+
+	QTextOption textOption;
+	textOption.setAlignment((Qt::Alignment)style.alignment);
+	textOption.setWrapMode(QTextOption::NoWrap);
+	document.setDefaultTextOption(textOption);
+
+	document.setDefaultStyleSheet("p { display: block; white-space: pre; }");
+	document.setHtml("<p>" + richText + "</p>");
+
+	const int width = (int)document.idealWidth();
+	document.setTextWidth(width);
+	const int height = (int)document.size().height();
+	if(width <= 0 || height <= 0)
+		return overlay;
+
+	overlay.image = QImage(width, height, QImage::Format_RGB32);
+	overlay.image.fill(transRGB);
+
+	QPainter painter(&overlay.image);
+	painter.setRenderHints(QPainter::Antialiasing | QPainter::TextAntialiasing | QPainter::SmoothPixmapTransform | QPainter::HighQualityAntialiasing | QPainter::NonCosmeticDefaultPen, style.antialias);
+	painter.setFont(font);
+
+	QAbstractTextDocumentLayout::PaintContext context;
+
+	if(style.outlineWidth > 0) {
+		// remove custom color info from document
+		QTextCharFormat fmt;
+		fmt.setForeground(QBrush(outlineColor));
+		QTextCursor cur(&document);
+		cur.select(QTextCursor::Document);
+		cur.mergeCharFormat(fmt);
+
+		context.palette.setColor(QPalette::Text, outlineColor);
+		document.documentLayout()->draw(&painter, context);
+		drawOutline(overlay.image, style.outlineWidth * overlay.image.devicePixelRatio(), outlineRGB, transRGB);
+
+		// restore custom color info
+		document.undo();
+	}
+
+	context.palette.setColor(QPalette::Text, primaryColor);
+	document.documentLayout()->draw(&painter, context);
+
+	painter.end();
+
+	overlay.mask = createMask(overlay.image, transRGB);
+
+	return overlay;
+}
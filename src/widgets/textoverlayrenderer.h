@@ -0,0 +1,115 @@
+#ifndef TEXTOVERLAYRENDERER_H
+#define TEXTOVERLAYRENDERER_H
+/**
+ * Copyright (C) 2010-2017 Mladen Milinkovic <max@smoothware.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "../core/subtitleline.h"
+
+#include <QObject>
+#include <QCache>
+#include <QColor>
+#include <QFont>
+#include <QHash>
+#include <QImage>
+#include <QThreadPool>
+
+namespace SubtitleComposer {
+/**
+ * @brief Rasterizes styled subtitle text with outline for TextOverlayWidget.
+ *
+ * Rendered overlays of subtitle lines are kept in an LRU cache limited by memory
+ * size and keyed by line, text revision and displayed text. Overlays of lines that
+ * will be shown soon can be prerendered on a worker thread.
+ */
+class TextOverlayRenderer : public QObject
+{
+	Q_OBJECT
+
+public:
+	struct Style {
+		QFont font;
+		QColor primaryColor;
+		QColor outlineColor;
+		int outlineWidth;
+		int alignment;
+		bool antialias;
+
+		bool operator==(const Style &other) const;
+		inline bool operator!=(const Style &other) const { return !operator==(other); }
+	};
+
+	struct Overlay {
+		QImage image;                   ///< text drawn over transparent color
+		QImage mask;                    ///< monochrome widget mask, color1 where text is drawn
+
+		inline bool isNull() const { return image.isNull(); }
+	};
+
+	explicit TextOverlayRenderer(QObject *parent = Q_NULLPTR);
+	virtual ~TextOverlayRenderer();
+
+	inline const Style & style() const { return m_style; }
+	/// changing the style drops all cached overlays
+	void setStyle(const Style &style);
+
+	void clear();
+
+	/**
+	 * @brief Returns cached overlay of the line's text, renders it if it's not cached yet
+	 */
+	Overlay overlay(const SubtitleLine *line, SubtitleLine::TextTarget target);
+	/**
+	 * @brief Renders overlay of the line's text on worker thread so that it's cached when needed
+	 */
+	void prerender(const SubtitleLine *line, SubtitleLine::TextTarget target);
+
+	static Overlay render(const QString &richText, const Style &style);
+
+private slots:
+	void onOverlayFinished(int request, int generation, const QImage &image, const QImage &mask);
+
+private:
+	struct Key {
+		const SubtitleLine *line;
+		quint32 revision;
+		SubtitleLine::TextTarget target;
+
+		inline bool operator==(const Key &other) const { return line == other.line && revision == other.revision && target == other.target; }
+	};
+	friend inline uint qHash(const Key &key, uint seed) { return ::qHash(key.line, seed) ^ ::qHash((key.revision << 2) | key.target, seed); }
+
+	class RenderJob;
+
+	static Key cacheKey(const SubtitleLine *line, SubtitleLine::TextTarget target);
+	static QString richText(const SString &text);
+
+	void insert(const Key &key, const Overlay &overlay);
+
+private:
+	Style m_style;
+
+	QThreadPool m_threadPool;
+	QCache<Key, Overlay> m_overlays;
+	QHash<int, Key> m_pendingOverlays;
+	int m_lastRequest;
+	int m_generation;
+};
+}
+
+#endif // TEXTOVERLAYRENDERER_H
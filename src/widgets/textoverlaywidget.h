@@ -20,6 +20,8 @@
  *   Boston, MA 02110-1301, USA.                                           *
  ***************************************************************************/
 
+#include "textoverlayrenderer.h"
+
 #include <QWidget>
 #include <QFont>
 #include <QPen>
@@ -27,8 +29,6 @@
 #include <QImage>
 #include <QBitmap>
 
-QT_FORWARD_DECLARE_CLASS(QTextDocument)
-
 class TextOverlayWidget : public QWidget
 {
 	Q_OBJECT
@@ -48,6 +48,14 @@ public:
 	int outlineWidth() const;
 	QColor outlineColor() const;
 
+	inline SubtitleComposer::TextOverlayRenderer * renderer() const { return m_renderer; }
+
+	/**
+	 * @brief setOverlay - shows text rendered by renderer() instead of text(); style
+	 *  changes don't affect the shown overlay until it's replaced
+	 */
+	void setOverlay(const SubtitleComposer::TextOverlayRenderer::Overlay &overlay);
+
 	virtual QSize minimumSizeHint() const;
 
 	virtual bool eventFilter(QObject *object, QEvent *event);
@@ -68,37 +76,27 @@ protected:
 	virtual void customEvent(QEvent *event);
 	virtual void paintEvent(QPaintEvent *event);
 
-	void setDirty(bool updateRichText, bool updateTransColor, bool flickerless = false);
+	void setStyle(const SubtitleComposer::TextOverlayRenderer::Style &style);
+	void setDirty();
 
-	void updateColors();
 	void updateContents();
+	void updatePosition();
 
 	QRect calculateTextRect() const;
-	void setMonoMask();
-	void setOutline();
 
 private:
 	QString m_text;
-	bool m_antialias;
-
-	int m_alignment;
-	QFont m_font;                           // font family and size are stored here
-	QColor m_primaryColor;
-	QRgb m_primaryRGB;
-
-	int m_outlineWidth;
-	QColor m_outlineColor;
-	QRgb m_outlineRGB;
-
-	QColor m_transColor;
-	QRgb m_transRGB;
+	bool m_prerendered;
 
-	QTextDocument *m_textDocument;
+	SubtitleComposer::TextOverlayRenderer *m_renderer;
+	SubtitleComposer::TextOverlayRenderer::Overlay m_overlay;
+	QBitmap m_overlayMask;
+	QPoint m_overlayOffset;
 
 	QBitmap m_noTextMask;
-	QImage m_bgImage;
 
 	bool m_dirty;
+	bool m_updatePending;
 };
 
 #endif
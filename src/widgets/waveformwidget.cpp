@@ -18,7 +18,12 @@
  */
 
 #include "waveformwidget.h"
+#include "spectrogramrenderer.h"
+#include "filmstriprenderer.h"
 #include "../core/subtitleline.h"
+#include "../streamprocessor/audioscrubber.h"
+#include "../streamprocessor/samplekernels.h"
+#include "../streamprocessor/voiceactivitydetector.h"
 #include "../videoplayer/videoplayer.h"
 #include "application.h"
 #include "actions/useractionnames.h"
@@ -42,8 +47,14 @@
 
 #include <KLocalizedString>
 
+#include <algorithm>
+
 #define MAX_WINDOW_ZOOM 3000
 #define DRAG_TOLERANCE (double(10 * m_samplesPerPixel / SAMPLE_RATE_MILIS))
+// minimum distance in pixels between drawn video frame boundaries
+#define FRAME_GRID_MIN_SPACING 4
+// height of video thumbnails in filmstrip lane
+#define FILMSTRIP_LANE_SIZE 36
 
 using namespace SubtitleComposer;
 
@@ -63,8 +74,16 @@ WaveformWidget::WaveformWidget(QWidget *parent)
 	  m_waveformDuration(0),
 	  m_waveformChannels(0),
 	  m_waveform(Q_NULLPTR),
+	  m_waveformComplete(false),
+	  m_spectrogram(new SpectrogramRenderer(this)),
+	  m_voiceActivity(new VoiceActivityDetector(this)),
+	  m_filmstrip(new FilmstripRenderer(this)),
+	  m_showFilmstrip(false),
+	  m_scrubber(new AudioScrubber(this)),
+	  m_scrubbing(false),
 	  m_waveformGraphics(new QWidget(this)),
 	  m_progressWidget(new QWidget(this)),
+	  m_displayMode(SCConfig::EnumWfDisplayMode::MinMaxRMS),
 	  m_samplesPerPixel(0),
 	  m_waveformZoomed(Q_NULLPTR),
 	  m_waveformZoomedSize(0),
@@ -131,11 +150,17 @@ WaveformWidget::WaveformWidget(QWidget *parent)
 
 	connect(m_scrollBar, &QScrollBar::valueChanged, this, &WaveformWidget::onScrollBarValueChanged);
 
-	connect(VideoPlayer::instance(), &VideoPlayer::positionChanged, this, &WaveformWidget::onPlayerPositionChanged);
+	VideoPlayer::instance()->subscribePosition(this, &WaveformWidget::onPlayerPositionChanged, VideoPlayer::FrameInterval);
+	connect(VideoPlayer::instance(), &VideoPlayer::frameIndexChanged, m_waveformGraphics, static_cast<void (QWidget::*)()>(&QWidget::update));
+	connect(VideoPlayer::instance(), &VideoPlayer::sceneCutsChanged, m_waveformGraphics, static_cast<void (QWidget::*)()>(&QWidget::update));
 	connect(m_stream, &StreamProcessor::streamProgress, this, &WaveformWidget::onStreamProgress);
 	connect(m_stream, &StreamProcessor::streamFinished, this, &WaveformWidget::onStreamFinished);
 	// Using Qt::DirectConnection here makes WaveformWidget::onStreamData() to execute in GStreamer's thread
 	connect(m_stream, &StreamProcessor::audioDataAvailable, this, &WaveformWidget::onStreamData, Qt::DirectConnection);
+	connect(m_spectrogram, &SpectrogramRenderer::tileReady, this, [this]() { m_waveformGraphics->update(); });
+	connect(VideoPlayer::instance(), &VideoPlayer::fileOpened, this, &WaveformWidget::onPlayerFileOpened);
+	connect(VideoPlayer::instance(), &VideoPlayer::fileClosed, m_filmstrip, &FilmstripRenderer::clear);
+	connect(m_filmstrip, &FilmstripRenderer::thumbnailsChanged, m_waveformGraphics, static_cast<void (QWidget::*)()>(&QWidget::update));
 
 	connect(SCConfig::self(), SIGNAL(configChanged()), this, SLOT(onConfigChanged()));
 	onConfigChanged();
@@ -165,6 +190,35 @@ WaveformWidget::onConfigChanged()
 
 	m_playColor = QPen(QColor(SCConfig::wfPlayLocation()), 0, Qt::SolidLine);
 	m_mouseColor = QPen(QColor(SCConfig::wfMouseLocation()), 0, Qt::DotLine);
+
+	QColor frameColor(SCConfig::wfOuterColor());
+	frameColor.setAlpha(64);
+	m_frameColor = QPen(frameColor, 0, Qt::DotLine);
+	frameColor.setAlpha(160);
+	m_keyframeColor = QPen(frameColor, 0, Qt::SolidLine);
+	m_sceneCutColor = QPen(QColor(SCConfig::wfSubNumberColor()), 2, Qt::DashLine);
+
+	m_displayMode = SCConfig::wfDisplayMode();
+	m_spectrogram->setCacheSize(SCConfig::wfSpectrogramCacheSize());
+
+	m_filmstrip->setCacheSize(SCConfig::wfFilmstripCacheSize());
+	if(m_showFilmstrip != SCConfig::wfFilmstrip()) {
+		m_showFilmstrip = SCConfig::wfFilmstrip();
+		if(!m_showFilmstrip)
+			m_filmstrip->clear();
+		else if(VideoPlayer::instance()->state() > VideoPlayer::Opening)
+			onPlayerFileOpened(VideoPlayer::instance()->filePath());
+	}
+
+	m_waveformGraphics->update();
+}
+
+void
+WaveformWidget::onPlayerFileOpened(const QString &filePath)
+{
+	// thumbnails are decoded only when they will be shown
+	if(m_showFilmstrip)
+		m_filmstrip->setMediaFile(filePath);
 }
 
 void
@@ -282,38 +336,30 @@ WaveformWidget::updateZoomData()
 			updateActions();
 		}
 
-		int iMin = m_waveformZoomedOffset * m_samplesPerPixel;
-		int iMax = m_waveformDataOffset / BYTES_PER_SAMPLE / m_waveformChannels;
-		qint32 xMin = 65535, xMax = -65535;
-//		qint32 xAvg = 0;
-//		qreal xRMS = 0;
-
-		for(quint32 ch = 0; ch < m_waveformChannels; ch++) {
-			for(int i = iMin; i < iMax; i++) {
-				qint32 val = (qint32)m_waveform[ch][i] + SIGNED_PAD;
-				if(xMin > val)
-					xMin = val;
-				if(xMax < val)
-					xMax = val;
-//				xAvg += val;
-//				xRMS += val * val;
-
-				if(i % int(m_samplesPerPixel) == int(m_samplesPerPixel) - 1) {
-//					xAvg /= m_samplesPerPixel;
-//					xRMS = sqrt(xRMS / m_samplesPerPixel);
-
-					int zi = i / m_samplesPerPixel;
-					m_waveformZoomed[ch][zi].min = xMin;
-					m_waveformZoomed[ch][zi].max = xMax;
-
-					xMin = 65535;
-					xMax = 0;
-//					xAvg = 0;
-//					xRMS = 0.0;
-				}
+		// all reductions are calculated so changing display mode doesn't require recalculation
+		const quint32 samplesAvailable = m_waveformDataOffset / BYTES_PER_SAMPLE / m_waveformChannels;
+		quint32 zi = m_waveformZoomedOffset;
+		for(; zi < m_waveformZoomedSize; zi++) {
+			const quint32 blockStart = zi * m_samplesPerPixel;
+			const quint32 blockEnd = qMax(blockStart + 1, quint32((zi + 1) * m_samplesPerPixel));
+			if(blockEnd > samplesAvailable)
+				break;
+
+			for(quint32 ch = 0; ch < m_waveformChannels; ch++) {
+				const SAMPLE_TYPE *block = m_waveform[ch] + blockStart;
+				const quint32 blockSize = blockEnd - blockStart;
+				ZoomData &zoomData = m_waveformZoomed[ch][zi];
+
+				SAMPLE_TYPE xMin;
+				SAMPLE_TYPE xMax;
+				SampleKernels::minMax(block, blockSize, &xMin, &xMax);
+				zoomData.min = xMin;
+				zoomData.max = xMax;
+				zoomData.mean = SampleKernels::mean(block, blockSize);
+				zoomData.rms = SampleKernels::rms(block, blockSize);
 			}
 		}
-		m_waveformZoomedOffset = iMax / m_samplesPerPixel;
+		m_waveformZoomedOffset = zi;
 	}
 }
 
@@ -366,8 +412,9 @@ WaveformWidget::setAudioStream(const QString &mediaFile, int audioStream)
 
 	m_waveformDuration = 0;
 	m_waveformDataOffset = 0;
+	m_waveformComplete = false;
 
-	static WaveFormat waveFormat(8000, 0, BYTES_PER_SAMPLE * 8, true);
+	static WaveFormat waveFormat(SAMPLE_RATE, 0, BYTES_PER_SAMPLE * 8, true);
 	if(m_stream->open(mediaFile) && m_stream->initAudio(audioStream, waveFormat))
 		m_stream->start();
 }
@@ -393,6 +440,11 @@ WaveformWidget::clearAudioStream()
 	m_mediaFile.clear();
 	m_streamIndex = -1;
 
+	// spectrogram and speech detection jobs might still be reading samples
+	m_spectrogram->clear();
+	m_scrubber->clear();
+	m_voiceActivity->clear();
+
 	if(m_waveformZoomed) {
 		for(quint32 i = 0; i < m_waveformChannels; i++)
 			delete[] m_waveformZoomed[i];
@@ -425,8 +477,12 @@ WaveformWidget::onStreamProgress(quint64 msecPos, quint64 msecLength)
 void
 WaveformWidget::onStreamFinished()
 {
+	m_waveformComplete = true;
 	m_progressWidget->hide();
 	m_stream->close();
+
+	if(m_waveformChannels)
+		m_voiceActivity->analyze(m_waveform, m_waveformChannels, m_waveformDataOffset / BYTES_PER_SAMPLE / m_waveformChannels, SAMPLE_RATE);
 }
 
 void
@@ -446,24 +502,20 @@ WaveformWidget::onStreamData(const void *buffer, const qint32 size, const WaveFo
 
 	Q_ASSERT(m_waveformDataOffset + size < m_waveformChannelSize * BYTES_PER_SAMPLE * m_waveformChannels);
 	Q_ASSERT(waveFormat->bitsPerSample() == BYTES_PER_SAMPLE * 8);
-	Q_ASSERT(waveFormat->sampleRate() == 8000);
+	Q_ASSERT(waveFormat->sampleRate() == SAMPLE_RATE);
 	Q_ASSERT(size % BYTES_PER_SAMPLE == 0);
 
+	// deinterleave channels
 	const SAMPLE_TYPE *sample = reinterpret_cast<const SAMPLE_TYPE *>(buffer);
 	int len = size / BYTES_PER_SAMPLE;
-	int i = m_waveformDataOffset / BYTES_PER_SAMPLE / m_waveformChannels;
-	while(len > 0) {
-		for(quint32 c = m_waveformDataOffset / BYTES_PER_SAMPLE % m_waveformChannels; len > 0 && c < m_waveformChannels; c++) {
-			qint32 val = *sample++;
-			if(i > 0) {
-				// simple lowpass filter
-				val = (val + m_waveform[c][i - 1]) / 2;
-			}
-			val &= BYTES_PER_SAMPLE == 1 ? 0x000000ff : 0x0000ffff;
-			m_waveform[c][i] = val;
-			len--;
+	quint32 i = m_waveformDataOffset / BYTES_PER_SAMPLE / m_waveformChannels;
+	quint32 c = m_waveformDataOffset / BYTES_PER_SAMPLE % m_waveformChannels;
+	while(len-- > 0) {
+		m_waveform[c][i] = *sample++;
+		if(++c == m_waveformChannels) {
+			c = 0;
+			i++;
 		}
-		i++;
 	}
 	m_waveformDataOffset += size;
 }
@@ -495,39 +547,72 @@ WaveformWidget::paintGraphics(QPainter &painter)
 
 	updateZoomData();
 
-	// FIXME: make visualization types configurable? Min/Max/Avg/RMS
-	if(m_waveformZoomed) {
+	if(m_waveformZoomed && m_displayMode == SCConfig::EnumWfDisplayMode::Spectrogram) {
+		quint32 yMin = SAMPLE_RATE_MILIS * m_timeStart.toMillis() / m_samplesPerPixel;
+		quint32 yMax = SAMPLE_RATE_MILIS * m_timeEnd.toMillis() / m_samplesPerPixel;
+		paintSpectrogram(painter, yMin, yMax, widgetWidth, widgetHeight);
+	} else if(m_waveformZoomed) {
 		quint32 yMin = SAMPLE_RATE_MILIS * m_timeStart.toMillis() / m_samplesPerPixel;
 		quint32 yMax = SAMPLE_RATE_MILIS * m_timeEnd.toMillis() / m_samplesPerPixel;
-		qint32 xMin, xMax;
+		qint32 outerLow, outerHigh, innerLow, innerHigh;
+		const bool drawInner = m_displayMode == SCConfig::EnumWfDisplayMode::MinMaxRMS;
 
 		qint32 chHalfWidth = (m_vertical ? widgetWidth : widgetHeight) / m_waveformChannels / 2;
+		const qint32 scale = 9 * chHalfWidth;
+		const qint32 scaleDiv = 5 * SAMPLE_MAX;
 
 		for(quint32 ch = 0; ch < m_waveformChannels; ch++) {
 			qint32 chCenter = (ch * 2 + 1) * chHalfWidth;
 			for(quint32 i = yMin; i < yMax; i++) {
 				if(i >= m_waveformZoomedOffset) {
-					xMin = xMax = 0;
+					outerLow = outerHigh = innerLow = innerHigh = 0;
 				} else {
-					xMin = m_waveformZoomed[ch][i].min * 9 / 5 * chHalfWidth / SAMPLE_MAX;
-					xMax = m_waveformZoomed[ch][i].max * 9 / 5 * chHalfWidth / SAMPLE_MAX;
+					const ZoomData &zoomData = m_waveformZoomed[ch][i];
+					switch(m_displayMode) {
+					case SCConfig::EnumWfDisplayMode::MinMax:
+						outerLow = zoomData.min * scale / scaleDiv;
+						outerHigh = zoomData.max * scale / scaleDiv;
+						break;
+					case SCConfig::EnumWfDisplayMode::Average:
+						outerHigh = zoomData.mean * scale / scaleDiv;
+						outerLow = -outerHigh;
+						break;
+					case SCConfig::EnumWfDisplayMode::RMS:
+						outerHigh = zoomData.rms * scale / scaleDiv;
+						outerLow = -outerHigh;
+						break;
+					default:
+						outerLow = zoomData.min * scale / scaleDiv;
+						outerHigh = zoomData.max * scale / scaleDiv;
+						break;
+					}
+					outerLow = qMax(outerLow, -chHalfWidth);
+					outerHigh = qMin(outerHigh, chHalfWidth);
+					innerHigh = qMin(zoomData.rms * scale / scaleDiv, chHalfWidth);
+					innerLow = -innerHigh;
 				}
 
 				int y = i - yMin;
 				painter.setPen(m_waveOuter);
 				if(m_vertical)
-					painter.drawLine(chCenter - xMax, y, chCenter + xMax, y);
-				else
-					painter.drawLine(y, chCenter - xMax, y, chCenter + xMax);
-				painter.setPen(m_waveInner);
-				if(m_vertical)
-					painter.drawLine(chCenter - xMin, y, chCenter + xMin, y);
+					painter.drawLine(chCenter + outerLow, y, chCenter + outerHigh, y);
 				else
-					painter.drawLine(y, chCenter - xMin, y, chCenter + xMin);
+					painter.drawLine(y, chCenter - outerHigh, y, chCenter - outerLow);
+				if(drawInner) {
+					painter.setPen(m_waveInner);
+					if(m_vertical)
+						painter.drawLine(chCenter + innerLow, y, chCenter + innerHigh, y);
+					else
+						painter.drawLine(y, chCenter - innerHigh, y, chCenter - innerLow);
+				}
 			}
 		}
 	}
 
+	paintFilmstrip(painter, widgetWidth, widgetHeight);
+	paintFrameGrid(painter, widgetWidth, widgetHeight);
+	paintSceneCuts(painter, widgetWidth, widgetHeight);
+
 	updateVisibleLines();
 
 	const RangeList &selection = Application::instance()->linesWidget()->selectionRanges();
@@ -630,6 +715,131 @@ WaveformWidget::paintGraphics(QPainter &painter)
 		painter.drawLine(playY, 0, playY, widgetHeight);
 }
 
+void
+WaveformWidget::paintFrameGrid(QPainter &painter, int widgetWidth, int widgetHeight)
+{
+	const FrameIndex &index = VideoPlayer::instance()->frameIndex();
+	if(index.isEmpty())
+		return;
+
+	const int widgetSpan = m_vertical ? widgetHeight : widgetWidth;
+	const double usecStart = m_timeStart.toMillis() * 1000.;
+	const double usecWindowSize = windowSize() * 1000.;
+	const int maxLines = widgetSpan / FRAME_GRID_MIN_SPACING;
+
+	auto drawBoundary = [&](qint64 frameTime) {
+		const int pos = widgetSpan * (frameTime - usecStart) / usecWindowSize;
+		if(m_vertical)
+			painter.drawLine(0, pos, widgetWidth, pos);
+		else
+			painter.drawLine(pos, 0, pos, widgetHeight);
+	};
+
+	const QVector<qint64> &frames = index.frames();
+	const int firstFrame = index.frameAfter(usecStart);
+	const int lastFrame = index.frameAt(usecStart + usecWindowSize);
+	if(lastFrame - firstFrame < maxLines) {
+		painter.setPen(m_frameColor);
+		for(int i = firstFrame; i <= lastFrame; i++) {
+			if(!index.isKeyframe(frames.at(i)))
+				drawBoundary(frames.at(i));
+		}
+	}
+
+	// keyframes are drawn even when zoomed out too far to show all frames
+	const QVector<qint64> &keyframes = index.keyframes();
+	auto it = std::lower_bound(keyframes.cbegin(), keyframes.cend(), qint64(usecStart));
+	auto end = std::upper_bound(it, keyframes.cend(), qint64(usecStart + usecWindowSize));
+	if(end - it < maxLines) {
+		painter.setPen(m_keyframeColor);
+		for(; it != end; ++it)
+			drawBoundary(*it);
+	}
+}
+
+void
+WaveformWidget::paintSceneCuts(QPainter &painter, int widgetWidth, int widgetHeight)
+{
+	const QVector<qint64> &cuts = VideoPlayer::instance()->sceneCuts();
+	if(cuts.isEmpty())
+		return;
+
+	const int widgetSpan = m_vertical ? widgetHeight : widgetWidth;
+	const double usecStart = m_timeStart.toMillis() * 1000.;
+	const double usecWindowSize = windowSize() * 1000.;
+
+	painter.setPen(m_sceneCutColor);
+	auto it = std::lower_bound(cuts.cbegin(), cuts.cend(), qint64(usecStart));
+	auto end = std::upper_bound(it, cuts.cend(), qint64(usecStart + usecWindowSize));
+	for(; it != end; ++it) {
+		const int pos = widgetSpan * (*it - usecStart) / usecWindowSize;
+		if(m_vertical)
+			painter.drawLine(0, pos, widgetWidth, pos);
+		else
+			painter.drawLine(pos, 0, pos, widgetHeight);
+	}
+}
+
+void
+WaveformWidget::paintFilmstrip(QPainter &painter, int widgetWidth, int widgetHeight)
+{
+	if(!m_showFilmstrip || m_filmstrip->mediaFile().isEmpty())
+		return;
+
+	// lane runs along the bottom (or right in vertical mode) edge and takes at most a third of the widget
+	QSize thumbnailSize;
+	if(m_vertical) {
+		const int width = qMin(FILMSTRIP_LANE_SIZE * FilmstripRenderer::THUMBNAIL_WIDTH / FilmstripRenderer::THUMBNAIL_HEIGHT, widgetWidth / 3);
+		thumbnailSize = QSize(width, width * FilmstripRenderer::THUMBNAIL_HEIGHT / FilmstripRenderer::THUMBNAIL_WIDTH);
+	} else {
+		const int height = qMin(FILMSTRIP_LANE_SIZE, widgetHeight / 3);
+		thumbnailSize = QSize(height * FilmstripRenderer::THUMBNAIL_WIDTH / FilmstripRenderer::THUMBNAIL_HEIGHT, height);
+	}
+	if(thumbnailSize.isEmpty())
+		return;
+	m_filmstrip->setLayout(thumbnailSize, m_vertical);
+
+	const int widgetSpan = m_vertical ? widgetHeight : widgetWidth;
+	const double msecPerPixel = double(windowSize()) / widgetSpan;
+	const qint64 pixelStart = qint64(m_timeStart.toMillis() / msecPerPixel);
+	const qint64 pixelEnd = qint64(m_timeEnd.toMillis() / msecPerPixel);
+
+	for(quint32 tileIndex = pixelStart / FilmstripRenderer::TILE_LENGTH; qint64(tileIndex) * FilmstripRenderer::TILE_LENGTH < pixelEnd; tileIndex++) {
+		const QImage *tile = m_filmstrip->tile(msecPerPixel, tileIndex);
+		if(!tile)
+			return;
+		const int tileStart = int(qint64(tileIndex) * FilmstripRenderer::TILE_LENGTH - pixelStart);
+		if(m_vertical)
+			painter.drawImage(widgetWidth - tile->width(), tileStart, *tile);
+		else
+			painter.drawImage(tileStart, widgetHeight - tile->height(), *tile);
+	}
+}
+
+void
+WaveformWidget::paintSpectrogram(QPainter &painter, quint32 yMin, quint32 yMax, int widgetWidth, int widgetHeight)
+{
+	m_spectrogram->setSource(m_waveform, m_waveformChannels);
+
+	const quint32 samplesAvailable = m_waveformDataOffset / BYTES_PER_SAMPLE / m_waveformChannels;
+	const int tileSpan = m_vertical ? widgetWidth : widgetHeight;
+
+	painter.save();
+	// tiles have time on x axis and frequency on y axis, swap them in vertical mode
+	if(m_vertical)
+		painter.setTransform(QTransform(0, 1, 1, 0, 0, 0), true);
+
+	for(quint32 tileIndex = yMin / SpectrogramRenderer::TILE_WIDTH; tileIndex * SpectrogramRenderer::TILE_WIDTH < yMax; tileIndex++) {
+		const QImage *tile = m_spectrogram->tile(m_samplesPerPixel, tileIndex, samplesAvailable, m_waveformComplete);
+		if(!tile)
+			continue;
+		const int tileStart = int(tileIndex * SpectrogramRenderer::TILE_WIDTH) - int(yMin);
+		painter.drawImage(QRect(tileStart, 0, SpectrogramRenderer::TILE_WIDTH, tileSpan), *tile);
+	}
+
+	painter.restore();
+}
+
 void
 WaveformWidget::setupScrollBar()
 {
@@ -734,6 +944,9 @@ WaveformWidget::eventFilter(QObject *obj, QEvent *event)
 
 		if(m_draggedLine) {
 			m_draggedTime = m_pointerTime;
+			scrub(m_draggedTime - m_draggedOffset);
+		} else if(m_scrubbing) {
+			scrub(m_pointerTime);
 		} else {
 			SubtitleLine *sub = Q_NULLPTR;
 			WaveformWidget::DragPosition res = subtitleAt(y, &sub);
@@ -785,8 +998,13 @@ WaveformWidget::eventFilter(QObject *obj, QEvent *event)
 				m_draggedOffset = m_pointerTime.toMillis() - m_draggedLine->hideTime().toMillis();
 		}
 
-		if(m_draggedLine)
+		if(m_draggedLine) {
 			emit dragStart(m_draggedLine, m_draggedPos);
+		} else {
+			// dragging over empty area plays audio under the pointer
+			m_scrubbing = true;
+			scrub(m_pointerTime);
+		}
 
 		return true;
 	}
@@ -834,6 +1052,8 @@ WaveformWidget::eventFilter(QObject *obj, QEvent *event)
 		m_draggedLine = Q_NULLPTR;
 		m_draggedPos = DRAG_NONE;
 		m_draggedTime = 0.;
+		m_scrubbing = false;
+		m_scrubber->stop();
 		return true;
 	}
 
@@ -842,6 +1062,17 @@ WaveformWidget::eventFilter(QObject *obj, QEvent *event)
 	}
 }
 
+void
+WaveformWidget::scrub(const Time &time)
+{
+	// player's own audio would play over scrubbed audio
+	if(!SCConfig::wfAudioScrubbing() || !m_waveformChannels || !m_waveform || VideoPlayer::instance()->isPlaying())
+		return;
+
+	m_scrubber->setSource(m_waveform, m_waveformChannels, SAMPLE_RATE);
+	m_scrubber->scrub(time.toMillis(), m_waveformDataOffset / BYTES_PER_SAMPLE / m_waveformChannels);
+}
+
 Time
 WaveformWidget::timeAt(int y)
 {
@@ -944,6 +1175,10 @@ WaveformWidget::showContextMenu(QMouseEvent *event)
 		menu->addAction(app()->action(ACT_WAVEFORM_SET_CURRENT_LINE_SHOW_TIME));
 		menu->addAction(app()->action(ACT_WAVEFORM_SET_CURRENT_LINE_HIDE_TIME));
 		menu->addAction(app()->action(ACT_WAVEFORM_INSERT_LINE));
+		menu->addSeparator();
+		menu->addAction(app()->action(ACT_SNAP_TO_SPEECH));
+		menu->addAction(app()->action(ACT_SNAP_TO_FRAMES));
+		menu->addAction(app()->action(ACT_SNAP_TO_SCENE_CUTS));
 	}
 
 	menu->popup(event->globalPos());
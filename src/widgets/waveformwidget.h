@@ -38,21 +38,18 @@ QT_FORWARD_DECLARE_CLASS(QScrollBar)
 QT_FORWARD_DECLARE_CLASS(QToolButton)
 QT_FORWARD_DECLARE_CLASS(QBoxLayout)
 
-// FIXME: make sample size configurable or drop this
-/*
-#define BYTES_PER_SAMPLE 2
 #define SAMPLE_TYPE qint16
-#define SIGNED_PAD 0 // 32768
-#define SAMPLE_MAX 32768 // 65535
-/*/
-#define BYTES_PER_SAMPLE 1
-#define SAMPLE_TYPE quint8
-#define SIGNED_PAD -128 // 0
-#define SAMPLE_MAX 128 // 255
-//*/
-#define SAMPLE_RATE_MILIS (8000 / 1000)
+#define BYTES_PER_SAMPLE int(sizeof(SAMPLE_TYPE))
+#define SAMPLE_MAX 32768
+#define SAMPLE_RATE 8000
+#define SAMPLE_RATE_MILIS (SAMPLE_RATE / 1000)
 
 namespace SubtitleComposer {
+class SpectrogramRenderer;
+class FilmstripRenderer;
+class AudioScrubber;
+class VoiceActivityDetector;
+
 class WaveformWidget : public QWidget
 {
 	Q_OBJECT
@@ -83,6 +80,8 @@ public:
 	inline const Time & rightMousePressTime() const { return m_timeRMBPress; }
 	inline const Time & rightMouseReleaseTime() const { return m_timeRMBRelease; }
 
+	inline const VoiceActivityDetector * voiceActivityDetector() const { return m_voiceActivity; }
+
 signals:
 	void doubleClick(Time time);
 	void dragStart(SubtitleLine *line, DragPosition dragPosition);
@@ -112,15 +111,21 @@ private slots:
 	void onStreamProgress(quint64 msecPos, quint64 msecLength);
 	void onStreamFinished();
 	void onScrollBarValueChanged(int value);
+	void onPlayerFileOpened(const QString &filePath);
 
 private:
 	void paintGraphics(QPainter &painter);
+	void paintSpectrogram(QPainter &painter, quint32 yMin, quint32 yMax, int widgetWidth, int widgetHeight);
+	void paintFrameGrid(QPainter &painter, int widgetWidth, int widgetHeight);
+	void paintSceneCuts(QPainter &painter, int widgetWidth, int widgetHeight);
+	void paintFilmstrip(QPainter &painter, int widgetWidth, int widgetHeight);
 	QToolButton * createToolButton(const QString &actionName, int iconSize=16);
 	void updateZoomData();
 	void updateVisibleLines();
 	Time timeAt(int y);
 	WaveformWidget::DragPosition subtitleAt(int y, SubtitleLine **result);
 	void setupScrollBar();
+	void scrub(const Time &time);
 
 private:
 	QString m_mediaFile;
@@ -146,6 +151,14 @@ private:
 	quint32 m_waveformChannels;
 	quint32 m_waveformChannelSize;
 	SAMPLE_TYPE **m_waveform;
+	bool m_waveformComplete;
+
+	SpectrogramRenderer *m_spectrogram;
+	VoiceActivityDetector *m_voiceActivity;
+	FilmstripRenderer *m_filmstrip;
+	bool m_showFilmstrip;
+	AudioScrubber *m_scrubber;
+	bool m_scrubbing;
 
 	QWidget *m_toolbar;
 
@@ -157,7 +170,10 @@ private:
 	struct ZoomData {
 		qint32 min;
 		qint32 max;
+		qint32 mean;
+		qint32 rms;
 	};
+	int m_displayMode;
 	double m_samplesPerPixel;
 	ZoomData **m_waveformZoomed;
 	quint32 m_waveformZoomedSize;
@@ -201,6 +217,10 @@ private:
 
 	QPen m_playColor;
 	QPen m_mouseColor;
+
+	QPen m_frameColor;
+	QPen m_keyframeColor;
+	QPen m_sceneCutColor;
 };
 }
 #endif